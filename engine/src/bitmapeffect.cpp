@@ -34,6 +34,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "bitmapeffect.h"
 #include "bitmapeffectblur.h"
 
+#include "thread.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Bitmap effects act on the alpha channel of a layer, producing several layers
@@ -1388,22 +1390,31 @@ static MCBitmapEffectCompositeCallback MCBitmapEffectChooseCompositer(MCBitmapEf
 	return NULL;
 }
 
-static void MCBitmapEffectRender(MCBitmapEffectRenderState& state, MCBitmapEffectLayer& dst, MCBitmapEffectLayer& src)
+// Render the rows [first_row, first_row + row_count) of the state's region.
+// The blur only depends on the position of the rows it is asked for, so any
+// set of rows renders exactly as it would as part of the whole region.
+static void MCBitmapEffectRenderRows(MCBitmapEffectRenderState& state, MCBitmapEffectLayer& dst, MCBitmapEffectLayer& src, int32_t p_first_row, int32_t p_row_count)
 {
 	// Compute the dst ptr/stride in pixels.
 	uint32_t t_dst_stride, *t_dst_pixels;
 	t_dst_stride = dst . stride / 4;
-	t_dst_pixels = (uint4 *)dst . bits + t_dst_stride * (state . region . y - dst . bounds . y) + (state . region . x - dst . bounds . x);
+	t_dst_pixels = (uint4 *)dst . bits + t_dst_stride * (state . region . y + p_first_row - dst . bounds . y) + (state . region . x - dst . bounds . x);
+
+	// Compute the blur output rect for the rows.
+	MCRectangle t_blur_rect;
+	t_blur_rect = state . blur_rect;
+	t_blur_rect . y += p_first_row;
+	t_blur_rect . height = p_row_count;
 
 	// Compute the blur src ptr/stride in pixels.
 	uint32_t t_blur_src_stride, *t_blur_src_pixels;
 	t_blur_src_stride = src . stride / 4;
-	t_blur_src_pixels = (uint4 *)src . bits + t_blur_src_stride * (state . blur_rect . y - src . bounds . y) + (state . blur_rect . x - src . bounds . x);
+	t_blur_src_pixels = (uint4 *)src . bits + t_blur_src_stride * (t_blur_rect . y - src . bounds . y) + (t_blur_rect . x - src . bounds . x);
 
 	// Compute the src ptr/stride in pixels.
 	uint32_t t_src_stride, *t_src_pixels;
 	t_src_stride = src . stride / 4;
-	t_src_pixels = (uint4 *)src . bits + t_src_stride * (state . region . y - src . bounds . y) + (state . region . x - src . bounds . x);
+	t_src_pixels = (uint4 *)src . bits + t_src_stride * (state . region . y + p_first_row - src . bounds . y) + (state . region . x - src . bounds . x);
 
 	// Compute the pre-multiplied color.
 	uint32_t t_color;
@@ -1433,9 +1444,9 @@ static void MCBitmapEffectRender(MCBitmapEffectRenderState& state, MCBitmapEffec
 	t_blur_params . spread = state . blur_spread;
 	t_blur_params . filter = state . blur_filter;
 
-	if (MCBitmapEffectBlurBegin(t_blur_params, src . bounds, state . blur_rect, t_blur_src_pixels, t_blur_src_stride, t_blur))
+	if (MCBitmapEffectBlurBegin(t_blur_params, src . bounds, t_blur_rect, t_blur_src_pixels, t_blur_src_stride, t_blur))
 	{
-		for(int32_t y = 0; y < state . region . height; y++, t_dst_pixels += t_dst_stride, t_src_pixels += t_src_stride)
+		for(int32_t y = p_first_row; y < p_first_row + p_row_count; y++, t_dst_pixels += t_dst_stride, t_src_pixels += t_src_stride)
 		{
 			// Fetch the next line of blur
 			MCBitmapEffectBlurContinue(t_blur, t_mask_pixels);
@@ -1453,6 +1464,53 @@ static void MCBitmapEffectRender(MCBitmapEffectRenderState& state, MCBitmapEffec
 	delete[] t_mask_pixels;
 }
 
+// The fewest rows worth rendering as a separate strip.
+#define kMCBitmapEffectMinimumStripHeight 64
+
+struct MCBitmapEffectRenderStripsContext
+{
+	MCBitmapEffectRenderState *state;
+	MCBitmapEffectLayer *dst;
+	MCBitmapEffectLayer *src;
+	int32_t strip_height;
+};
+
+static void MCBitmapEffectRenderStrip(void *p_context, uindex_t p_index)
+{
+	MCBitmapEffectRenderStripsContext *t_context;
+	t_context = (MCBitmapEffectRenderStripsContext *)p_context;
+
+	int32_t t_first_row;
+	t_first_row = p_index * t_context -> strip_height;
+
+	MCBitmapEffectRenderRows(*t_context -> state, *t_context -> dst, *t_context -> src, t_first_row, MCU_min(t_context -> strip_height, t_context -> state -> region . height - t_first_row));
+}
+
+static void MCBitmapEffectRender(MCBitmapEffectRenderState& state, MCBitmapEffectLayer& dst, MCBitmapEffectLayer& src)
+{
+	// Each strip has to blur the rows within the blur size above it again, so
+	// only split the region up when the strips are tall in comparison.
+	int32_t t_strip_height;
+	t_strip_height = MCU_max(kMCBitmapEffectMinimumStripHeight, 4 * (int32_t)state . blur_size);
+
+	uindex_t t_strip_count;
+	t_strip_count = MCU_min((uindex_t)(state . region . height / t_strip_height), MCThreadPoolGetConcurrency());
+	if (t_strip_count <= 1)
+	{
+		MCBitmapEffectRenderRows(state, dst, src, 0, state . region . height);
+		return;
+	}
+
+	// The strips write to distinct rows of dst, so they can be rendered at the
+	// same time.
+	MCBitmapEffectRenderStripsContext t_context;
+	t_context . state = &state;
+	t_context . dst = &dst;
+	t_context . src = &src;
+	t_context . strip_height = (state . region . height + t_strip_count - 1) / t_strip_count;
+	MCThreadPoolRun(t_strip_count, MCBitmapEffectRenderStrip, &t_context);
+}
+
 static void MCShadowEffectRender(MCShadowEffect* self, bool p_inner, const MCRectangle& p_shape, MCBitmapEffectLayer& dst, MCBitmapEffectLayer& src)
 {
 	// We fill in this structure and defer to the main rendering routine.
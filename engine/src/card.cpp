@@ -58,6 +58,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "redraw.h"
 
 #include "globals.h"
+#include "core.h"
 #include "mctheme.h"
 #include "context.h"
 
@@ -2956,6 +2957,75 @@ Exec_stat MCCard::opencontrols(bool p_is_preopen)
 	return ES_NORMAL;
 }
 
+static void MCCardCollectImageReps(MCControl *p_control, const MCRectangle& p_clip, MCImageRep **&x_reps, uindex_t &x_count)
+{
+	if (!p_control -> getflag(F_VISIBLE))
+		return;
+
+	// Controls which are scrolled or placed out of view won't be drawn.
+	MCRectangle t_visible;
+	t_visible = MCU_intersect_rect(p_control -> getrect(), p_clip);
+	if (t_visible . width == 0 || t_visible . height == 0)
+		return;
+
+	if (p_control -> gettype() == CT_GROUP)
+	{
+		MCControl *t_controls;
+		t_controls = static_cast<MCGroup *>(p_control) -> getcontrols();
+		if (t_controls != NULL)
+		{
+			MCControl *t_control = t_controls;
+			do
+			{
+				MCCardCollectImageReps(t_control, t_visible, x_reps, x_count);
+				t_control = t_control -> next();
+			}
+			while (t_control != t_controls);
+		}
+	}
+	else if (p_control -> gettype() == CT_IMAGE)
+	{
+		// Images which are shown scaled or rotated are left alone, as their
+		// source may not need decoding at full size.
+		MCImage *t_image;
+		t_image = static_cast<MCImage *>(p_control);
+		if (t_image -> gettransformed() != nil)
+			return;
+
+		MCImageRep *t_rep;
+		t_rep = t_image -> getrep();
+		if (t_rep != nil && MCMemoryResizeArray(x_count + 1, x_reps, x_count))
+			x_reps[x_count - 1] = t_rep;
+	}
+}
+
+void MCCard::prefetchimages(void)
+{
+	if (objptrs == NULL)
+		return;
+
+	MCImageRep **t_reps;
+	t_reps = nil;
+	uindex_t t_count;
+	t_count = 0;
+
+	MCObjptr *optr = objptrs;
+	do
+	{
+		MCControl *t_control;
+		t_control = optr -> getref();
+		if (t_control != NULL)
+			MCCardCollectImageReps(t_control, getrect(), t_reps, t_count);
+		optr = optr -> next();
+	}
+	while (optr != objptrs);
+
+	if (t_count > 1)
+		MCEncodedImageRep::PrefetchImageFrames(t_reps, t_count);
+
+	MCMemoryDeleteArray(t_reps);
+}
+
 Exec_stat MCCard::closecontrols(void)
 {
 	if (objptrs != NULL)
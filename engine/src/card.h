@@ -185,6 +185,9 @@ public:
 	Exec_stat opencontrols(bool p_is_preopen);
 	Exec_stat closecontrols(void);
 
+	// Decode the images of the card's visible controls ahead of drawing them.
+	void prefetchimages(void);
+
 	// MW-2011-08-19: [[ Layers ]] Dirty the given rect of the viewport.
 	void layer_dirtyrect(const MCRectangle& dirty_rect);
 	// MW-2011-08-19: [[ Layers ]] A layer has been added to the card.
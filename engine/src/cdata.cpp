@@ -26,11 +26,67 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "cdata.h"
 #include "field.h"
 #include "paragraf.h"
+#include "font.h"
+
+#include "globals.h"
+
+#include "core.h"
+
+// The unparsed paragraphs of a field's card data. Everything which affects how
+// they are read is captured at load time, so they can be parsed at any later
+// point.
+struct MCCdataDeferredParagraphs
+{
+	MCLogicalFontTableRef fonts;
+	char *version;
+	Boolean translatechars;
+	uint4 length;
+	// The bytes are followed by an OT_END tag to terminate the paragraph list.
+	char *bytes;
+};
+
+static IO_stat MCCdataLoadParagraphs(IO_handle stream, MCField *parent, const char *version, MCParagraph*& r_paragraphs)
+{
+	IO_stat stat;
+
+	MCParagraph *paragraphs = NULL;
+	while (True)
+	{
+		uint1 type;
+		if ((stat = IO_read_uint1(&type, stream)) != IO_NORMAL)
+			break;
+
+		// MW-2012-03-04: [[ StackFile5500 ]] Handle either the paragraph or extended
+		//   paragraph tag.
+		if (type != OT_PARAGRAPH && type != OT_PARAGRAPH_EXT)
+		{
+			MCS_seek_cur(stream, -1);
+			break;
+		}
+
+		MCParagraph *newpar = new MCParagraph;
+		newpar->setparent(parent);
+		
+		// MW-2012-03-04: [[ StackFile5500 ]] If the paragraph tab was the extended
+		//   variant, then pass the correct is_ext parameter.
+		if ((stat = newpar->load(stream, version, type == OT_PARAGRAPH_EXT)) != IO_NORMAL)
+		{
+			delete newpar;
+			break;
+		}
+		newpar->appendto(paragraphs);
+	}
+
+	r_paragraphs = paragraphs;
+
+	return stat;
+}
 
 MCCdata::MCCdata()
 {
 	id = 0;
 	data = NULL;
+	deferred = NULL;
 }
 
 MCCdata::MCCdata(const MCCdata &cref) : MCDLlist(cref)
@@ -56,16 +112,38 @@ MCCdata::MCCdata(const MCCdata &cref) : MCDLlist(cref)
 	}
 	else
 		data = cref.data;
+
+	// Paragraphs which haven't been parsed yet are copied as they are.
+	deferred = NULL;
+	if (cref.deferred != NULL)
+	{
+		MCCdataDeferredParagraphs *t_deferred;
+		if (MCMemoryNew(t_deferred))
+		{
+			if (MCMemoryAllocateCopy(cref.deferred -> bytes, cref.deferred -> length + 1, t_deferred -> bytes))
+			{
+				t_deferred -> fonts = MCLogicalFontTableRetain(cref.deferred -> fonts);
+				t_deferred -> version = strclone(cref.deferred -> version);
+				t_deferred -> translatechars = cref.deferred -> translatechars;
+				t_deferred -> length = cref.deferred -> length;
+				deferred = t_deferred;
+			}
+			else
+				MCMemoryDelete(t_deferred);
+		}
+	}
 }
 
 MCCdata::MCCdata(uint4 newid)
 {
 	id = newid;
 	data = NULL;
+	deferred = NULL;
 }
 
 MCCdata::~MCCdata()
 {
+	deletedeferred();
 	if (data != NULL && data != (void *)1)
 	{
 		if (id & COMPACT_PARAGRAPHS)
@@ -83,7 +161,16 @@ MCCdata::~MCCdata()
 	}
 }
 
-IO_stat MCCdata::load(IO_handle stream, MCObject *parent, const char *version)
+// Returns true if there are at least the given number of bytes left to read in
+// the stream.
+static bool MCCdataStreamHasBytes(IO_handle p_stream, uint4 p_count)
+{
+	int64_t t_available;
+	t_available = MCS_fsize(p_stream) - MCS_tell(p_stream);
+	return t_available >= 0 && (uint64_t)t_available >= (uint64_t)p_count;
+}
+
+IO_stat MCCdata::load(IO_handle stream, MCObject *parent, const char *version, uint4 p_length)
 {
 	IO_stat stat;
 
@@ -105,46 +192,48 @@ IO_stat MCCdata::load(IO_handle stream, MCObject *parent, const char *version)
 				return stat;
 			data = string;
 		}
-		else
+		else if (p_length > sizeof(uint4) && MCCdataStreamHasBytes(stream, p_length - sizeof(uint4)))
 		{
-			MCParagraph *paragraphs = NULL;
-			while (True)
+			// The size of the paragraphs is known, so just take a copy of them -
+			// they are parsed the first time they are needed.
+			uint4 t_length;
+			t_length = p_length - sizeof(uint4);
+
+			MCCdataDeferredParagraphs *t_deferred;
+			if (!MCMemoryNew(t_deferred))
+				return IO_ERROR;
+			if (!MCMemoryAllocate(t_length + 1, t_deferred -> bytes) ||
+				!MCLogicalFontTableCopy(t_deferred -> fonts))
 			{
-				uint1 type;
-				if ((stat = IO_read_uint1(&type, stream)) != IO_NORMAL)
-					return stat;
-				switch (type)
-				{
-				// MW-2012-03-04: [[ StackFile5500 ]] Handle either the paragraph or extended
-				//   paragraph tag.
-				case OT_PARAGRAPH:
-				case OT_PARAGRAPH_EXT:
-					{
-						MCParagraph *newpar = new MCParagraph;
-						newpar->setparent((MCField *)parent);
-						
-						// MW-2012-03-04: [[ StackFile5500 ]] If the paragraph tab was the extended
-						//   variant, then pass the correct is_ext parameter.
-						if ((stat = newpar->load(stream, version, type == OT_PARAGRAPH_EXT)) != IO_NORMAL)
-						{
-							delete newpar;
-							return stat;
-						}
-						newpar->appendto(paragraphs);
-					}
-					break;
-				default:
-					data = paragraphs;
-					MCS_seek_cur(stream, -1);
-					return IO_NORMAL;
-				}
+				MCMemoryDeallocate(t_deferred -> bytes);
+				MCMemoryDelete(t_deferred);
+				return IO_ERROR;
 			}
+			t_deferred -> version = strclone(version);
+			t_deferred -> translatechars = MCtranslatechars;
+			t_deferred -> length = t_length;
+			t_deferred -> bytes[t_length] = OT_END;
+			deferred = t_deferred;
+
+			uint4 t_count;
+			t_count = t_length;
+			if ((stat = IO_read(t_deferred -> bytes, sizeof(char), t_count, stream)) != IO_NORMAL)
+				return stat;
+			if (t_count != t_length)
+				return IO_EOF;
+		}
+		else
+		{
+			MCParagraph *paragraphs;
+			stat = MCCdataLoadParagraphs(stream, (MCField *)parent, version, paragraphs);
+			data = paragraphs;
+			return stat;
 		}
 	}
 	return IO_NORMAL;
 }
 
-IO_stat MCCdata::save(IO_handle stream, Object_type type, uint4 p_part)
+IO_stat MCCdata::save(IO_handle stream, Object_type type, uint4 p_part, MCField *p_parent)
 {
 	IO_stat stat;
 
@@ -153,6 +242,11 @@ IO_stat MCCdata::save(IO_handle stream, Object_type type, uint4 p_part)
 	if (p_part != 0 && id != p_part)
 		return IO_NORMAL;
 
+	// The font indices in the paragraphs are rebuilt on save, so any unparsed
+	// paragraphs must be parsed first.
+	if (deferred != NULL)
+		loaddeferred(p_parent);
+
 	if ((stat = IO_write_uint1(type, stream)) != IO_NORMAL)
 		return stat;
 	if ((stat = IO_write_uint4(p_part != 0 ? 0 : id, stream)) != IO_NORMAL)
@@ -190,8 +284,11 @@ void MCCdata::setid(uint4 newid)
 	id = newid | (id & COMPACT_PARAGRAPHS);
 }
 
-MCParagraph *MCCdata::getparagraphs()
+MCParagraph *MCCdata::getparagraphs(MCField *p_parent)
 {
+	if (deferred != NULL)
+		loaddeferred(p_parent);
+
 	MCParagraph *paragraphs;
 	if (id & COMPACT_PARAGRAPHS)
 	{
@@ -220,10 +317,25 @@ MCParagraph *MCCdata::getparagraphs()
 
 void MCCdata::setparagraphs(MCParagraph *&newpar)
 {
+	deletedeferred();
 	id &= ~COMPACT_PARAGRAPHS;
 	data = newpar;
 }
 
+void MCCdata::setparent(MCField *p_field)
+{
+	if (data == NULL || data == (void *)1 || (id & COMPACT_PARAGRAPHS) != 0)
+		return;
+
+	MCParagraph *tptr = (MCParagraph *)data;
+	do
+	{
+		tptr -> setparent(p_field);
+		tptr = tptr -> next();
+	}
+	while (tptr != data);
+}
+
 Boolean MCCdata::getset()
 {
 	return data != NULL;
@@ -233,3 +345,40 @@ void MCCdata::setset(Boolean newset)
 {
 	data = (void *)(newset != 0);
 }
+
+void MCCdata::loaddeferred(MCField *p_parent)
+{
+	// Parse the paragraphs with the font table and char translation that were in
+	// effect when they were read.
+	IO_handle t_stream;
+	t_stream = MCS_fakeopen(MCString(deferred -> bytes, deferred -> length + 1));
+
+	Boolean t_old_translatechars;
+	t_old_translatechars = MCtranslatechars;
+	MCtranslatechars = deferred -> translatechars;
+	MCLogicalFontTablePush(deferred -> fonts);
+
+	MCParagraph *t_paragraphs;
+	MCCdataLoadParagraphs(t_stream, p_parent, deferred -> version, t_paragraphs);
+
+	MCLogicalFontTablePop();
+	MCtranslatechars = t_old_translatechars;
+
+	MCS_close(t_stream);
+
+	deletedeferred();
+
+	data = t_paragraphs;
+}
+
+void MCCdata::deletedeferred(void)
+{
+	if (deferred == NULL)
+		return;
+
+	MCLogicalFontTableRelease(deferred -> fonts);
+	delete deferred -> version;
+	MCMemoryDeallocate(deferred -> bytes);
+	MCMemoryDelete(deferred);
+	deferred = NULL;
+}
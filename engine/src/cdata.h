@@ -24,21 +24,36 @@ class MCField;
 
 #define COMPACT_PARAGRAPHS 0x80000000
 
+struct MCCdataDeferredParagraphs;
+
 class MCCdata : public MCDLlist
 {
 	uint4 id;
 	void *data;
+	// If non-nil, the paragraphs as read from the stack file - they are only
+	// parsed when first needed.
+	MCCdataDeferredParagraphs *deferred;
+
+	void loaddeferred(MCField *p_parent);
+	void deletedeferred(void);
 public:
 	MCCdata();
 	MCCdata(uint4 newid);
 	MCCdata(const MCCdata &fref);
 	~MCCdata();
-	IO_stat load(IO_handle stream, MCObject *parent, const char *version);
-	IO_stat save(IO_handle stream, Object_type type, uint4 p_part);
+	// If 'length' is non-zero it is the size of the field data following its tag,
+	// and parsing its paragraphs is deferred until they are needed.
+	IO_stat load(IO_handle stream, MCObject *parent, const char *version, uint4 length = 0);
+	// The data may be held by a card, or moved between fields, until the
+	// paragraphs are parsed, so the field they are parsed for is passed in.
+	IO_stat save(IO_handle stream, Object_type type, uint4 p_part, MCField *p_parent = NULL);
 	uint4 getid();
 	void setid(uint4 newid);
-	MCParagraph *getparagraphs();
+	MCParagraph *getparagraphs(MCField *p_parent);
 	void setparagraphs(MCParagraph *&newpar);
+	// Makes the given field the parent of the paragraphs (as when the data has
+	// been copied from another field).
+	void setparent(MCField *p_field);
 	Boolean getset();
 	void setset(Boolean newdata);
 	void setdata(int4 newdata)
@@ -1269,19 +1269,128 @@ Exec_stat MCChunk::getobj(MCExecPoint &ep, MCObject *&objptr,
 	return ES_NORMAL;
 }
 
+static int4 countlines(MCExecPoint &ep, const char *sptr, const char *eptr);
+static int4 countitems(MCExecPoint &ep, const char *sptr, const char *eptr);
+
+// Returns p_source if the range [sptr, eptr) lies within its string value, in
+// which case the delimiter index of the value can be used to find chunks.
+static MCVariableValue *indexedsource(MCVariableValue *p_source, const char *sptr, const char *eptr)
+{
+	if (p_source == nil || !p_source -> is_string())
+		return nil;
+
+	MCString t_string;
+	t_string = p_source -> get_string();
+	if (sptr < t_string . getstring() || eptr > t_string . getstring() + t_string . getlength())
+		return nil;
+
+	return p_source;
+}
+
+// Count the chunks in [sptr, eptr), using the delimiter index of p_indexed
+// for line and item chunks if there is one.
+static int4 countchunks(MCExecPoint &ep, const char *sptr, const char *eptr,
+                        int4 (*count)(MCExecPoint &ep, const char *sptr, const char *eptr),
+                        MCVariableValue *p_indexed)
+{
+	char t_delimiter;
+	if (p_indexed == nil)
+		return (*count)(ep, sptr, eptr);
+	else if (count == countlines)
+		t_delimiter = ep.getlinedel();
+	else if (count == countitems)
+		t_delimiter = ep.getitemdel();
+	else
+		return (*count)(ep, sptr, eptr);
+
+	if (sptr >= eptr)
+		return 1;
+
+	// As with countlines/countitems, a trailing delimiter doesn't begin a new
+	// chunk.
+	const char *t_base;
+	t_base = p_indexed -> get_string() . getstring();
+	int4 t_chunks;
+	t_chunks = 1 + p_indexed -> count_delimiters(t_delimiter, eptr - t_base) - p_indexed -> count_delimiters(t_delimiter, sptr - t_base);
+	if (*(eptr - 1) == t_delimiter)
+		t_chunks--;
+
+	return t_chunks;
+}
+
+// Advance sptr past (at most) x_count delimiters before eptr using the
+// delimiter index of p_indexed. On return x_count is the number of delimiters
+// still to be skipped by the scanning loop - the final delimiter of the range
+// is always left to the loop so that its accounting at the end of the string
+// is unchanged.
+static void skipdelimiters(MCVariableValue *p_indexed, char p_delimiter, const char *&sptr, const char *eptr, int4 &x_count)
+{
+	if (x_count <= 0)
+		return;
+
+	const char *t_base;
+	t_base = p_indexed -> get_string() . getstring();
+
+	uint32_t t_first, t_last;
+	t_first = p_indexed -> count_delimiters(p_delimiter, sptr - t_base);
+	t_last = p_indexed -> count_delimiters(p_delimiter, eptr - t_base);
+
+	uint32_t t_skip;
+	if ((uint32_t)x_count < t_last - t_first)
+		t_skip = x_count;
+	else if (t_last - t_first > 1)
+		t_skip = t_last - t_first - 1;
+	else
+		return;
+
+	uint32_t t_offset;
+	if (!p_indexed -> find_delimiter(p_delimiter, t_first + t_skip - 1, t_offset))
+		return;
+
+	sptr = t_base + t_offset + 1;
+	x_count -= t_skip;
+}
+
+// Return the position of the p_count'th delimiter at or after sptr, or eptr
+// if there are not that many before eptr.
+static const char *finddelimiter(MCVariableValue *p_indexed, char p_delimiter, const char *sptr, const char *eptr, int4 p_count)
+{
+	if (sptr >= eptr || p_count <= 0)
+		return sptr;
+
+	const char *t_base;
+	t_base = p_indexed -> get_string() . getstring();
+
+	uint32_t t_first;
+	t_first = p_indexed -> count_delimiters(p_delimiter, sptr - t_base);
+
+	uint32_t t_offset;
+	if (t_first + p_count - 1 < t_first ||
+		!p_indexed -> find_delimiter(p_delimiter, t_first + p_count - 1, t_offset) ||
+		t_base + t_offset >= eptr)
+		return eptr;
+
+	return t_base + t_offset;
+}
+
 Exec_stat MCChunk::extents(MCCRef *ref, int4 &start, int4 &number,
                            MCExecPoint &ep, const char *sptr, const char *eptr,
                            int4 (*count)(MCExecPoint &ep, const char *sptr,
-                                         const char *eptr))
+                                         const char *eptr),
+                           MCVariableValue *p_indexed, int4 p_nchunks)
 {
-	int4 nchunks = -1;
+	// If the number of chunks is already known it is passed in, otherwise it
+	// is counted if needed.
+	int4 nchunks = p_nchunks;
 	int4 tn;
 	MCExecPoint ep2(ep);
 	number = 1;
 	switch (ref->etype)
 	{
 	case CT_ANY:
-		start = MCU_any((*count)(ep, sptr, eptr));
+		if (nchunks == -1)
+			nchunks = countchunks(ep, sptr, eptr, count, p_indexed);
+		start = MCU_any(nchunks);
 		break;
 	case CT_FIRST:
 	case CT_SECOND:
@@ -1296,10 +1405,14 @@ Exec_stat MCChunk::extents(MCCRef *ref, int4 &start, int4 &number,
 		start = ref->etype - CT_FIRST;
 		break;
 	case CT_LAST:
-		start = ((*count)(ep, sptr, eptr)) - 1;
+		if (nchunks == -1)
+			nchunks = countchunks(ep, sptr, eptr, count, p_indexed);
+		start = nchunks - 1;
 		break;
 	case CT_MIDDLE:
-		start = ((*count)(ep, sptr, eptr)) / 2;
+		if (nchunks == -1)
+			nchunks = countchunks(ep, sptr, eptr, count, p_indexed);
+		start = nchunks / 2;
 		break;
 	case CT_RANGE:
 		if (ref->startpos->eval(ep2) != ES_NORMAL || ep2.ton() != ES_NORMAL)
@@ -1310,7 +1423,8 @@ Exec_stat MCChunk::extents(MCCRef *ref, int4 &start, int4 &number,
 		start = ep2.getint4();
 		if (start < 0)
 		{
-			nchunks = (*count)(ep, sptr, eptr);
+			if (nchunks == -1)
+				nchunks = countchunks(ep, sptr, eptr, count, p_indexed);
 			start += nchunks;
 		}
 		else
@@ -1324,7 +1438,7 @@ Exec_stat MCChunk::extents(MCCRef *ref, int4 &start, int4 &number,
 		if (tn < 0)
 		{
 			if (nchunks == -1)
-				nchunks = (*count)(ep, sptr, eptr);
+				nchunks = countchunks(ep, sptr, eptr, count, p_indexed);
 			tn += nchunks + 1;
 		}
 		number = tn - start;
@@ -1337,7 +1451,11 @@ Exec_stat MCChunk::extents(MCCRef *ref, int4 &start, int4 &number,
 		}
 		start = ep2.getint4();
 		if (start < 0)
-			start += (*count)(ep, sptr, eptr);
+		{
+			if (nchunks == -1)
+				nchunks = countchunks(ep, sptr, eptr, count, p_indexed);
+			start += nchunks;
+		}
 		else
 			start--;
 		break;
@@ -1356,28 +1474,16 @@ Exec_stat MCChunk::extents(MCCRef *ref, int4 &start, int4 &number,
 
 static int4 countlines(MCExecPoint &ep, const char *sptr, const char *eptr)
 {
-	int4 clines = 1;
-	if (sptr < eptr)
-		do
-		{
-			if (*sptr == ep.getlinedel() && sptr + 1 < eptr)
-				clines++;
-		}
-		while (++sptr < eptr);
-	return clines;
+	if (sptr >= eptr)
+		return 1;
+	return 1 + MCU_countchar(sptr, eptr - 1, ep.getlinedel());
 }
 
 static int4 countitems(MCExecPoint &ep, const char *sptr, const char *eptr)
 {
-	int4 items = 1;
-	if (sptr < eptr)
-		do
-		{
-			if (*sptr == ep.getitemdel() && sptr + 1 < eptr)
-				items++;
-		}
-		while (++sptr < eptr);
-	return items;
+	if (sptr >= eptr)
+		return 1;
+	return 1 + MCU_countchar(sptr, eptr - 1, ep.getitemdel());
 }
 
 static int4 countwords(MCExecPoint &ep, const char *sptr, const char *eptr)
@@ -1440,7 +1546,9 @@ static void skip_word(const char *&sptr, const char *&eptr)
 
 // MW-2012-02-23: [[ FieldChars ]] Added the 'includechars' flag, if true any char chunk
 //   will be processed; otherwise it will be ignored.
-Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force, Boolean wholechunk, bool includechars)
+// If 'source' is not nil, it is the value ep's string was fetched from - its
+// delimiter index is used to locate line and item chunks.
+Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force, Boolean wholechunk, bool includechars, MCVariableValue *source)
 {
 	start = 0;
 	end = ep.getsvalue().getlength();
@@ -1449,9 +1557,12 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 	const char *eptr = sptr + ep.getsvalue().getlength();
 	int4 s, n;
 
+	MCVariableValue *t_indexed;
+	t_indexed = indexedsource(source, sptr, eptr);
+
 	if (cline != NULL)
 	{
-		if (extents(cline, s, n, ep, sptr, eptr, countlines) != ES_NORMAL)
+		if (extents(cline, s, n, ep, sptr, eptr, countlines, t_indexed) != ES_NORMAL)
 		{
 			MCeerror->add(EE_CHUNK_BADLINEMARK, line, pos);
 			return ES_ERROR;
@@ -1464,21 +1575,26 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 		else
 		{
 			uint4 add = 0;
+			if (t_indexed != nil)
+				skipdelimiters(t_indexed, ep.getlinedel(), sptr, eptr, s);
 			while (s--)
 			{
-				while (sptr < eptr && *sptr++ != ep.getlinedel())
-					;
+				sptr = MCU_findchar(sptr, eptr, ep.getlinedel());
+				if (sptr < eptr)
+					sptr++;
 				if (sptr == eptr && !(s == 0 && sptr > startptr && *(sptr - 1) == ep.getlinedel()))
 					add++;
 			}
 			start = sptr - startptr;
-			while (sptr < eptr && n--)
-			{
-				while (sptr < eptr && *sptr != ep.getlinedel())
-					sptr++;
-				if (sptr < eptr && n)
-					sptr++;
-			}
+			if (t_indexed != nil)
+				sptr = finddelimiter(t_indexed, ep.getlinedel(), sptr, eptr, n);
+			else
+				while (sptr < eptr && n--)
+				{
+					sptr = MCU_findchar(sptr, eptr, ep.getlinedel());
+					if (sptr < eptr && n)
+						sptr++;
+				}
 			end = sptr - startptr;
 			if (wholechunk && item == NULL && word == NULL && character == NULL)
 			{
@@ -1494,6 +1610,7 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 				start += add;
 				end += add;
 				startptr = ep.getsvalue().getstring();
+				t_indexed = nil;
 			}
 			sptr = startptr + start;
 			eptr = startptr + end;
@@ -1504,15 +1621,18 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 	{
 		int4 ostart = start;
 		uint4 add	= 0;
-		if (extents(item, s, n, ep, sptr, eptr, countitems) != ES_NORMAL)
+		if (extents(item, s, n, ep, sptr, eptr, countitems, t_indexed) != ES_NORMAL)
 		{
 			MCeerror->add(EE_CHUNK_BADITEMMARK, line, pos);
 			return ES_ERROR;
 		}
+		if (t_indexed != nil)
+			skipdelimiters(t_indexed, ep.getitemdel(), sptr, eptr, s);
 		while (s--)
 		{
-			while (sptr < eptr && *sptr++ != ep.getitemdel())
-				;
+			sptr = MCU_findchar(sptr, eptr, ep.getitemdel());
+			if (sptr < eptr)
+				sptr++;
 			if (sptr == eptr
 			        && !(s == 0 && sptr > startptr && *(sptr - 1) == ep.getitemdel()))
 				add++;
@@ -1525,13 +1645,15 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 		}
 		else
 		{
-			while (sptr < eptr && n--)
-			{
-				while (sptr < eptr && *sptr != ep.getitemdel())
-					sptr++;
-				if (sptr < eptr && n)
-					sptr++;
-			}
+			if (t_indexed != nil)
+				sptr = finddelimiter(t_indexed, ep.getitemdel(), sptr, eptr, n);
+			else
+				while (sptr < eptr && n--)
+				{
+					sptr = MCU_findchar(sptr, eptr, ep.getitemdel());
+					if (sptr < eptr && n)
+						sptr++;
+				}
 			end = sptr - startptr;
 			if (wholechunk && word == NULL && character == NULL)
 			{
@@ -1548,6 +1670,7 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 				start += add;
 				end += add;
 				startptr = ep.getsvalue().getstring();
+				t_indexed = nil;
 			}
 			sptr = startptr + start;
 			eptr = startptr + end;
@@ -1651,11 +1774,11 @@ Exec_stat MCChunk::mark(MCExecPoint &ep, int4 &start, int4 &end, Boolean force,
 	return ES_NORMAL;
 }
 
-Exec_stat MCChunk::gets(MCExecPoint &ep)
+Exec_stat MCChunk::gets(MCExecPoint &ep, MCVariableValue *source)
 {
 	int4 start, end;
 
-	if (mark(ep, start, end, False, False) != ES_NORMAL)
+	if (mark(ep, start, end, False, False, true, source) != ES_NORMAL)
 	{
 		MCeerror->add(EE_CHUNK_CANTMARK, line, pos);
 		return ES_ERROR;
@@ -1666,12 +1789,33 @@ Exec_stat MCChunk::gets(MCExecPoint &ep)
 
 Exec_stat MCChunk::eval(MCExecPoint &ep)
 {
+	MCVariableValue *t_source;
+	return evalsource(ep, t_source);
+}
+
+// Evaluate the chunk into ep. If the container is a plain variable then
+// r_source is set to its value, so that the caller can use its delimiter
+// index; otherwise it is nil.
+Exec_stat MCChunk::evalsource(MCExecPoint &ep, MCVariableValue*& r_source)
+{
+	r_source = nil;
 	if (source != NULL && url == NULL && stack == NULL && background == NULL && card == NULL
 	        && group == NULL && object == NULL)
 	{
 		if (desttype != DT_OWNER)
 		{
-			if (source->eval(ep) != ES_NORMAL)
+			MCVariable *t_var;
+			t_var = source -> evalvar(ep);
+			if (t_var != nil)
+			{
+				if (t_var -> fetch(ep) != ES_NORMAL)
+				{
+					MCeerror->add(EE_CHUNK_CANTGETSOURCE, line, pos);
+					return ES_ERROR;
+				}
+				r_source = &t_var -> getvalue();
+			}
+			else if (source->eval(ep) != ES_NORMAL)
 			{
 				MCeerror->add(EE_CHUNK_CANTGETSOURCE, line, pos);
 				return ES_ERROR;
@@ -1787,7 +1931,7 @@ Exec_stat MCChunk::eval(MCExecPoint &ep)
 		//   for backwards compatibility.
 		if (ep . getformat() == VF_ARRAY)
 			ep . clear();
-		if (ep.tos() != ES_NORMAL || gets(ep) != ES_NORMAL)
+		if (ep.tos() != ES_NORMAL || gets(ep, r_source) != ES_NORMAL)
 		{
 			MCeerror->add(EE_CHUNK_CANTGETSUBSTRING, line, pos, ep.getsvalue());
 			return ES_ERROR;
@@ -1904,6 +2048,14 @@ Exec_stat MCChunk::set(MCExecPoint &ep, Preposition_type ptype)
 		{
 			memcpy((char *)ep2.getsvalue().getstring() + start, ep.getsvalue().getstring(),
 			       ep.getsvalue().getlength());
+
+			// The variable's buffer has been modified in place, so any delimiter
+			// index it has is no longer valid.
+			MCVariable *t_var;
+			t_var = destvar -> evalvar(ep2);
+			if (t_var != nil)
+				t_var -> getvalue() . discard_delimiter_index();
+
 			return ES_NORMAL;
 		}
 	}
@@ -2118,7 +2270,8 @@ Exec_stat MCChunk::count(Chunk_term tocount, Chunk_term ptype,
 	else
 	{
 		uint4 i = 0;
-		if (eval(ep) != ES_NORMAL)
+		MCVariableValue *t_source;
+		if (evalsource(ep, t_source) != ES_NORMAL)
 			return ES_ERROR;
 
 		// MW-2009-07-22: If the value of the chunk is an array, then either
@@ -2134,10 +2287,10 @@ Exec_stat MCChunk::count(Chunk_term tocount, Chunk_term ptype,
 				switch(tocount)
 				{
 				case CT_LINE:
-					i = countlines(ep, sptr, eptr);
+					i = countchunks(ep, sptr, eptr, countlines, indexedsource(t_source, sptr, eptr));
 					break;
 				case CT_ITEM:
-					i = countitems(ep, sptr, eptr);
+					i = countchunks(ep, sptr, eptr, countitems, indexedsource(t_source, sptr, eptr));
 					break;
 				case CT_WORD:
 					i = countwords(ep, sptr, eptr);
@@ -2352,6 +2505,15 @@ Exec_stat MCChunk::fieldmark(MCExecPoint &ep, MCField *fptr, uint4 parid,
 	}
 	else
 	{
+		// A chunk which is just a line can be found from the offsets of the
+		// field's paragraphs (each line being a paragraph), if they are indexed,
+		// without fetching the field's text.
+		MCFieldParagraphIndex *t_index;
+		uint4 t_count;
+		if (cline != nil && item == nil && word == nil && token == nil && character == nil &&
+			ep . getlinedel() == '\n' && fptr -> getnativeparagraphindex(parid, false, t_index, t_count))
+			return fieldmarklines(ep, fptr, parid, t_index, t_count, start, end, wholechunk, force, keeptext);
+
 		// We can make do with ASCII content if the delimiters (if needed) are
 		// ASCII chars.
 		bool t_ascii_only;
@@ -2416,6 +2578,88 @@ Exec_stat MCChunk::fieldmark(MCExecPoint &ep, MCField *fptr, uint4 parid,
 	return ES_NORMAL;
 }
 
+// The result is the same as that of 'mark' on the field's native text, which is
+// the paragraphs separated by CRs - so the offsets of the paragraphs are enough to
+// find the extent of any lines.
+Exec_stat MCChunk::fieldmarklines(MCExecPoint &ep, MCField *fptr, uint4 parid, MCFieldParagraphIndex *p_index, uint4 p_count,
+                                  int4 &start, int4 &end, Boolean wholechunk, Boolean force, Boolean keeptext)
+{
+	// The text ends in a CR if the last of several paragraphs is empty, in which
+	// case (as with 'countlines') the CR doesn't begin a new line.
+	int4 t_length, t_lines;
+	t_length = fptr -> getnativeparagraphoffset(p_index, p_count) - 1;
+	if (t_length == 0)
+		t_lines = 1;
+	else if (p_count > 1 && (int4)fptr -> getnativeparagraphoffset(p_index, p_count - 1) == t_length)
+		t_lines = p_count - 1;
+	else
+		t_lines = p_count;
+
+	int4 s, n;
+	if (extents(cline, s, n, ep, nil, nil, countlines, nil, t_lines) != ES_NORMAL)
+	{
+		MCeerror->add(EE_CHUNK_BADLINEMARK, line, pos);
+		MCeerror->add(EE_CHUNK_BADTEXT, line, pos);
+		return ES_ERROR;
+	}
+
+	// Evaluating the chunk expression might have changed the field, so refetch
+	// the index.
+	if (!fptr -> getnativeparagraphindex(parid, true, p_index, p_count))
+	{
+		MCeerror->add(EE_CHUNK_BADTEXT, line, pos);
+		return ES_ERROR;
+	}
+	t_length = fptr -> getnativeparagraphoffset(p_index, p_count) - 1;
+
+	start = 0;
+	end = 0;
+	if (n != 0)
+	{
+		// Skipping s lines goes past the end of the text if there are fewer
+		// than s + 1 paragraphs, each CR missing being counted in 'add'.
+		uint4 add;
+		if ((uint4)s < p_count)
+		{
+			start = fptr -> getnativeparagraphoffset(p_index, s);
+			add = 0;
+		}
+		else
+		{
+			start = t_length;
+			add = s - p_count + 1;
+		}
+
+		// The line chunk ends at the end of its last paragraph, or at the end of
+		// the text.
+		if ((uint4)s + (uint4)n <= p_count)
+			end = fptr -> getnativeparagraphoffset(p_index, s + n) - 1;
+		else
+			end = t_length;
+
+		if (wholechunk)
+		{
+			if (end < t_length)
+				end++;
+			else if (start > 0 && !add)
+				start--;
+		}
+		else if (force && add)
+		{
+			ep . clear();
+			ep . fill(0, '\n', add);
+			fptr -> settextindex(parid, t_length, t_length, ep . getsvalue(), False);
+			start += add;
+			end += add;
+		}
+	}
+
+	if (keeptext)
+		fptr -> exportastext(parid, ep, start, end, false);
+
+	return ES_NORMAL;
+}
+
 Exec_stat MCChunk::getobjforprop(MCExecPoint& ep, MCObject*& r_object, uint4& r_parid)
 {
 	MCObject *objptr;
@@ -19,6 +19,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "express.h"
 
+struct MCFieldParagraphIndex;
+
 class MCCRef
 {
 public:
@@ -62,6 +64,7 @@ public:
 
 	Parse_stat parse(MCScriptPoint &spt, Boolean the);
 	Exec_stat eval(MCExecPoint &);
+	Exec_stat evalsource(MCExecPoint &, MCVariableValue*& r_source);
 	MCVarref *getrootvarref(void);
 
 	void take_components(MCChunk *tchunk);
@@ -69,12 +72,13 @@ public:
 	Exec_stat extents(MCCRef *ref, int4 &start, int4 &number,
 	                  MCExecPoint &ep, const char *sptr, const char *eptr,
 	                  int4 (*count)(MCExecPoint &ep, const char *sptr,
-	                                const char *eptr));
-	Exec_stat mark(MCExecPoint &, int4 &start, int4 &end, Boolean force, Boolean wholechunk, bool include_characters = true);
+	                                const char *eptr),
+	                  MCVariableValue *indexed = nil, int4 nchunks = -1);
+	Exec_stat mark(MCExecPoint &, int4 &start, int4 &end, Boolean force, Boolean wholechunk, bool include_characters = true, MCVariableValue *source = nil);
 	// MW-2012-02-23: [[ CharChunk ]] Compute the start and end field indices corresponding
 	//   to the field char chunk in 'field'.
 	Exec_stat markcharactersinfield(uint32_t part_id, MCExecPoint& ep, int32_t& start, int32_t& end, MCField *field);
-	Exec_stat gets(MCExecPoint &);
+	Exec_stat gets(MCExecPoint &, MCVariableValue *source = nil);
 	Exec_stat set(MCExecPoint &, Preposition_type ptype);
 	// MW-2012-02-23: [[ PutUnicode ]] Set the chunk to the UTF-16 encoded text in ep.
 	Exec_stat setunicode(MCExecPoint& ep, Preposition_type ptype);
@@ -84,6 +88,8 @@ public:
 	// MW-2012-01-27: [[ UnicodeChunks ]] Added the 'keeptext' parameter, if True then on exit the
 	//   ep will contain the actual content of the field.
 	Exec_stat fieldmark(MCExecPoint &, MCField *fptr, uint4 parid, int4 &start, int4 &end, Boolean wholechunk, Boolean force, Boolean keeptext = False);
+	// Mark a chunk which is just a line of the field, using the offsets of its paragraphs.
+	Exec_stat fieldmarklines(MCExecPoint &, MCField *fptr, uint4 parid, MCFieldParagraphIndex *p_index, uint4 p_count, int4 &start, int4 &end, Boolean wholechunk, Boolean force, Boolean keeptext);
 
 	// MW-2011-11-23: [[ Array Chunk Props ]] If index is not nil, then treat as an array chunk prop
 	Exec_stat getprop(Properties w, MCExecPoint &, MCNameRef index, Boolean effective);
@@ -1335,17 +1335,22 @@ class MCFilter : public MCStatement
 {
 	MCChunk *container;
 	MCExpression *pattern;
+	// The chunks that are filtered - CT_LINE, CT_ITEM or CT_ELEMENT.
+	Chunk_term chunktype;
 	Boolean out;
+	// If true, the pattern is a regular expression rather than a wildcard.
+	Boolean regex;
 public:
 	MCFilter()
 	{
 		container = NULL;
 		pattern = NULL;
+		chunktype = CT_LINE;
 		out = False;
+		regex = False;
 	}
 	virtual ~MCFilter();
-	Boolean match(char *s, char *p, Boolean casesensitive);
-	char *filterlines(char *sstring, char *pstring, Boolean casesensitive);
+	static Boolean match(char *s, char *p, Boolean casesensitive);
 	virtual Parse_stat parse(MCScriptPoint &);
 	virtual Exec_stat exec(MCExecPoint &);
 };
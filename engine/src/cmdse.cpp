@@ -120,9 +120,7 @@ Exec_stat MCAccept::exec(MCExecPoint &ep)
 	MCSocket *s = MCS_accept(port, ep.getobj(), t_message_name, datagram, secure, secureverify, NULL);
 	if (s != NULL)
 	{
-		MCU_realloc((char **)&MCsockets, MCnsockets,
-		            MCnsockets + 1, sizeof(MCSocket *));
-		MCsockets[MCnsockets++] = s;
+		IO_addsocket(s);
 	}
 
 	return ES_NORMAL;
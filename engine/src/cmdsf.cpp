@@ -28,6 +28,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "execpt.h"
 #include "cmds.h"
 #include "chunk.h"
+#include "variable.h"
 #include "mcerror.h"
 #include "object.h"
 #include "control.h"
@@ -54,6 +55,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "iquantization.h"
 
 #include "core.h"
+#include "regex.h"
 
 MCClose::~MCClose()
 {
@@ -1215,84 +1217,464 @@ Boolean MCFilter::match(char *s, char *p, Boolean casesensitive)
 	return *p == 0;
 }
 
-char *MCFilter::filterlines(char *sstring, char *pstring,
-                            Boolean casesensitive)
+// The pattern of a filter command is compiled once per execution into an
+// MCFilterMatcher. Wildcards of the form [*]literal[*] are matched by comparing
+// or searching for the literal directly. Any other wildcard is compiled into a
+// bit-parallel NFA with one bit per token, so each byte of a chunk costs one
+// table lookup and a few word operations regardless of the number of '*'s.
+// Wildcards with too many tokens for the NFA fall back to MCFilter::match.
+#define FILTER_NFA_TOKENS 63
+
+enum MCFilterMatcherKind
+{
+	kMCFilterMatchAll,
+	kMCFilterMatchEqual,
+	kMCFilterMatchPrefix,
+	kMCFilterMatchSuffix,
+	kMCFilterMatchContains,
+	kMCFilterMatchNFA,
+	kMCFilterMatchWildcard,
+	kMCFilterMatchRegex,
+};
+
+class MCFilterMatcher
+{
+public:
+	MCFilterMatcher(void);
+	~MCFilterMatcher(void);
+
+	void compile(const MCString& p_pattern, Boolean p_casesensitive);
+	void compileregex(regexp *p_regex);
+
+	bool match(const char *p_chunk, uint4 p_length);
+
+private:
+	bool compare(const char *p_chunk, const char *p_literal, uint4 p_length) const;
+
+	MCFilterMatcherKind kind;
+	Boolean casesensitive;
+	regexp *regex;
+
+	// The literal (for the direct kinds) or C-string pattern (for the wildcard
+	// fallback) and the scratch buffer used to NUL-terminate chunks for the
+	// latter.
+	char *literal;
+	uint4 literal_length;
+	char *scratch;
+	uint4 scratch_size;
+
+	// Bit i of masks[c] is set if token i consumes byte c, bit i of stars is
+	// set if token i is a '*' and the pattern has matched when bit 'accept' is
+	// set.
+	uint64_t masks[256];
+	uint64_t stars;
+	uint64_t start;
+	uint64_t accept;
+};
+
+MCFilterMatcher::MCFilterMatcher(void)
+{
+	kind = kMCFilterMatchAll;
+	casesensitive = False;
+	regex = NULL;
+	literal = NULL;
+	literal_length = 0;
+	scratch = NULL;
+	scratch_size = 0;
+	stars = 0;
+	start = 0;
+	accept = 0;
+}
+
+MCFilterMatcher::~MCFilterMatcher(void)
+{
+	delete literal;
+	delete scratch;
+}
+
+// Returns the position after the bracket expression starting at p_bracket (just
+// after the '['), or NULL if it is never closed. This follows the scan done by
+// MCFilter::match, where a ']' only closes the bracket once there is a previous
+// character and a '-' between two characters forms a range.
+static const char *MCFilterBracketEnd(const char *p_bracket, const char *p_limit)
+{
+	const char *p;
+	p = p_bracket;
+	if (p < p_limit && *p == '!')
+		p++;
+
+	int lc = -1;
+	while (p < p_limit)
+	{
+		uint1 c = *p++;
+		if (c == CLOSE_BRACKET && lc >= 0)
+			return p;
+		else if (c == '-' && lc >= 0 && p < p_limit && *p != CLOSE_BRACKET)
+			p++;
+		else
+			lc = c;
+	}
+
+	return NULL;
+}
+
+// Returns whether the (closed) bracket expression starting at p_bracket accepts
+// the given byte. The logic is exactly that of MCFilter::match, so brackets are
+// always case-sensitive.
+static bool MCFilterBracketAccepts(const char *p_bracket, uint1 scc)
+{
+	const char *p;
+	p = p_bracket;
+
+	bool notflag = false;
+	if (*p == '!')
+	{
+		notflag = true;
+		p++;
+	}
+
+	bool ok = false;
+	int lc = -1;
+	for(;;)
+	{
+		uint1 c = *p++;
+		if (c == CLOSE_BRACKET && lc >= 0)
+			return ok;
+		else if (c == '-' && lc >= 0 && *p != CLOSE_BRACKET)
+		{
+			c = *p++;
+			if (notflag)
+			{
+				if (lc > scc || scc > c)
+					ok = true;
+				else
+					return false;
+			}
+			else if (lc < scc && scc <= c)
+				ok = true;
+		}
+		else
+		{
+			if (notflag)
+			{
+				if (scc != c)
+					ok = true;
+				else
+					return false;
+			}
+			else if (scc == c)
+				ok = true;
+			lc = c;
+		}
+	}
+}
+
+void MCFilterMatcher::compile(const MCString& p_pattern, Boolean p_casesensitive)
 {
-	uint4 offset = 0;
-	char *dstring = new char[strlen(sstring) + 1];
-	char *line;
+	casesensitive = p_casesensitive;
+
+	// As before, the pattern stops at the first NUL.
+	const char *t_pattern, *t_limit;
+	t_pattern = p_pattern . getstring();
+	t_limit = t_pattern + p_pattern . getlength();
+	const char *t_nul;
+	t_nul = (const char *)memchr(t_pattern, '\0', t_limit - t_pattern);
+	if (t_nul != NULL)
+		t_limit = t_nul;
+
+	uint4 t_length;
+	t_length = t_limit - t_pattern;
+
+	// Work out the shape of the pattern - whether it is a literal surrounded by
+	// optional '*'s and, if not, how many tokens it has.
+	bool t_leading_star, t_trailing_star, t_literal;
+	t_leading_star = false;
+	t_trailing_star = false;
+	t_literal = true;
+
+	uint4 t_first, t_last;
+	t_first = 0;
+	while (t_first < t_length && t_pattern[t_first] == '*')
+		t_first++;
+	t_last = t_length;
+	while (t_last > t_first && t_pattern[t_last - 1] == '*')
+		t_last--;
+	t_leading_star = t_first != 0;
+	t_trailing_star = t_last != t_length;
+	for(uint4 i = t_first; i < t_last; i++)
+		if (t_pattern[i] == '*' || t_pattern[i] == '?' || t_pattern[i] == OPEN_BRACKET)
+		{
+			t_literal = false;
+			break;
+		}
+
+	if (t_literal)
+	{
+		literal_length = t_last - t_first;
+		literal = new char[literal_length + 1];
+		memcpy(literal, t_pattern + t_first, literal_length);
+
+		if (literal_length == 0 && t_leading_star)
+			kind = kMCFilterMatchAll;
+		else if (t_leading_star && t_trailing_star)
+			kind = kMCFilterMatchContains;
+		else if (t_leading_star)
+			kind = kMCFilterMatchSuffix;
+		else if (t_trailing_star)
+			kind = kMCFilterMatchPrefix;
+		else
+			kind = kMCFilterMatchEqual;
+		return;
+	}
+
+	// Build the NFA, collapsing runs of '*' into one token.
+	memset(masks, 0, sizeof(masks));
+	stars = 0;
+
+	uint4 t_token;
+	t_token = 0;
+	const char *p;
+	p = t_pattern;
+	while (p < t_limit && t_token <= FILTER_NFA_TOKENS)
+	{
+		uint64_t t_bit;
+		t_bit = t_token < FILTER_NFA_TOKENS ? (uint64_t)1 << t_token : 0;
+
+		uint1 c = *p++;
+		if (c == '*')
+		{
+			while (p < t_limit && *p == '*')
+				p++;
+			stars |= t_bit;
+		}
+		else if (c == '?')
+		{
+			for(uint4 i = 0; i < 256; i++)
+				masks[i] |= t_bit;
+		}
+		else if (c == OPEN_BRACKET)
+		{
+			// An unclosed bracket never matches, and swallows the rest of the
+			// pattern.
+			const char *t_end;
+			t_end = MCFilterBracketEnd(p, t_limit);
+			if (t_end != NULL)
+			{
+				for(uint4 i = 0; i < 256; i++)
+					if (MCFilterBracketAccepts(p, (uint1)i))
+						masks[i] |= t_bit;
+				p = t_end;
+			}
+			else
+				p = t_limit;
+		}
+		else if (casesensitive)
+			masks[c] |= t_bit;
+		else
+		{
+			uint1 t_folded;
+			t_folded = MCS_tolower(c);
+			for(uint4 i = 0; i < 256; i++)
+				if (MCS_tolower((uint1)i) == t_folded)
+					masks[i] |= t_bit;
+		}
+
+		t_token++;
+	}
+
+	if (t_token > FILTER_NFA_TOKENS)
+	{
+		literal_length = t_length;
+		literal = new char[t_length + 1];
+		memcpy(literal, t_pattern, t_length);
+		literal[t_length] = '\0';
+		kind = kMCFilterMatchWildcard;
+		return;
+	}
+
+	// Stars have been collapsed so a single step is enough to take the epsilon
+	// transitions out of the start state.
+	start = 1 | (stars & 1) << 1;
+	accept = (uint64_t)1 << t_token;
+	kind = kMCFilterMatchNFA;
+}
+
+void MCFilterMatcher::compileregex(regexp *p_regex)
+{
+	regex = p_regex;
+	kind = kMCFilterMatchRegex;
+}
+
+inline bool MCFilterMatcher::compare(const char *p_chunk, const char *p_literal, uint4 p_length) const
+{
+	if (casesensitive)
+		return memcmp(p_chunk, p_literal, p_length) == 0;
+
+	for(uint4 i = 0; i < p_length; i++)
+		if (MCS_tolower(p_chunk[i]) != MCS_tolower(p_literal[i]))
+			return false;
+
+	return true;
+}
+
+bool MCFilterMatcher::match(const char *p_chunk, uint4 p_length)
+{
+	switch(kind)
+	{
+	case kMCFilterMatchAll:
+		return true;
+
+	case kMCFilterMatchEqual:
+		return p_length == literal_length && compare(p_chunk, literal, p_length);
 
-	// OK-2010-01-11: Bug 7649 - Filter command was incorrectly removing empty lines.
-	// Now does:
-	// 1. Remove terminal delimiter from list
-	// 2. Do the filtering (now using strchr instead of strtok to fix the original bug)
-	// 3. If the filtered list is non-empty and had a terminal delimiter, put a return after it.
+	case kMCFilterMatchPrefix:
+		return p_length >= literal_length && compare(p_chunk, literal, literal_length);
 
-	// Duplicate input string because the algorithm needs to change it.
-	char *t_string;
-	t_string = strdup(sstring);
+	case kMCFilterMatchSuffix:
+		return p_length >= literal_length && compare(p_chunk + p_length - literal_length, literal, literal_length);
 
-	// Keep a copy of the original pointer so it can be freed
-	char *t_original_string;
-	t_original_string = t_string;
+	case kMCFilterMatchContains:
+	{
+		uint4 t_offset;
+		return p_length >= literal_length && MCU_offset(MCString(literal, literal_length), MCString(p_chunk, p_length), t_offset, casesensitive);
+	}
 
-	// MW-2010-10-05: [[ Bug 9034 ]] If t_string is of zero length, then the next couple
-	//   of lines will cause problems so return empty in this case.
-	uint32_t t_length;
-	t_length = strlen(t_string);
-	if (t_length == 0)
+	case kMCFilterMatchNFA:
 	{
-		free(t_original_string);
-		*dstring = '\0';
-		return dstring;
+		uint64_t t_state;
+		t_state = start;
+		for(uint4 i = 0; i < p_length && t_state != 0; i++)
+		{
+			t_state = ((t_state & masks[(uint1)p_chunk[i]]) << 1) | (t_state & stars);
+			t_state |= (t_state & stars) << 1;
+		}
+		return (t_state & accept) != 0;
 	}
 
-	// Record whether or not the string was terminated with a trailing delimiter,
-	// if it was, then remove this trailing delimiter.
+	case kMCFilterMatchWildcard:
+		if (p_length + 1 > scratch_size)
+		{
+			delete scratch;
+			scratch_size = p_length + 1;
+			scratch = new char[scratch_size];
+		}
+		memcpy(scratch, p_chunk, p_length);
+		scratch[p_length] = '\0';
+		return MCFilter::match(scratch, literal, casesensitive) == True;
+
+	case kMCFilterMatchRegex:
+		return MCR_exec(regex, p_chunk, p_length) != 0;
+	}
+
+	return false;
+}
+
+// Filter the chunks of p_length bytes at p_src separated by p_delimiter into
+// p_dst, returning the number of bytes written. As only matching chunks are
+// kept, p_dst may be the same as p_src, in which case the filtering is done in
+// place. A trailing delimiter on the input is kept if any chunk remains.
+static uint4 MCFilterChunks(const char *p_src, uint4 p_length, char *p_dst, char p_delimiter, MCFilterMatcher& p_matcher, Boolean p_out)
+{
+	// MW-2010-10-05: [[ Bug 9034 ]] Empty input yields empty output.
+	if (p_length == 0)
+		return 0;
+
+	// OK-2010-01-11: Bug 7649 - Empty chunks are kept if they match, and a
+	//   terminal delimiter isn't counted as starting another chunk.
 	bool t_was_terminated;
-	t_was_terminated = (t_string[t_length - 1] == '\n');
+	t_was_terminated = p_src[p_length - 1] == p_delimiter;
 	if (t_was_terminated)
-		t_string[t_length - 1] = '\0';
+		p_length--;
 
+	uint4 t_read, t_write, t_kept;
+	t_read = 0;
+	t_write = 0;
+	t_kept = 0;
 	for(;;)
 	{
-		char *t_return;
-		t_return = strchr(t_string, '\n');
+		const char *t_chunk;
+		t_chunk = p_src + t_read;
 
-		if (t_return != nil)
-			*t_return = '\0';
+		const char *t_next;
+		t_next = (const char *)memchr(t_chunk, p_delimiter, p_length - t_read);
 
-		line = t_string;
-		if (match(line, pstring, casesensitive) != out)
-		{
-			if (offset)
-				dstring[offset++] = '\n';
+		uint4 t_chunk_length;
+		t_chunk_length = t_next != NULL ? t_next - t_chunk : p_length - t_read;
 
-			// MW-2010-10-18: [[ Bug 7864 ]] This should be a 32-bit integer - removing 65535 char limit.
-			uint32_t length = strlen(line);
-			memcpy(&dstring[offset], line, length);
-			offset += length;
+		if (p_matcher . match(t_chunk, t_chunk_length) != (p_out == True))
+		{
+			if (t_kept++ != 0)
+				p_dst[t_write++] = p_delimiter;
+			if (p_dst + t_write != t_chunk)
+				memmove(p_dst + t_write, t_chunk, t_chunk_length);
+			t_write += t_chunk_length;
 		}
 
-		if (t_return == nil)
+		if (t_next == NULL)
 			break;
 
-		t_string = t_return + 1;
+		t_read += t_chunk_length + 1;
 	}
 
-	if (offset != 0 && t_was_terminated)
-		dstring[offset++] = '\n';
-
+	if (t_kept != 0 && t_was_terminated)
+		p_dst[t_write++] = p_delimiter;
 
-	free(t_original_string);
+	return t_write;
+}
 
-	dstring[offset] = '\0';
-	return dstring;
+// Remove the elements of the given array whose (string) value does not pass the
+// filter. Nested arrays are treated as empty without being converted.
+static void MCFilterElements(MCExecPoint& ep, MCVariableValue& p_array, MCFilterMatcher& p_matcher, Boolean p_out)
+{
+	MCVariableArray *t_array;
+	t_array = p_array . get_array();
+
+	uint4 l;
+	l = 0;
+	MCHashentry *e;
+	e = NULL;
+	while((e = t_array -> getnextkey(l, e)) != NULL)
+	{
+		MCString t_value;
+		if (!e -> value . is_array() && e -> value . ensure_string(ep))
+			t_value = e -> value . get_string();
+
+		// Removing the entry leaves the slots after it in place, so iteration
+		// can continue from the same index - unless it was the last entry, in
+		// which case the array becomes empty and its table is freed.
+		if (p_matcher . match(t_value . getstring(), t_value . getlength()) == (p_out == True))
+		{
+			p_array . remove_hash(e);
+			if (!p_array . is_array())
+				break;
+		}
+	}
 }
 
 Parse_stat MCFilter::parse(MCScriptPoint &sp)
 {
 	initpoint(sp);
+
+	// filter [ lines | items | elements of ] <container> ...
+	Symbol_type type;
+	const LT *te;
+	if (sp.next(type) == PS_NORMAL)
+	{
+		if (sp.lookup(SP_FACTOR, te) == PS_NORMAL && te->type == TT_CLASS
+		        && (te->which == CT_LINE || te->which == CT_ITEM || te->which == CT_ELEMENT))
+		{
+			chunktype = (Chunk_term)te->which;
+			if (sp.skip_token(SP_FACTOR, TT_OF) != PS_NORMAL)
+			{
+				MCperror->add
+				(PE_FILTER_BADDEST, sp);
+				return PS_ERROR;
+			}
+		}
+		else
+			sp.backup();
+	}
+
 	container = new MCChunk(True);
 	if (container->parse(sp, False) != PS_NORMAL)
 	{
@@ -1316,6 +1698,16 @@ Parse_stat MCFilter::parse(MCScriptPoint &sp)
 	else
 		if (stat == PS_NORMAL)
 			out = True;
+
+	// filter <container> with|without regex pattern <pattern>
+	if (sp.skip_token(SP_SUGAR, TT_UNDEFINED, SG_REGEX) == PS_NORMAL)
+	{
+		if (sp.skip_token(SP_SUGAR, TT_UNDEFINED, SG_PATTERN) == PS_NORMAL)
+			regex = True;
+		else
+			sp.backup();
+	}
+
 	if (sp.parseexp(False, True, &pattern) != PS_NORMAL)
 	{
 		MCperror->add
@@ -1327,24 +1719,88 @@ Parse_stat MCFilter::parse(MCScriptPoint &sp)
 
 Exec_stat MCFilter::exec(MCExecPoint &ep)
 {
-	if (container->eval(ep) != ES_NORMAL)
+	// The pattern is compiled first so that the container's value can then be
+	// filtered where it lies.
+	if (pattern->eval(ep) != ES_NORMAL)
 	{
-		MCeerror->add(EE_FILTER_CANTGET, line, pos);
+		MCeerror->add(EE_FILTER_CANTGETPATTERN, line, pos);
 		return ES_ERROR;
 	}
-	char *sptr = ep.getsvalue().clone();
-	if (pattern->eval(ep) != ES_NORMAL)
+
+	MCFilterMatcher t_matcher;
+	if (regex)
 	{
-		MCeerror->add(EE_FILTER_CANTGETPATTERN, line, pos);
-		delete sptr;
+		regexp *t_compiled;
+		t_compiled = MCR_lookup(ep.getsvalue().getstring(), ep.getsvalue().getlength());
+		if (t_compiled == NULL)
+		{
+			MCeerror->add(EE_FILTER_BADREGEX, line, pos, MCR_geterror());
+			return ES_ERROR;
+		}
+		t_matcher.compileregex(t_compiled);
+	}
+	else
+		t_matcher.compile(ep.getsvalue(), ep.getcasesensitive());
+
+	char t_delimiter;
+	t_delimiter = chunktype == CT_ITEM ? ep.getitemdel() : '\n';
+
+	// If the container is a variable (or an element of one), filter its buffer
+	// directly rather than copying the value out and back.
+	MCVarref *t_ref;
+	t_ref = container->getrootvarref();
+	if (t_ref != NULL && container->nochunks())
+	{
+		MCVariable *t_var;
+		MCVariableValue *t_value;
+		if (t_ref->evalcontainer(ep, t_var, t_value) != ES_NORMAL)
+		{
+			MCeerror->add(EE_FILTER_CANTGET, line, pos);
+			return ES_ERROR;
+		}
+
+		if (chunktype == CT_ELEMENT)
+		{
+			if (t_value->is_array())
+				MCFilterElements(ep, *t_value, t_matcher, out);
+		}
+		else if (t_value->ensure_string(ep) && !t_value->is_empty())
+		{
+			void *t_buffer;
+			uint32_t t_length;
+			if (!t_value->reserve(0, t_buffer, t_length))
+			{
+				MCeerror->add(EE_NO_MEMORY, line, pos);
+				return ES_ERROR;
+			}
+
+			t_length = MCFilterChunks((const char *)t_buffer, t_length, (char *)t_buffer, t_delimiter, t_matcher, out);
+			if (t_length == 0)
+				t_value->assign_empty();
+			else
+				t_value->commit(t_length);
+		}
+
+		if (t_var != NULL)
+			t_var->synchronize(ep, True);
+
+		return ES_NORMAL;
+	}
+
+	if (container->eval(ep) != ES_NORMAL)
+	{
+		MCeerror->add(EE_FILTER_CANTGET, line, pos);
 		return ES_ERROR;
 	}
-	char *pptr = ep.getsvalue().clone();
-	char *dptr = filterlines(sptr, pptr, ep.getcasesensitive());
-	delete sptr;
-	delete pptr;
-	ep.copysvalue(dptr, strlen(dptr));
-	delete dptr;
+
+	// Other containers can't hold arrays, so have no elements to filter.
+	if (chunktype == CT_ELEMENT)
+		return ES_NORMAL;
+
+	ep.grabsvalue();
+	char *t_buffer;
+	t_buffer = (char *)ep.getsvalue().getstring();
+	ep.setsvalue(MCString(t_buffer, MCFilterChunks(t_buffer, ep.getsvalue().getlength(), t_buffer, t_delimiter, t_matcher, out)));
 	if (container->set(ep, PT_INTO) != ES_NORMAL)
 	{
 		MCeerror->add(EE_FILTER_CANTSET, line, pos);
@@ -2224,8 +2680,7 @@ Exec_stat MCOpen::exec(MCExecPoint &ep)
 			MCSocket *s = MCS_open_socket(name, datagram, ep.getobj(), t_message_name, secure, secureverify, NULL);
 			if (s != NULL)
 			{
-				MCU_realloc((char **)&MCsockets, MCnsockets, MCnsockets + 1, sizeof(MCSocket *));
-				MCsockets[MCnsockets++] = s;
+				IO_addsocket(s);
 			}
 			else
 				delete name;
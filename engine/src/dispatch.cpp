@@ -55,6 +55,10 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "printer.h"
 #include "font.h"
 #include "stacksecurity.h"
+#include "md5.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #define UNLICENSED_TIME 6.0
 #ifdef _DEBUG_MALLOC_INC
@@ -796,6 +800,84 @@ IO_stat MCDispatch::savestack(MCStack *sptr, const MCString& fname)
 	return stat;
 }
 
+// Fetches the size, modification time and file id of the file at the given
+// path. These are what is compared to tell whether a stack's file has been
+// touched since it was saved. On Windows the file id is always 0, so only the
+// size and time count there. If the file can't be found this returns false.
+static bool MCDispatchGetFileStamp(const char *p_path, int64_t& r_size, int64_t& r_modified, uint64_t& r_id)
+{
+	char *t_path;
+	t_path = MCS_resolvepath(p_path);
+	if (t_path == NULL)
+		return false;
+
+	bool t_found;
+#ifdef _WINDOWS
+	struct _stat t_info;
+	t_found = _stat(t_path, &t_info) == 0;
+#else
+	struct stat t_info;
+	t_found = stat(t_path, &t_info) == 0;
+#endif
+	delete t_path;
+
+	if (!t_found)
+		return false;
+
+	r_size = t_info . st_size;
+	r_modified = t_info . st_mtime;
+	r_id = t_info . st_ino;
+
+	return true;
+}
+
+// Computes the md5 digest and length of the file at the given path, reading it
+// a block at a time.
+static bool MCDispatchDigestFile(const char *p_path, uint4& r_length, uint8_t r_digest[16])
+{
+	IO_handle t_stream;
+	t_stream = MCS_open(p_path, IO_READ_MODE, False, False, 0);
+	if (t_stream == NULL)
+		return false;
+
+	int64_t t_size;
+	t_size = MCS_fsize(t_stream);
+
+	md5_state_t t_state;
+	md5_init(&t_state);
+
+	char *t_block;
+	t_block = new char[65536];
+
+	bool t_success;
+	t_success = t_size >= 0 && t_size <= MAXUINT4;
+
+	uint4 t_length;
+	t_length = t_success ? (uint4)t_size : 0;
+	uint4 t_offset;
+	t_offset = 0;
+	while(t_success && t_offset < t_length)
+	{
+		uint4 t_count;
+		t_count = MCU_min(t_length - t_offset, 65536U);
+		t_success = IO_read(t_block, sizeof(char), t_count, t_stream) == IO_NORMAL;
+		if (t_success)
+			md5_append(&t_state, (const md5_byte_t *)t_block, t_count);
+		t_offset += t_count;
+	}
+
+	delete[] t_block;
+	MCS_close(t_stream);
+
+	if (!t_success)
+		return false;
+
+	md5_finish(&t_state, r_digest);
+	r_length = t_length;
+
+	return true;
+}
+
 IO_stat MCDispatch::dosavestack(MCStack *sptr, const MCString &fname)
 {
 	if (MCModeCheckSaveStack(sptr, fname) != IO_NORMAL)
@@ -821,30 +903,29 @@ IO_stat MCDispatch::dosavestack(MCStack *sptr, const MCString &fname)
 		delete linkname;
 		return IO_ERROR;
 	}
+
+	MCString errstring = "Error writing stack (disk full?)";
+
+	// The stack is written to a temporary file next to the real one, which is
+	// only replaced once the whole stack has been written. This means that an
+	// error part way through never touches the existing file.
+	char *t_temporary;
+	t_temporary = new char[strlen(linkname) + 3];
+	strcpy(t_temporary, linkname);
+	strcat(t_temporary, "~~");
+
 	char *oldfiletype = MCfiletype;
 	MCfiletype = MCstackfiletype;
-	char *backup = new char[strlen(linkname) + 2];
-	strcpy(backup, linkname);
-	strcat(backup, "~");
-	MCS_unlink(backup);
-	if (MCS_exists(linkname, True) && !MCS_backup(linkname, backup))
-	{
-		MCresult->sets("can't open stack backup file");
-		MCfiletype = oldfiletype;
-		delete linkname;
-		delete backup;
-		return IO_ERROR;
-	}
 	IO_handle stream;
-	if ((stream = MCS_open(linkname, IO_WRITE_MODE, True, False, 0)) == NULL)
+	stream = MCS_open(t_temporary, IO_WRITE_MODE, True, False, 0);
+	MCfiletype = oldfiletype;
+	if (stream == NULL)
 	{
 		MCresult->sets("can't open stack file");
-		cleanup(stream, linkname, backup);
-		MCfiletype = oldfiletype;
+		delete t_temporary;
+		delete linkname;
 		return IO_ERROR;
 	}
-	MCfiletype = oldfiletype;
-	MCString errstring = "Error writing stack (disk full?)";
 	
 	// MW-2012-03-04: [[ StackFile5500 ]] Work out what header to emit, and the size.
 	const char *t_header;
@@ -856,36 +937,77 @@ IO_stat MCDispatch::dosavestack(MCStack *sptr, const MCString &fname)
 	else
 		t_header = header, t_header_size = HEADERSIZE;
 	
-	if (IO_write(t_header, sizeof(char), t_header_size, stream) != IO_NORMAL
-	        || IO_write_uint1(CHARSET, stream) != IO_NORMAL)
-	{
-		MCresult->sets(errstring);
-		cleanup(stream, linkname, backup);
-		return IO_ERROR;
-	}
-
-	if (IO_write_uint1(OT_NOTHOME, stream) != IO_NORMAL
-	        || IO_write_string(NULL, stream) != IO_NORMAL)
-	{ // was stackfiles
-		MCresult->sets(errstring);
-		cleanup(stream, linkname, backup);
-		return IO_ERROR;
-	}
-	
 	// MW-2012-02-22; [[ NoScrollSave ]] Adjust the rect by the current group offset.
 	MCgroupedobjectoffset . x = 0;
 	MCgroupedobjectoffset . y = 0;
 	
 	MCresult -> clear();
-	if (sptr->save(stream, 0, false) != IO_NORMAL
+	if (IO_write(t_header, sizeof(char), t_header_size, stream) != IO_NORMAL
+	        || IO_write_uint1(CHARSET, stream) != IO_NORMAL
+	        || IO_write_uint1(OT_NOTHOME, stream) != IO_NORMAL
+	        || IO_write_string(NULL, stream) != IO_NORMAL // was stackfiles
+	        || sptr->save(stream, 0, false) != IO_NORMAL
 	        || IO_write_uint1(OT_END, stream) != IO_NORMAL)
 	{
 		if (MCresult -> isclear())
 			MCresult->sets(errstring);
-		cleanup(stream, linkname, backup);
+		MCS_close(stream);
+		MCS_unlink(t_temporary);
+		delete t_temporary;
+		delete linkname;
 		return IO_ERROR;
 	}
 	MCS_close(stream);
+
+	// If what was written is the same as what was last saved to the same file,
+	// and that file hasn't been touched since (it has the same size, time and
+	// file id as when it was saved), the file is left alone. This only compares
+	// digests of the whole stack - it doesn't track which objects have changed,
+	// so the stack is still written out in full each time.
+	uint4 t_length;
+	uint8_t t_digest[16];
+	bool t_have_digest;
+	t_have_digest = MCDispatchDigestFile(t_temporary, t_length, t_digest);
+
+	int64_t t_file_size, t_file_modified;
+	uint64_t t_file_id;
+	if (t_have_digest &&
+		sptr -> getfilename() != NULL && strequal(linkname, sptr -> getfilename()) &&
+		MCDispatchGetFileStamp(linkname, t_file_size, t_file_modified, t_file_id) &&
+		t_file_size == t_length &&
+		sptr -> matchessaveddigest(t_length, t_digest, t_file_modified, t_file_id))
+	{
+		MCS_unlink(t_temporary);
+		delete t_temporary;
+		delete linkname;
+		return IO_NORMAL;
+	}
+
+	// The existing file is moved out of the way before the new one is renamed
+	// over it, as on Windows a rename won't replace a file. If the rename fails
+	// the existing file is put back.
+	char *backup = new char[strlen(linkname) + 2];
+	strcpy(backup, linkname);
+	strcat(backup, "~");
+	MCS_unlink(backup);
+	if (MCS_exists(linkname, True) && !MCS_backup(linkname, backup))
+	{
+		MCresult->sets("can't open stack backup file");
+		MCS_unlink(t_temporary);
+		delete t_temporary;
+		delete linkname;
+		delete backup;
+		return IO_ERROR;
+	}
+	if (!MCS_rename(t_temporary, linkname))
+	{
+		MCresult->sets("can't open stack file");
+		MCS_unlink(t_temporary);
+		delete t_temporary;
+		cleanup(NULL, linkname, backup);
+		return IO_ERROR;
+	}
+	delete t_temporary;
 	uint2 oldmask = MCS_umask(0);
 	uint2 newmask = ~oldmask & 00777;
 	if (oldmask & 00400)
@@ -901,6 +1023,8 @@ IO_stat MCDispatch::dosavestack(MCStack *sptr, const MCString &fname)
 	else if (sptr -> getfilename() != NULL)
 		MCS_copyresourcefork(backup, linkname);
 	sptr->setfilename(linkname);
+	if (t_have_digest && MCDispatchGetFileStamp(linkname, t_file_size, t_file_modified, t_file_id))
+		sptr->setsaveddigest(t_length, t_digest, t_file_modified, t_file_id);
 	if (backup != NULL)
 	{
 		MCS_unlink(backup);
@@ -2371,6 +2371,12 @@ enum Exec_errors
 	
 	// {EE-0778} image cache limit: not a number
 	EE_PROPERTY_BADIMAGECACHELIMIT,
+	
+	// {EE-0779} sessionStore: bad value
+	EE_SESSION_STORE_BADVALUE,
+	
+	// {EE-0780} filter: error in regex pattern
+	EE_FILTER_BADREGEX,
 };
 
 extern const char *MCexecutionerrors;
@@ -43,6 +43,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "globals.h"
 #include "context.h"
 #include "redraw.h"
+#include "objectstream.h"
+#include "font.h"
 
 int2 MCField::clickx;
 int2 MCField::clicky;
@@ -89,6 +91,7 @@ MCField::MCField()
 	tabs = NULL;
 	ntabs = 0;
 	label = NULL;
+	pgindex = NULL;
 }
 
 MCField::MCField(const MCField &fref) : MCControl(fref)
@@ -144,12 +147,14 @@ MCField::MCField(const MCField &fref) : MCControl(fref)
 		do
 		{
 			MCCdata *newfdata = new MCCdata(*fptr);
+			newfdata->setparent(this);
 			newfdata->appendto(fdata);
 			fptr = fptr->next();
 		}
 		while (fptr != fref.fdata);
 	}
 	label = strclone(fref.label);
+	pgindex = NULL;
 	state &= ~CS_KFOCUSED;
 }
 
@@ -159,6 +164,10 @@ MCField::~MCField()
 	// particuarly if the field had image source characters.
 	while (opened)
 		close();
+
+	// Dropping the index first saves it being updated as each paragraph is
+	// deleted.
+	deleteparagraphindex();
 	
 	if (opened && paragraphs != NULL)
 	{
@@ -237,7 +246,7 @@ bool MCField::visit(MCVisitStyle p_style, uint32_t p_part, MCObjectVisitor *p_vi
 			if (t_include)
 			{
 				// MW-2012-11-22: [[ Bug 10558 ]] Make sure we visit the correct fdata!
-				MCParagraph *pgptr = t_fdata -> getparagraphs();
+				MCParagraph *pgptr = t_fdata -> getparagraphs(this);
 
 				MCParagraph *tpgptr = pgptr;
 				do
@@ -306,7 +315,7 @@ void MCField::open()
 	else
 		parentid = getcard()->getid();
 	MCCdata *foundptr = getcarddata(fdata, parentid, True);
-	paragraphs = foundptr->getparagraphs();
+	paragraphs = foundptr->getparagraphs(this);
 	foundptr->totop(fdata);
 	if (paragraphs == oldparagraphs)
 		oldparagraphs = NULL;
@@ -1249,6 +1258,7 @@ Exec_stat MCField::getprop(uint4 parid, Properties which, MCExecPoint& ep, Boole
 		ep.setint(scrollbarwidth);
 		break;
 	case P_FORMATTED_HEIGHT:
+		layoutestimated(NULL, INT32_MAX);
 		if (opened)
 			ep.setint(textheight + rect.height - getfheight()
 			          + topmargin + bottommargin - TEXT_Y_OFFSET);
@@ -1256,6 +1266,8 @@ Exec_stat MCField::getprop(uint4 parid, Properties which, MCExecPoint& ep, Boole
 			ep.setint(0);
 		break;
 	case P_FORMATTED_WIDTH:
+		layoutestimated(NULL, INT32_MAX);
+		measuretextwidth();
 		if (opened)
 			ep.setint(textwidth + rect.width - getfwidth()
 			          + leftmargin + rightmargin
@@ -1562,7 +1574,7 @@ Exec_stat MCField::setprop(uint4 parid, Properties p, MCExecPoint &ep, Boolean e
 				fptr = getcarddata(fdata, 0, True);
 			else
 				fptr = getcarddata(fdata, getcard()->getid(), True);
-			MCParagraph *pgptr = fptr->getparagraphs();
+			MCParagraph *pgptr = fptr->getparagraphs(this);
 			fdata->setparagraphs(pgptr);
 			fdata = fptr;
 			fdata->setparagraphs(paragraphs);
@@ -2126,7 +2138,7 @@ MCParagraph *MCField::resolveparagraphs(uint4 parid)
 	{
 		if (parid == 0 && !(flags & F_SHARED_TEXT))
 			parid = getcard()->getid();
-		pgptr = getcarddata(fdata, parid, True)->getparagraphs();
+		pgptr = getcarddata(fdata, parid, True)->getparagraphs(this);
 	}
 	
 	return pgptr;
@@ -2190,7 +2202,7 @@ void MCField::replacedata(MCCdata *&data, uint4 newid)
 	fptr->insertto(fdata);
 	if (opened)
 	{
-		paragraphs = fdata->getparagraphs();
+		paragraphs = fdata->getparagraphs(this);
 		openparagraphs();
 		recompute();
 
@@ -2236,7 +2248,7 @@ void MCField::resetfontindex(MCStack *oldstack)
 		MCCdata *fptr = fdata;
 		MCCdata *tptr = fptr->remove(fptr);
 		
-		MCParagraph *pgptr = tptr->getparagraphs();
+		MCParagraph *pgptr = tptr->getparagraphs(this);
 		MCParagraph *tpgptr = pgptr;
 		do
 		{
@@ -2283,6 +2295,7 @@ Exec_stat MCField::hscroll(int4 offset, Boolean doredraw)
 			drect.height += flags & F_HSCROLLBAR ? DEFAULT_BORDER
 			                : DEFAULT_BORDER * 2;
 		}
+	measuretextwidth();
 	uint4 twidth = textwidth + leftmargin + rightmargin - DEFAULT_BORDER * 2;
 	if (textx < 0 || twidth < (uint4)drect.width)
 		textx = 0;
@@ -2335,6 +2348,11 @@ Exec_stat MCField::vscroll(int4 offset, Boolean doredraw)
 		drect.y++;
 		drect.height--;
 	}
+	// Paragraphs about to come into view may only have had their height
+	// estimated, so flow them before clamping to the height of the text. The
+	// cached positions haven't been scrolled yet, hence the offset.
+	layoutestimated(NULL, drect . y + drect . height - getcontenty() + texty - oldy);
+
 	uint4 theight = textheight + topmargin + bottommargin - TEXT_Y_OFFSET * 2;
 	if (texty < 0 || theight < (uint4)drect.height)
 		texty = 0;
@@ -2511,6 +2529,16 @@ void MCField::setsbrects()
 	resetscrollbars(False);
 }
 
+// Returns the average width of a character of running text in the given font,
+// used to estimate how many lines a paragraph will wrap onto.
+static int32_t MCFieldEstimateCharWidth(MCFontRef p_font)
+{
+	static const char s_sample[] = "The quick brown fox jumps over the lazy dog. ";
+	int32_t t_width;
+	t_width = MCFontMeasureText(p_font, s_sample, sizeof(s_sample) - 1, false);
+	return MCU_max(t_width / (int32_t)(sizeof(s_sample) - 1), 1);
+}
+
 void MCField::recompute()
 {
 	if (!opened)
@@ -2519,26 +2547,53 @@ void MCField::recompute()
 	uint2 fheight;
 	fheight = gettextheight();
 
+	// Wrapping paragraphs that start below the visible part of the field are
+	// only estimated, as flowing them means measuring all their text. They are
+	// flowed when they are scrolled into view, or when their position is needed.
+	MCRectangle t_frect;
+	t_frect = getfrect();
+	int32_t t_y, t_bottom, t_char_width;
+	t_y = topmargin - texty;
+	t_bottom = t_frect . y + t_frect . height - getcontenty();
+	t_char_width = 0;
+	state &= ~CS_HEIGHTS_ESTIMATED;
+
+	MCParagraph *t_first_estimated;
+	t_first_estimated = NULL;
+
 	MCParagraph *pgptr = paragraphs;
 	fixeda = fixedd = 0;
-	textwidth = 0;
 	do
 	{
 		// MW-2012-01-25: [[ ParaStyles ]] Whether to flow or noflow is decided on a
 		//   per-paragraph basis.
-		pgptr -> layout();
+		if (t_y >= t_bottom && !pgptr -> getdontwrap())
+		{
+			if (t_char_width == 0)
+				t_char_width = MCFieldEstimateCharWidth(m_font);
+			pgptr -> estimate(t_char_width);
+			if (t_first_estimated == NULL)
+				t_first_estimated = pgptr;
+			state |= CS_HEIGHTS_ESTIMATED;
+		}
+		else
+			pgptr -> layout();
+		t_y += pgptr -> getheight(flags & F_FIXED_HEIGHT ? fheight : 0);
 
-		uint2 ascent, descent, width;
-		pgptr->getmaxline(width, ascent, descent);
+		uint2 ascent, descent;
+		pgptr->getmaxline(ascent, descent);
 		if (ascent > fixeda)
 			fixeda = ascent;
 		if (descent > fixedd)
 			fixedd = descent;
-		if (width > textwidth)
-			textwidth = width;
 		pgptr = pgptr->next();
 	}
 	while (pgptr != paragraphs);
+
+	// Lines that don't wrap are only measured when first needed, so computing
+	// the width of the widest one is left until something asks for it.
+	textwidth = 0;
+	state |= CS_MEASURE_PENDING;
 	if (flags & F_FIXED_HEIGHT)
 	{
 		fixedheight = fheight;
@@ -2553,6 +2608,7 @@ void MCField::recompute()
 		pgptr = pgptr->next();
 	}
 	while (pgptr != paragraphs);
+	setfirstestimated(t_first_estimated);
 	resetscrollbars(False);
 	if (MCclickfield == this)
 		MCclickfield = NULL;
@@ -2562,6 +2618,37 @@ void MCField::recompute()
 		replacecursor(False, False);
 }
 
+// Bring textwidth up to date by measuring any lines whose width was deferred
+// by recompute. Only the horizontal extent of the text depends on this.
+void MCField::measuretextwidth(void)
+{
+	if (!(state & CS_MEASURE_PENDING))
+		return;
+
+	state &= ~CS_MEASURE_PENDING;
+	if (!opened || paragraphs == NULL)
+		return;
+
+	MCParagraph *pgptr = paragraphs;
+	do
+	{
+		// Paragraphs that have only been estimated are measured when they are
+		// flowed (see layoutestimated).
+		if (pgptr->isestimated())
+		{
+			pgptr = pgptr->next();
+			continue;
+		}
+
+		uint2 width;
+		width = pgptr->getwidth();
+		if (width > textwidth)
+			textwidth = width;
+		pgptr = pgptr->next();
+	}
+	while (pgptr != paragraphs);
+}
+
 void MCField::textchanged(void)
 {
 	if (getstate(CS_IN_TEXTCHANGED))
@@ -2897,14 +2984,97 @@ void MCField::draw(MCDC *dc, const MCRectangle& p_dirty, bool p_isolated, bool p
 //  SAVING AND LOADING
 //
 
+#define FIELD_EXTRA_CARDDATASIZES (1U << 0)
+
+// The sizes of the field's card data records. These are measured by save before
+// the extended data is written, and read by extendedload so that load can defer
+// parsing the paragraphs of each record.
+static uint4 *s_fdata_sizes = nil;
+static uint4 s_fdata_size_count = 0;
+
+static void MCFieldResetCardDataSizes(void)
+{
+	MCMemoryDeleteArray(s_fdata_sizes);
+	s_fdata_sizes = nil;
+	s_fdata_size_count = 0;
+}
+
 IO_stat MCField::extendedsave(MCObjectOutputStream& p_stream, uint4 p_part)
 {
-	return defaultextendedsave(p_stream, p_part);
+	// The extended data area for a field is:
+	//   taginfo tag
+	//   if carddatasizes then
+	//     uint32_t count
+	//     uint32_t sizes[count]
+
+	uint32_t t_size, t_flags;
+	t_size = 0;
+	t_flags = 0;
+
+	if (s_fdata_size_count != 0)
+	{
+		t_flags |= FIELD_EXTRA_CARDDATASIZES;
+		t_size += 4 + 4 * s_fdata_size_count;
+	}
+
+	IO_stat t_stat;
+	t_stat = p_stream . WriteTag(t_flags, t_size);
+
+	if (t_stat == IO_NORMAL && (t_flags & FIELD_EXTRA_CARDDATASIZES))
+	{
+		t_stat = p_stream . WriteU32(s_fdata_size_count);
+		for(uint32_t i = 0; t_stat == IO_NORMAL && i < s_fdata_size_count; i++)
+			t_stat = p_stream . WriteU32(s_fdata_sizes[i]);
+	}
+
+	if (t_stat == IO_NORMAL)
+		t_stat = MCObject::extendedsave(p_stream, p_part);
+
+	return t_stat;
 }
 
-IO_stat MCField::extendedload(MCObjectInputStream& p_stream, const char *p_version, uint4 p_length)
+IO_stat MCField::extendedload(MCObjectInputStream& p_stream, const char *p_version, uint4 p_remaining)
 {
-	return defaultextendedload(p_stream, p_version, p_length);
+	IO_stat t_stat;
+	t_stat = IO_NORMAL;
+
+	if (p_remaining > 0)
+	{
+		uint4 t_flags, t_length, t_header_length;
+		t_stat = p_stream . ReadTag(t_flags, t_length, t_header_length);
+
+		if (t_stat == IO_NORMAL)
+			t_stat = p_stream . Mark();
+
+		uint32_t t_count;
+		t_count = 0;
+		if (t_stat == IO_NORMAL && (t_flags & FIELD_EXTRA_CARDDATASIZES))
+			t_stat = p_stream . ReadU32(t_count);
+
+		// Ignore a size list which doesn't fit in the tag - the card data is then
+		// just loaded as it always was.
+		if (t_stat == IO_NORMAL && t_count != 0 && t_length >= 4 && t_count <= (t_length - 4) / 4)
+		{
+			MCFieldResetCardDataSizes();
+			if (!MCMemoryNewArray(t_count, s_fdata_sizes))
+				t_stat = IO_ERROR;
+			for(uint32_t i = 0; t_stat == IO_NORMAL && i < t_count; i++)
+				t_stat = p_stream . ReadU32(s_fdata_sizes[i]);
+			if (t_stat == IO_NORMAL)
+				s_fdata_size_count = t_count;
+		}
+
+		if (t_stat == IO_NORMAL)
+			t_stat = p_stream . Skip(t_length);
+
+		if (t_stat == IO_NORMAL)
+			p_remaining -= t_length + t_header_length;
+	}
+
+	if (t_stat == IO_NORMAL)
+		t_stat = MCObject::extendedload(p_stream, p_version, p_remaining);
+
+	return t_stat;
 }
 
 IO_stat MCField::save(IO_handle stream, uint4 p_part, bool p_force_ext)
@@ -2916,45 +3086,102 @@ IO_stat MCField::save(IO_handle stream, uint4 p_part, bool p_force_ext)
 	if ((stat = IO_write_uint1(OT_FIELD, stream)) != IO_NORMAL)
 		return stat;
 
-	if ((stat = MCObject::save(stream, p_part, p_force_ext)) != IO_NORMAL)
-		return stat;
-
-	if ((stat = IO_write_int2(leftmargin, stream)) != IO_NORMAL)
-		return stat;
-	if ((stat = IO_write_int2(rightmargin, stream)) != IO_NORMAL)
-		return stat;
-	if ((stat = IO_write_int2(topmargin, stream)) != IO_NORMAL)
-		return stat;
-	if ((stat = IO_write_int2(bottommargin, stream)) != IO_NORMAL)
-		return stat;
-	if ((stat = IO_write_int2(indent, stream)) != IO_NORMAL)
-		return stat;
-	if (flags & F_TABS)
+	if (fdata != NULL && opened)
 	{
-		if ((stat = IO_write_uint2(ntabs, stream)) != IO_NORMAL)
-			return stat;
-		uint2 i;
-		for (i = 0 ; i < ntabs ; i++)
-			if ((stat = IO_write_uint2(tabs[i], stream)) != IO_NORMAL)
-				return stat;
+		resetparagraphs();
+		fdata->setparagraphs(paragraphs);
 	}
-	if ((stat = savepropsets(stream)) != IO_NORMAL)
-		return stat;
-	if (fdata != NULL)
-	{
-		if (opened)
+
+	// If the field has text on more than one card, the card data is written out
+	// in advance so that the size of each record can be put in the extended data.
+	// This lets the card data be loaded without parsing its paragraphs.
+	char *t_fdata_buffer;
+	uint4 t_fdata_length;
+	t_fdata_buffer = nil;
+	t_fdata_length = 0;
+	MCFieldResetCardDataSizes();
+	if (fdata != NULL && fdata -> next() != fdata && p_part == 0 &&
+		!getflag(F_SHARED_TEXT) && MCstackfileversion >= 2700)
+	{
+		uint4 t_count;
+		t_count = 0;
+		MCCdata *tptr = fdata;
+		do
 		{
-			resetparagraphs();
-			fdata->setparagraphs(paragraphs);
+			t_count++;
+			tptr = tptr->next();
+		}
+		while (tptr != fdata);
+
+		if (!MCMemoryNewArray(t_count, s_fdata_sizes))
+			return IO_ERROR;
+
+		IO_handle t_fdata_stream;
+		t_fdata_stream = MCS_fakeopenwrite();
+
+		stat = IO_NORMAL;
+		do
+		{
+			uint4 t_start;
+			t_start = MCS_faketell(t_fdata_stream);
+			if ((stat = tptr->save(t_fdata_stream, OT_FDATA, 0, this)) != IO_NORMAL)
+				break;
+
+			// The size doesn't include the OT_FDATA tag.
+			s_fdata_sizes[s_fdata_size_count++] = MCS_faketell(t_fdata_stream) - t_start - 1;
+			tptr = tptr->next();
+		}
+		while (tptr != fdata);
+
+		MCS_fakeclosewrite(t_fdata_stream, t_fdata_buffer, t_fdata_length);
+
+		if (stat != IO_NORMAL)
+		{
+			free(t_fdata_buffer);
+			MCFieldResetCardDataSizes();
+			return stat;
 		}
+	}
+
+	stat = MCObject::save(stream, p_part, s_fdata_size_count != 0 || p_force_ext);
+	MCFieldResetCardDataSizes();
+
+	if (stat == IO_NORMAL)
+		stat = IO_write_int2(leftmargin, stream);
+	if (stat == IO_NORMAL)
+		stat = IO_write_int2(rightmargin, stream);
+	if (stat == IO_NORMAL)
+		stat = IO_write_int2(topmargin, stream);
+	if (stat == IO_NORMAL)
+		stat = IO_write_int2(bottommargin, stream);
+	if (stat == IO_NORMAL)
+		stat = IO_write_int2(indent, stream);
+	if (stat == IO_NORMAL && (flags & F_TABS))
+	{
+		stat = IO_write_uint2(ntabs, stream);
+		for (uint2 i = 0 ; stat == IO_NORMAL && i < ntabs ; i++)
+			stat = IO_write_uint2(tabs[i], stream);
+	}
+	if (stat == IO_NORMAL)
+		stat = savepropsets(stream);
+
+	bool t_fdata_written;
+	t_fdata_written = t_fdata_buffer != nil;
+	if (stat == IO_NORMAL && t_fdata_written)
+		stat = IO_write(t_fdata_buffer, sizeof(char), t_fdata_length, stream);
+	free(t_fdata_buffer);
 
+	if (stat != IO_NORMAL)
+		return stat;
+	if (fdata != NULL && !t_fdata_written)
+	{
 		// If p_part != 0, and the field is shared, we only want to save the '0' part.
 		if (getflag(F_SHARED_TEXT))
 		{
 			MCCdata *tptr;
 			tptr = getcarddata(fdata, 0, False);
 			if (tptr != NULL)
-				if ((stat = tptr -> save(stream, OT_FDATA, 0)) != IO_NORMAL)
+				if ((stat = tptr -> save(stream, OT_FDATA, 0, this)) != IO_NORMAL)
 					return stat;
 		}
 		else
@@ -2962,7 +3189,7 @@ IO_stat MCField::save(IO_handle stream, uint4 p_part, bool p_force_ext)
 			MCCdata *tptr = fdata;
 			do
 			{
-				if ((stat = tptr->save(stream, OT_FDATA, p_part)) != IO_NORMAL)
+				if ((stat = tptr->save(stream, OT_FDATA, p_part, this)) != IO_NORMAL)
 					return stat;
 				tptr = tptr->next();
 			}
@@ -2997,6 +3224,9 @@ IO_stat MCField::load(IO_handle stream, const char *version)
 {
 	IO_stat stat;
 
+	// Any card data sizes will be set by extendedload.
+	MCFieldResetCardDataSizes();
+
 	if ((stat = MCObject::load(stream, version)) != IO_NORMAL)
 		return stat;
 	if ((stat = IO_read_int2(&leftmargin, stream)) != IO_NORMAL)
@@ -3029,6 +3259,8 @@ IO_stat MCField::load(IO_handle stream, const char *version)
 		flags |= F_DONT_WRAP;
 	if ((stat = loadpropsets(stream)) != IO_NORMAL)
 		return stat;
+	uint4 t_fdata_index;
+	t_fdata_index = 0;
 	while (True)
 	{
 		uint1 type;
@@ -3036,8 +3268,15 @@ IO_stat MCField::load(IO_handle stream, const char *version)
 			return stat;
 		if (type == OT_FDATA)
 		{
+			// If the size of the record is known, its paragraphs are only parsed
+			// when first needed.
+			uint4 t_length;
+			t_length = 0;
+			if (t_fdata_index < s_fdata_size_count)
+				t_length = s_fdata_sizes[t_fdata_index++];
+
 			MCCdata *newfdata = new MCCdata;
-			if ((stat = newfdata->load(stream, this, version)) != IO_NORMAL)
+			if ((stat = newfdata->load(stream, this, version, t_length)) != IO_NORMAL)
 			{
 				delete newfdata;
 				return stat;
@@ -3083,6 +3322,9 @@ IO_stat MCField::load(IO_handle stream, const char *version)
 				break;
 			}
 	}
+
+	MCFieldResetCardDataSizes();
+
 	return IO_NORMAL;
 }
 
@@ -160,6 +160,12 @@ typedef bool (*MCFieldExportCallback)(void *context, MCFieldExportEventType even
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The start offsets of a list of paragraphs, used to find the paragraph an
+// index is in without walking the list (see fields.cpp).
+struct MCFieldParagraphIndex;
+
+////////////////////////////////////////////////////////////////////////////////
+
 class MCField : public MCControl
 {
 	friend class MCHcfield;
@@ -191,6 +197,7 @@ class MCField : public MCControl
 	MCScrollbar *vscrollbar;
 	MCScrollbar *hscrollbar;
 	char *label;
+	MCFieldParagraphIndex *pgindex;
 	
 	static int2 clickx;
 	static int2 clicky;
@@ -365,6 +372,20 @@ public:
 	// MW-2012-02-08: [[ Field Indices ]] The 'index' parameter, if non-nil, will contain
 	//   the 1-based index of the returned paragraph (i.e. the one si resides in).
 	MCParagraph *indextoparagraph(MCParagraph *top, int4 &si, int4 &ei, int* index = nil);
+	// Returns the paragraph index for the list starting at 'top'. The index is
+	//   kept up to date as the paragraphs change, but if there is none for the
+	//   list it is only built if 'p_build' is true, or it has been asked for
+	//   before.
+	MCFieldParagraphIndex *getparagraphindex(MCParagraph *top, bool p_build);
+	void deleteparagraphindex(void);
+	// Fetches the index of the paragraphs in the given part and the number of
+	//   paragraphs in it. The index remains valid until the field's paragraphs
+	//   change.
+	bool getnativeparagraphindex(uint4 parid, bool p_build, MCFieldParagraphIndex*& r_index, uint4& r_count);
+	// Returns the offset of the given (0-based) paragraph of the index in its
+	//   native text, that of paragraph 'count' being the length of the text
+	//   plus one.
+	uint4 getnativeparagraphoffset(MCFieldParagraphIndex *p_index, uint4 p_paragraph);
 	void indextocharacter(int4 &si);
 	uint4 ytooffset(int4 y);
 	int4 paragraphtoy(MCParagraph *target);
@@ -476,6 +497,19 @@ public:
 	
 	// MW-2012-02-08: [[ TextChanged ]] This causes a 'textChanged' message to be sent.
 	void textchanged(void);
+
+	// Make sure textwidth accounts for every line, measuring those whose width
+	//   was deferred by recompute.
+	void measuretextwidth(void);
+
+	// Flow the paragraphs whose height recompute only estimated, down to and
+	//   including 'p_target' (if not NULL) and any that start above 'p_bottom'
+	//   (in the same co-ords as cury). Text height and the positions of the
+	//   focused and first paragraphs are adjusted to match.
+	void layoutestimated(MCParagraph *p_target, int32_t p_bottom);
+	// Records the first paragraph recompute only estimated the height of, so
+	//   that layoutestimated can start from there.
+	void setfirstestimated(MCParagraph *p_paragraph);
 	
 	// MW-2012-02-20: [[ FieldExport ]] Iterates over paragraphs and runs in the field between the
 	//   start and end indices, invoking the callback based on the provided flags.
@@ -702,6 +702,7 @@ void MCField::positioncursor(Boolean force, Boolean goal, MCRectangle &drect, in
 				{
 					// MW-2012-03-13: [[ Bug ]] Make sure we scroll the field towards
 					//   the left edge if the longest line has got cropped.
+					measuretextwidth();
 					dx = (getcontentx() + textwidth + rightmargin - DEFAULT_BORDER) - (mrect . x + mrect . width);
 					if (dx < 0)
 					{
@@ -992,6 +993,10 @@ void MCField::drawrect(MCDC *dc, const MCRectangle &dirty)
 			d = fixedd;
 		}
 
+		// Any paragraphs in view whose height was only estimated (for
+		// example, if those above have shrunk) must be flowed before drawing.
+		layoutestimated(NULL, trect . y + trect . height - getcontenty());
+
 		int32_t pgheight;
 		do
 		{
@@ -1112,6 +1117,10 @@ void MCField::draw3dhilite(MCDC *dc, const MCRectangle &trect)
 
 void MCField::setfocus(int2 x, int2 y)
 {
+	// Make sure the paragraphs down to the location have been flowed, rather
+	// than estimated.
+	layoutestimated(NULL, y - getcontenty() + 1);
+
 	MCParagraph *spg = focusedparagraph;
 	int4 sy = focusedy;
 	state &= ~(CS_DELETING | CS_PARTIAL);
@@ -1767,6 +1776,7 @@ void MCField::fdel(Field_translations function, const char *string, KeySym key)
 	MCRedrawLockScreen();
 
 	removecursor();
+	measuretextwidth();
 	uint2 oldwidth = focusedparagraph->getwidth();
 	if (!deleteselection(False))
 	{
@@ -2150,6 +2160,7 @@ void MCField::fmove(Field_translations function, const char *string, KeySym key)
 				break;
 		case FT_END:
 		case FT_EOL:
+			measuretextwidth();
 			drect.x = textwidth + leftmargin + indent + rect.width;
 			break;
 		case FT_BOF:
@@ -2157,6 +2168,7 @@ void MCField::fmove(Field_translations function, const char *string, KeySym key)
 			drect.y = -texty - rect.height;
 			break;
 		case FT_EOF:
+			measuretextwidth();
 			drect.x = textwidth + leftmargin;
 			drect.y = textheight + topmargin;
 			break;
@@ -753,6 +753,7 @@ bool MCField::importblock(MCParagraph *p_paragraph, const MCFieldCharacterStyle&
 	// Copy across the bytes of the text.
 	memcpy(p_paragraph -> text + t_block -> index, p_bytes, t_block -> size);
 	p_paragraph -> textsize += t_block -> size;
+	p_paragraph -> indexchanged();
 	
 	// Import the block attributes.
 	t_block -> importattrs(p_style);
@@ -1086,6 +1087,7 @@ bool MCField::converttoparagraphs(void *p_context, const MCTextParagraph *p_para
 						
 					memcpy(t_paragraph -> text + t_paragraph -> textsize, t_input_text, t_used * 2);
 					t_paragraph -> textsize += t_used * 2;
+					t_paragraph -> indexchanged();
 
 					t_block -> size += t_used * 2;
 					t_block -> flags |= F_HAS_UNICODE;
@@ -1097,6 +1099,7 @@ bool MCField::converttoparagraphs(void *p_context, const MCTextParagraph *p_para
 						t_made = MCU_min(t_made, 65535U - t_paragraph -> textsize);
 						
 					t_paragraph -> textsize += t_made;
+					t_paragraph -> indexchanged();
 
 					t_block -> size += t_made;
 					t_block -> flags &= ~F_HAS_UNICODE;
@@ -16,6 +16,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "prefix.h"
 
+#include "core.h"
 #include "globdefs.h"
 #include "filedefs.h"
 #include "objdefs.h"
@@ -107,7 +108,7 @@ Exec_stat MCField::sort(MCExecPoint &ep, uint4 parid, Chunk_term type,
 		if (opened && parid == 0)
 			pgptr = paragraphs;
 		else
-			pgptr = getcarddata(fdata, parid, True)->getparagraphs();
+			pgptr = getcarddata(fdata, parid, True)->getparagraphs(this);
 
 		// MW-2008-02-29: [[ Bug 5763 ]] The crash report seems to suggest a problem with
 		//   a NULL-pointer access on a paragraph - this is the only place I can see this
@@ -203,7 +204,7 @@ Boolean MCField::find(MCExecPoint &ep, uint4 cardid, Find_mode mode,
 	{
 		if (tptr->getid() == cardid)
 		{
-			MCParagraph *paragraphptr = tptr->getparagraphs();
+			MCParagraph *paragraphptr = tptr->getparagraphs(this);
 			MCParagraph *tpgptr = paragraphptr;
 			uint2 flength = tofind.getlength();
 			int4 toffset, oldoffset;
@@ -304,10 +305,508 @@ void MCField::verifyindex(MCParagraph *top, int4 &si, bool p_is_end)
 	si = (oldindex - si) + bptr->verifyindex(si, p_is_end);
 }
 
+// The paragraph index records the paragraphs of a list in order, in chunks of
+// up to PARAGRAPH_CHUNK_MAX, with each paragraph pointing back at its chunk.
+// This lets it be kept up to date as paragraphs are linked in, unlinked and
+// changed, each change only touching one chunk. Each chunk holds the size of
+// its paragraphs with a CR after each - both in bytes (as used by field
+// indices) and in chars (as used by the field's native text) - and their
+// height, and the index holds the running totals of the chunk sizes, heights
+// and paragraph counts, with an extra entry at the end for the whole list. The
+// totals are recomputed, from the first chunk that has changed, when they are
+// next needed.
+#define PARAGRAPH_CHUNK_MAX 128
+
+struct MCFieldParagraphChunk
+{
+	MCFieldParagraphIndex *index;
+	uint4 position;
+	uint4 count;
+	// Set when the sizes need recomputing.
+	bool dirty;
+	uint4 size;
+	uint4 nativesize;
+	uint4 height;
+	MCParagraph *paragraphs[PARAGRAPH_CHUNK_MAX];
+};
+
+struct MCFieldParagraphIndex
+{
+	MCField *field;
+	MCFieldParagraphChunk **chunks;
+	uint4 chunkcount;
+	uindex_t chunkcapacity;
+	// The totals before each chunk, those up to entry 'valid' being up to date.
+	uint4 *counts;
+	uint4 *offsets;
+	uint4 *nativeoffsets;
+	uint4 *heights;
+	uindex_t countscapacity;
+	uindex_t offsetscapacity;
+	uindex_t nativeoffsetscapacity;
+	uindex_t heightscapacity;
+	uint4 valid;
+	// The fixed line height the heights are for (see MCParagraph::getheight).
+	uint2 fixedheight;
+	// The first paragraph whose height may only be estimated - every paragraph
+	// above it has been flowed (see layoutestimated).
+	MCParagraph *firstestimated;
+	// The list the index was last asked for, but not built, for.
+	MCParagraph *misshead;
+};
+
+static MCParagraph *MCFieldParagraphIndexHead(MCFieldParagraphIndex *self)
+{
+	if (self == NULL || self -> chunkcount == 0)
+		return NULL;
+	return self -> chunks[0] -> paragraphs[0];
+}
+
+static uint4 MCFieldParagraphChunkFind(MCFieldParagraphChunk *self, MCParagraph *p_paragraph)
+{
+	uint4 t_slot;
+	for(t_slot = 0; self -> paragraphs[t_slot] != p_paragraph; t_slot++)
+		;
+	return t_slot;
+}
+
+static bool MCFieldParagraphIndexContains(MCFieldParagraphIndex *self, MCParagraph *p_paragraph)
+{
+	return p_paragraph -> getindexchunk() != NULL && p_paragraph -> getindexchunk() -> index == self;
+}
+
+// Returns the (0-based) position of an indexed paragraph in its list. The
+// totals must be up to date.
+static uint4 MCFieldParagraphIndexOrdinal(MCParagraph *p_paragraph)
+{
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = p_paragraph -> getindexchunk();
+	return t_chunk -> index -> counts[t_chunk -> position] + MCFieldParagraphChunkFind(t_chunk, p_paragraph);
+}
+
+// Returns the height of the paragraphs above an indexed paragraph in its list.
+// The totals must be up to date.
+static uint4 MCFieldParagraphIndexHeightBefore(MCParagraph *p_paragraph)
+{
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = p_paragraph -> getindexchunk();
+
+	uint4 t_height;
+	t_height = t_chunk -> index -> heights[t_chunk -> position];
+	for(uint4 i = 0; t_chunk -> paragraphs[i] != p_paragraph; i++)
+		t_height += t_chunk -> paragraphs[i] -> getheight(t_chunk -> index -> fixedheight);
+	return t_height;
+}
+
+// Returns the position of the last chunk whose total before it is at most the
+// given value.
+static uint4 MCFieldParagraphIndexFindChunk(MCFieldParagraphIndex *self, const uint4 *p_totals, uint4 p_value)
+{
+	uint4 t_low, t_high;
+	t_low = 0;
+	t_high = self -> chunkcount - 1;
+	while (t_low < t_high)
+	{
+		uint4 t_mid;
+		t_mid = t_low + (t_high - t_low + 1) / 2;
+		if (p_totals[t_mid] <= p_value)
+			t_low = t_mid;
+		else
+			t_high = t_mid - 1;
+	}
+	return t_low;
+}
+
+static void MCFieldParagraphIndexClear(MCFieldParagraphIndex *self)
+{
+	for(uint4 i = 0; i < self -> chunkcount; i++)
+	{
+		MCFieldParagraphChunk *t_chunk;
+		t_chunk = self -> chunks[i];
+		for(uint4 j = 0; j < t_chunk -> count; j++)
+			t_chunk -> paragraphs[j] -> setindexchunk(NULL);
+		MCMemoryDelete(t_chunk);
+	}
+	self -> chunkcount = 0;
+	self -> valid = 0;
+	self -> firstestimated = NULL;
+}
+
+// The heights of the paragraphs depend on the field's fixed line height, so
+// they all have to be recomputed if that changes.
+static void MCFieldParagraphIndexSetFixedHeight(MCFieldParagraphIndex *self, uint2 p_fixed_height)
+{
+	if (self -> fixedheight == p_fixed_height)
+		return;
+
+	self -> fixedheight = p_fixed_height;
+	for(uint4 i = 0; i < self -> chunkcount; i++)
+		self -> chunks[i] -> dirty = true;
+	self -> valid = 0;
+}
+
+// Adds an empty chunk at the given position, returning false if there is no
+// memory for it.
+static bool MCFieldParagraphIndexInsertChunk(MCFieldParagraphIndex *self, uint4 p_position, MCFieldParagraphChunk*& r_chunk)
+{
+	if (self -> chunkcount + 1 > self -> chunkcapacity)
+	{
+		uindex_t t_capacity, t_chunks_capacity;
+		t_capacity = MCU_max(self -> chunkcapacity * 2, 16U);
+		t_chunks_capacity = self -> chunkcapacity;
+		if (!MCMemoryResizeArray(t_capacity, self -> chunks, t_chunks_capacity) ||
+			!MCMemoryResizeArray(t_capacity + 1, self -> counts, self -> countscapacity) ||
+			!MCMemoryResizeArray(t_capacity + 1, self -> offsets, self -> offsetscapacity) ||
+			!MCMemoryResizeArray(t_capacity + 1, self -> nativeoffsets, self -> nativeoffsetscapacity) ||
+			!MCMemoryResizeArray(t_capacity + 1, self -> heights, self -> heightscapacity))
+			return false;
+		self -> chunkcapacity = t_capacity;
+	}
+
+	MCFieldParagraphChunk *t_chunk;
+	if (!MCMemoryNew(t_chunk))
+		return false;
+	t_chunk -> index = self;
+	t_chunk -> dirty = true;
+
+	MCMemoryMove(self -> chunks + p_position + 1, self -> chunks + p_position, (self -> chunkcount - p_position) * sizeof(MCFieldParagraphChunk *));
+	self -> chunks[p_position] = t_chunk;
+	self -> chunkcount += 1;
+	for(uint4 i = p_position; i < self -> chunkcount; i++)
+		self -> chunks[i] -> position = i;
+	self -> valid = MCU_min(self -> valid, p_position);
+
+	r_chunk = t_chunk;
+	return true;
+}
+
+static void MCFieldParagraphIndexRemoveChunk(MCFieldParagraphIndex *self, uint4 p_position)
+{
+	MCMemoryDelete(self -> chunks[p_position]);
+	MCMemoryMove(self -> chunks + p_position, self -> chunks + p_position + 1, (self -> chunkcount - p_position - 1) * sizeof(MCFieldParagraphChunk *));
+	self -> chunkcount -= 1;
+	for(uint4 i = p_position; i < self -> chunkcount; i++)
+		self -> chunks[i] -> position = i;
+	self -> valid = MCU_min(self -> valid, p_position);
+}
+
+// Brings the totals up to date. Fetching the size of a paragraph which has just
+// been loaded initializes its text, which marks its chunk as changed again, so
+// this carries on until no chunk has changed.
+static void MCFieldParagraphIndexUpdate(MCFieldParagraphIndex *self)
+{
+	while(self -> valid < self -> chunkcount)
+	{
+		uint4 t_position;
+		t_position = self -> valid;
+
+		MCFieldParagraphChunk *t_chunk;
+		t_chunk = self -> chunks[t_position];
+		if (t_chunk -> dirty)
+		{
+			t_chunk -> dirty = false;
+
+			uint4 t_size, t_native_size, t_height;
+			t_size = 0;
+			t_native_size = 0;
+			t_height = 0;
+			for(uint4 i = 0; i < t_chunk -> count; i++)
+			{
+				t_size += t_chunk -> paragraphs[i] -> gettextsizecr();
+				t_native_size += t_chunk -> paragraphs[i] -> gettextlength() + 1;
+				t_height += t_chunk -> paragraphs[i] -> getheight(self -> fixedheight);
+			}
+			t_chunk -> size = t_size;
+			t_chunk -> nativesize = t_native_size;
+			t_chunk -> height = t_height;
+			continue;
+		}
+
+		self -> counts[t_position + 1] = self -> counts[t_position] + t_chunk -> count;
+		self -> offsets[t_position + 1] = self -> offsets[t_position] + t_chunk -> size;
+		self -> nativeoffsets[t_position + 1] = self -> nativeoffsets[t_position] + t_chunk -> nativesize;
+		self -> heights[t_position + 1] = self -> heights[t_position] + t_chunk -> height;
+		self -> valid = t_position + 1;
+	}
+}
+
+void MCFieldParagraphIndexChanged(MCParagraph *p_paragraph)
+{
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = p_paragraph -> getindexchunk();
+	t_chunk -> dirty = true;
+	t_chunk -> index -> valid = MCU_min(t_chunk -> index -> valid, t_chunk -> position);
+}
+
+void MCFieldParagraphIndexInsert(MCParagraph *p_anchor, MCParagraph *p_paragraph, bool p_before)
+{
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = p_anchor -> getindexchunk();
+
+	MCFieldParagraphIndex *self;
+	self = t_chunk -> index;
+
+	uint4 t_slot;
+	t_slot = MCFieldParagraphChunkFind(t_chunk, p_anchor);
+	if (!p_before)
+		t_slot += 1;
+
+	// If the chunk is full, a paragraph after its end goes in a new chunk (so a
+	// list being appended to is indexed in full chunks), otherwise the chunk is
+	// split in two.
+	if (t_chunk -> count == PARAGRAPH_CHUNK_MAX)
+	{
+		MCFieldParagraphChunk *t_new_chunk;
+		if (!MCFieldParagraphIndexInsertChunk(self, t_chunk -> position + 1, t_new_chunk))
+		{
+			self -> field -> deleteparagraphindex();
+			return;
+		}
+
+		if (t_slot == PARAGRAPH_CHUNK_MAX)
+		{
+			t_chunk = t_new_chunk;
+			t_slot = 0;
+		}
+		else
+		{
+			uint4 t_half;
+			t_half = PARAGRAPH_CHUNK_MAX / 2;
+			t_new_chunk -> count = PARAGRAPH_CHUNK_MAX - t_half;
+			MCMemoryCopy(t_new_chunk -> paragraphs, t_chunk -> paragraphs + t_half, t_new_chunk -> count * sizeof(MCParagraph *));
+			for(uint4 i = 0; i < t_new_chunk -> count; i++)
+				t_new_chunk -> paragraphs[i] -> setindexchunk(t_new_chunk);
+			t_chunk -> count = t_half;
+			t_chunk -> dirty = true;
+			self -> valid = MCU_min(self -> valid, t_chunk -> position);
+
+			if (t_slot > t_half)
+			{
+				t_chunk = t_new_chunk;
+				t_slot -= t_half;
+			}
+		}
+	}
+
+	MCMemoryMove(t_chunk -> paragraphs + t_slot + 1, t_chunk -> paragraphs + t_slot, (t_chunk -> count - t_slot) * sizeof(MCParagraph *));
+	t_chunk -> paragraphs[t_slot] = p_paragraph;
+	t_chunk -> count += 1;
+	p_paragraph -> setindexchunk(t_chunk);
+
+	MCFieldParagraphIndexChanged(p_paragraph);
+}
+
+void MCFieldParagraphIndexRemove(MCParagraph *p_paragraph)
+{
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = p_paragraph -> getindexchunk();
+
+	MCFieldParagraphIndex *self;
+	self = t_chunk -> index;
+
+	// Every paragraph above the one after the first estimated one has still
+	// been flowed.
+	if (p_paragraph == self -> firstestimated)
+	{
+		self -> firstestimated = p_paragraph -> next();
+		if (self -> firstestimated == p_paragraph || self -> firstestimated == MCFieldParagraphIndexHead(self))
+			self -> firstestimated = NULL;
+	}
+
+	uint4 t_slot;
+	t_slot = MCFieldParagraphChunkFind(t_chunk, p_paragraph);
+	MCMemoryMove(t_chunk -> paragraphs + t_slot, t_chunk -> paragraphs + t_slot + 1, (t_chunk -> count - t_slot - 1) * sizeof(MCParagraph *));
+	t_chunk -> count -= 1;
+	p_paragraph -> setindexchunk(NULL);
+
+	// Chunks are never left empty, and a chunk which has become small is merged
+	// with the next so that deleting many paragraphs doesn't leave the index
+	// with many more chunks than it needs.
+	if (t_chunk -> count == 0)
+	{
+		MCFieldParagraphIndexRemoveChunk(self, t_chunk -> position);
+		return;
+	}
+
+	if (t_chunk -> position + 1 < self -> chunkcount)
+	{
+		MCFieldParagraphChunk *t_next;
+		t_next = self -> chunks[t_chunk -> position + 1];
+		if (t_chunk -> count + t_next -> count <= PARAGRAPH_CHUNK_MAX / 2)
+		{
+			MCMemoryCopy(t_chunk -> paragraphs + t_chunk -> count, t_next -> paragraphs, t_next -> count * sizeof(MCParagraph *));
+			for(uint4 i = 0; i < t_next -> count; i++)
+				t_next -> paragraphs[i] -> setindexchunk(t_chunk);
+			t_chunk -> count += t_next -> count;
+			MCFieldParagraphIndexRemoveChunk(self, t_next -> position);
+		}
+	}
+
+	t_chunk -> dirty = true;
+	self -> valid = MCU_min(self -> valid, t_chunk -> position);
+}
+
+void MCFieldParagraphIndexDiscard(MCParagraph *p_paragraph)
+{
+	p_paragraph -> getindexchunk() -> index -> field -> deleteparagraphindex();
+}
+
+MCFieldParagraphIndex *MCField::getparagraphindex(MCParagraph *top, bool p_build)
+{
+	if (top == NULL)
+		return NULL;
+
+	if (top == MCFieldParagraphIndexHead(pgindex))
+	{
+		MCFieldParagraphIndexSetFixedHeight(pgindex, fixedheight);
+		MCFieldParagraphIndexUpdate(pgindex);
+		return pgindex;
+	}
+
+	if (pgindex == NULL)
+	{
+		if (!MCMemoryNew(pgindex))
+			return NULL;
+		pgindex -> field = this;
+	}
+
+	// Building the index costs about as much as a walk through the paragraphs,
+	// so only do it once the same list has been looked up twice (i.e. when it
+	// will get used). After that it is kept up to date.
+	if (!p_build && pgindex -> misshead != top)
+	{
+		pgindex -> misshead = top;
+		return NULL;
+	}
+	pgindex -> misshead = NULL;
+
+	// The index only records one list, so forget any other.
+	MCFieldParagraphIndexClear(pgindex);
+
+	// Chunks are filled to three-quarters, leaving room to insert paragraphs
+	// without splitting them.
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = NULL;
+	MCParagraph *t_paragraph;
+	t_paragraph = top;
+	do
+	{
+		if (t_paragraph -> getindexchunk() != NULL)
+			MCFieldParagraphIndexDiscard(t_paragraph);
+
+		if (t_chunk == NULL || t_chunk -> count == PARAGRAPH_CHUNK_MAX * 3 / 4)
+			if (!MCFieldParagraphIndexInsertChunk(pgindex, pgindex -> chunkcount, t_chunk))
+			{
+				deleteparagraphindex();
+				return NULL;
+			}
+
+		t_chunk -> paragraphs[t_chunk -> count++] = t_paragraph;
+		t_paragraph -> setindexchunk(t_chunk);
+		t_paragraph = t_paragraph -> next();
+	}
+	while(t_paragraph != top);
+
+	pgindex -> fixedheight = fixedheight;
+	MCFieldParagraphIndexUpdate(pgindex);
+
+	return pgindex;
+}
+
+void MCField::deleteparagraphindex(void)
+{
+	if (pgindex == NULL)
+		return;
+
+	MCFieldParagraphIndexClear(pgindex);
+	MCMemoryDeleteArray(pgindex -> chunks);
+	MCMemoryDeleteArray(pgindex -> counts);
+	MCMemoryDeleteArray(pgindex -> offsets);
+	MCMemoryDeleteArray(pgindex -> nativeoffsets);
+	MCMemoryDeleteArray(pgindex -> heights);
+	MCMemoryDelete(pgindex);
+	pgindex = NULL;
+}
+
+bool MCField::getnativeparagraphindex(uint4 parid, bool p_build, MCFieldParagraphIndex*& r_index, uint4& r_count)
+{
+	MCFieldParagraphIndex *t_index;
+	t_index = getparagraphindex(resolveparagraphs(parid), p_build);
+	if (t_index == NULL)
+		return false;
+
+	r_index = t_index;
+	r_count = t_index -> counts[t_index -> chunkcount];
+
+	return true;
+}
+
+uint4 MCField::getnativeparagraphoffset(MCFieldParagraphIndex *p_index, uint4 p_paragraph)
+{
+	MCFieldParagraphIndexUpdate(p_index);
+
+	if (p_paragraph >= p_index -> counts[p_index -> chunkcount])
+		return p_index -> nativeoffsets[p_index -> chunkcount];
+
+	uint4 t_position;
+	t_position = MCFieldParagraphIndexFindChunk(p_index, p_index -> counts, p_paragraph);
+
+	MCFieldParagraphChunk *t_chunk;
+	t_chunk = p_index -> chunks[t_position];
+
+	uint4 t_offset;
+	t_offset = p_index -> nativeoffsets[t_position];
+	for(uint4 i = 0; i < p_paragraph - p_index -> counts[t_position]; i++)
+		t_offset += t_chunk -> paragraphs[i] -> gettextlength() + 1;
+
+	return t_offset;
+}
+
 // MW-2012-02-08: [[ Field Indices ]] If 'index' is non-nil then we return the
 //   1-based index of the paragraph that si resides in.
 MCParagraph *MCField::indextoparagraph(MCParagraph *top, int4 &si, int4 &ei, int4* index)
 {
+	// If the paragraphs are indexed, binary search for the chunk containing si
+	// rather than walking the list. As with the walk, an index past the end is
+	// clamped to the end of the last paragraph.
+	MCFieldParagraphIndex *t_pgindex;
+	t_pgindex = NULL;
+	if (top == paragraphs || top == MCFieldParagraphIndexHead(pgindex))
+		t_pgindex = getparagraphindex(top, false);
+	if (t_pgindex != NULL)
+	{
+		uint4 t_position, t_slot;
+		MCFieldParagraphChunk *t_chunk;
+		if (si >= (int4)t_pgindex -> offsets[t_pgindex -> chunkcount])
+		{
+			t_position = t_pgindex -> chunkcount - 1;
+			t_chunk = t_pgindex -> chunks[t_position];
+			t_slot = t_chunk -> count - 1;
+			si = ei = t_chunk -> paragraphs[t_slot] -> gettextsizecr() - 1;
+		}
+		else
+		{
+			t_position = MCFieldParagraphIndexFindChunk(t_pgindex, t_pgindex -> offsets, si < 0 ? 0 : si);
+			t_chunk = t_pgindex -> chunks[t_position];
+			si -= t_pgindex -> offsets[t_position];
+			ei -= t_pgindex -> offsets[t_position];
+
+			t_slot = 0;
+			uint2 l = t_chunk -> paragraphs[0] -> gettextsizecr();
+			while (si >= l && t_slot + 1 < t_chunk -> count)
+			{
+				si -= l;
+				ei -= l;
+				t_slot += 1;
+				l = t_chunk -> paragraphs[t_slot] -> gettextsizecr();
+			}
+		}
+
+		if (index != nil)
+			*index = t_pgindex -> counts[t_position] + t_slot + 1;
+		return t_chunk -> paragraphs[t_slot];
+	}
+
 	int4 t_index;
 	uint2 l = top->gettextsizecr();
 	MCParagraph *pgptr = top;
@@ -333,6 +832,40 @@ MCParagraph *MCField::indextoparagraph(MCParagraph *top, int4 &si, int4 &ei, int
 
 uint4 MCField::ytooffset(int4 y)
 {
+	// If the paragraphs are indexed, binary search for the chunk containing y
+	// and walk from the start of that.
+	MCFieldParagraphIndex *t_pgindex;
+	t_pgindex = getparagraphindex(paragraphs, false);
+	if (t_pgindex != NULL && y <= (int4)t_pgindex -> heights[t_pgindex -> chunkcount])
+	{
+		uint4 t_low, t_high;
+		t_low = 0;
+		t_high = t_pgindex -> chunkcount - 1;
+		while (t_low < t_high)
+		{
+			uint4 t_mid;
+			t_mid = t_low + (t_high - t_low) / 2;
+			if ((int4)t_pgindex -> heights[t_mid + 1] >= y)
+				t_high = t_mid;
+			else
+				t_low = t_mid + 1;
+		}
+
+		MCFieldParagraphChunk *t_chunk;
+		t_chunk = t_pgindex -> chunks[t_low];
+		y -= t_pgindex -> heights[t_low];
+
+		uint4 si = t_pgindex -> offsets[t_low];
+		for(uint4 i = 0; i + 1 < t_chunk -> count; i++)
+		{
+			y -= t_chunk -> paragraphs[i] -> getheight(fixedheight);
+			if (y <= 0)
+				break;
+			si += t_chunk -> paragraphs[i] -> gettextsizecr();
+		}
+		return si;
+	}
+
 	uint4 si = 0;
 	MCParagraph *tptr = paragraphs;
 	while (True)
@@ -348,6 +881,18 @@ uint4 MCField::ytooffset(int4 y)
 
 int4 MCField::paragraphtoy(MCParagraph *target)
 {
+	// The position of the target is only exact once every paragraph above it
+	// has been flowed.
+	layoutestimated(target, INT32_MIN);
+
+	// If the paragraphs are indexed, the position comes from the height of the
+	// paragraphs above the target.
+	MCFieldParagraphIndex *t_pgindex;
+	t_pgindex = getparagraphindex(paragraphs, false);
+	if (t_pgindex != NULL && target != NULL && MCFieldParagraphIndexContains(t_pgindex, target) &&
+		curparagraph != NULL && MCFieldParagraphIndexContains(t_pgindex, curparagraph))
+		return cury + (int4)MCFieldParagraphIndexHeightBefore(target) - (int4)MCFieldParagraphIndexHeightBefore(curparagraph);
+
 	int4 y = cury;
 	MCParagraph *tptr = curparagraph;
 	
@@ -371,6 +916,110 @@ int4 MCField::paragraphtoy(MCParagraph *target)
 	return y;
 }
 
+void MCField::layoutestimated(MCParagraph *p_target, int32_t p_bottom)
+{
+	if (!(state & CS_HEIGHTS_ESTIMATED) || !opened || paragraphs == NULL)
+		return;
+
+	// The cached positions of paragraphs below any that are flowed have to
+	// move by the difference between their estimated and actual heights.
+	bool t_seen_focused, t_seen_first, t_remaining;
+	t_seen_focused = t_seen_first = t_remaining = false;
+
+	int32_t t_y, t_delta;
+	t_y = cury;
+	t_delta = 0;
+
+	MCParagraph *pgptr = curparagraph;
+
+	// Every paragraph above the first estimated one has been flowed, so if the
+	// paragraphs are indexed start from there, its position coming from the
+	// index. Any of the target, focused and first paragraphs above it have
+	// already been passed.
+	MCFieldParagraphIndex *t_pgindex;
+	t_pgindex = getparagraphindex(paragraphs, true);
+	if (t_pgindex != NULL && t_pgindex -> firstestimated != NULL && curparagraph == paragraphs &&
+		(p_target == NULL || MCFieldParagraphIndexContains(t_pgindex, p_target)) &&
+		(focusedparagraph == NULL || MCFieldParagraphIndexContains(t_pgindex, focusedparagraph)) &&
+		(firstparagraph == NULL || MCFieldParagraphIndexContains(t_pgindex, firstparagraph)))
+	{
+		pgptr = t_pgindex -> firstestimated;
+		t_y = cury + MCFieldParagraphIndexHeightBefore(pgptr);
+
+		uint4 t_start;
+		t_start = MCFieldParagraphIndexOrdinal(pgptr);
+		if (p_target != NULL && MCFieldParagraphIndexOrdinal(p_target) < t_start)
+			p_target = NULL;
+		t_seen_focused = focusedparagraph != NULL && MCFieldParagraphIndexOrdinal(focusedparagraph) < t_start;
+		t_seen_first = firstparagraph != NULL && MCFieldParagraphIndexOrdinal(firstparagraph) < t_start;
+	}
+
+	do
+	{
+		if (t_y >= p_bottom && p_target == NULL)
+		{
+			t_remaining = true;
+			break;
+		}
+
+		if (pgptr == focusedparagraph)
+		{
+			focusedy += t_delta;
+			t_seen_focused = true;
+		}
+		if (pgptr == firstparagraph)
+		{
+			firsty += t_delta;
+			t_seen_first = true;
+		}
+
+		if (pgptr -> isestimated())
+		{
+			uint2 t_old_height;
+			t_old_height = pgptr -> getheight(fixedheight);
+			pgptr -> layout();
+			t_delta += pgptr -> getheight(fixedheight) - t_old_height;
+			if (!(state & CS_MEASURE_PENDING))
+				textwidth = MCU_max(textwidth, pgptr -> getwidth());
+		}
+
+		if (pgptr == p_target)
+			p_target = NULL;
+
+		t_y += pgptr -> getheight(fixedheight);
+		pgptr = pgptr -> next();
+	}
+	while (pgptr != paragraphs);
+
+	if (!t_seen_focused)
+		focusedy += t_delta;
+	if (!t_seen_first)
+		firsty += t_delta;
+	textheight += t_delta;
+
+	if (!t_remaining)
+		state &= ~CS_HEIGHTS_ESTIMATED;
+
+	// The next call can start where this one stopped.
+	if (t_pgindex != NULL && t_pgindex == pgindex && MCFieldParagraphIndexHead(t_pgindex) == paragraphs)
+		t_pgindex -> firstestimated = t_remaining && MCFieldParagraphIndexContains(t_pgindex, pgptr) ? pgptr : NULL;
+}
+
+void MCField::setfirstestimated(MCParagraph *p_paragraph)
+{
+	if (p_paragraph == NULL)
+	{
+		if (pgindex != NULL)
+			pgindex -> firstestimated = NULL;
+		return;
+	}
+
+	MCFieldParagraphIndex *t_pgindex;
+	t_pgindex = getparagraphindex(paragraphs, true);
+	if (t_pgindex != NULL && MCFieldParagraphIndexContains(t_pgindex, p_paragraph))
+		t_pgindex -> firstestimated = p_paragraph;
+}
+
 bool MCField::nativizetext(uint4 parid, MCExecPoint& ep, bool p_ascii_only)
 {
 	bool t_has_unicode;
@@ -471,7 +1120,7 @@ void MCField::setparagraphs(MCParagraph *newpgptr, uint4 parid)
 		if (parid == 0)
 			parid = getcard()->getid();
 	MCCdata *fptr = getcarddata(fdata, parid, True);
-	MCParagraph *pgptr = fptr->getparagraphs();
+	MCParagraph *pgptr = fptr->getparagraphs(this);
 	if (opened && fptr == fdata)
 		closeparagraphs(pgptr);
 	if (pgptr == paragraphs)
@@ -643,7 +1292,7 @@ Exec_stat MCField::settextindex(uint4 parid, int4 si, int4 ei, const MCString &s
 	}
 	int4 oldsi = si;
 	
-	MCParagraph *toppgptr = fptr->getparagraphs();
+	MCParagraph *toppgptr = fptr->getparagraphs(this);
 
 	MCParagraph *pgptr;
 	pgptr = verifyindices(toppgptr, si, ei);
@@ -817,7 +1466,7 @@ Exec_stat MCField::gettextatts(uint4 parid, Properties which, MCExecPoint &ep, M
 
 	if (flags & F_SHARED_TEXT)
 		parid = 0;
-	MCParagraph *pgptr = getcarddata(fdata, parid, True)->getparagraphs();
+	MCParagraph *pgptr = getcarddata(fdata, parid, True)->getparagraphs(this);
 
 	// MW-2012-02-08: [[ Field Indices ]] If we pass a pointer to indextoparagraph
 	//   then it computes the index of the paragraph (1-based).
@@ -1307,7 +1956,7 @@ Exec_stat MCField::settextatts(uint4 parid, Properties which, MCExecPoint& ep, M
 		}
 		settextindex(parid, si, ei, MCnullmcstring, False);
 		MCCdata *fptr = getcarddata(fdata, parid, True);
-		MCParagraph *oldparagraphs = fptr->getparagraphs();
+		MCParagraph *oldparagraphs = fptr->getparagraphs(this);
 		fptr->setset(0);
 		switch (which)
 		{
@@ -1328,7 +1977,7 @@ Exec_stat MCField::settextatts(uint4 parid, Properties which, MCExecPoint& ep, M
 		default:
 			break;
 		}
-		MCParagraph *newpgptr = fptr->getparagraphs();
+		MCParagraph *newpgptr = fptr->getparagraphs(this);
 		MCParagraph *lastpgptr = newpgptr->prev();
 		if (lastpgptr == newpgptr)
 			lastpgptr = NULL;
@@ -1420,7 +2069,7 @@ Exec_stat MCField::settextatts(uint4 parid, Properties which, MCExecPoint& ep, M
 		return ES_NORMAL;
 	}
 
-	MCParagraph *pgptr = getcarddata(fdata, parid, True)->getparagraphs();
+	MCParagraph *pgptr = getcarddata(fdata, parid, True)->getparagraphs(this);
 
 	// MW-2013-03-20: [[ Bug 10764 ]] We only need to layout if the paragraphs
 	//   are attached to the current card.
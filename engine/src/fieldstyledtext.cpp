@@ -466,6 +466,7 @@ void MCField::parsestyledtextappendblock(MCParagraph *p_paragraph, MCVariableVal
 	// Copy across the bytes of the text.
 	memcpy(p_paragraph -> text + t_block -> index, p_initial, t_block -> size);
 	p_paragraph -> textsize += t_block -> size;
+	p_paragraph -> indexchanged();
 	
 	// Now set the block styles.
 	MCExecPoint ep(nil, nil, nil);
@@ -83,6 +83,21 @@ uint2 MCLogicalFontTableMap(MCNameRef p_textfont, uint2 p_textstyle, uint2 p_tex
 // Lookup the given index in the logical font table, and return its attrs.
 void MCLogicalFontTableLookup(uint2 index, MCNameRef& r_textfont, uint2& r_textstyle, uint2& r_textsize, bool& r_unicode);
 
+typedef struct MCLogicalFontTable *MCLogicalFontTableRef;
+
+// Return a reference to a copy of the current logical font table, so that objects
+// whose loading is deferred can still map their font indices after the load has
+// finished. Copies are shared until the table changes.
+bool MCLogicalFontTableCopy(MCLogicalFontTableRef& r_table);
+
+// Retain or release a reference to a copy of a logical font table.
+MCLogicalFontTableRef MCLogicalFontTableRetain(MCLogicalFontTableRef table);
+void MCLogicalFontTableRelease(MCLogicalFontTableRef table);
+
+// Make the given copy the logical font table until the matching pop.
+void MCLogicalFontTablePush(MCLogicalFontTableRef table);
+void MCLogicalFontTablePop(void);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 enum Font_weight {
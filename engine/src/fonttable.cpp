@@ -46,6 +46,20 @@ static uint32_t s_logical_font_table_size = 0;
 static uint32_t s_logical_font_table_capacity = 0;
 static MCLogicalFontTableEntry *s_logical_font_table = nil;
 
+struct MCLogicalFontTable
+{
+	uint32_t references;
+	uint32_t size;
+	MCLogicalFontTableEntry *entries;
+};
+
+// The shared copy of the current table (if one has been made), and the table
+// which was current before a copy was pushed.
+static MCLogicalFontTable *s_logical_font_table_copy = nil;
+static uint32_t s_pushed_logical_font_table_size = 0;
+static uint32_t s_pushed_logical_font_table_capacity = 0;
+static MCLogicalFontTableEntry *s_pushed_logical_font_table = nil;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static void MCLogicalFontTableGetEntry(uint32_t p_index, MCNameRef& r_textfont, uint2& r_textstyle, uint2& r_textsize, bool& r_unicode)
@@ -200,6 +214,13 @@ void MCLogicalFontTableBuild(MCObject *p_object, uint32_t p_part)
 
 void MCLogicalFontTableFinish(void)
 {
+	// The table is changing, so any copy of it is no longer current.
+	if (s_logical_font_table_copy != nil)
+	{
+		MCLogicalFontTableRelease(s_logical_font_table_copy);
+		s_logical_font_table_copy = nil;
+	}
+
 	for(uint32_t i = 0; i < s_logical_font_table_size; i++)
 	{
 		MCNameRef t_textfont;
@@ -363,3 +384,81 @@ void MCLogicalFontTableLookup(uint16_t p_index, MCNameRef& r_font, uint16_t& r_s
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool MCLogicalFontTableCopy(MCLogicalFontTableRef& r_table)
+{
+	if (s_logical_font_table_copy == nil)
+	{
+		MCLogicalFontTable *t_copy;
+		if (!MCMemoryNew(t_copy))
+			return false;
+
+		if (!MCMemoryNewArray(s_logical_font_table_size, t_copy -> entries))
+		{
+			MCMemoryDelete(t_copy);
+			return false;
+		}
+
+		for(uint32_t i = 0; i < s_logical_font_table_size; i++)
+		{
+			t_copy -> entries[i] = s_logical_font_table[i];
+			MCNameClone(s_logical_font_table[i] . textfont, t_copy -> entries[i] . textfont);
+		}
+
+		t_copy -> size = s_logical_font_table_size;
+		t_copy -> references = 1;
+
+		s_logical_font_table_copy = t_copy;
+	}
+
+	s_logical_font_table_copy -> references += 1;
+	r_table = s_logical_font_table_copy;
+
+	return true;
+}
+
+MCLogicalFontTableRef MCLogicalFontTableRetain(MCLogicalFontTableRef p_table)
+{
+	if (p_table != nil)
+		p_table -> references += 1;
+	return p_table;
+}
+
+void MCLogicalFontTableRelease(MCLogicalFontTableRef p_table)
+{
+	if (p_table == nil)
+		return;
+
+	p_table -> references -= 1;
+	if (p_table -> references > 0)
+		return;
+
+	for(uint32_t i = 0; i < p_table -> size; i++)
+		MCNameDelete(p_table -> entries[i] . textfont);
+	MCMemoryDeleteArray(p_table -> entries);
+	MCMemoryDelete(p_table);
+}
+
+void MCLogicalFontTablePush(MCLogicalFontTableRef p_table)
+{
+	s_pushed_logical_font_table_size = s_logical_font_table_size;
+	s_pushed_logical_font_table_capacity = s_logical_font_table_capacity;
+	s_pushed_logical_font_table = s_logical_font_table;
+
+	// The copy's entries are only read while it is pushed, so they can be used
+	// in place.
+	s_logical_font_table_size = s_logical_font_table_capacity = p_table -> size;
+	s_logical_font_table = p_table -> entries;
+}
+
+void MCLogicalFontTablePop(void)
+{
+	s_logical_font_table_size = s_pushed_logical_font_table_size;
+	s_logical_font_table_capacity = s_pushed_logical_font_table_capacity;
+	s_logical_font_table = s_pushed_logical_font_table;
+
+	s_pushed_logical_font_table_size = 0;
+	s_pushed_logical_font_table_capacity = 0;
+	s_pushed_logical_font_table = nil;
+}
+
+////////////////////////////////////////////////////////////////////////////////
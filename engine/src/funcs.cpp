@@ -60,8 +60,6 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "core.h"
 
-char *MCregexpatterns[PATTERN_CACHE_SIZE];
-regexp *MCregexcache[PATTERN_CACHE_SIZE];
 
 #define GZIP_HEAD_CRC     0x02 /* bit 1 set: header CRC present */
 #define GZIP_EXTRA_FIELD  0x04 /* bit 2 set: extra field present */
@@ -3198,30 +3196,8 @@ Exec_stat MCMatch::eval(MCExecPoint &ep)
 		(EE_MATCH_BADPATTERN, line, pos);
 		return ES_ERROR;
 	}
-	char *pstring = ep.getsvalue().clone();
-	regexp *compiled = NULL;
+	regexp *compiled = MCR_lookup(ep.getsvalue().getstring(), ep.getsvalue().getlength());
 	uint2 i;
-	for (i = 0 ; i < PATTERN_CACHE_SIZE ; i++)
-		if (strequal(pstring, MCregexpatterns[i]))
-		{
-			compiled = MCregexcache[i];
-			break;
-		}
-	if (compiled == NULL)
-	{
-		delete MCregexpatterns[PATTERN_CACHE_SIZE - 1];
-		MCR_free(MCregexcache[PATTERN_CACHE_SIZE - 1]);
-		for (i = PATTERN_CACHE_SIZE - 1 ; i ; i--)
-		{
-			MCregexcache[i] = MCregexcache[i - 1];
-			MCregexpatterns[i] = MCregexpatterns[i - 1];
-		}
-		MCregexpatterns[0] = pstring;
-		MCregexcache[0] = MCR_compile(MCregexpatterns[0]);
-		compiled = MCregexcache[0];
-	}
-	else
-		delete pstring;
 	if (compiled == NULL)
 	{
 		MCeerror->add
@@ -4039,34 +4015,9 @@ Exec_stat MCReplaceText::eval(MCExecPoint &ep)
 		delete rstring;
 		return ES_NORMAL;
 	}
-	char *pstring = ep.getsvalue().clone();
-
-	regexp *compiled = NULL;
-	const char *pattern = NULL;
-	uint2 i;
-	for (i = 0 ; i < PATTERN_CACHE_SIZE ; i++)
-		if (strequal(pstring, MCregexpatterns[i]))
-		{
-			compiled = MCregexcache[i];
-			pattern = MCregexpatterns[i];
-			break;
-		}
-	if (compiled == NULL)
-	{
-		delete MCregexpatterns[PATTERN_CACHE_SIZE - 1];
-		MCR_free(MCregexcache[PATTERN_CACHE_SIZE - 1]);
-		uint2 i;
-		for (i = PATTERN_CACHE_SIZE - 1 ; i ; i--)
-		{
-			MCregexcache[i] = MCregexcache[i - 1];
-			MCregexpatterns[i] = MCregexpatterns[i - 1];
-		}
-		pattern = MCregexpatterns[0] = pstring;
-		MCregexcache[0] = MCR_compile(MCregexpatterns[0]);
-		compiled = MCregexcache[0];
-	}
-	else
-		delete pstring;
+	// An anchored pattern can only match once.
+	bool t_anchored = ep.getsvalue().getstring()[0] == '^';
+	regexp *compiled = MCR_lookup(ep.getsvalue().getstring(), ep.getsvalue().getlength());
 	if (compiled == NULL)
 	{
 		delete rstring;
@@ -4115,7 +4066,7 @@ Exec_stat MCReplaceText::eval(MCExecPoint &ep)
 			// Begin searching again after the end of the match
 			t_source_offset = t_end;
 
-			if (pattern[0] == '^')
+			if (t_anchored)
 				break;
 		}
 		
@@ -809,12 +809,8 @@ void X_clear_globals(void)
 	MCfalsemcstring = MCfalsestring;
 	MCnullmcstring = NULL;
 
-	// MW-2013-03-11: [[ Bug 10713 ]] Make sure we reset the regex cache globals to nil.
-	for(uindex_t i = 0; i < PATTERN_CACHE_SIZE; i++)
-	{
-		MCregexpatterns[i] = nil;
-		MCregexcache[i] = nil;
-	}
+	// MW-2013-03-11: [[ Bug 10713 ]] Make sure we reset the regex cache.
+	MCR_setcachesize(PATTERN_CACHE_SIZE);
 
 	for(uint32_t i = 0; i < PI_NCURSORS; i++)
 		MCcursors[i] = nil;
@@ -1092,11 +1088,7 @@ int X_close(void)
 		delete tvar;
 	}
 	uint2 i;
-	for (i = 0 ; i < PATTERN_CACHE_SIZE ; i++)
-	{
-		delete MCregexpatterns[i];
-		MCR_free(MCregexcache[i]);
-	}
+	MCR_clearcache();
 	delete MCperror;
 	delete MCeerror;
 
@@ -322,7 +322,7 @@ Exec_stat MCHandler::exec(MCExecPoint &ep, MCParameter *plist)
 					err = True;
 					break;
 				}
-				/* UNCHECKED */ MCVariable::createwithname(i < npnames ? pinfo[i] . name : kMCEmptyName, newparams[i]);
+				/* UNCHECKED */ MCVariable::createlocal(i < npnames ? pinfo[i] . name : kMCEmptyName, newparams[i]);
 				newparams[i]->store(ep, False);
 			}
 			plist = plist->getnext();
@@ -334,14 +334,14 @@ Exec_stat MCHandler::exec(MCExecPoint &ep, MCParameter *plist)
 				err = True;
 				break;
 			}
-			/* UNCHECKED */ MCVariable::createwithname(i < npnames ? pinfo[i] . name : kMCEmptyName, newparams[i]);
+			/* UNCHECKED */ MCVariable::createlocal(i < npnames ? pinfo[i] . name : kMCEmptyName, newparams[i]);
 		}
 	}
 	if (err)
 	{
 		while (i--)
 			if (i >= npnames || !pinfo[i].is_reference)
-				delete newparams[i];
+				MCVariable::destroylocal(newparams[i]);
 		delete newparams;
 		MCeerror->add(EE_HANDLER_BADPARAM, firstline - 1, 1, name);
 		return ES_ERROR;
@@ -362,7 +362,7 @@ Exec_stat MCHandler::exec(MCExecPoint &ep, MCParameter *plist)
 		i = nvnames;
 		while (i--)
 		{
-			/* UNCHECKED */ MCVariable::createwithname(vinfo[i] . name, vars[i]);
+			/* UNCHECKED */ MCVariable::createlocal(vinfo[i] . name, vars[i]);
 
 			// A UQL is indicated by 'init' being nil.
 			if (vinfo[i] . init != nil)
@@ -465,7 +465,7 @@ Exec_stat MCHandler::exec(MCExecPoint &ep, MCParameter *plist)
 		i = newnparams;
 		while (i--)
 			if (i >= npnames || !pinfo[i].is_reference)
-				delete params[i];
+				MCVariable::destroylocal(params[i]);
 		delete params;
 	}
 	if (vars != NULL)
@@ -477,7 +477,7 @@ Exec_stat MCHandler::exec(MCExecPoint &ep, MCParameter *plist)
 				MCNameDelete(vinfo[nvnames] . name);
 				MCNameDelete(vinfo[nvnames] . init);
 			}
-			delete vars[nvnames];
+			MCVariable::destroylocal(vars[nvnames]);
 		}
 		delete vars;
 	}
@@ -573,7 +573,7 @@ Parse_stat MCHandler::newvar(MCNameRef p_name, MCNameRef p_init, MCVarref **r_re
 	if (executing)
 	{
 		MCU_realloc((char **)&vars, nvnames, nvnames + 1, sizeof(MCVariable *));
-		/* UNCHECKED */ MCVariable::createwithname(p_name, vars[nvnames]);
+		/* UNCHECKED */ MCVariable::createlocal(p_name, vars[nvnames]);
 
 		if (p_init != nil)
 			vars[nvnames] -> setnameref_unsafe(p_init);
@@ -66,6 +66,14 @@ void MCHandlerArray::clear(void)
 	m_count = 0;
 }
 
+void MCHandlerArray::detach(void)
+{
+	free(m_handlers);
+
+	m_handlers = NULL;
+	m_count = 0;
+}
+
 void MCHandlerArray::append(MCHandler *p_handler)
 {
 	m_handlers = (MCHandler **)realloc(m_handlers, sizeof(MCHandler *) * (m_count + 1));
@@ -615,6 +623,71 @@ void MCHandlerlist::addhandler(Handler_type type, MCHandler *handler)
 	handlers[type - 1] . sort();
 }
 
+void MCHandlerlist::addhandlers(MCHandler **p_handlers, uint32_t p_count)
+{
+	bool t_changed[6] = { false, false, false, false, false, false };
+	for(uint32_t i = 0; i < p_count; i++)
+	{
+		Handler_type t_type;
+		t_type = p_handlers[i] -> gettype();
+		handlers[t_type - 1] . append(p_handlers[i]);
+		t_changed[t_type - 1] = true;
+	}
+
+	for(uint32_t i = 0; i < 6; i++)
+		if (t_changed[i])
+			handlers[i] . sort();
+}
+
+void MCHandlerlist::detachhandlers(void)
+{
+	for(uint32_t i = 0; i < 6; ++i)
+		handlers[i] . detach();
+}
+
+MCVariable *MCHandlerlist::truncate(uint2 p_nvars, uint2 p_nconstants, uint2 p_nglobals)
+{
+	MCVariable *t_removed;
+	t_removed = NULL;
+
+	if (p_nvars < nvars)
+	{
+		if (p_nvars == 0)
+		{
+			t_removed = vars;
+			vars = NULL;
+		}
+		else
+		{
+			MCVariable *t_last;
+			t_last = vars;
+			for(uint32_t i = 1; i < p_nvars; i++)
+				t_last = t_last -> getnext();
+			t_removed = t_last -> getnext();
+			t_last -> setnext(NULL);
+		}
+
+		for(uint32_t i = p_nvars; i < nvars; i++)
+			MCNameDelete(vinits[i]);
+		nvars = p_nvars;
+	}
+
+	if (p_nconstants < nconstants)
+	{
+		for(uint32_t i = p_nconstants; i < nconstants; i++)
+		{
+			MCNameDelete(cinfo[i] . name);
+			MCNameDelete(cinfo[i] . value);
+		}
+		nconstants = p_nconstants;
+	}
+
+	if (p_nglobals < nglobals)
+		nglobals = p_nglobals;
+
+	return t_removed;
+}
+
 static bool enumerate_handlers(MCExecPoint& ep, const char *p_type, MCHandlerArray& p_handlers, bool p_first = false, MCObject *p_object = NULL)
 {
 	for(uint32_t j = 0; j < p_handlers . count(); ++j)
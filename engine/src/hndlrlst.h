@@ -35,6 +35,10 @@ public:
 	// Destroy the list of handlers.
 	void clear(void);
 
+	// Empty the list without destroying the handlers (which must be owned
+	// elsewhere).
+	void detach(void);
+
 	// Sort the list of handlers ready for finding.
 	void sort(void);
 
@@ -125,6 +129,19 @@ public:
 	Exec_stat findhandler(Handler_type, MCNameRef name, MCHandler *&);
 	bool hashandler(Handler_type type, MCNameRef name);
 	void addhandler(Handler_type type, MCHandler *handler);
+	// Add several handlers (each to the list for its own type), sorting each
+	// list that changes once at the end.
+	void addhandlers(MCHandler **handlers, uint32_t count);
+
+	// Remove all the handlers from the list without destroying them. This is
+	// used by the server script, which retains parsed handlers between
+	// requests.
+	void detachhandlers(void);
+
+	// Remove any script locals, constants and globals declared after the
+	// given number of each. The removed script locals are returned rather than
+	// deleted, as existing varrefs may still refer to them.
+	MCVariable *truncate(uint2 p_nvars, uint2 p_nconstants, uint2 p_nglobals);
 
 	uint2 getnglobals(void);
 	MCVariable *getglobal(uint2 p_index);
@@ -135,6 +152,11 @@ public:
 		return nvars;
 	}
 
+	uint2 getnconstants(void)
+	{
+		return nconstants;
+	}
+
 	MCVariable *getvars(void)
 	{
 		return vars;
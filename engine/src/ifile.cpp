@@ -147,6 +147,11 @@ void MCImage::recompress()
 }
 
 bool MCImageDecompress(MCImageCompressedBitmap *p_compressed, MCImageFrame *&r_frames, uindex_t &r_frame_count)
+{
+	return MCImageDecompress(p_compressed, 0, 0, r_frames, r_frame_count);
+}
+
+bool MCImageDecompress(MCImageCompressedBitmap *p_compressed, uindex_t p_target_width, uindex_t p_target_height, MCImageFrame *&r_frames, uindex_t &r_frame_count)
 {
 	bool t_success = true;
 
@@ -171,11 +176,11 @@ bool MCImageDecompress(MCImageCompressedBitmap *p_compressed, MCImageFrame *&r_f
 			break;
 
 		case F_PNG:
-			t_success = MCImageDecodePNG(t_stream, t_frames[0].image);
+			t_success = MCImageDecodePNG(t_stream, p_target_width, p_target_height, t_frames[0].image);
 			break;
 
 		case F_JPEG:
-			t_success = MCImageDecodeJPEG(t_stream, t_frames[0].image);
+			t_success = MCImageDecodeJPEG(t_stream, p_target_width, p_target_height, t_frames[0].image);
 			break;
 
 		case F_RLE:
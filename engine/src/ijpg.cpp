@@ -568,7 +568,71 @@ void MCJPEGFreeSrcManager(MCJPEGSrcManager *p_manager)
 	}
 }
 
+bool MCImageGetJPEGGeometry(IO_handle p_stream, uindex_t &r_width, uindex_t &r_height)
+{
+	bool t_success = true;
+
+	jpeg_decompress_struct t_jpeg;
+	MC_jpegerr t_err;
+	MCJPEGSrcManager *t_src = nil;
+
+	uint32_t t_orientation = 0;
+
+	t_jpeg.err = jpeg_std_error((jpeg_error_mgr*) &t_err);
+	t_err.pub.error_exit = jpg_MCerr_exit;
+
+	if (setjmp(t_err.setjmp_buffer))
+	{
+		t_success = false;
+	}
+
+	if (t_success)
+		jpeg_create_decompress(&t_jpeg);
+
+	if (t_success)
+		t_success = MCJPEGCreateSrcManager(p_stream, t_src);
+
+	if (t_success)
+	{
+		t_jpeg.src = (jpeg_source_mgr*)t_src;
+
+		// The orientation determines which way round the decoded image will be.
+		jpeg_save_markers(&t_jpeg, JPEG_APP0 + 1, 0xffff);
+
+		jpeg_read_header(&t_jpeg, TRUE);
+	}
+
+	if (t_success)
+	{
+		if (!read_exif_orientation(&t_jpeg, &t_orientation))
+			t_orientation = 0;
+
+		if (t_orientation >= 5)
+		{
+			r_width = t_jpeg.image_height;
+			r_height = t_jpeg.image_width;
+		}
+		else
+		{
+			r_width = t_jpeg.image_width;
+			r_height = t_jpeg.image_height;
+		}
+	}
+
+	jpeg_destroy_decompress(&t_jpeg);
+
+	if (t_src != nil)
+		MCJPEGFreeSrcManager(t_src);
+
+	return t_success;
+}
+
 bool MCImageDecodeJPEG(IO_handle p_stream, MCImageBitmap *&r_image)
+{
+	return MCImageDecodeJPEG(p_stream, 0, 0, r_image);
+}
+
+bool MCImageDecodeJPEG(IO_handle p_stream, uindex_t p_target_width, uindex_t p_target_height, MCImageBitmap *&r_image)
 {
 	bool t_success = true;
 
@@ -648,6 +712,28 @@ bool MCImageDecodeJPEG(IO_handle p_stream, MCImageBitmap *&r_image)
 			t_orientation = 0;
 	}
 
+	// If a target size has been given, let the decoder scale the image down by
+	// as much as it can (up to 1/8) while staying at least that big. The
+	// orientation is applied afterwards so the target may need turning round.
+	if (t_success && p_target_width != 0 && p_target_height != 0)
+	{
+		uindex_t t_target_width, t_target_height;
+		if (t_orientation >= 5)
+			t_target_width = p_target_height, t_target_height = p_target_width;
+		else
+			t_target_width = p_target_width, t_target_height = p_target_height;
+
+		uindex_t t_denom;
+		t_denom = 1;
+		while (t_denom < 8 &&
+			t_jpeg.image_width / (t_denom * 2) >= t_target_width &&
+			t_jpeg.image_height / (t_denom * 2) >= t_target_height)
+			t_denom *= 2;
+
+		t_jpeg.scale_num = 1;
+		t_jpeg.scale_denom = t_denom;
+	}
+
 	if (t_success)
 		jpeg_start_decompress(&t_jpeg);
 
@@ -63,10 +63,14 @@ bool MCImageDecodeGIF(IO_handle p_stream, MCImageFrame *&r_frames, uindex_t &r_f
 
 bool MCImageEncodeJPEG(MCImageBitmap *p_image, IO_handle p_stream, uindex_t &r_bytes_written);
 bool MCImageDecodeJPEG(IO_handle p_stream, MCImageBitmap *&r_image);
+bool MCImageDecodeJPEG(IO_handle p_stream, uindex_t p_target_width, uindex_t p_target_height, MCImageBitmap *&r_image);
+bool MCImageGetJPEGGeometry(IO_handle p_stream, uindex_t &r_width, uindex_t &r_height);
 
 bool MCImageEncodePNG(MCImageBitmap *p_bitmap, IO_handle p_stream, uindex_t &r_bytes_written);
 bool MCImageEncodePNG(MCImageIndexedBitmap *p_bitmap, IO_handle p_stream, uindex_t &r_bytes_written);
 bool MCImageDecodePNG(IO_handle p_stream, MCImageBitmap *&r_bitmap);
+bool MCImageDecodePNG(IO_handle p_stream, uindex_t p_target_width, uindex_t p_target_height, MCImageBitmap *&r_bitmap);
+bool MCImageGetPNGGeometry(IO_handle p_stream, uindex_t &r_width, uindex_t &r_height);
 
 bool MCImageEncodeBMP(MCImageBitmap *p_bitmap, IO_handle p_stream, uindex_t &r_bytes_written);
 bool MCImageDecodeBMPStruct(IO_handle p_stream, uindex_t &x_bytes_read, MCImageBitmap *&r_bitmap);
@@ -123,6 +127,10 @@ bool MCImageDecompressRLE(MCImageCompressedBitmap *p_compressed, MCImageBitmap *
 
 bool MCImageCompress(MCImageBitmap *p_bitmap, bool p_dither, MCImageCompressedBitmap *&r_compressed);
 bool MCImageDecompress(MCImageCompressedBitmap *p_compressed, MCImageFrame *&r_frames, uindex_t &r_frame_count);
+// Decompress, decoding JPEG and PNG images at a reduced size if they are much
+// larger than the given target size. The result is never smaller than the
+// target, so will usually still need to be scaled.
+bool MCImageDecompress(MCImageCompressedBitmap *p_compressed, uindex_t p_target_width, uindex_t p_target_height, MCImageFrame *&r_frames, uindex_t &r_frame_count);
 
 bool MCImageGetMetafileGeometry(IO_handle p_stream, uindex_t &r_width, uindex_t &r_height);
 bool MCImageImport(IO_handle p_stream, IO_handle p_mask_stream, MCPoint &r_hotspot, char *&r_name, MCImageCompressedBitmap *&r_compressed, MCImageBitmap *&r_bitmap);
@@ -348,6 +356,15 @@ private:
 	void notifyneeds(bool p_deleting);
 	
 public:
+	MCImageRep *getrep(void)
+	{
+		return m_rep;
+	}
+	MCTransformedImageRep *gettransformed(void)
+	{
+		return m_transformed;
+	}
+
 	MCImage();
 	MCImage(const MCImage &iref);
 	// virtual functions from MCObject
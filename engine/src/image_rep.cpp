@@ -96,9 +96,21 @@ bool MCCachedImageRep::EnsureImageFrames()
 	if (m_frames != nil)
 		return true;
 	
-	if (!LoadImageFrames(m_frames, m_frame_count))
+	MCImageFrame *t_frames;
+	uindex_t t_frame_count;
+	if (!LoadImageFrames(t_frames, t_frame_count))
 		return false;
 	
+	AdoptImageFrames(t_frames, t_frame_count);
+	
+	return true;
+}
+
+void MCCachedImageRep::AdoptImageFrames(MCImageFrame *p_frames, uindex_t p_frame_count)
+{
+	m_frames = p_frames;
+	m_frame_count = p_frame_count;
+	
 	s_cache_size += GetFrameByteCount();
 	
 	if (s_cache_size > s_cache_limit)
@@ -107,8 +119,6 @@ bool MCCachedImageRep::EnsureImageFrames()
 		FlushCacheToLimit();
 		m_lock_count--;
 	}
-	
-	return true;
 }
 
 bool MCCachedImageRep::LockImageFrame(uindex_t p_frame, MCImageFrame *&r_frame)
@@ -76,6 +76,8 @@ public:
 	uint32_t GetFrameByteCount();
 	void ReleaseFrames();
 
+	bool HasImageFrames() { return m_frames != nil; }
+
 	//////////
 
 	static void init();
@@ -97,6 +99,10 @@ protected:
 	virtual bool CalculateGeometry(uindex_t &r_width, uindex_t &r_height) = 0;
 	virtual bool LoadImageFrames(MCImageFrame *&r_frames, uindex_t &r_frame_count) = 0;
 
+	// take ownership of frames which have been loaded other than through
+	// LoadImageFrames, adding them to the cache
+	void AdoptImageFrames(MCImageFrame *p_frames, uindex_t p_frame_count);
+
 	bool m_have_geometry;
 	uindex_t m_width, m_height;
 
@@ -137,11 +143,27 @@ public:
 
 	uint32_t GetDataCompression();
 
+	uindex_t GetFrameCount();
+
+	// decode frames which are no smaller than the given size, without adding
+	// them to the cache - JPEG and PNG images are decoded at a reduced size
+	bool LoadScaledImageFrames(uindex_t p_width, uindex_t p_height, MCImageFrame *&r_frames, uindex_t &r_frame_count);
+
+	// decode the frames of any of the given reps which don't have them, using
+	// the thread pool for the decoding itself
+	static void PrefetchImageFrames(MCImageRep **p_reps, uindex_t p_count);
+
 protected:
 	// returns the image frames as decoded from the input stream
 	bool LoadImageFrames(MCImageFrame *&r_frames, uindex_t &r_frame_count);
 	bool CalculateGeometry(uindex_t &r_width, uindex_t &r_height);
 
+	// read the image data from the input stream - the formats which can be
+	// decoded independently of the engine are returned compressed
+	bool ImportImageData(MCImageCompressedBitmap *&r_compressed, MCImageBitmap *&r_bitmap);
+	// record the geometry and compression of newly loaded frames
+	void SetImageFrameInfo(MCImageFrame *p_frames, MCImageCompressedBitmap *p_compressed);
+
 	//////////
 
 	// return the input stream from which the image data will be read
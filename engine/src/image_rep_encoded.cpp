@@ -31,13 +31,15 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "image.h"
 
+#include "thread.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 
 MCEncodedImageRep::~MCEncodedImageRep()
 {
 }
 
-bool MCEncodedImageRep::LoadImageFrames(MCImageFrame *&r_frames, uindex_t &r_frame_count)
+bool MCEncodedImageRep::ImportImageData(MCImageCompressedBitmap *&r_compressed, MCImageBitmap *&r_bitmap)
 {
 	bool t_success = true;
 
@@ -47,56 +49,131 @@ bool MCEncodedImageRep::LoadImageFrames(MCImageFrame *&r_frames, uindex_t &r_fra
 	IO_handle t_stream = nil;
 	IO_handle t_mask_stream = nil;
 
-	MCImageCompressedBitmap *t_compressed = nil;
-	MCImageBitmap *t_bitmap = nil;
-
 	MCPoint t_hotspot = {1, 1};
 	char *t_name = nil;
 
 	t_success = GetDataStream(t_stream) &&
-		MCImageImport(t_stream, t_mask_stream, t_hotspot, t_name, t_compressed, t_bitmap);
+		MCImageImport(t_stream, t_mask_stream, t_hotspot, t_name, r_compressed, r_bitmap);
 
 	if (t_stream != nil)
 		MCS_close(t_stream);
 
+	MCCStringFree(t_name);
+
+	return t_success;
+}
+
+// Turn the result of ImportImageData into frames. This only touches the data
+// it is given, so can be run on the thread pool.
+static bool MCEncodedImageRepDecode(MCImageCompressedBitmap *p_compressed, MCImageBitmap *&x_bitmap, MCImageFrame *&r_frames, uindex_t &r_frame_count)
+{
+	if (p_compressed != nil)
+		return MCImageDecompress(p_compressed, r_frames, r_frame_count);
+
+	if (!MCMemoryNewArray(1, r_frames))
+		return false;
+
+	r_frames[0].image = x_bitmap;
+	x_bitmap = nil;
+	r_frame_count = 1;
+
+	return true;
+}
+
+void MCEncodedImageRep::SetImageFrameInfo(MCImageFrame *p_frames, MCImageCompressedBitmap *p_compressed)
+{
+	m_width = p_frames[0].image->width;
+	m_height = p_frames[0].image->height;
+
+	if (p_compressed != nil)
+		m_compression = p_compressed->compression;
+
+	m_have_geometry = true;
+}
+
+bool MCEncodedImageRep::LoadImageFrames(MCImageFrame *&r_frames, uindex_t &r_frame_count)
+{
+	bool t_success = true;
+
+	MCImageCompressedBitmap *t_compressed = nil;
+	MCImageBitmap *t_bitmap = nil;
+
+	t_success = ImportImageData(t_compressed, t_bitmap) &&
+		MCEncodedImageRepDecode(t_compressed, t_bitmap, r_frames, r_frame_count);
+
+	if (t_success)
+		SetImageFrameInfo(r_frames, t_compressed);
+
+	MCImageFreeBitmap(t_bitmap);
+	MCImageFreeCompressedBitmap(t_compressed);
+
+	return t_success;
+}
+
+bool MCEncodedImageRep::LoadScaledImageFrames(uindex_t p_width, uindex_t p_height, MCImageFrame *&r_frames, uindex_t &r_frame_count)
+{
+	bool t_success = true;
+
+	MCImageCompressedBitmap *t_compressed = nil;
+	MCImageBitmap *t_bitmap = nil;
+
+	t_success = ImportImageData(t_compressed, t_bitmap);
+
 	if (t_success)
 	{
 		if (t_compressed != nil)
-			t_success = MCImageDecompress(t_compressed, r_frames, r_frame_count);
+			t_success = MCImageDecompress(t_compressed, p_width, p_height, r_frames, r_frame_count);
 		else
-		{
-			t_success = MCMemoryNewArray(1, r_frames);
-			if (t_success)
-			{
-				r_frames[0].image = t_bitmap;
-				t_bitmap = nil;
-				r_frame_count = 1;
-			}
-		}
+			t_success = MCEncodedImageRepDecode(t_compressed, t_bitmap, r_frames, r_frame_count);
 	}
 
-	if (t_success)
-	{
+	MCImageFreeBitmap(t_bitmap);
+	MCImageFreeCompressedBitmap(t_compressed);
 
-		m_width = r_frames[0].image->width;
-		m_height = r_frames[0].image->height;
+	return t_success;
+}
 
-		if (t_compressed != nil)
-			m_compression = t_compressed->compression;
+// JPEG and PNG images can be measured from their header, rather than by
+// decoding them. This returns false for any other format.
+static bool MCEncodedImageRepReadHeaderGeometry(IO_handle p_stream, uint32_t &r_compression, uindex_t &r_width, uindex_t &r_height)
+{
+	uint8_t t_header[8];
+	uint4 t_count;
+	t_count = sizeof(t_header);
+	if (IO_read(t_header, sizeof(uint8_t), t_count, p_stream) != IO_NORMAL || t_count != sizeof(t_header))
+		return false;
 
-		m_have_geometry = true;
+	if (MCS_seek_set(p_stream, 0) != IO_NORMAL)
+		return false;
+
+	if (memcmp(t_header, "\x89PNG\r\n\x1a\n", 8) == 0)
+	{
+		r_compression = F_PNG;
+		return MCImageGetPNGGeometry(p_stream, r_width, r_height);
 	}
 
-	MCCStringFree(t_name);
-	
-	MCImageFreeBitmap(t_bitmap);
-	MCImageFreeCompressedBitmap(t_compressed);
+	if (t_header[0] == 0xFF && t_header[1] == 0xD8 && t_header[2] == 0xFF)
+	{
+		r_compression = F_JPEG;
+		return MCImageGetJPEGGeometry(p_stream, r_width, r_height);
+	}
 
-	return t_success;
+	return false;
 }
 
 bool MCEncodedImageRep::CalculateGeometry(uindex_t &r_width, uindex_t &r_height)
 {
+	IO_handle t_stream = nil;
+	if (GetDataStream(t_stream))
+	{
+		bool t_success;
+		t_success = MCEncodedImageRepReadHeaderGeometry(t_stream, m_compression, r_width, r_height);
+		MCS_close(t_stream);
+
+		if (t_success)
+			return true;
+	}
+
 	MCImageFrame *t_frame = nil;
 	if (!LockImageFrame(0, t_frame))
 		return false;
@@ -109,6 +186,16 @@ bool MCEncodedImageRep::CalculateGeometry(uindex_t &r_width, uindex_t &r_height)
 	return true;
 }
 
+uindex_t MCEncodedImageRep::GetFrameCount()
+{
+	// JPEG and PNG images always have one frame, so there is no need to decode
+	// them to find out.
+	if (m_have_geometry && (m_compression == F_JPEG || m_compression == F_PNG))
+		return 1;
+
+	return MCCachedImageRep::GetFrameCount();
+}
+
 uint32_t MCEncodedImageRep::GetDataCompression()
 {
 	/* OVERHAUL - REVISIT - need to refactor image import code so we can detect
@@ -126,6 +213,202 @@ uint32_t MCEncodedImageRep::GetDataCompression()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The PNG and JPEG decoders ask the screen for a color transform if the image
+// carries color space information. That isn't safe off the main thread, so
+// check for it before handing an image to the pool. Anything which can't be
+// parsed is assumed to need one.
+static bool MCEncodedImageRepNeedsColorTransform(MCImageCompressedBitmap *p_compressed)
+{
+	const uint8_t *t_data;
+	t_data = (const uint8_t *)p_compressed->data;
+
+	uindex_t t_size;
+	t_size = p_compressed->size;
+
+	if (p_compressed->compression == F_GIF)
+		return false;
+
+	if (p_compressed->compression == F_PNG)
+	{
+		// Walk the chunks up to the image data looking for iCCP, sRGB or cHRM.
+		uindex_t t_offset;
+		t_offset = 8;
+		while (t_offset + 8 <= t_size)
+		{
+			uint32_t t_length;
+			t_length = (t_data[t_offset] << 24) | (t_data[t_offset + 1] << 16) | (t_data[t_offset + 2] << 8) | t_data[t_offset + 3];
+
+			const char *t_type;
+			t_type = (const char *)t_data + t_offset + 4;
+			if (memcmp(t_type, "IDAT", 4) == 0 || memcmp(t_type, "IEND", 4) == 0)
+				return false;
+			if (memcmp(t_type, "iCCP", 4) == 0 || memcmp(t_type, "sRGB", 4) == 0 || memcmp(t_type, "cHRM", 4) == 0)
+				return true;
+
+			if (t_length > t_size - t_offset - 8)
+				break;
+			t_offset += t_length + 12;
+		}
+		return true;
+	}
+
+	if (p_compressed->compression == F_JPEG)
+	{
+		// Walk the markers up to the scan data looking for an ICC profile.
+		uindex_t t_offset;
+		t_offset = 2;
+		while (t_offset + 4 <= t_size && t_data[t_offset] == 0xFF)
+		{
+			uint8_t t_marker;
+			t_marker = t_data[t_offset + 1];
+			if (t_marker == 0xFF)
+			{
+				t_offset += 1;
+				continue;
+			}
+			if (t_marker == 0xDA || t_marker == 0xD9)
+				return false;
+			if (t_marker == 0x01 || (t_marker >= 0xD0 && t_marker <= 0xD7))
+			{
+				t_offset += 2;
+				continue;
+			}
+
+			uindex_t t_length;
+			t_length = (t_data[t_offset + 2] << 8) | t_data[t_offset + 3];
+			if (t_marker == 0xE2 && t_length >= 14 && t_offset + 16 <= t_size &&
+				memcmp(t_data + t_offset + 4, "ICC_PROFILE", 12) == 0)
+				return true;
+
+			t_offset += t_length + 2;
+		}
+		return true;
+	}
+
+	return true;
+}
+
+struct MCEncodedImageRepDecodeJob
+{
+	MCEncodedImageRep *rep;
+	MCImageCompressedBitmap *compressed;
+	MCImageBitmap *bitmap;
+	MCImageFrame *frames;
+	uindex_t frame_count;
+	bool success;
+};
+
+static void MCEncodedImageRepDecodeJobRun(void *p_context, uindex_t p_index)
+{
+	MCEncodedImageRepDecodeJob *t_job;
+	t_job = &((MCEncodedImageRepDecodeJob *)p_context)[p_index];
+	t_job->success = MCEncodedImageRepDecode(t_job->compressed, t_job->bitmap, t_job->frames, t_job->frame_count);
+}
+
+void MCEncodedImageRep::PrefetchImageFrames(MCImageRep **p_reps, uindex_t p_count)
+{
+	// There is nothing to gain unless the decoding can be spread out.
+	uindex_t t_concurrency;
+	t_concurrency = MCThreadPoolGetConcurrency();
+	if (t_concurrency <= 1)
+		return;
+
+	// The images are decoded a batch (one per thread) at a time, and this stops
+	// once the decoded frames fill the cache - any more would only push out
+	// the ones already decoded.
+	MCEncodedImageRepDecodeJob *t_jobs;
+	if (!MCMemoryNewArray(t_concurrency, t_jobs))
+		return;
+
+	uint32_t t_decoded_size;
+	t_decoded_size = 0;
+
+	uindex_t t_next;
+	t_next = 0;
+	while(t_next < p_count && t_decoded_size < GetCacheLimit())
+	{
+		// Reading the data has to happen here as it may need the engine (to
+		// fetch a url, for example).
+		uindex_t t_job_count;
+		t_job_count = 0;
+		while(t_next < p_count && t_job_count < t_concurrency && t_decoded_size < GetCacheLimit())
+		{
+			MCImageRep *t_next_rep;
+			t_next_rep = p_reps[t_next++];
+			if (t_next_rep->GetType() != kMCImageRepReferenced && t_next_rep->GetType() != kMCImageRepResident)
+				continue;
+
+			MCEncodedImageRep *t_rep;
+			t_rep = static_cast<MCEncodedImageRep *>(t_next_rep);
+			if (t_rep->HasImageFrames())
+				continue;
+
+			// The same rep can be used by several images.
+			bool t_queued;
+			t_queued = false;
+			for(uindex_t j = 0; j < t_job_count && !t_queued; j++)
+				t_queued = t_jobs[j].rep == t_rep;
+			if (t_queued)
+				continue;
+
+			MCEncodedImageRepDecodeJob *t_job;
+			t_job = &t_jobs[t_job_count];
+			MCMemoryClear(t_job, sizeof(MCEncodedImageRepDecodeJob));
+			if (!t_rep->ImportImageData(t_job->compressed, t_job->bitmap))
+			{
+				MCImageFreeBitmap(t_job->bitmap);
+				MCImageFreeCompressedBitmap(t_job->compressed);
+				continue;
+			}
+
+			// Images which need color matching are decoded here instead.
+			if (t_job->compressed != nil && MCEncodedImageRepNeedsColorTransform(t_job->compressed))
+			{
+				if (MCEncodedImageRepDecode(t_job->compressed, t_job->bitmap, t_job->frames, t_job->frame_count))
+				{
+					t_rep->SetImageFrameInfo(t_job->frames, t_job->compressed);
+					t_rep->AdoptImageFrames(t_job->frames, t_job->frame_count);
+					t_decoded_size += t_rep->GetFrameByteCount();
+				}
+				MCImageFreeBitmap(t_job->bitmap);
+				MCImageFreeCompressedBitmap(t_job->compressed);
+				continue;
+			}
+
+			t_rep->Retain();
+			t_job->rep = t_rep;
+			t_job_count++;
+		}
+
+		MCThreadPoolRun(t_job_count, MCEncodedImageRepDecodeJobRun, t_jobs);
+
+		for(uindex_t i = 0; i < t_job_count; i++)
+		{
+			MCEncodedImageRepDecodeJob *t_job;
+			t_job = &t_jobs[i];
+
+			// If decoding failed the frames are left to be loaded (and fail) when
+			// they are first needed, as before.
+			if (t_job->success && !t_job->rep->HasImageFrames())
+			{
+				t_job->rep->SetImageFrameInfo(t_job->frames, t_job->compressed);
+				t_job->rep->AdoptImageFrames(t_job->frames, t_job->frame_count);
+				t_decoded_size += t_job->rep->GetFrameByteCount();
+			}
+			else if (t_job->success)
+				MCImageFreeFrames(t_job->frames, t_job->frame_count);
+
+			MCImageFreeBitmap(t_job->bitmap);
+			MCImageFreeCompressedBitmap(t_job->compressed);
+			t_job->rep->Release();
+		}
+	}
+
+	MCMemoryDeleteArray(t_jobs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 MCReferencedImageRep::MCReferencedImageRep(const char *p_file_name)
 {
 	/* UNCHECKED */ MCCStringClone(p_file_name, m_file_name);
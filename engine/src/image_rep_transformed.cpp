@@ -71,12 +71,65 @@ bool MCTransformedImageRep::CalculateGeometry(uindex_t &r_width, uindex_t &r_hei
 	return true;
 }
 
+// If the source is encoded, hasn't been decoded yet and is much bigger than the
+// target size, decode it straight to near the target size rather than decoding
+// (and caching) it at full size just to scale it down.
+static bool MCTransformedImageRepLoadScaledFrames(MCImageRep *p_source, uindex_t p_width, uindex_t p_height, uint32_t p_quality, MCImageFrame *&r_frames, uindex_t &r_frame_count)
+{
+	if (p_source->GetType() != kMCImageRepReferenced && p_source->GetType() != kMCImageRepResident)
+		return false;
+
+	MCEncodedImageRep *t_source;
+	t_source = static_cast<MCEncodedImageRep *>(p_source);
+
+	uindex_t t_src_width, t_src_height;
+	if (t_source->HasImageFrames() || !t_source->GetGeometry(t_src_width, t_src_height))
+		return false;
+
+	if (p_width == 0 || p_height == 0 || p_width * 2 > t_src_width || p_height * 2 > t_src_height)
+		return false;
+
+	bool t_success = true;
+
+	MCImageFrame *t_frames = nil;
+	uindex_t t_frame_count = 0;
+
+	t_success = t_source->LoadScaledImageFrames(p_width, p_height, t_frames, t_frame_count);
+
+	for (uindex_t i = 0; t_success && i < t_frame_count; i++)
+	{
+		if (t_frames[i].image->width != p_width || t_frames[i].image->height != p_height)
+		{
+			MCImageBitmap *t_scaled = nil;
+			t_success = MCImageScaleBitmap(t_frames[i].image, p_width, p_height, p_quality, t_scaled);
+			if (t_success)
+			{
+				MCImageFreeBitmap(t_frames[i].image);
+				t_frames[i].image = t_scaled;
+			}
+		}
+	}
+
+	if (t_success)
+	{
+		r_frames = t_frames;
+		r_frame_count = t_frame_count;
+	}
+	else
+		MCImageFreeFrames(t_frames, t_frame_count);
+
+	return t_success;
+}
+
 bool MCTransformedImageRep::LoadImageFrames(MCImageFrame *&r_frames, uindex_t &r_frame_count)
 {
 	uindex_t t_target_width, t_target_height;
 	if (!GetGeometry(t_target_width, t_target_height))
 		return false;
 	
+	if (m_angle == 0 && MCTransformedImageRepLoadScaledFrames(m_source, t_target_width, t_target_height, m_quality, r_frames, r_frame_count))
+		return true;
+	
 	bool t_success = true;
 	
 	MCImageFrame *t_frames = nil;
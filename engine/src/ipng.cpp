@@ -86,11 +86,86 @@ extern "C" void stream_read(png_structp png_ptr, png_bytep data, png_size_t leng
 		png_error(png_ptr, (char *)"pnglib read error");
 }
 
+bool MCImageGetPNGGeometry(IO_handle p_stream, uindex_t &r_width, uindex_t &r_height)
+{
+	bool t_success = true;
+
+	png_structp t_png = nil;
+	png_infop t_info = nil;
+
+	t_success = nil != (t_png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL));
+
+	if (t_success)
+		t_success = nil != (t_info = png_create_info_struct(t_png));
+
+	if (t_success && setjmp(png_jmpbuf(t_png)))
+	{
+		t_success = false;
+	}
+
+	if (t_success)
+	{
+		png_set_read_fn(t_png, p_stream, stream_read);
+		png_read_info(t_png, t_info);
+
+		r_width = png_get_image_width(t_png, t_info);
+		r_height = png_get_image_height(t_png, t_info);
+	}
+
+	if (t_png != nil)
+		png_destroy_read_struct(&t_png, &t_info, nil);
+
+	return t_success;
+}
+
+// The largest factor the decoder will reduce an image by - this keeps the
+// accumulated color values within 32 bits.
+#define PNG_MAX_REDUCTION 64
+
+// Average each p_factor x p_factor block of the accumulated rows into a single
+// pixel of the given row. The colors are weighted by alpha so transparent
+// pixels don't bleed into their neighbours.
+static void png_reduce_row(uint32_t *p_sums, uindex_t p_src_width, uindex_t p_factor, uindex_t p_rows, uint32_t *p_dst)
+{
+	uindex_t t_dst_width;
+	t_dst_width = (p_src_width + p_factor - 1) / p_factor;
+
+	for (uindex_t x = 0; x < t_dst_width; x++)
+	{
+		uint32_t *t_sum = p_sums + x * 4;
+
+		uindex_t t_count;
+		t_count = MCU_min(p_factor, p_src_width - x * p_factor) * p_rows;
+
+		uint32_t t_alpha;
+		t_alpha = t_sum[0];
+		if (t_alpha == 0)
+			p_dst[x] = 0;
+		else
+		{
+			uint32_t t_red, t_green, t_blue;
+			t_red = (t_sum[1] + t_alpha / 2) / t_alpha;
+			t_green = (t_sum[2] + t_alpha / 2) / t_alpha;
+			t_blue = (t_sum[3] + t_alpha / 2) / t_alpha;
+			p_dst[x] = (((t_alpha + t_count / 2) / t_count) << 24) | (t_red << 16) | (t_green << 8) | t_blue;
+		}
+
+		t_sum[0] = t_sum[1] = t_sum[2] = t_sum[3] = 0;
+	}
+}
+
 bool MCImageDecodePNG(IO_handle p_stream, MCImageBitmap *&r_bitmap)
+{
+	return MCImageDecodePNG(p_stream, 0, 0, r_bitmap);
+}
+
+bool MCImageDecodePNG(IO_handle p_stream, uindex_t p_target_width, uindex_t p_target_height, MCImageBitmap *&r_bitmap)
 {
 	bool t_success = true;
 
 	MCImageBitmap *t_bitmap = nil;
+	uint32_t *t_row = nil;
+	uint32_t *t_sums = nil;
 
 	png_structp t_png = nil;
 	png_infop t_info = nil;
@@ -127,8 +202,20 @@ bool MCImageDecodePNG(IO_handle p_stream, MCImageBitmap *&r_bitmap)
 			&t_interlace_method, &t_compression_method, &t_filter_method);
 	}
 
+	// If a target size has been given, work out how much the image can be
+	// reduced by while staying at least that big. Interlaced images are
+	// delivered in passes, so can only be decoded at full size.
+	uindex_t t_factor;
+	t_factor = 1;
+	if (t_success && p_target_width != 0 && p_target_height != 0 && t_interlace_method == PNG_INTERLACE_NONE)
+		t_factor = MCU_max(1U, MCU_min((uindex_t)PNG_MAX_REDUCTION, MCU_min(t_width / p_target_width, t_height / p_target_height)));
+
 	if (t_success)
-		t_success = MCImageBitmapCreate(t_width, t_height, t_bitmap);
+		t_success = MCImageBitmapCreate((t_width + t_factor - 1) / t_factor, (t_height + t_factor - 1) / t_factor, t_bitmap);
+
+	if (t_success && t_factor > 1)
+		t_success = MCMemoryNewArray(t_width, t_row) &&
+			MCMemoryNewArray(t_bitmap->width * 4, t_sums);
 	
 	if (t_success)
 	{
@@ -224,7 +311,36 @@ bool MCImageDecodePNG(IO_handle p_stream, MCImageBitmap *&r_bitmap)
 			png_set_gamma(t_png, MCgamma, 0.45);
 	}
 	
-	if (t_success)
+	if (t_success && t_factor > 1)
+	{
+		// Read each row in turn, accumulating it into the sums for the row of
+		// the bitmap it contributes to.
+		uint8_t *t_data_ptr = (uint8_t *)t_bitmap->data;
+		for (uindex_t y = 0; y < t_height; y++)
+		{
+			png_read_row(t_png, (png_bytep)t_row, nil);
+
+			for (uindex_t x = 0; x < t_width; x++)
+			{
+				uint32_t t_pixel, t_alpha;
+				t_pixel = t_row[x];
+				t_alpha = t_pixel >> 24;
+
+				uint32_t *t_sum = t_sums + (x / t_factor) * 4;
+				t_sum[0] += t_alpha;
+				t_sum[1] += ((t_pixel >> 16) & 0xFF) * t_alpha;
+				t_sum[2] += ((t_pixel >> 8) & 0xFF) * t_alpha;
+				t_sum[3] += (t_pixel & 0xFF) * t_alpha;
+			}
+
+			if ((y + 1) % t_factor == 0 || y + 1 == t_height)
+			{
+				png_reduce_row(t_sums, t_width, t_factor, y % t_factor + 1, (uint32_t *)t_data_ptr);
+				t_data_ptr += t_bitmap->stride;
+			}
+		}
+	}
+	else if (t_success)
 	{
 		for (uindex_t t_pass = 0; t_pass < t_interlace_passes; t_pass++)
 		{
@@ -250,6 +366,9 @@ bool MCImageDecodePNG(IO_handle p_stream, MCImageBitmap *&r_bitmap)
 	if (t_color_xform != nil)
 		MCscreen -> destroycolortransform(t_color_xform);
 
+	MCMemoryDeleteArray(t_row);
+	MCMemoryDeleteArray(t_sums);
+
 	if (t_success)
 		r_bitmap = t_bitmap;
 	else
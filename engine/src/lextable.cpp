@@ -936,6 +936,7 @@ LT factor_table[] =
         {"img", TT_CHUNK, CT_IMAGE},
         {"imgs", TT_CLASS, CT_IMAGE},
         {"in", TT_IN, PT_IN},
+		{"includecachestatistics", TT_PROPERTY, P_INCLUDE_CACHE_STATISTICS},
         {"ink", TT_PROPERTY, P_INK},
 		{"innerglow", TT_PROPERTY, P_BITMAP_EFFECT_INNER_GLOW},
 		{"innershadow", TT_PROPERTY, P_BITMAP_EFFECT_INNER_SHADOW},
@@ -1268,6 +1269,7 @@ LT factor_table[] =
         {"rect", TT_PROPERTY, P_RECTANGLE},
         {"rectangle", TT_PROPERTY, P_RECTANGLE},
         {"recursionlimit", TT_PROPERTY, P_RECURSION_LIMIT},
+        {"regexcachesize", TT_PROPERTY, P_REGEX_CACHE_SIZE},
 #ifdef MODE_DEVELOPMENT
 		{"referringstack", TT_PROPERTY, P_REFERRING_STACK},
 #endif
@@ -1382,6 +1384,7 @@ LT factor_table[] =
 		{"sessionid", TT_PROPERTY, P_SESSION_ID},
 		{"sessionlifetime", TT_PROPERTY, P_SESSION_LIFETIME},
 		{"sessionsavepath", TT_PROPERTY, P_SESSION_SAVE_PATH},
+		{"sessionstore", TT_PROPERTY, P_SESSION_STORE},
         {"setregistry", TT_FUNCTION, F_SET_REGISTRY},
         {"setresource", TT_FUNCTION, F_SET_RESOURCE},
         {"seventh", TT_CHUNK, CT_SEVENTH},
@@ -1903,6 +1906,8 @@ static LT sugar_table[] =
 		{"open", TT_UNDEFINED, SG_OPEN},
 		{"optimized", TT_UNDEFINED, SG_OPTIMIZED},
 		{"options", TT_UNDEFINED, SG_OPTIONS},
+		{"pattern", TT_UNDEFINED, SG_PATTERN},
+		{"regex", TT_UNDEFINED, SG_REGEX},
 		{"standard", TT_UNDEFINED, SG_STANDARD},
 		{"unicode", TT_UNDEFINED, SG_UNICODE},
 		{"url", TT_UNDEFINED, SG_URL},
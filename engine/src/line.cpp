@@ -36,6 +36,7 @@ MCLine::MCLine(MCParagraph *paragraph)
 	firstblock = lastblock = NULL;
 	width = ascent = descent = 0;
 	dirtywidth = 0;
+	measured = true;
 }
 
 MCLine::~MCLine()
@@ -44,6 +45,13 @@ MCLine::~MCLine()
 
 void MCLine::takebreaks(MCLine *lptr)
 {
+	// If this line was never measured, the last width it was drawn at is held
+	// in dirtywidth.
+	if (!measured)
+	{
+		width = dirtywidth;
+		measured = true;
+	}
 	if (firstblock != lptr->firstblock)
 	{
 		dirtywidth = MCU_max(width, lptr->width);
@@ -211,26 +219,46 @@ MCBlock *MCLine::fitblocks(MCBlock* p_first, MCBlock* p_sentinal, uint2 p_max_wi
 	while(t_block != lastblock -> next());
 	
 	dirtywidth = width;
+	measured = true;
 	
 	return lastblock -> next();
 }
 
+// Measuring text is by far the most expensive part of laying out a line, so
+// appendall only computes the ascent and descent here. The width is computed
+// the first time it is needed (usually when the line is first drawn), so lines
+// that are never scrolled into view are never measured.
 void MCLine::appendall(MCBlock *bptr)
 {
 	firstblock = bptr;
 	lastblock = (MCBlock *)bptr->prev();
-	uint2 oldwidth = width;
+	if (measured)
+		dirtywidth = width;
 	width = 0;
+	measured = false;
 	bptr = lastblock;
 	ascent = descent = 0;
 	do
 	{
 		bptr = (MCBlock *)bptr->next();
 		setscents(bptr);
+	}
+	while (bptr != lastblock);
+}
+
+void MCLine::measure(void)
+{
+	uint2 oldwidth = dirtywidth;
+	width = 0;
+	MCBlock *bptr = lastblock;
+	do
+	{
+		bptr = (MCBlock *)bptr->next();
 		width += bptr->getwidth(NULL, width);
 	}
 	while (bptr != lastblock);
 	dirtywidth = MCU_max(width, oldwidth);
+	measured = true;
 }
 
 void MCLine::draw(MCDC *dc, int2 x, int2 y, uint2 si, uint2 ei, const char *tptr, uint2 pstyle)
@@ -349,6 +377,8 @@ void MCLine::setscents(MCBlock *bptr)
 
 uint2 MCLine::getdirtywidth()
 {
+	if (!measured)
+		measure();
 	return dirtywidth;
 }
 
@@ -359,7 +389,7 @@ void MCLine::clean()
 
 void MCLine::makedirty()
 {
-	dirtywidth = MCU_max(width, 1);
+	dirtywidth = MCU_max(getwidth(), 1);
 }
 
 void MCLine::getindex(uint2 &i, uint2 &l)
@@ -402,6 +432,8 @@ uint2 MCLine::getcursorindex(int2 cx, Boolean chunk)
 
 uint2 MCLine::getwidth()
 {
+	if (!measured)
+		measure();
 	return width;
 }
 
@@ -425,4 +457,5 @@ uint2 MCLine::getdescent()
 void MCLine::setwidth(uint2 p_new_width)
 {
 	width = p_new_width;
+	measured = true;
 }
@@ -34,6 +34,10 @@ class MCLine : public MCDLlist
 	uint2 ascent;
 	uint2 descent;
 	uint2 dirtywidth;
+	// False if appendall has deferred computing the width of the line.
+	bool measured;
+
+	void measure(void);
 public:
 	MCLine(MCParagraph *paragraph);
 	~MCLine();
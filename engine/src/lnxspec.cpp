@@ -63,6 +63,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include <sys/mman.h>
 #include <sys/dir.h>
 #include <sys/wait.h>
+#include <sys/epoll.h>
 #include <dlfcn.h>
 #include <termios.h>
 #include <langinfo.h>
@@ -1522,6 +1523,20 @@ void MCS_fakewriteat(IO_handle stream, uint4 p_pos, const void *p_buffer, uint4
 	memcpy(stream -> buffer + p_pos, p_buffer, p_size);
 }
 
+bool MCS_getreadbuffer(IO_handle stream, const char*& r_buffer, uint4& r_available)
+{
+	if ((stream -> flags & IO_FAKECUSTOM) == IO_FAKECUSTOM || (stream -> flags & IO_FAKEWRITE) == IO_FAKEWRITE)
+		return false;
+
+	if (stream -> fptr != NULL || stream -> buffer == NULL)
+		return false;
+
+	r_buffer = stream -> ioptr;
+	r_available = stream -> len - (stream -> ioptr - stream -> buffer);
+
+	return true;
+}
+
 
 void MCS_delete_registry(const char *key, MCExecPoint &dest)
 {
@@ -1674,6 +1689,54 @@ void MCS_unloadmodule(MCSysModuleHandle p_module)
 	dlclose ( p_module ) ;
 }
 
+// The epoll set that sockets register with through MCSocket::setselect. It
+// is -2 until first used, and -1 if epoll is not available.
+static int s_socket_epoll = -2;
+
+// The most socket events handled in a single poll, any others are handled by
+// the next poll.
+#define SOCKET_EVENT_BATCH 256
+
+int MCS_socket_epoll(void)
+{
+	if (s_socket_epoll == -2)
+		s_socket_epoll = epoll_create1(EPOLL_CLOEXEC);
+	return s_socket_epoll;
+}
+
+static void MCS_poll_socket_events(int p_epoll)
+{
+	struct epoll_event t_events[SOCKET_EVENT_BATCH];
+	int t_count;
+	t_count = epoll_wait(p_epoll, t_events, SOCKET_EVENT_BATCH, 0);
+	
+	for (int i = 0; i < t_count; i++)
+	{
+		MCSocket *t_socket;
+		t_socket = (MCSocket *)t_events[i] . data . ptr;
+		
+		uint4 t_ready;
+		t_ready = t_events[i] . events;
+		
+		// The socket may have changed state since it was registered, so check
+		// its interest is current before handling the event. As in the select
+		// path, read first so ssl handshaking data is not consumed by
+		// writesome().
+		if (t_socket -> resolve_state != kMCSocketStateResolving &&
+			t_socket -> resolve_state != kMCSocketStateError)
+		{
+			if ((t_ready & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0 &&
+				(t_socket -> connected && !t_socket -> closing && !t_socket -> shared || t_socket -> accepting))
+				t_socket -> readsome();
+			if ((t_ready & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0 &&
+				(!t_socket -> connected || t_socket -> wevents != NULL))
+				t_socket -> writesome();
+		}
+		
+		t_socket -> setselect();
+	}
+}
+
 Boolean MCS_poll(real8 delay, int fd)
 {
 	Boolean readinput = False;
@@ -1686,6 +1749,11 @@ Boolean MCS_poll(real8 delay, int fd)
 	
 	extern int g_notify_pipe[2];
 	
+	// When epoll is available only its descriptor is selected on for the
+	// sockets, otherwise every socket is added to the fd sets.
+	int t_socket_epoll;
+	t_socket_epoll = MCS_socket_epoll();
+	
 	fd_set rmaskfd, wmaskfd, emaskfd;
 	FD_ZERO(&rmaskfd);
 	FD_ZERO(&wmaskfd);
@@ -1708,24 +1776,39 @@ Boolean MCS_poll(real8 delay, int fd)
 		if (MCinputfd > maxfd)
 			maxfd = MCinputfd;
 	}
-	for (i = 0 ; i < MCnsockets ; i++)
+	if (t_socket_epoll != -1)
 	{
-		if (MCsockets[i]->resolve_state != kMCSocketStateResolving &&
-		   MCsockets[i]->resolve_state != kMCSocketStateError)
+		FD_SET(t_socket_epoll, &rmaskfd);
+		if (t_socket_epoll > maxfd)
+			maxfd = t_socket_epoll;
+		if (MCSocket::anyadded)
 		{
-			if (MCsockets[i]->connected && !MCsockets[i]->closing
-				&& !MCsockets[i]->shared || MCsockets[i]->accepting)
-				FD_SET(MCsockets[i]->fd, &rmaskfd);
-			if (!MCsockets[i]->connected || MCsockets[i]->wevents != NULL)
-				FD_SET(MCsockets[i]->fd, &wmaskfd);
-			FD_SET(MCsockets[i]->fd, &emaskfd);
-			if (MCsockets[i]->fd > maxfd)
-				maxfd = MCsockets[i]->fd;
-			if (MCsockets[i]->added)
+			delay = 0.0;
+			MCSocket::anyadded = False;
+			handled = True;
+		}
+	}
+	else
+	{
+		for (i = 0 ; i < MCnsockets ; i++)
+		{
+			if (MCsockets[i]->resolve_state != kMCSocketStateResolving &&
+			   MCsockets[i]->resolve_state != kMCSocketStateError)
 			{
-				delay = 0.0;
-				MCsockets[i]->added = False;
-				handled = True;
+				if (MCsockets[i]->connected && !MCsockets[i]->closing
+					&& !MCsockets[i]->shared || MCsockets[i]->accepting)
+					FD_SET(MCsockets[i]->fd, &rmaskfd);
+				if (!MCsockets[i]->connected || MCsockets[i]->wevents != NULL)
+					FD_SET(MCsockets[i]->fd, &wmaskfd);
+				FD_SET(MCsockets[i]->fd, &emaskfd);
+				if (MCsockets[i]->fd > maxfd)
+					maxfd = MCsockets[i]->fd;
+				if (MCsockets[i]->added)
+				{
+					delay = 0.0;
+					MCsockets[i]->added = False;
+					handled = True;
+				}
 			}
 		}
 	}
@@ -1750,26 +1833,34 @@ Boolean MCS_poll(real8 delay, int fd)
 		return True;
 	if (MCinputfd != -1 && FD_ISSET(MCinputfd, &rmaskfd))
 		readinput = True;
-	for (i = 0 ; i < MCnsockets ; i++)
+	if (t_socket_epoll != -1)
 	{
-		if (FD_ISSET(MCsockets[i]->fd, &emaskfd))
+		if (FD_ISSET(t_socket_epoll, &rmaskfd))
+			MCS_poll_socket_events(t_socket_epoll);
+	}
+	else
+	{
+		for (i = 0 ; i < MCnsockets ; i++)
 		{
-			if (!MCsockets[i]->waiting)
+			if (FD_ISSET(MCsockets[i]->fd, &emaskfd))
 			{
-				MCsockets[i]->error = strclone("select error");
-				MCsockets[i]->doclose();
+				if (!MCsockets[i]->waiting)
+				{
+					MCsockets[i]->error = strclone("select error");
+					MCsockets[i]->doclose();
+				}
+			}
+			else
+			{
+				/* read first here, otherwise a situation can arise when select indicates
+				 * read & write on the socket as part of the sslconnect handshaking
+				 * and so consumed during writesome() leaving no data to read
+				 */
+				if (FD_ISSET(MCsockets[i]->fd, &rmaskfd) && !MCsockets[i]->shared)
+					MCsockets[i]->readsome();
+				if (FD_ISSET(MCsockets[i]->fd, &wmaskfd))
+					MCsockets[i]->writesome();
 			}
-		}
-		else
-		{
-			/* read first here, otherwise a situation can arise when select indicates
-			 * read & write on the socket as part of the sslconnect handshaking
-			 * and so consumed during writesome() leaving no data to read
-			 */
-			if (FD_ISSET(MCsockets[i]->fd, &rmaskfd) && !MCsockets[i]->shared)
-				MCsockets[i]->readsome();
-			if (FD_ISSET(MCsockets[i]->fd, &wmaskfd))
-				MCsockets[i]->writesome();
 		}
 	}
 	
@@ -844,6 +844,22 @@ const char *MCS_get_session_id(void)
 	return NULL;
 }
 
+bool MCS_set_session_store(MCSSessionStore p_store)
+{
+	return true;
+}
+
+MCSSessionStore MCS_get_session_store(void)
+{
+	return kMCSSessionStoreIndex;
+}
+
+void MCS_get_include_cache_statistics(uint32_t& r_hits, uint32_t& r_misses)
+{
+	r_hits = 0;
+	r_misses = 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 int MCA_file(MCExecPoint& ep, const char *p_title, const char *p_prompt, const char *p_filter, const char *p_initial, unsigned int p_options)
@@ -33,6 +33,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "stacksecurity.h"
 
+#include "core.h"
+
 #if !defined(_MOBILE) && !defined(_SERVER)
 void IO_set_stream(IO_handle stream, char *newptr)
 {
@@ -135,20 +137,223 @@ void IO_cleanprocesses()
 			i++;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// The socket table. MCsockets holds the open sockets in no particular order
+// and grows by doubling. It is indexed by socket name and by object, so that
+// finding a socket and freeing an object do not depend on how many sockets
+// are open. Both indices are open-addressed with linear probing, are at most
+// half full and are rebuilt whenever MCsockets grows.
+
+// A slot in the name index holds the position of a socket in MCsockets (plus
+// one, so zero is empty) and the hash of its name. Sockets with the same name
+// each have a slot.
+struct IO_socketname
+{
+	hash_t hash;
+	uint2 position;
+};
+
+// A slot in the object index counts the sockets whose messages go to the
+// object.
+struct IO_socketobject
+{
+	MCObject *object;
+	uint4 count;
+};
+
+static uint2 s_socket_capacity = 0;
+static uint4 s_socket_index_size = 0;
+static IO_socketname *s_socket_names = NULL;
+static IO_socketobject *s_socket_objects = NULL;
+
+static inline hash_t IO_socketnamehash(const char *p_name)
+{
+	if (p_name == NULL)
+		return 0;
+	return MCMemoryHash(p_name, strlen(p_name));
+}
+
+static inline hash_t IO_socketobjecthash(MCObject *p_object)
+{
+	return MCMemoryHash(&p_object, sizeof(MCObject *));
+}
+
+// Returns true if the slot <p_slot> must move back to <p_hole> when <p_hole>
+// is emptied, i.e. if its home slot is not cyclically within (p_hole, p_slot].
+static inline bool IO_socketslotshifts(uint4 p_hole, uint4 p_slot, uint4 p_home)
+{
+	if (p_hole <= p_slot)
+		return p_home <= p_hole || p_home > p_slot;
+	return p_home <= p_hole && p_home > p_slot;
+}
+
+static void IO_socketnameinsert(uint2 p_position)
+{
+	uint4 t_mask = s_socket_index_size - 1;
+	hash_t t_hash = IO_socketnamehash(MCsockets[p_position] -> name);
+	uint4 t_slot = t_hash & t_mask;
+	while (s_socket_names[t_slot] . position != 0)
+		t_slot = (t_slot + 1) & t_mask;
+	s_socket_names[t_slot] . hash = t_hash;
+	s_socket_names[t_slot] . position = p_position + 1;
+}
+
+static uint4 IO_socketnamefind(uint2 p_position)
+{
+	uint4 t_mask = s_socket_index_size - 1;
+	uint4 t_slot = IO_socketnamehash(MCsockets[p_position] -> name) & t_mask;
+	while (s_socket_names[t_slot] . position != p_position + 1)
+		t_slot = (t_slot + 1) & t_mask;
+	return t_slot;
+}
+
+static void IO_socketnameremove(uint2 p_position)
+{
+	uint4 t_mask = s_socket_index_size - 1;
+	uint4 t_hole = IO_socketnamefind(p_position);
+	uint4 t_slot = t_hole;
+	for(;;)
+	{
+		t_slot = (t_slot + 1) & t_mask;
+		if (s_socket_names[t_slot] . position == 0)
+			break;
+		if (IO_socketslotshifts(t_hole, t_slot, s_socket_names[t_slot] . hash & t_mask))
+		{
+			s_socket_names[t_hole] = s_socket_names[t_slot];
+			t_hole = t_slot;
+		}
+	}
+	s_socket_names[t_hole] . position = 0;
+}
+
+static void IO_socketobjectadd(MCObject *p_object)
+{
+	uint4 t_mask = s_socket_index_size - 1;
+	uint4 t_slot = IO_socketobjecthash(p_object) & t_mask;
+	while (s_socket_objects[t_slot] . count != 0 && s_socket_objects[t_slot] . object != p_object)
+		t_slot = (t_slot + 1) & t_mask;
+	s_socket_objects[t_slot] . object = p_object;
+	s_socket_objects[t_slot] . count++;
+}
+
+static uint4 IO_socketobjectcount(MCObject *p_object)
+{
+	if (s_socket_objects == NULL)
+		return 0;
+	uint4 t_mask = s_socket_index_size - 1;
+	uint4 t_slot = IO_socketobjecthash(p_object) & t_mask;
+	while (s_socket_objects[t_slot] . count != 0)
+	{
+		if (s_socket_objects[t_slot] . object == p_object)
+			return s_socket_objects[t_slot] . count;
+		t_slot = (t_slot + 1) & t_mask;
+	}
+	return 0;
+}
+
+static void IO_socketobjectremove(MCObject *p_object)
+{
+	uint4 t_mask = s_socket_index_size - 1;
+	uint4 t_hole = IO_socketobjecthash(p_object) & t_mask;
+	while (s_socket_objects[t_hole] . object != p_object)
+		t_hole = (t_hole + 1) & t_mask;
+	if (--s_socket_objects[t_hole] . count != 0)
+		return;
+	uint4 t_slot = t_hole;
+	for(;;)
+	{
+		t_slot = (t_slot + 1) & t_mask;
+		if (s_socket_objects[t_slot] . count == 0)
+			break;
+		if (IO_socketslotshifts(t_hole, t_slot, IO_socketobjecthash(s_socket_objects[t_slot] . object) & t_mask))
+		{
+			s_socket_objects[t_hole] = s_socket_objects[t_slot];
+			t_hole = t_slot;
+		}
+	}
+	s_socket_objects[t_hole] . object = NULL;
+	s_socket_objects[t_hole] . count = 0;
+}
+
+static void IO_socketsgrow(void)
+{
+	// The globals reset MCsockets without telling us, so start again if that
+	// has happened.
+	if (MCsockets == NULL)
+		s_socket_capacity = 0;
+
+	uint2 t_capacity;
+	t_capacity = s_socket_capacity == 0 ? 16 : MCU_min(s_socket_capacity * 2, 65535);
+	MCU_realloc((char **)&MCsockets, MCnsockets, t_capacity, sizeof(MCSocket *));
+	s_socket_capacity = t_capacity;
+
+	delete[] s_socket_names;
+	delete[] s_socket_objects;
+	s_socket_index_size = 32;
+	while (s_socket_index_size < t_capacity * 2U)
+		s_socket_index_size *= 2;
+	s_socket_names = new IO_socketname[s_socket_index_size];
+	s_socket_objects = new IO_socketobject[s_socket_index_size];
+	memset(s_socket_names, 0, sizeof(IO_socketname) * s_socket_index_size);
+	memset(s_socket_objects, 0, sizeof(IO_socketobject) * s_socket_index_size);
+
+	for (uint2 i = 0 ; i < MCnsockets ; i++)
+	{
+		IO_socketnameinsert(i);
+		IO_socketobjectadd(MCsockets[i] -> object);
+	}
+}
+
+void IO_addsocket(MCSocket *s)
+{
+	if (MCsockets == NULL || MCnsockets == s_socket_capacity)
+		IO_socketsgrow();
+	MCsockets[MCnsockets] = s;
+	IO_socketnameinsert(MCnsockets);
+	IO_socketobjectadd(s -> object);
+	MCnsockets++;
+}
+
+// Delete the socket at <i>, moving the last socket into its place.
+static void IO_removesocket(uint2 i)
+{
+	IO_socketnameremove(i);
+	IO_socketobjectremove(MCsockets[i] -> object);
+	delete MCsockets[i];
+
+	uint2 t_last = --MCnsockets;
+	if (i != t_last)
+	{
+		s_socket_names[IO_socketnamefind(t_last)] . position = i + 1;
+		MCsockets[i] = MCsockets[t_last];
+	}
+}
+
+// Change the object a socket in the table sends its messages to.
+void IO_setsocketobject(MCSocket *s, MCObject *o)
+{
+	if (s -> object != o)
+	{
+		IO_socketobjectremove(s -> object);
+		IO_socketobjectadd(o);
+	}
+	s -> object = o;
+}
+
+// A socket is finished with once it has been closed and its data read.
+static inline bool IO_socketisfinished(MCSocket *s)
+{
+	return !s->waiting && s->fd == 0 && s->nread == 0 && s->resolve_state != kMCSocketStateResolving;
+}
+
 real8 IO_cleansockets(real8 ctime)
 {
 	real8 etime = ctime + MCmaxwait;
 	uint2 i = 0;
 	while (i < MCnsockets)
-		if (!MCsockets[i]->waiting && MCsockets[i]->fd == 0
-			&& MCsockets[i]->nread == 0 && MCsockets[i]->resolve_state != kMCSocketStateResolving)
-		{
-			delete MCsockets[i];
-			uint2 j = i;
-			while (++j < MCnsockets)
-				MCsockets[j - 1] = MCsockets[j];
-			MCnsockets--;
-		}
+		if (IO_socketisfinished(MCsockets[i]))
+			IO_removesocket(i);
 		else
 		{
 			MCSocket *s = MCsockets[i++];
@@ -175,15 +380,46 @@ real8 IO_cleansockets(real8 ctime)
 
 Boolean IO_findsocket(const char *name, uint2 &i)
 {
-	IO_cleansockets(MCS_time());
-	for (i = 0 ; i < MCnsockets ; i++)
-		if (strequal(MCsockets[i]->name, name))
+	if (MCnsockets == 0 || MCsockets == NULL || s_socket_names == NULL)
+		return False;
+
+	// Rather than cleaning the whole table, finished sockets are removed as
+	// they are found. If several sockets share the name, the earliest is
+	// returned.
+	uint4 t_mask = s_socket_index_size - 1;
+	hash_t t_hash = IO_socketnamehash(name);
+	for(;;)
+	{
+		uint2 t_found = 0;
+		uint4 t_slot = t_hash & t_mask;
+		while (s_socket_names[t_slot] . position != 0)
+		{
+			uint2 t_position = s_socket_names[t_slot] . position;
+			if (s_socket_names[t_slot] . hash == t_hash && strequal(MCsockets[t_position - 1] -> name, name) &&
+				(t_found == 0 || t_position < t_found))
+				t_found = t_position;
+			t_slot = (t_slot + 1) & t_mask;
+		}
+
+		if (t_found == 0)
+			return False;
+
+		if (!IO_socketisfinished(MCsockets[t_found - 1]))
+		{
+			i = t_found - 1;
 			return True;
-	return False;
+		}
+
+		IO_removesocket(t_found - 1);
+	}
 }
 
 void IO_freeobject(MCObject *o)
 {
+	// Most objects have no sockets, so avoid looking at the table at all.
+	if (IO_socketobjectcount(o) == 0)
+		return;
+
 	IO_cleansockets(MCS_time());
 	uint2 i = 0;
 	while (i < MCnsockets)
@@ -56,6 +56,8 @@ extern Boolean IO_closefile(const char *name);
 extern Boolean IO_findprocess(const char *name, uint2 &i);
 extern void IO_cleanprocesses();
 extern Boolean IO_findsocket(const char *name, uint2 &i);
+extern void IO_addsocket(MCSocket *s);
+extern void IO_setsocketobject(MCSocket *s, MCObject *o);
 extern real8 IO_cleansockets(real8 ctime);
 extern void IO_freeobject(MCObject *o);
 extern IO_stat IO_read(void *ptr, uint4 size, uint4 &n, IO_handle stream);
@@ -126,6 +128,10 @@ extern bool MCS_isfake(IO_handle stream);
 extern uint4 MCS_faketell(IO_handle stream);
 extern void MCS_fakewriteat(IO_handle stream, uint4 p_pos, const void *p_buffer, uint4 p_size);
 
+// If the stream is held in memory (a mapped file or a fake stream), return a
+// pointer to its current read position and the number of bytes which follow it.
+extern bool MCS_getreadbuffer(IO_handle stream, const char*& r_buffer, uint4& r_available);
+
 extern IO_handle MCS_open(const char *path, const char *mode, Boolean map, Boolean driver, uint4 offset);
 extern IO_stat MCS_close(IO_handle &stream);
 
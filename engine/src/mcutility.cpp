@@ -18,6 +18,21 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "globdefs.h"
 
+// SSE2 is part of the baseline for all x86-64 targets so use it for the
+// delimiter counting kernel where it is available, as the C library has no
+// equivalent. Finding a delimiter uses memchr, which glibc and the Mac libc
+// vectorize better than a plain SSE2 loop - only the Windows CRT's memchr is
+// bytewise, so the SSE2 loop is used for finding there.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MCU_USE_SSE2
+#endif
+
+#if defined(MCU_USE_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_BitScanForward)
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void *memdup(const void *p_src, unsigned int p_src_length)
@@ -113,20 +128,120 @@ bool MCU_strcaseequal(const char *a, const char *b)
 	return MCU_strcasecmp(a, b) == 0;
 }
 
+#if defined(MCU_USE_SSE2) && defined(_MSC_VER)
+static inline uint32_t MCU_lowestbit(uint32_t p_mask)
+{
+	unsigned long t_index;
+	_BitScanForward(&t_index, p_mask);
+	return t_index;
+}
+#endif
+
+const char *MCU_findchar(const char *p_start, const char *p_end, char p_target)
+{
+#if defined(MCU_USE_SSE2) && defined(_MSC_VER)
+	const char *t_ptr;
+	t_ptr = p_start;
+
+	// Process bytes individually until the pointer is 16-byte aligned, after
+	// which whole blocks can be compared at once.
+	while (t_ptr < p_end && ((uintptr_t)t_ptr & 15) != 0)
+	{
+		if (*t_ptr == p_target)
+			return t_ptr;
+		t_ptr++;
+	}
+
+	__m128i t_pattern;
+	t_pattern = _mm_set1_epi8(p_target);
+	while (p_end - t_ptr >= 32)
+	{
+		uint32_t t_mask;
+		t_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)t_ptr), t_pattern)) |
+					(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)(t_ptr + 16)), t_pattern)) << 16);
+		if (t_mask != 0)
+			return t_ptr + MCU_lowestbit(t_mask);
+		t_ptr += 32;
+	}
+
+	while (t_ptr < p_end)
+	{
+		if (*t_ptr == p_target)
+			return t_ptr;
+		t_ptr++;
+	}
+
+	return p_end;
+#else
+	const char *t_found;
+	t_found = (const char *)memchr(p_start, p_target, p_end - p_start);
+	if (t_found == NULL)
+		return p_end;
+	return t_found;
+#endif
+}
+
+uint32_t MCU_countchar(const char *p_start, const char *p_end, char p_target)
+{
+	const char *t_ptr;
+	t_ptr = p_start;
+
+	uint32_t t_count;
+	t_count = 0;
+
+#ifdef MCU_USE_SSE2
+	while (t_ptr < p_end && ((uintptr_t)t_ptr & 15) != 0)
+	{
+		if (*t_ptr == p_target)
+			t_count++;
+		t_ptr++;
+	}
+
+	// Matches are accumulated bytewise (a match compares as -1) so at most 255
+	// blocks can be processed before the accumulator must be summed.
+	__m128i t_pattern, t_zero;
+	t_pattern = _mm_set1_epi8(p_target);
+	t_zero = _mm_setzero_si128();
+	while (p_end - t_ptr >= 16)
+	{
+		uint32_t t_blocks;
+		t_blocks = MCU_min((uint32_t)((p_end - t_ptr) / 16), 255U);
+
+		__m128i t_accum;
+		t_accum = t_zero;
+		while (t_blocks-- > 0)
+		{
+			t_accum = _mm_sub_epi8(t_accum, _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)t_ptr), t_pattern));
+			t_ptr += 16;
+		}
+
+		__m128i t_sums;
+		t_sums = _mm_sad_epu8(t_accum, t_zero);
+		t_count += _mm_cvtsi128_si32(t_sums) + _mm_cvtsi128_si32(_mm_srli_si128(t_sums, 8));
+	}
+#endif
+
+	while (t_ptr < p_end)
+	{
+		if (*t_ptr == p_target)
+			t_count++;
+		t_ptr++;
+	}
+
+	return t_count;
+}
+
 Boolean MCU_strchr(const char *&sptr, uint4 &l, char target, Boolean isunicode)
 {
 	const char *startptr = sptr;
 	const char *eptr = sptr + l;
 	if (!isunicode)
 	{
-		while (sptr < eptr)
+		sptr = MCU_findchar(sptr, eptr, target);
+		if (sptr < eptr)
 		{
-			if (*sptr == target)
-			{
-				l = eptr - sptr;
-				return True;
-			}
-			sptr++;
+			l = eptr - sptr;
+			return True;
 		}
 	}
 	else
@@ -39,6 +39,13 @@ int4 MCU_strncasecmp(const char *one, const char *two, size_t n);
 bool MCU_strcaseequal(const char *a, const char *b);
 Boolean MCU_strchr(const char *&sptr, uint4 &l, char target, Boolean isunicode);
 
+// Return a pointer to the first occurrence of target in [sptr, eptr), or eptr
+// if there is none.
+const char *MCU_findchar(const char *sptr, const char *eptr, char target);
+
+// Return the number of occurrences of target in [sptr, eptr).
+uint32_t MCU_countchar(const char *sptr, const char *eptr, char target);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 inline char *MCU_empty()
@@ -439,6 +439,10 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #define CS_MENUFIELD			(1UL << 24)
 #define CS_MOUSEDOWN			(1UL << 25)
 #define CS_IN_TEXTCHANGED		(1UL << 26)
+// Set when textwidth doesn't yet account for lines whose width was deferred.
+#define CS_MEASURE_PENDING		(1UL << 27)
+// Set when recompute has only estimated the height of some paragraphs.
+#define CS_HEIGHTS_ESTIMATED	(1UL << 28)
 // MCGraphic state
 #define CS_CREATE_POINTS        (1UL << 13)
 // MCPlayer state
@@ -517,6 +521,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #define PS_BACK                 (1UL << 1)
 #define PS_HILITED              (PS_FRONT | PS_BACK)
 #define PS_LINES_NOT_SYNCHED		(1UL << 2)
+// Set when the paragraph has been laid out by estimate() rather than flowed.
+#define PS_HEIGHT_ESTIMATED		(1UL << 3)
 
 // MCStack decorations
 #define DECORATION_LENGTH     64
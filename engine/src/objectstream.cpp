@@ -27,7 +27,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "object.h"
 #include "objectstream.h"
 
-MCObjectInputStream::MCObjectInputStream(IO_handle p_stream, uint32_t p_remaining)
+MCObjectInputStream::MCObjectInputStream(IO_handle p_stream, uint32_t p_remaining, bool p_passthrough)
 {
 	m_stream = p_stream;
 	m_buffer = NULL;
@@ -36,11 +36,14 @@ MCObjectInputStream::MCObjectInputStream(IO_handle p_stream, uint32_t p_remainin
 	m_bound = 0;
 	m_remaining = p_remaining;
 	m_mark = 0;
+	m_passthrough = p_passthrough;
+	m_buffer_is_mapped = false;
 }
 
 MCObjectInputStream::~MCObjectInputStream(void)
 {
-	delete (char *)m_buffer;
+	if (!m_buffer_is_mapped)
+		delete (char *)m_buffer;
 }
 
 // Flushing reads and discards the rest of the stream
@@ -217,13 +220,15 @@ IO_stat MCObjectInputStream::ReadCString(char*& r_value)
 		}
 
 		uint32_t t_offset;
-		for(t_offset = 0; t_offset < m_limit - m_frontier; ++t_offset)
-			if (((char *)m_buffer)[m_frontier + t_offset] == '\0')
-			{
-				t_offset += 1;
-				t_finished = true;
-				break;
-			}
+		const char *t_nul;
+		t_nul = (const char *)memchr((char *)m_buffer + m_frontier, '\0', m_limit - m_frontier);
+		if (t_nul != NULL)
+		{
+			t_offset = t_nul - ((char *)m_buffer + m_frontier) + 1;
+			t_finished = true;
+		}
+		else
+			t_offset = m_limit - m_frontier;
 
 		uint32_t t_new_length;
 		t_new_length = t_length + t_offset;
@@ -262,10 +267,25 @@ IO_stat MCObjectInputStream::ReadCString(char*& r_value)
 
 IO_stat MCObjectInputStream::ReadNameRef(MCNameRef& r_value)
 {
+	// If the stream is being read in place, the name can be made straight from
+	// the string in it.
+	const char *t_borrowed_cstring;
+	t_borrowed_cstring = nil;
+
+	IO_stat t_stat;
+	t_stat = ReadBorrowedCString(t_borrowed_cstring);
+	if (t_stat != IO_NORMAL)
+		return t_stat;
+	if (t_borrowed_cstring != nil)
+	{
+		if (!MCNameCreateWithCString(t_borrowed_cstring, r_value))
+			return IO_ERROR;
+		return IO_NORMAL;
+	}
+
 	char *t_name_cstring;
 	t_name_cstring = nil;
 
-	IO_stat t_stat;
 	t_stat = ReadCString(t_name_cstring);
 	if (t_stat == IO_NORMAL &&
 		!MCNameCreateWithCString(t_name_cstring != nil ? t_name_cstring : MCnullstring, r_value))
@@ -320,6 +340,57 @@ IO_stat MCObjectInputStream::Read(void *p_buffer, uint32_t p_amount)
 	return IO_NORMAL;
 }
 
+IO_stat MCObjectInputStream::ReadBorrowed(const void*& r_data, uint32_t p_amount)
+{
+	r_data = nil;
+
+	// The first Fill decides whether the stream is read in place.
+	if (m_buffer == nil && m_remaining != 0)
+	{
+		IO_stat t_stat;
+		t_stat = Fill();
+		if (t_stat != IO_NORMAL)
+			return t_stat;
+	}
+
+	if (!m_buffer_is_mapped)
+		return IO_NORMAL;
+
+	if (m_limit - m_frontier < p_amount)
+		return IO_EOF;
+
+	r_data = (char *)m_buffer + m_frontier;
+	m_frontier += p_amount;
+
+	return IO_NORMAL;
+}
+
+IO_stat MCObjectInputStream::ReadBorrowedCString(const char*& r_value)
+{
+	r_value = nil;
+
+	if (m_buffer == nil && m_remaining != 0)
+	{
+		IO_stat t_stat;
+		t_stat = Fill();
+		if (t_stat != IO_NORMAL)
+			return t_stat;
+	}
+
+	if (!m_buffer_is_mapped)
+		return IO_NORMAL;
+
+	const char *t_nul;
+	t_nul = (const char *)memchr((char *)m_buffer + m_frontier, '\0', m_limit - m_frontier);
+	if (t_nul == NULL)
+		return IO_EOF;
+
+	r_value = (char *)m_buffer + m_frontier;
+	m_frontier += t_nul - r_value + 1;
+
+	return IO_NORMAL;
+}
+
 IO_stat MCObjectInputStream::Fill(void)
 {
 	if (m_remaining == 0)
@@ -327,6 +398,28 @@ IO_stat MCObjectInputStream::Fill(void)
 
 	IO_stat t_stat;
 
+	// If the input stream is in memory, then the buffer can just point at it - this
+	// saves copying everything through the 16K buffer. This is only possible if
+	// the data needs no transformation, as the memory must not be modified.
+	const char *t_mapped_buffer;
+	uint32_t t_mapped_available;
+	if (m_passthrough && m_buffer == nil &&
+		MCS_getreadbuffer(m_stream, t_mapped_buffer, t_mapped_available) &&
+		t_mapped_available >= m_remaining)
+	{
+		t_stat = MCS_seek_cur(m_stream, m_remaining);
+		if (t_stat != IO_NORMAL)
+			return t_stat;
+
+		m_buffer = (void *)t_mapped_buffer;
+		m_buffer_is_mapped = true;
+		m_bound = m_remaining;
+		m_limit = m_remaining;
+		m_remaining = 0;
+
+		return IO_NORMAL;
+	}
+
 	if (m_buffer == nil)
 		m_buffer = new char[16384];
 	
@@ -362,13 +455,17 @@ IO_stat MCObjectInputStream::Fill(void)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-MCObjectOutputStream::MCObjectOutputStream(IO_handle p_stream)
+MCObjectOutputStream::MCObjectOutputStream(IO_handle p_stream, bool p_passthrough)
 {
 	m_stream = p_stream;
 
 	m_buffer = new char[16384];
 	m_frontier = 0;
 	m_mark = 0;
+
+	m_passthrough = p_passthrough;
+	m_direct_buffer = nil;
+	m_direct_amount = 0;
 }
 
 MCObjectOutputStream::~MCObjectOutputStream(void)
@@ -461,6 +558,23 @@ IO_stat MCObjectOutputStream::WriteColor(const MCColor &p_value)
 
 IO_stat MCObjectOutputStream::Write(const void *p_buffer, uint32_t p_amount)
 {
+	// Large blocks (such as image data or long property values) are handed to
+	// Flush to write directly rather than being copied through the buffer in 16K
+	// pieces - as long as Flush won't be transforming the data.
+	if (m_passthrough && p_amount >= 16384)
+	{
+		m_direct_buffer = p_buffer;
+		m_direct_amount = p_amount;
+
+		IO_stat t_stat;
+		t_stat = Flush(false);
+
+		m_direct_buffer = nil;
+		m_direct_amount = 0;
+
+		return t_stat;
+	}
+
 	while(p_amount > 0)
 	{
 		if (m_frontier == 16384)
@@ -500,5 +614,12 @@ IO_stat MCObjectOutputStream::Flush(bool p_end)
 	m_frontier -= m_mark;
 	m_mark = 0;
 
+	if (m_direct_amount != 0)
+	{
+		t_stat = MCS_write(m_direct_buffer, m_direct_amount, t_count, m_stream);
+		if (t_stat != IO_NORMAL)
+			return t_stat;
+	}
+
 	return IO_NORMAL;
 }
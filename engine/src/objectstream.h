@@ -22,7 +22,10 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 class MCObjectInputStream
 {
 public:
-	MCObjectInputStream(IO_handle p_stream, uint32_t p_remaining);
+	// If p_passthrough is true, the stream's data is used exactly as read (no
+	// decryption or other transformation happens in Fill), so it may be read in
+	// place when the underlying handle is held in memory.
+	MCObjectInputStream(IO_handle p_stream, uint32_t p_remaining, bool p_passthrough = false);
 	virtual ~MCObjectInputStream(void);
 
 	IO_stat ReadTag(uint32_t& r_flags, uint32_t& r_length, uint32_t& r_header_length);
@@ -42,6 +45,14 @@ public:
 
 	IO_stat Read(void *p_buffer, uint32_t p_amount);
 
+	// If the stream is being read in place (see Fill), these point r_data at the
+	// next p_amount bytes, or r_value at the next (NUL-terminated) string, and
+	// move past them without copying anything. The pointer is valid as long as
+	// the underlying handle is open. Otherwise, nothing is read and the pointer
+	// is set to nil, and the caller should use Read or ReadCString instead.
+	IO_stat ReadBorrowed(const void*& r_data, uint32_t p_amount);
+	IO_stat ReadBorrowedCString(const char*& r_value);
+
 	IO_stat Mark(void);
 	IO_stat Skip(uint32_t p_amount);
 	IO_stat Flush(void);
@@ -56,6 +67,13 @@ protected:
 	// Pointer to buffer holding input data
 	void *m_buffer;
 
+	// If true, the data is not transformed as it is read.
+	bool m_passthrough;
+
+	// If true, the buffer points directly into the input stream's memory (as
+	// the stream was a mapped file or a fake stream) and isn't owned.
+	bool m_buffer_is_mapped;
+
 	// The current read head
 	uint32_t m_frontier;
 
@@ -74,7 +92,10 @@ protected:
 class MCObjectOutputStream
 {
 public:
-	MCObjectOutputStream(IO_handle p_stream);
+	// If p_passthrough is true, the buffered data is written exactly as it is
+	// (no encryption or other transformation happens in Flush), so large blocks
+	// may be written without copying them into the buffer.
+	MCObjectOutputStream(IO_handle p_stream, bool p_passthrough = false);
 	virtual ~MCObjectOutputStream(void);
 
 	IO_stat WriteTag(uint32_t p_flags, uint32_t p_length);
@@ -114,6 +135,14 @@ protected:
 	void *m_buffer;
 	uint32_t m_mark;
 	uint32_t m_frontier;
+
+	// If true, the data is not transformed as it is written.
+	bool m_passthrough;
+
+	// A large block which is to be written by the next Flush, after the
+	// buffered data.
+	const void *m_direct_buffer;
+	uint32_t m_direct_amount;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
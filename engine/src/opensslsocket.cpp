@@ -82,6 +82,10 @@ extern char *osx_cfstring_to_cstring(CFStringRef p_string, bool p_release);
 #include <netdb.h>
 #include <unistd.h>
 
+#ifdef _LINUX_DESKTOP
+#include <sys/epoll.h>
+#endif
+
 #endif
 
 #include <openssl/bio.h>
@@ -113,6 +117,7 @@ extern "C" char *strdup(const char *);
 #define READ_SOCKET_SIZE  4096
 
 Boolean MCSocket::sslinited = False;
+Boolean MCSocket::anyadded = False;
 
 #ifdef _MACOSX
 static void socketCallback (CFSocketRef cfsockref, CFSocketCallBackType type, CFDataRef address, const void *pData, void *pInfo)
@@ -608,7 +613,7 @@ void MCS_read_socket(MCSocket *s, MCExecPoint &ep, uint4 length, char *until, MC
 	{
 		MCNameDelete(s->message);
 		/* UNCHECKED */ MCNameClone(mptr, s -> message);
-		s->object = ep.getobj();
+		IO_setsocketobject(s, ep.getobj());
 		delete until;
 	}
 	else
@@ -728,7 +733,7 @@ void MCS_write_socket(const MCString &d, MCSocket *s, MCObject *optr, MCNameRef
 		if (mptr != NULL)
 		{
 			MCscreen->delaymessage(optr, mptr, strclone(s->name));
-			s->added = True;
+			s->setadded();
 		}
 	}
 	else
@@ -1047,6 +1052,13 @@ MCSocket::MCSocket(char *n, MCObject *o, MCNameRef m, Boolean d, MCSocketHandle
 
 MCSocket::~MCSocket()
 {
+#ifdef _LINUX_DESKTOP
+	// A socket can be deleted without being closed, so make sure epoll no
+	// longer refers to it.
+	if (fd != 0)
+		setselect(0);
+#endif
+
 	delete name;
 	MCNameDelete(message);
 	deletereads();
@@ -1152,14 +1164,13 @@ void MCSocket::acceptone()
 		char *t = inet_ntoa(addr.sin_addr);
 		char *n = new char[strlen(t) + I4L];
 		sprintf(n, "%s:%d", t, newfd);
-		MCU_realloc((char **)&MCsockets, MCnsockets,
-		            MCnsockets + 1, sizeof(MCSocket *));
-		MCsockets[MCnsockets] = new MCSocket(n, object, NULL,
-		                                     False, newfd, False, False,False);
-		MCsockets[MCnsockets]->connected = True;
-		MCsockets[MCnsockets++]->setselect();
+		MCSocket *t_socket = new MCSocket(n, object, NULL,
+		                                  False, newfd, False, False,False);
+		t_socket->connected = True;
+		t_socket->setselect();
+		IO_addsocket(t_socket);
 		MCscreen->delaymessage(object, message, strclone(n), strclone(name));
-		added = True;
+		setadded();
 	}
 }
 #endif
@@ -1212,10 +1223,8 @@ void MCSocket::readsome()
 				uint2 index;
 				if (accepting && !IO_findsocket(n, index))
 				{
-					MCU_realloc((char **)&MCsockets, MCnsockets,
-					            MCnsockets + 1, sizeof(MCSocket *));
-					MCsockets[MCnsockets++] = new MCSocket(strclone(n), object, NULL,
-					                                       True, fd, False, True,False);
+					IO_addsocket(new MCSocket(strclone(n), object, NULL,
+					                          True, fd, False, True,False));
 				}
 				MCParameter *params = new MCParameter;
 				params->setbuffer(n, strlen(n));
@@ -1226,7 +1235,7 @@ void MCSocket::readsome()
 				MCscreen->addmessage(object, message, curtime, params);
 			}
 		}
-		added = True;
+		setadded();
 		doread = False;
 	}
 	else
@@ -1235,7 +1244,7 @@ void MCSocket::readsome()
 		{
 #ifdef _WINDOWS
 			acceptone();
-			added = True;
+			setadded();
 #else
 
 			int newfd = accept(fd, (struct sockaddr *)&addr, &addrsize);
@@ -1246,16 +1255,15 @@ void MCSocket::readsome()
 				char *t = inet_ntoa(addr.sin_addr);
 				char *n = new char[strlen(t) + U2L];
 				sprintf(n, "%s:%d", t, MCSwapInt16NetworkToHost(addr.sin_port));
-				MCU_realloc((char **)&MCsockets, MCnsockets,
-							MCnsockets + 1, sizeof(MCSocket *));
-				MCsockets[MCnsockets] = new MCSocket(n, object, NULL,
-													 False, newfd, False, False,secure);
-				MCsockets[MCnsockets]->connected = True;
+				MCSocket *t_socket = new MCSocket(n, object, NULL,
+												  False, newfd, False, False,secure);
+				t_socket->connected = True;
 				if (secure)
-					MCsockets[MCnsockets]->sslaccept();
-				MCsockets[MCnsockets++]->setselect();
+					t_socket->sslaccept();
+				t_socket->setselect();
+				IO_addsocket(t_socket);
 				MCscreen->delaymessage(object, message, strclone(n), strclone(name));
-				added = True;
+				setadded();
 			}
 #endif
 
@@ -1364,7 +1372,7 @@ void MCSocket::processreadqueue()
 				delete e;
 				if (nread == 0 && fd == 0)
 					MCscreen->delaymessage(object, MCM_socket_closed, strclone(name));
-				added = True;
+				setadded();
 			}
 			else
 				break;
@@ -1381,7 +1389,7 @@ void MCSocket::writesome()
 	{
 #endif
 		MCscreen->delaymessage(object, message, strclone(name));
-		added = True;
+		setadded();
 		MCNameDelete(message);
 		message = NULL;
 	}
@@ -1423,7 +1431,7 @@ void MCSocket::writesome()
 				MCSocketwrite *e = wevents->remove
 				                   (wevents);
 				MCscreen->delaymessage(e->optr, e->message, strclone(name));
-				added = True;
+				setadded();
 				delete e;
 			}
 			else
@@ -1451,13 +1459,13 @@ void MCSocket::doclose()
 		if (error != NULL)
 		{
 			MCscreen->delaymessage(object, MCM_socket_error, strclone(name), error);
-			added = True;
+			setadded();
 		}
 		else
 			if (nread == 0)
 			{
 				MCscreen->delaymessage(object, MCM_socket_closed, strclone(name));
-				added = True;
+				setadded();
 			}
 	}
 }
@@ -1468,6 +1476,18 @@ void MCSocket::setselect()
 	uint2 bioselectstate = 0;
 	if (fd)
 	{
+#if defined(_LINUX_DESKTOP)
+		// MCS_poll reads from every connected socket, not just those with
+		// pending reads, so that closure is noticed. Resolving sockets are
+		// not watched until they start connecting.
+		if (resolve_state != kMCSocketStateResolving && resolve_state != kMCSocketStateError)
+		{
+			if (connected && !closing && !shared || accepting)
+				bioselectstate |= BIONB_TESTREAD;
+			if (!connected || wevents != NULL)
+				bioselectstate |= BIONB_TESTWRITE;
+		}
+#else
 #ifdef _WINDOWS
 		if (connected && !closing && (!shared && revents != NULL || accepting || datagram))
 #else
@@ -1478,6 +1498,7 @@ void MCSocket::setselect()
 			bioselectstate |= BIONB_TESTREAD;
 		if (!connected || wevents != NULL)
 			bioselectstate |= BIONB_TESTWRITE;
+#endif
 		setselect(bioselectstate);
 	}
 }
@@ -1503,11 +1524,48 @@ void MCSocket::setselect(uint2 sflags)
 	if (sflags & BIONB_TESTREAD)
 		CFSocketEnableCallBacks(cfsockref,kCFSocketReadCallBack);
 #endif
+#ifdef _LINUX_DESKTOP
+	// Shared datagram sockets use their listener's descriptor, which is
+	// registered by the listener.
+	int t_epoll;
+	t_epoll = MCS_socket_epoll();
+	if (t_epoll != -1 && !shared)
+	{
+		uint4 t_events = 0;
+		if (sflags & BIONB_TESTREAD)
+			t_events |= EPOLLIN;
+		if (sflags & BIONB_TESTWRITE)
+			t_events |= EPOLLOUT;
+		
+		if (t_events != pollevents)
+		{
+			struct epoll_event t_event;
+			t_event . events = t_events;
+			t_event . data . ptr = this;
+			
+			// A registered descriptor always reports errors and hangups, so
+			// sockets with no interest are removed from the set.
+			if (t_events == 0)
+				epoll_ctl(t_epoll, EPOLL_CTL_DEL, fd, &t_event);
+			else
+				epoll_ctl(t_epoll, pollevents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &t_event);
+			
+			pollevents = t_events;
+		}
+	}
+#endif
 }
 
 Boolean MCSocket::init(MCSocketHandle newfd)
 {
 	fd = newfd;
+#ifdef _LINUX_DESKTOP
+
+	// Sockets are not polled unless registered, so register the interest of
+	// the new socket now.
+	pollevents = 0;
+	setselect();
+#endif
 #ifdef _MACOSX
 
 	cfsockref = NULL;
@@ -1541,6 +1599,9 @@ void MCSocket::close()
 			rlref = NULL;
 		}
 #endif
+#ifdef _LINUX_DESKTOP
+		setselect(0);
+#endif
 #ifdef _WINDOWS
 		closesocket(fd);
 #else
@@ -237,6 +237,12 @@ enum MCSOutputLineEndings
 void MCS_set_outputlineendings(MCSOutputLineEndings line_endings);
 MCSOutputLineEndings MCS_get_outputlineendings(void);
 
+enum MCSSessionStore
+{
+	kMCSSessionStoreIndex,
+	kMCSSessionStoreSharded,
+};
+
 bool MCS_set_session_save_path(const char *p_path);
 const char *MCS_get_session_save_path(void);
 bool MCS_set_session_lifetime(uint32_t p_lifetime);
@@ -245,6 +251,10 @@ bool MCS_set_session_name(const char *p_name);
 const char *MCS_get_session_name(void);
 bool MCS_set_session_id(const char *p_id);
 const char *MCS_get_session_id(void);
+bool MCS_set_session_store(MCSSessionStore p_store);
+MCSSessionStore MCS_get_session_store(void);
+
+void MCS_get_include_cache_statistics(uint32_t& r_hits, uint32_t& r_misses);
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -49,8 +49,6 @@ MCScreenDC::MCScreenDC()
 	lockcolormap = False;
 	ownselection = False;
 	messageid = 0;
-	nmessages = maxmessages = 0;
-	messages = NULL;
 	beeppitch = 1440L;                    //1440 Hz
 	beepduration = 500;                 // 1/2 second
 	pendingevents = NULL;
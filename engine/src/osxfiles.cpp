@@ -206,6 +206,20 @@ void MCS_fakewriteat(IO_handle stream, uint4 p_pos, const void *p_buffer, uint4
 	memcpy(stream -> buffer + p_pos, p_buffer, p_size);
 }
 
+bool MCS_getreadbuffer(IO_handle stream, const char*& r_buffer, uint4& r_available)
+{
+	if ((stream -> flags & IO_FAKECUSTOM) == IO_FAKECUSTOM || (stream -> flags & IO_FAKEWRITE) == IO_FAKEWRITE)
+		return false;
+
+	if (stream -> serialIn != 0 || stream -> fptr != NULL || stream -> buffer == NULL)
+		return false;
+
+	r_buffer = stream -> ioptr;
+	r_available = stream -> len - (stream -> ioptr - stream -> buffer);
+
+	return true;
+}
+
 void MCS_loadfile(MCExecPoint &ep, Boolean binary)
 {
 	if (!MCSecureModeCanAccessDisk())
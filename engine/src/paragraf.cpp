@@ -115,6 +115,8 @@ MCParagraph::MCParagraph()
 	opened = 0;
 	startindex = endindex = originalindex = MAXUINT2;
 	state = 0;
+	estimatedlines = 0;
+	indexchunk = NULL;
 
 	// MW-2012-01-25: [[ ParaStyles ]] All attributes are unset to begin with.
 	attrs = nil;
@@ -155,10 +157,15 @@ MCParagraph::MCParagraph(const MCParagraph &pref) : MCDLlist(pref)
 	startindex = endindex = originalindex = MAXUINT2;
 	opened = 0;
 	state = 0;
+	estimatedlines = 0;
+	indexchunk = NULL;
 }
 
 MCParagraph::~MCParagraph()
 {
+	// Deleting a paragraph unlinks it from its list.
+	if (indexchunk != NULL)
+		MCFieldParagraphIndexRemove(this);
 	while (opened)
 		close();
 	if (text != NULL)
@@ -208,6 +215,7 @@ IO_stat MCParagraph::load(IO_handle stream, const char *version, bool is_ext)
 	if ((stat = IO_read_string(text, t_length, stream, 2, true, false)) != IO_NORMAL)
 		return stat;
 	textsize = t_length;
+	indexchanged();
 
 	// MW-2012-03-04: [[ StackFile5500 ]] If this is an extended paragraph then
 	//   load in the attribute extension record.
@@ -396,6 +404,26 @@ void MCParagraph::setparent(MCField *newparent)
 	parent = newparent;
 }
 
+void MCParagraph::indexlink(MCParagraph *p_anchor, bool p_before)
+{
+	if (indexchunk == NULL && p_anchor -> indexchunk == NULL)
+		return;
+
+	// Linking a single paragraph into an indexed list is the common case (when
+	// appending, or splitting a paragraph), and the index can be updated in
+	// place. Anything else changes the lists too much, so their indices are
+	// discarded.
+	if (indexchunk == NULL && next() == this)
+		MCFieldParagraphIndexInsert(p_anchor, this, p_before);
+	else
+	{
+		if (indexchunk != NULL)
+			MCFieldParagraphIndexDiscard(this);
+		if (p_anchor -> indexchunk != NULL)
+			MCFieldParagraphIndexDiscard(p_anchor);
+	}
+}
+
 // MW-2012-02-14: [[ FontRefs ]] Recalculate the block's fontrefs using the new parent fontref.
 bool MCParagraph::recomputefonts(MCFontRef p_parent_font)
 {
@@ -461,6 +489,7 @@ void MCParagraph::deletelines()
 		MCLine *lptr = lines->remove(lines);
 		delete lptr;
 	}
+	indexchanged();
 }
 
 // **** mutate blocks
@@ -584,7 +613,8 @@ void MCParagraph::flow(void)
 		lptr->makedirty();
 	}
 
-	state &= ~PS_LINES_NOT_SYNCHED;
+	state &= ~(PS_LINES_NOT_SYNCHED | PS_HEIGHT_ESTIMATED);
+	indexchanged();
 }
 
 //flow paragraph and don't wrap
@@ -617,7 +647,28 @@ void MCParagraph::noflow(void)
 	if (t_table_width != 0)
 		lines -> setwidth(t_table_width);
 
-	state &= ~PS_LINES_NOT_SYNCHED;
+	state &= ~(PS_LINES_NOT_SYNCHED | PS_HEIGHT_ESTIMATED);
+	indexchanged();
+}
+
+// Wrapping a paragraph means measuring all of its text, so for paragraphs that
+// aren't visible the field uses this instead. The paragraph is laid out as if
+// it didn't wrap (which doesn't measure anything), and the number of lines it
+// will take up is estimated from its length. Any indent on the first line is
+// ignored, as are the widths of the words at the ends of lines.
+void MCParagraph::estimate(int32_t p_char_width)
+{
+	noflow();
+
+	int32_t pwidth, twidth;
+	computelayoutwidths(pwidth, twidth);
+
+	uint32_t t_lines;
+	t_lines = (textsize * p_char_width + pwidth - 1) / pwidth;
+	estimatedlines = MCU_max(MCU_min(t_lines, (uint32_t)MAXUINT2), 1U);
+
+	state |= PS_HEIGHT_ESTIMATED;
+	indexchanged();
 }
 
 // MW-2008-04-02: [[ Bug 6259 ]] Make sure front and back hilites are only
@@ -1508,6 +1559,7 @@ void MCParagraph::join()
 	}
 	while (bptr != blocks);
 	textsize += pgptr->textsize;
+	indexchanged();
 	pgptr->blocks = NULL;
 	delete pgptr;
 	clearzeros();
@@ -1532,6 +1584,7 @@ void MCParagraph::split() //split paragraphs on return
 	//   list index.
 	pgptr -> setlistindex(0);
 	textsize = buffersize = focusedindex;
+	indexchanged();
 	if (!buffersize)
 		buffersize = 1;
 	text = new char[buffersize];
@@ -1625,6 +1678,7 @@ void MCParagraph::deletestring(uint2 si, uint2 ei)
 	if (textsize - ei)
 		memmove(&text[si], &text[ei], textsize - ei);
 	textsize -= length;
+	indexchanged();
 	clearzeros();
 
 	state |= PS_LINES_NOT_SYNCHED;
@@ -1774,6 +1828,7 @@ void MCParagraph::finsertnobreak(const MCString& p_text, bool p_is_unicode)
 		// Now copy in the new text.
 		memcpy(text + focusedindex, t_bytes, t_byte_length);
 		textsize += t_byte_length;
+		indexchanged();
 
 		// Update the index of the first block, and then all the subsequent blocks.
 		t_block -> moveindex(text, 0, t_byte_length);
@@ -2547,6 +2602,7 @@ void MCParagraph::inittext()
 		text = new char[1];
 		text[0] = '\0';
 		textsize = buffersize = 0;
+		indexchanged();
 	}
 	deletelines();
 	deleteblocks();
@@ -2721,6 +2777,7 @@ void MCParagraph::settext(char *tptr, uint2 length, bool p_is_unicode)
 	deleteblocks();
 	text = tptr;
 	textsize = buffersize = length;
+	indexchanged();
 	blocks = new MCBlock;
 	blocks->setparent(this);
 	blocks->setindex(text, 0, length);
@@ -2731,6 +2788,7 @@ void MCParagraph::resettext(char *tptr, uint2 length)
 {
 	text = tptr;
 	textsize = buffersize = length;
+	indexchanged();
 	uint2 i, l;
 	if (blocks == NULL)
 	{
@@ -2743,37 +2801,20 @@ void MCParagraph::resettext(char *tptr, uint2 length)
 	blocks->prev()->setindex(text, i, MCU_max(length - i, 0));
 }
 
-void MCParagraph::getmaxline(uint2 &width, uint2 &aheight, uint2 &dheight)
+void MCParagraph::getmaxline(uint2 &aheight, uint2 &dheight)
 {
-	width = aheight = dheight = 0;
+	aheight = dheight = 0;
 	if (lines != NULL)
 	{
-		int32_t t_first_indent;
-		t_first_indent = getfirstindent();
-
 		MCLine *lptr = lines;
 		do
 		{
-			uint2 t_line_width;
-			t_line_width = lptr -> getwidth();
-
-			// MW-2012-03-16: [[ Bug 10001 ]] Adjust the line width to take into
-			//   account any extra width added by first indent (-ve first indent
-			//   widens non-first lines; +ve first indent widens first line).
-			if (lines == lptr)
-				t_line_width += MCMax(0, t_first_indent);
-			else
-				t_line_width -= MCMin(0, t_first_indent);
-
-			width = MCU_max(width, t_line_width);
 			aheight = MCU_max(aheight, lptr->getascent());
 			dheight = MCU_max(dheight, lptr->getdescent());
 			lptr = lptr->next();
 		}
 		while (lptr != lines);
 	}
-
-	width += computeleftmargin() + computerightmargin();
 }
 
 uint2 MCParagraph::getwidth() const
@@ -2823,7 +2864,11 @@ uint2 MCParagraph::getheight(uint2 fixedheight) const
 	//   before.
 	height += computetopmargin();
 
-	if (lines != NULL)
+	// An estimated paragraph has a single line, standing in for each of
+	// the lines it is expected to wrap onto.
+	if (lines != NULL && (state & PS_HEIGHT_ESTIMATED) != 0)
+		height += MCU_min((fixedheight == 0 ? lines->getheight() : fixedheight) * (uint4)estimatedlines, (uint4)(MAXUINT2 - height));
+	else if (lines != NULL)
 	{
 		MCLine *lptr = lines;
 		do
@@ -90,6 +90,18 @@ enum
 	kMCParagraphListStyleSkip,
 };
 
+// A part of a field's paragraph index (see fields.cpp).
+struct MCFieldParagraphChunk;
+
+// Called by a paragraph in an indexed list to keep the index up to date when
+// its size or layout changes, when a paragraph is linked in before or after
+// it, or when it is unlinked. If the list changes in some other way, the
+// index is discarded.
+void MCFieldParagraphIndexChanged(MCParagraph *p_paragraph);
+void MCFieldParagraphIndexInsert(MCParagraph *p_anchor, MCParagraph *p_paragraph, bool p_before);
+void MCFieldParagraphIndexRemove(MCParagraph *p_paragraph);
+void MCFieldParagraphIndexDiscard(MCParagraph *p_paragraph);
+
 // MW-2012-01-25: [[ ParaStyles ]] A collection of paragraph attributes.
 struct MCParagraphAttrs
 {
@@ -137,8 +149,14 @@ class MCParagraph : public MCDLlist
 	uint2 startindex, endindex, originalindex;
 	uint2 opened;
 	uint1 state;
+	// The number of lines the paragraph is expected to wrap onto, if its
+	// height is an estimate.
+	uint2 estimatedlines;
 	// MW-2012-01-25: [[ ParaStyles ]] This paragraphs collection of attrs.
 	MCParagraphAttrs *attrs;
+	// The part of the paragraph index holding the paragraph, if the list it is
+	// in has been indexed by a field.
+	MCFieldParagraphChunk *indexchunk;
 
 	static uint2 cursorwidth;
 
@@ -165,6 +183,28 @@ public:
 	}
 	void setparent(MCField *newparent);
 
+	MCFieldParagraphChunk *getindexchunk(void)
+	{
+		return indexchunk;
+	}
+	void setindexchunk(MCFieldParagraphChunk *p_chunk)
+	{
+		indexchunk = p_chunk;
+	}
+
+	// Tells the index of the list the paragraph is in (if any) that its text
+	// size or layout has changed.
+	void indexchanged(void)
+	{
+		if (indexchunk != NULL)
+			MCFieldParagraphIndexChanged(this);
+	}
+
+	// Keeps the index of the list 'p_anchor' is in (and that of this paragraph's
+	// list) up to date as this paragraph's list is linked in after 'p_anchor',
+	// or in front of it if 'p_before' is true. Must be called before linking.
+	void indexlink(MCParagraph *p_anchor, bool p_before);
+
 	// MW-2012-02-14: [[ FontRefs ]] Invoked to recompute the block's fontrefs based
 	//   on a new parent fontref.
 	bool recomputefonts(MCFontRef parent_font);
@@ -332,11 +372,12 @@ public:
 	//   MCField::htmltoparagraphs
 	void resettext(char *tptr, uint2 length);
 
-	// Calculate the maximum of the width, ascender and descender of all
-	// lines that make up the paragraph.
+	// Calculate the maximum of the ascender and descender of all lines that
+	// make up the paragraph. The width is left to getwidth() so that lines
+	// which are never drawn don't need to be measured.
 	// Called by:
 	//   MCField::recompute
-	void getmaxline(uint2 &width, uint2 &aheight, uint2 &dheight);
+	void getmaxline(uint2 &aheight, uint2 &dheight);
 
 	// Calculate the height of the paragraph, using the given fixedheight
 	// if non-zero.
@@ -579,6 +620,20 @@ public:
 
 	// Force the paragraph to re-flow itself depending on its setting of dontWrap.
 	void layout(void);
+
+	// Lay the paragraph out on a single line without measuring its text, and
+	// estimate from its length how many lines it will wrap onto, given the
+	// average width of a character. Its height is then an estimate until it is
+	// next laid out.
+	// Called by:
+	//   MCField::recompute
+	void estimate(int32_t p_char_width);
+
+	// Returns true if the paragraph's height is an estimate.
+	bool isestimated(void) const
+	{
+		return (state & PS_HEIGHT_ESTIMATED) != 0;
+	}
 	
 	// MW-2012-01-27: [[ UnicodeChunks ]] Returns the content of the field in a native
 	//   form such that indices match that of the original content. If ASCII-only is
@@ -683,28 +738,45 @@ public:
 	{
 		return (MCParagraph *)MCDLlist::prev();
 	}
+	// The list operations keep any paragraph index up to date, so don't use
+	// MCDLlist's directly.
 	void totop(MCParagraph *&list)
 	{
-		MCDLlist::totop((MCDLlist *&)list);
+		if (this != list)
+		{
+			remove(list);
+			insertto(list);
+		}
 	}
 	void insertto(MCParagraph *&list)
 	{
+		if (list != NULL)
+			indexlink(list, true);
 		MCDLlist::insertto((MCDLlist *&)list);
 	}
 	void appendto(MCParagraph *&list)
 	{
+		if (list != NULL)
+			indexlink(list -> prev(), false);
 		MCDLlist::appendto((MCDLlist *&)list);
 	}
 	void append(MCParagraph *node)
 	{
+		node -> indexlink(this, false);
 		MCDLlist::append((MCDLlist *)node);
 	}
 	void splitat(MCParagraph *node)
 	{
+		if (indexchunk != NULL)
+			MCFieldParagraphIndexDiscard(this);
+		if (node -> indexchunk != NULL)
+			MCFieldParagraphIndexDiscard(node);
 		MCDLlist::splitat((MCDLlist *)node) ;
 	}
 	MCParagraph *remove(MCParagraph *&list)
 	{
+		if (indexchunk != NULL)
+			MCFieldParagraphIndexRemove(this);
 		return (MCParagraph *)MCDLlist::remove((MCDLlist *&)list);
 	}
 
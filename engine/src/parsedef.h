@@ -21,12 +21,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #define	PARSEDEFS_H
 
 // for regex
-#define PATTERN_CACHE_SIZE 20
-extern char *MCregexpatterns[];
-
 #define NSUBEXP  50
 typedef struct _regexp regexp;
-extern regexp *MCregexcache[];
 
 typedef struct _constant
 {
@@ -917,6 +913,7 @@ enum Properties {
     P_IDLE_TICKS,
     P_BLINK_RATE,
     P_RECURSION_LIMIT,
+    P_REGEX_CACHE_SIZE,
     P_REPEAT_RATE,
     P_REPEAT_DELAY,
     P_TYPE_RATE,
@@ -1082,9 +1079,11 @@ enum Properties {
 	P_SESSION_LIFETIME,
 	P_SESSION_COOKIE_NAME,
 	P_SESSION_ID,
+	P_SESSION_STORE,
 
 	P_SCRIPT_EXECUTION_ERRORS,
 	P_SCRIPT_PARSING_ERRORS,
+	P_INCLUDE_CACHE_STATISTICS,
 	P_DEFAULT_NETWORK_INTERFACE,
 
 	/* 2013-01-07-IM global property to control image cache limit */
@@ -1739,6 +1738,8 @@ enum Sugar_constants {
 	SG_OPEN,
 	SG_CLOSED,
 	SG_CALLER,
+	SG_REGEX,
+	SG_PATTERN,
 };
 
 enum Statements {
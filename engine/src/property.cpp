@@ -328,6 +328,7 @@ Parse_stat MCProperty::parse(MCScriptPoint &sp, Boolean the)
 	case P_IDLE_TICKS:
 	case P_BLINK_RATE:
 	case P_RECURSION_LIMIT:
+	case P_REGEX_CACHE_SIZE:
 	case P_REPEAT_RATE:
 	case P_REPEAT_DELAY:
 	case P_TYPE_RATE:
@@ -503,9 +504,11 @@ Parse_stat MCProperty::parse(MCScriptPoint &sp, Boolean the)
 	case P_SESSION_LIFETIME:
 	case P_SESSION_COOKIE_NAME:
 	case P_SESSION_ID:
+	case P_SESSION_STORE:
 	
 	case P_SCRIPT_EXECUTION_ERRORS:
 	case P_SCRIPT_PARSING_ERRORS:
+	case P_INCLUDE_CACHE_STATISTICS:
 			
 	case P_REV_RUNTIME_BEHAVIOUR:
 	
@@ -1289,6 +1292,29 @@ Exec_stat MCProperty::set(MCExecPoint &ep)
 		}
 	}
 	break;
+	case P_SESSION_STORE:
+	{
+		MCString t_value;
+		t_value = ep.getsvalue();
+		
+		MCSSessionStore t_store;
+		if (t_value == "index")
+			t_store = kMCSSessionStoreIndex;
+		else if (t_value == "sharded")
+			t_store = kMCSSessionStoreSharded;
+		else
+		{
+			MCeerror->add(EE_SESSION_STORE_BADVALUE, line, pos);
+			return ES_ERROR;
+		}
+		
+		if (!MCS_set_session_store(t_store))
+		{
+			MCeerror->add(EE_SESSION_STORE_BADVALUE, line, pos);
+			return ES_ERROR;
+		}
+	}
+	break;
 			
 	case P_REV_RUNTIME_BEHAVIOUR:
 		return ep.getuint4(MCruntimebehaviour, line, pos, EE_PROPERTY_NAN);
@@ -1966,6 +1992,14 @@ Exec_stat MCProperty::set(MCExecPoint &ep)
 		MCrecursionlimit = MCU_max(MCrecursionlimit, MCU_abs(MCstackbottom - (char *)&stat) * 3); // fudge to 3x current stack depth
 #endif
 		break;
+	case P_REGEX_CACHE_SIZE:
+	{
+		uint4 t_size;
+		if (ep.getuint4(t_size, line, pos, EE_PROPERTY_NAN) != ES_NORMAL)
+			return ES_ERROR;
+		MCR_setcachesize(t_size);
+	}
+	break;
 	case P_REPEAT_RATE:
 		if (ep.getuint2(MCrepeatrate, line, pos,
 		                EE_PROPERTY_BADREPEATRATE) != ES_NORMAL)
@@ -3425,6 +3459,9 @@ Exec_stat MCProperty::eval(MCExecPoint &ep)
 	case P_SESSION_ID:
 		ep.setcstring(MCS_get_session_id());
 		break;
+	case P_SESSION_STORE:
+		ep.setstaticcstring(MCS_get_session_store() == kMCSSessionStoreSharded ? "sharded" : "index");
+		break;
 
 	case P_SCRIPT_EXECUTION_ERRORS:
 		ep . setstaticcstring(MCexecutionerrors);
@@ -3432,6 +3469,13 @@ Exec_stat MCProperty::eval(MCExecPoint &ep)
 	case P_SCRIPT_PARSING_ERRORS:
 		ep . setstaticcstring(MCparsingerrors);
 		break;
+	case P_INCLUDE_CACHE_STATISTICS:
+	{
+		uint32_t t_hits, t_misses;
+		MCS_get_include_cache_statistics(t_hits, t_misses);
+		ep . setstringf("%u,%u", t_hits, t_misses);
+	}
+	break;
 	case P_REV_RUNTIME_BEHAVIOUR:
 		ep.setint(MCruntimebehaviour);
 	break;
@@ -3456,6 +3500,9 @@ Exec_stat MCProperty::eval(MCExecPoint &ep)
 	case P_RECURSION_LIMIT:
 		ep.setuint(MCrecursionlimit);
 		break;
+	case P_REGEX_CACHE_SIZE:
+		ep.setuint(MCR_getcachesize());
+		break;
 	case P_REPEAT_RATE:
 		ep.setint(MCrepeatrate);
 		break;
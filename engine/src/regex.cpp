@@ -19,6 +19,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "globdefs.h"
 #include "parsedef.h"
 #include "regex.h"
+#include "core.h"
 
 #include <pcre.h>
 
@@ -184,6 +185,12 @@ regerror(int errcode, const regex_t *preg, char *errbuf, size_t errbuf_size)
 
 void regfree(regex_t *preg)
 {
+	if (preg->re_extra != NULL)
+#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study((pcre_extra *)preg->re_extra);
+#else
+		(pcre_free)(preg->re_extra);
+#endif
 	(pcre_free)(preg->re_pcre);
 }
 
@@ -213,10 +220,20 @@ int regcomp(regex_t *preg, const char *pattern, int cflags)
 		options |= PCRE_MULTILINE;
 	preg->re_pcre = pcre_compile(pattern, options, &errorptr, &erroffset, NULL);
 	preg->re_erroffset = erroffset;
+	preg->re_extra = NULL;
 
 	if (preg->re_pcre == NULL)
 		return eint[erroffset];
 
+	// Compiled patterns are cached and reused, so it is worth studying them
+	// (and JIT compiling them where PCRE supports it). If studying fails, or
+	// finds nothing useful, the pattern is matched without extra data.
+#ifdef PCRE_STUDY_JIT_COMPILE
+	preg->re_extra = pcre_study((const pcre *)preg->re_pcre, PCRE_STUDY_JIT_COMPILE, &errorptr);
+#else
+	preg->re_extra = pcre_study((const pcre *)preg->re_pcre, 0, &errorptr);
+#endif
+
 	preg->re_nsub = pcre_info((const pcre *)preg->re_pcre, NULL, NULL);
 	return 0;
 }
@@ -226,9 +243,12 @@ int regcomp(regex_t *preg, const char *pattern, int cflags)
 *************************************************/
 
 /* Unfortunately, PCRE requires 3 ints of working space for each captured
-substring, so we have to get and release working store instead of just using
-the POSIX structures as was done in earlier releases when PCRE needed only 2
-ints. */
+substring, so we have to get working store instead of just using the POSIX
+structures as was done in earlier releases when PCRE needed only 2 ints. The
+usual case of NSUBEXP matches uses a static buffer rather than allocating one
+on every match. */
+
+static int s_ovector[NSUBEXP * 3];
 
 int regexec(regex_t *preg, const char *string, int len, size_t nmatch,
             regmatch_t pmatch[], int eflags)
@@ -236,6 +256,7 @@ int regexec(regex_t *preg, const char *string, int len, size_t nmatch,
 	int rc;
 	int options = 0;
 	int *ovector = NULL;
+	bool allocated = false;
 
 	if ((eflags & REG_NOTBOL) != 0)
 		options |= PCRE_NOTBOL;
@@ -243,14 +264,17 @@ int regexec(regex_t *preg, const char *string, int len, size_t nmatch,
 		options |= PCRE_NOTEOL;
 
 	preg->re_erroffset = (size_t)(-1);   /* Only has meaning after compile */
-	if (nmatch > 0)
+	if (nmatch > NSUBEXP)
 	{
 		ovector = (int *)malloc(sizeof(int) * nmatch * 3);
 		if (ovector == NULL)
 			return REG_ESPACE;
+		allocated = true;
 	}
+	else if (nmatch > 0)
+		ovector = s_ovector;
 
-	rc = pcre_exec((const pcre *)preg->re_pcre, NULL, string, len, 0, options,
+	rc = pcre_exec((const pcre *)preg->re_pcre, (const pcre_extra *)preg->re_extra, string, len, 0, options,
 	               ovector, nmatch * 3);
 
 	if (rc == 0)
@@ -264,7 +288,7 @@ int regexec(regex_t *preg, const char *string, int len, size_t nmatch,
 			pmatch[i].rm_so = ovector[i*2];
 			pmatch[i].rm_eo = ovector[i*2+1];
 		}
-		if (ovector != NULL)
+		if (allocated)
 			free(ovector);
 		for (; i < (int)nmatch; i++)
 			pmatch[i].rm_so = pmatch[i].rm_eo = -1;
@@ -272,7 +296,7 @@ int regexec(regex_t *preg, const char *string, int len, size_t nmatch,
 	}
 	else
 	{
-		if (ovector != NULL)
+		if (allocated)
 			free(ovector);
 		switch(rc)
 		{
@@ -341,3 +365,200 @@ void MCR_free(regexp *prog)
 		delete prog;
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The pattern cache is a hash table of compiled patterns, keyed on the text of
+// the pattern, with the entries also linked in order of use so that the least
+// recently used pattern can be evicted when the cache is full.
+
+struct MCRegexCacheEntry
+{
+	MCRegexCacheEntry *chain;
+	MCRegexCacheEntry *previous;
+	MCRegexCacheEntry *next;
+	hash_t hash;
+	char *pattern;
+	uint4 length;
+	regexp *compiled;
+};
+
+static MCRegexCacheEntry **s_regex_cache_buckets = NULL;
+static uint4 s_regex_cache_bucket_count = 0;
+static uint4 s_regex_cache_count = 0;
+static uint4 s_regex_cache_size = PATTERN_CACHE_SIZE;
+static MCRegexCacheEntry *s_regex_cache_first = NULL;
+static MCRegexCacheEntry *s_regex_cache_last = NULL;
+
+static void MCR_cacheunlink(MCRegexCacheEntry *p_entry)
+{
+	if (p_entry -> previous != NULL)
+		p_entry -> previous -> next = p_entry -> next;
+	else
+		s_regex_cache_first = p_entry -> next;
+	if (p_entry -> next != NULL)
+		p_entry -> next -> previous = p_entry -> previous;
+	else
+		s_regex_cache_last = p_entry -> previous;
+}
+
+static void MCR_cachelinkfirst(MCRegexCacheEntry *p_entry)
+{
+	p_entry -> previous = NULL;
+	p_entry -> next = s_regex_cache_first;
+	if (s_regex_cache_first != NULL)
+		s_regex_cache_first -> previous = p_entry;
+	else
+		s_regex_cache_last = p_entry;
+	s_regex_cache_first = p_entry;
+}
+
+static void MCR_cacheremove(MCRegexCacheEntry *p_entry)
+{
+	MCRegexCacheEntry **t_link;
+	t_link = &s_regex_cache_buckets[p_entry -> hash & (s_regex_cache_bucket_count - 1)];
+	while (*t_link != p_entry)
+		t_link = &(*t_link) -> chain;
+	*t_link = p_entry -> chain;
+
+	MCR_cacheunlink(p_entry);
+	s_regex_cache_count--;
+
+	MCR_free(p_entry -> compiled);
+	delete[] p_entry -> pattern;
+	delete p_entry;
+}
+
+static bool MCR_cacheensurebuckets(void)
+{
+	if (s_regex_cache_buckets != NULL)
+		return true;
+
+	// Keep the load factor at or below one half.
+	uint4 t_count;
+	t_count = 16;
+	while (t_count / 2 < s_regex_cache_size)
+		t_count *= 2;
+
+	s_regex_cache_buckets = new MCRegexCacheEntry *[t_count];
+	if (s_regex_cache_buckets == NULL)
+		return false;
+	memset(s_regex_cache_buckets, 0, t_count * sizeof(MCRegexCacheEntry *));
+	s_regex_cache_bucket_count = t_count;
+
+	return true;
+}
+
+regexp *MCR_lookup(const char *p_pattern, uint4 p_length)
+{
+	if (!MCR_cacheensurebuckets())
+		return NULL;
+
+	hash_t t_hash;
+	t_hash = MCMemoryHash(p_pattern, p_length);
+
+	MCRegexCacheEntry **t_bucket;
+	t_bucket = &s_regex_cache_buckets[t_hash & (s_regex_cache_bucket_count - 1)];
+	for(MCRegexCacheEntry *t_entry = *t_bucket; t_entry != NULL; t_entry = t_entry -> chain)
+		if (t_entry -> hash == t_hash && t_entry -> length == p_length && memcmp(t_entry -> pattern, p_pattern, p_length) == 0)
+		{
+			if (t_entry != s_regex_cache_first)
+			{
+				MCR_cacheunlink(t_entry);
+				MCR_cachelinkfirst(t_entry);
+			}
+			return t_entry -> compiled;
+		}
+
+	char *t_pattern;
+	t_pattern = new char[p_length + 1];
+	if (t_pattern == NULL)
+		return NULL;
+	memcpy(t_pattern, p_pattern, p_length);
+	t_pattern[p_length] = '\0';
+
+	// Patterns which fail to compile are not cached, so the error is reported
+	// each time they are used.
+	regexp *t_compiled;
+	t_compiled = MCR_compile(t_pattern);
+	if (t_compiled == NULL)
+	{
+		delete[] t_pattern;
+		return NULL;
+	}
+
+	if (s_regex_cache_count == s_regex_cache_size)
+		MCR_cacheremove(s_regex_cache_last);
+
+	MCRegexCacheEntry *t_entry;
+	t_entry = new MCRegexCacheEntry;
+	if (t_entry == NULL)
+	{
+		MCR_free(t_compiled);
+		delete[] t_pattern;
+		return NULL;
+	}
+	t_entry -> hash = t_hash;
+	t_entry -> pattern = t_pattern;
+	t_entry -> length = p_length;
+	t_entry -> compiled = t_compiled;
+	t_entry -> chain = *t_bucket;
+	*t_bucket = t_entry;
+	MCR_cachelinkfirst(t_entry);
+	s_regex_cache_count++;
+
+	return t_compiled;
+}
+
+void MCR_setcachesize(uint4 p_size)
+{
+	if (p_size < 1)
+		p_size = 1;
+	else if (p_size > PATTERN_CACHE_MAX_SIZE)
+		p_size = PATTERN_CACHE_MAX_SIZE;
+
+	// Evict the least recently used patterns until the cache fits, then drop
+	// the bucket table so it is resized on the next lookup.
+	while (s_regex_cache_count > p_size)
+		MCR_cacheremove(s_regex_cache_last);
+
+	s_regex_cache_size = p_size;
+	if (s_regex_cache_count == 0)
+	{
+		delete[] s_regex_cache_buckets;
+		s_regex_cache_buckets = NULL;
+		s_regex_cache_bucket_count = 0;
+		return;
+	}
+
+	MCRegexCacheEntry *t_first;
+	t_first = s_regex_cache_first;
+
+	delete[] s_regex_cache_buckets;
+	s_regex_cache_buckets = NULL;
+	if (!MCR_cacheensurebuckets())
+		return;
+
+	for(MCRegexCacheEntry *t_entry = t_first; t_entry != NULL; t_entry = t_entry -> next)
+	{
+		MCRegexCacheEntry **t_bucket;
+		t_bucket = &s_regex_cache_buckets[t_entry -> hash & (s_regex_cache_bucket_count - 1)];
+		t_entry -> chain = *t_bucket;
+		*t_bucket = t_entry;
+	}
+}
+
+uint4 MCR_getcachesize(void)
+{
+	return s_regex_cache_size;
+}
+
+void MCR_clearcache(void)
+{
+	while (s_regex_cache_last != NULL)
+		MCR_cacheremove(s_regex_cache_last);
+
+	delete[] s_regex_cache_buckets;
+	s_regex_cache_buckets = NULL;
+	s_regex_cache_bucket_count = 0;
+}
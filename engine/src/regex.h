@@ -23,13 +23,16 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #define REG_OKAY 0
 
-#define PATTERN_CACHE_SIZE 20
-extern char *MCregexpatterns[];
+// The default number of compiled patterns kept by MCR_lookup.
+#define PATTERN_CACHE_SIZE 64
+// The largest the regexCacheSize property can be set to.
+#define PATTERN_CACHE_MAX_SIZE 4096
 
 //regex structure
 typedef struct
 {
 	void *re_pcre;
+	void *re_extra;
 	size_t re_nsub;
 	size_t re_erroffset;
 }
@@ -61,5 +64,16 @@ regexp *MCR_compile(char *exp);
 int MCR_exec(regexp *prog, const char *string, uint4 len);
 void MCR_free(regexp *prog);
 
-extern regexp *MCregexcache[];
+// Return the compiled form of the given pattern, compiling and caching it if
+// it is not already in the pattern cache. The cache owns the returned regexp,
+// which remains valid until the pattern is evicted. Returns NULL if the
+// pattern does not compile.
+regexp *MCR_lookup(const char *exp, uint4 length);
+
+// Set and get the number of compiled patterns the cache keeps (at least 1).
+void MCR_setcachesize(uint4 size);
+uint4 MCR_getcachesize(void);
+
+// Free all the compiled patterns in the cache.
+void MCR_clearcache(void);
 #endif
@@ -136,6 +136,15 @@ public:
 	void setselect();
 	void setselect(uint2 sflags);
 
+	// Note that the socket has queued a message, so the next poll should not
+	// block.
+	void setadded(void)
+	{
+		added = True;
+		anyadded = True;
+	}
+	static Boolean anyadded;
+
 	void close();
 	Boolean init(MCSocketHandle newfd);
 
@@ -173,6 +182,10 @@ protected:
 	CFSocketRef cfsockref;
 	CFRunLoopSourceRef rlref;
 #endif
+#ifdef _LINUX_DESKTOP
+	// The events the socket is registered for in the epoll set.
+	uint4 pollevents;
+#endif
 
 	static Boolean sslinited;
 	static Boolean sslinit();
@@ -198,6 +211,12 @@ extern void MCS_aton(MCExecPoint &ep);
 extern void MCS_ntoa(MCExecPoint &ep, MCExecPoint &ep2);
 extern void MCS_pa(MCExecPoint &ep, MCSocket *s);
 
+#ifdef _LINUX_DESKTOP
+// Returns the epoll descriptor sockets register with, or -1 if epoll is not
+// available and MCS_poll should select over all the sockets instead.
+extern int MCS_socket_epoll(void);
+#endif
+
 
 
 
@@ -43,6 +43,16 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #ifndef _WINDOWS_SERVER
 #include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #endif
 
 #ifdef _WINDOWS_SERVER
@@ -64,9 +74,19 @@ static MCVariable *s_cgi_get;
 static MCVariable *s_cgi_get_raw;
 static MCVariable *s_cgi_get_binary;
 static MCVariable *s_cgi_cookie;
+static MCVariable *s_cgi_session;
 
 static bool s_cgi_processed_post = false;
 
+// If true, the engine is serving several requests from one process (FastCGI
+// mode) so any per-request state must be released by cgi_finalize.
+static bool s_cgi_persistent = false;
+
+// The stdin handle the input cache reads from, and the handle wrapping the
+// stdout delegate (both are only needed to clean up in persistent mode).
+static IO_handle s_cgi_stdin_source = NULL;
+static IO_handle s_cgi_stdout_wrapper = NULL;
+
 // rather than making stdin / $_POST_RAW / $_POST, $_POST_BINARY, $_FILES
 // exclusive, we store the stream contents in this cache object and create a
 // cache reader handle around it when reading from stdin
@@ -197,6 +217,8 @@ public:
 	bool Write(const void *p_buffer, uint32_t p_length, uint32_t& r_written)
 	{
 		Close();
+		
+		MCservercgiheaders_sent = true;
 
 		if (!(cgi_send_cookies() && cgi_send_headers()))
 			return false;
@@ -1201,6 +1223,36 @@ _CRTIMP extern char **_environ;
 extern char **environ;
 #endif
 
+// Create the given global variable, or just discard its current value if it
+// has been created by a previous request.
+static void cgi_create_variable(const char *p_name, MCVariable*& x_var)
+{
+	if (x_var != NULL)
+	{
+		x_var -> clear(True);
+		return;
+	}
+	
+	/* UNCHECKED */ MCVariable::createwithname_cstring(p_name, x_var);
+	x_var -> setnext(MCglobals);
+	MCglobals = x_var;
+}
+
+// Create the given deferred global variable, or re-arm it if it has been
+// created by a previous request.
+static void cgi_create_deferred_variable(const char *p_name, MCDeferredVariableComputeCallback p_callback, MCVariable*& x_var)
+{
+	if (x_var != NULL)
+	{
+		static_cast<MCDeferredVariable *>(x_var) -> reset();
+		return;
+	}
+	
+	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring(p_name, p_callback, nil, x_var);
+	x_var -> setnext(MCglobals);
+	MCglobals = x_var;
+}
+
 bool cgi_initialize()
 {
 	// need to ensure PATH_TRANSLATED points to the script and PATH_INFO contains everything that follows
@@ -1224,6 +1276,8 @@ bool cgi_initialize()
 	MCservercgiheaders = NULL;
 	MCservercgiheaders_sent = false;
 	
+	s_cgi_processed_post = false;
+	
 	// Get the document root
 	MCservercgidocumentroot = getenv("DOCUMENT_ROOT");
 	
@@ -1231,20 +1285,20 @@ bool cgi_initialize()
 	// which is filled as the stream is read from.  this allows stdin to be used
 	// to populate the post data arrays, and also to be read from by the script
 	// without conflicting
+	s_cgi_stdin_source = IO_stdin;
 	s_cgi_stdin_cache = new MCStreamCache(IO_stdin->handle);
 	IO_stdin = new IO_header(new MCCacheHandle(s_cgi_stdin_cache), 0);
 		
 	// Initialize the output wrapper, this simply ensures we output headers
 	// before any content.
 	IO_stdout = new IO_header(new cgi_stdout, 0);
+	s_cgi_stdout_wrapper = IO_stdout;
 	
 	// Need an exec-point for variable creation.
 	MCExecPoint ep;
 	
 	// Construct the _SERVER variable
-	/* UNCHECKED */ MCVariable::createwithname_cstring("$_SERVER", s_cgi_server);
-	s_cgi_server -> setnext(MCglobals);
-	MCglobals = s_cgi_server;
+	cgi_create_variable("$_SERVER", s_cgi_server);
 	for(uint32_t i = 0; environ[i] != NULL; i++)
 	{
 		
@@ -1320,45 +1374,26 @@ bool cgi_initialize()
 	
 	// Construct the GET variables by parsing the QUERY_STRING
 	
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_GET_RAW", cgi_compute_get_raw_var, nil, s_cgi_get_raw);
-	s_cgi_get_raw -> setnext(MCglobals);
-	MCglobals = s_cgi_get_raw;	
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_GET", cgi_compute_get_var, nil, s_cgi_get);
-	s_cgi_get -> setnext(MCglobals);
-	MCglobals = s_cgi_get;
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_GET_BINARY", cgi_compute_get_binary_var, nil, s_cgi_get_binary);
-	s_cgi_get_binary -> setnext(MCglobals);
-	MCglobals = s_cgi_get_binary;	
+	cgi_create_deferred_variable("$_GET_RAW", cgi_compute_get_raw_var, s_cgi_get_raw);
+	cgi_create_deferred_variable("$_GET", cgi_compute_get_var, s_cgi_get);
+	cgi_create_deferred_variable("$_GET_BINARY", cgi_compute_get_binary_var, s_cgi_get_binary);
 	
 	// Construct the _POST variables by reading stdin.
 	
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_POST_RAW", cgi_compute_post_raw_var, nil, s_cgi_post_raw);
-	s_cgi_post_raw -> setnext(MCglobals);
-	MCglobals = s_cgi_post_raw;
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_POST", cgi_compute_post_var, nil, s_cgi_post);
-	s_cgi_post -> setnext(MCglobals);
-	MCglobals = s_cgi_post;
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_POST_BINARY", cgi_compute_post_binary_var, nil, s_cgi_post_binary);
-	s_cgi_post_binary -> setnext(MCglobals);
-	MCglobals = s_cgi_post_binary;	
+	cgi_create_deferred_variable("$_POST_RAW", cgi_compute_post_raw_var, s_cgi_post_raw);
+	cgi_create_deferred_variable("$_POST", cgi_compute_post_var, s_cgi_post);
+	cgi_create_deferred_variable("$_POST_BINARY", cgi_compute_post_binary_var, s_cgi_post_binary);
 	
 	// Construct the FILES variable by reading stdin
 
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_FILES", cgi_compute_files_var, nil, s_cgi_files);
-	s_cgi_files -> setnext(MCglobals);
-	MCglobals = s_cgi_files;
+	cgi_create_deferred_variable("$_FILES", cgi_compute_files_var, s_cgi_files);
 	
 	// Construct the COOKIES variable by parsing HTTP_COOKIE
-	/* UNCHECKED */ MCDeferredVariable::createwithname_cstring("$_COOKIE", cgi_compute_cookie_var, nil, s_cgi_cookie);
-	s_cgi_cookie -> setnext(MCglobals);
-	MCglobals = s_cgi_cookie;
+	cgi_create_deferred_variable("$_COOKIE", cgi_compute_cookie_var, s_cgi_cookie);
 	
 	// Create the $_SESSION variable explicitly, to be populated upon calls to "start session"
 	// required as implicit references to "$_SESSION" will result in its creation as an env var
-	MCVariable *t_session_var = NULL;
-	/* UNCHECKED */ MCVariable::createwithname_cstring("$_SESSION", t_session_var);
-	t_session_var->setnext(MCglobals);
-	MCglobals = t_session_var;
+	cgi_create_variable("$_SESSION", s_cgi_session);
 
 	return true;
 }
@@ -1372,6 +1407,53 @@ void cgi_finalize()
 	
 	// clean up session data
 	cgi_finalize_session();
+	
+	if (!s_cgi_persistent)
+		return;
+	
+	// In persistent mode the process goes on to serve another request, so
+	// make sure this one is complete and release everything specific to it.
+	
+	// Ensure the headers are sent even if the script produced no content.
+	if (!MCservercgiheaders_sent)
+	{
+		uint32_t t_written;
+		IO_stdout -> handle -> Write(NULL, 0, t_written);
+	}
+	delete s_cgi_stdout_wrapper;
+	s_cgi_stdout_wrapper = NULL;
+	
+	MCS_close(IO_stdin);
+	IO_stdin = s_cgi_stdin_source;
+	s_cgi_stdin_source = NULL;
+	delete s_cgi_stdin_cache;
+	s_cgi_stdin_cache = NULL;
+	
+	for(uint32_t i = 0; i < MCservercgiheadercount; i++)
+		free(MCservercgiheaders[i]);
+	free(MCservercgiheaders);
+	MCservercgiheaders = NULL;
+	MCservercgiheadercount = 0;
+	
+	for(uint32_t i = 0; i < MCservercgicookiecount; i++)
+	{
+		MCCStringFree(MCservercgicookies[i] . name);
+		MCCStringFree(MCservercgicookies[i] . value);
+		MCCStringFree(MCservercgicookies[i] . path);
+		MCCStringFree(MCservercgicookies[i] . domain);
+	}
+	MCMemoryDeleteArray(MCservercgicookies);
+	MCservercgicookies = NULL;
+	MCservercgicookiecount = 0;
+	
+	MCCStringFree(MCsessionid);
+	MCsessionid = NULL;
+	MCCStringFree(MCsessionname);
+	MCsessionname = NULL;
+	MCCStringFree(MCsessionsavepath);
+	MCsessionsavepath = NULL;
+	MCsessionlifetime = 60 * 24;
+	MCsessionstore = kMCSSessionStoreIndex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1468,188 +1550,1337 @@ static bool cgi_send_headers(void)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool MCServerGetSessionIdFromCookie(char *&r_id);
+// In FastCGI mode the engine serves a sequence of requests from one process.
+// Each request is run exactly as it would be in CGI mode except that the
+// environment, stdin, stdout and stderr come from the FastCGI connection. A
+// master process pre-forks a pool of workers which all accept on the same
+// listening socket, and replaces any that exit.
 
-MCSession *s_current_session = NULL;
+#ifndef _WINDOWS_SERVER
 
-bool MCServerStartSession()
+#define FCGI_VERSION_1 1
+#define FCGI_LISTENSOCK_FILENO 0
+#define FCGI_HEADER_LENGTH 8
+#define FCGI_MAX_CONTENT_LENGTH 65535
+#define FCGI_MAX_PADDING_LENGTH 255
+
+#define FCGI_KEEP_CONN 1
+#define FCGI_RESPONDER 1
+
+enum
 {
-	// start session:
-	// if MCsessionid is empty - get id from cookie
-	// if MCsessionid not empty - use MCsessionid - clear MCsessionid once opened
-	bool t_success = true;
+	FCGI_BEGIN_REQUEST = 1,
+	FCGI_ABORT_REQUEST = 2,
+	FCGI_END_REQUEST = 3,
+	FCGI_PARAMS = 4,
+	FCGI_STDIN = 5,
+	FCGI_STDOUT = 6,
+	FCGI_STDERR = 7,
+	FCGI_DATA = 8,
+	FCGI_GET_VALUES = 9,
+	FCGI_GET_VALUES_RESULT = 10,
+	FCGI_UNKNOWN_TYPE = 11,
+};
+
+enum
+{
+	FCGI_REQUEST_COMPLETE = 0,
+	FCGI_CANT_MPX_CONN = 1,
+	FCGI_OVERLOADED = 2,
+	FCGI_UNKNOWN_ROLE = 3,
+};
+
+// The amount of stdout / stderr content accumulated before a record is sent.
+#define FASTCGI_OUTPUT_BUFFER_SIZE 8192
+
+// The number of connections we can serve concurrently (reported to the web
+// server on request).
+static uint32_t s_fastcgi_max_connections = 1;
+
+// Set when the server has been asked to terminate. This only stops new
+// requests from being accepted - unlike MCquit and MCexitall, it leaves the
+// request being served (if any) to run to completion.
+static volatile sig_atomic_t s_fastcgi_shutdown = 0;
+
+static void fastcgi_handle_terminate(int p_signal)
+{
+	s_fastcgi_shutdown = 1;
+}
+
+static bool fastcgi_read_length(const uint8_t*& x_ptr, const uint8_t *p_limit, uint32_t& r_length)
+{
+	if (x_ptr >= p_limit)
+		return false;
 	
-	if (s_current_session != NULL)
+	if ((x_ptr[0] & 0x80) == 0)
+	{
+		r_length = *x_ptr++;
 		return true;
+	}
+	
+	if (p_limit - x_ptr < 4)
+		return false;
+	
+	r_length = ((x_ptr[0] & 0x7f) << 24) | (x_ptr[1] << 16) | (x_ptr[2] << 8) | x_ptr[3];
+	x_ptr += 4;
+	
+	return true;
+}
 
-	const char *t_session_id = NULL;
-	char *t_cookie_id = NULL;
+// Read the lengths of the next name-value pair, returning false if the pair
+// does not fit in the remaining data.
+static bool fastcgi_read_pair(const uint8_t*& x_ptr, const uint8_t *p_limit, uint32_t& r_name_length, uint32_t& r_value_length)
+{
+	if (!fastcgi_read_length(x_ptr, p_limit, r_name_length) ||
+		!fastcgi_read_length(x_ptr, p_limit, r_value_length))
+		return false;
 	
-	t_session_id = MCsessionid;
+	uint32_t t_available;
+	t_available = p_limit - x_ptr;
+	return r_name_length <= t_available && r_value_length <= t_available - r_name_length;
+}
+
+class MCFastCGIConnection
+{
+public:
+	MCFastCGIConnection(int p_fd);
+	~MCFastCGIConnection(void);
 	
-	if (t_session_id == NULL)
+	// Wait for the next request on the connection and install its params in
+	// the environment. Returns false if the connection has been closed.
+	bool BeginRequest(void);
+	
+	// Complete the current request, discarding any unread input and sending
+	// any remaining output.
+	bool EndRequest(void);
+	
+	// Returns true if the web server wants the connection to stay open once
+	// the current request is complete.
+	bool KeepConnection(void) const
 	{
-		t_success = MCServerGetSessionIdFromCookie(t_cookie_id);
-		t_session_id = t_cookie_id;
+		return m_keep_connection;
 	}
 	
-	if (t_success)
-		t_success = MCSessionStart(t_session_id, s_current_session);
+	// Read from the current request's stdin stream. Fewer bytes than requested
+	// are only returned at the end of the stream.
+	bool Read(void *p_buffer, uint32_t p_length, uint32_t& r_read);
 	
-	MCVariable *t_session_var = NULL;
+	// Write to (or flush) the current request's stdout or stderr stream.
+	bool Write(uint8_t p_type, const void *p_buffer, uint32_t p_length);
+	bool Flush(uint8_t p_type);
 	
-	if (t_success)
-	{
-		t_session_var = MCVariable::lookupglobal_cstring("$_SESSION");
-		if (t_session_var == NULL)
-		{
-			t_success = MCVariable::createwithname_cstring("$_SESSION", t_session_var);
-			if (t_success)
-			{
-				t_session_var->setnext(MCglobals);
-				MCglobals = t_session_var;
-			}
-		}
-	}
-	if (t_success)
-		t_session_var->getvalue().assign_empty();
+private:
+	bool ReadBytes(void *p_buffer, uint32_t p_length);
+	bool WriteBytes(const void *p_buffer, uint32_t p_length);
 	
-	if (t_success)
-	{
-		if (s_current_session->data_length > 0)
-			t_success = t_session_var->getvalue().decode(MCString(s_current_session->data, s_current_session->data_length));
-	}
+	bool ReadRecord(void);
+	bool WriteRecord(uint8_t p_type, uint16_t p_request_id, const void *p_content, uint32_t p_length);
+	bool WriteEndRequest(uint16_t p_request_id, uint8_t p_protocol_status);
+	bool WriteValues(void);
 	
-	if (t_success)
-	{
-		// clear MCsessionid - now associated with open session
-		MCCStringFree(MCsessionid);
-		MCsessionid = NULL;
-	}
-	else
-	{
-		MCSessionDiscard(s_current_session);
-		s_current_session = NULL;
-	}
+	// Deal with a record that doesn't belong to the current request.
+	bool HandleOtherRecord(void);
 	
-	MCCStringFree(t_cookie_id);
+	// Wait for a begin request record for a role we support.
+	bool AcceptRequest(void);
 	
-	return t_success;
+	// Read the params stream of the current request, setting r_aborted if the
+	// web server abandons the request first.
+	bool ReadParams(uint8_t*& r_params, uint32_t& r_length, bool& r_aborted);
+	
+	bool SetParams(const uint8_t *p_params, uint32_t p_length);
+	void ClearParams(void);
+	
+	int m_fd;
+	
+	// The current request's id (zero if there is none).
+	uint16_t m_request_id;
+	bool m_keep_connection;
+	
+	// The most recently read record.
+	uint8_t m_record_type;
+	uint16_t m_record_id;
+	uint32_t m_record_length;
+	uint8_t *m_record;
+	
+	// The unread portion of the current stdin record, and whether the end of
+	// the stdin stream has been reached.
+	uint32_t m_input_offset;
+	uint32_t m_input_length;
+	bool m_input_finished;
+	
+	// The pending stdout and stderr content, indexed by type - FCGI_STDOUT.
+	uint8_t *m_output[2];
+	uint32_t m_output_length[2];
+	bool m_output_used[2];
+	
+	// The names of the environment variables set from the request's params.
+	char **m_params;
+	uint32_t m_param_count;
+};
+
+MCFastCGIConnection::MCFastCGIConnection(int p_fd)
+{
+	m_fd = p_fd;
+	m_request_id = 0;
+	m_keep_connection = false;
+	m_record_type = 0;
+	m_record_id = 0;
+	m_record_length = 0;
+	m_record = new uint8_t[FCGI_MAX_CONTENT_LENGTH + FCGI_MAX_PADDING_LENGTH];
+	m_input_offset = 0;
+	m_input_length = 0;
+	m_input_finished = true;
+	for(uint32_t i = 0; i < 2; i++)
+	{
+		m_output[i] = new uint8_t[FASTCGI_OUTPUT_BUFFER_SIZE];
+		m_output_length[i] = 0;
+		m_output_used[i] = false;
+	}
+	m_params = NULL;
+	m_param_count = 0;
 }
 
-bool MCServerStopSession()
+MCFastCGIConnection::~MCFastCGIConnection(void)
 {
-	bool t_success = true;
-	
-	if (s_current_session == NULL)
-		return true;
+	ClearParams();
 	
-	char *t_data = NULL;
-	uint32_t t_data_length = 0;
+	delete[] m_record;
+	for(uint32_t i = 0; i < 2; i++)
+		delete[] m_output[i];
 	
-	MCVariable *t_session_var;
-	t_session_var = MCVariable::lookupglobal_cstring("$_SESSION");
-
-	if (t_session_var != NULL)
-		t_success = t_session_var->getvalue().encode((void*&)t_data, t_data_length);
+	close(m_fd);
+}
 
-	if (t_success)
+bool MCFastCGIConnection::BeginRequest(void)
+{
+	for(;;)
 	{
-		MCMemoryDeallocate(s_current_session->data);
-		s_current_session->data = t_data;
-		s_current_session->data_length = t_data_length;
+		if (!AcceptRequest())
+			return false;
 		
-		t_success = MCSessionCommit(s_current_session);
-		s_current_session = NULL;
+		uint8_t *t_params;
+		uint32_t t_params_length;
+		bool t_aborted;
+		if (!ReadParams(t_params, t_params_length, t_aborted))
+			return false;
+		
+		if (!t_aborted)
+		{
+			bool t_success;
+			t_success = SetParams(t_params, t_params_length);
+			MCMemoryDeallocate(t_params);
+			
+			if (!t_success)
+				return false;
+			
+			break;
+		}
+		
+		if (!WriteEndRequest(m_request_id, FCGI_REQUEST_COMPLETE) || !m_keep_connection)
+			return false;
 	}
-
-	return t_success;
+	
+	m_input_offset = 0;
+	m_input_length = 0;
+	m_input_finished = false;
+	
+	for(uint32_t i = 0; i < 2; i++)
+	{
+		m_output_length[i] = 0;
+		m_output_used[i] = false;
+	}
+	
+	return true;
 }
 
-bool MCServerDeleteSession()
+bool MCFastCGIConnection::EndRequest(void)
 {
-	bool t_success = true;
-	
-	t_success = MCSessionExpire(MCS_get_session_id());
+	bool t_success;
+	t_success = true;
 	
-	if (s_current_session != NULL)
+	// Consume any input the script didn't read so that the next request starts
+	// at a record boundary.
+	while(t_success && !m_input_finished)
 	{
-		MCSessionDiscard(s_current_session);
-		s_current_session = NULL;
+		m_input_offset = m_input_length;
+		
+		uint8_t t_byte;
+		uint32_t t_read;
+		t_success = Read(&t_byte, 1, t_read);
 	}
 	
+	// Each stream is terminated by an empty record.
+	if (t_success)
+		t_success = Flush(FCGI_STDOUT) && WriteRecord(FCGI_STDOUT, m_request_id, NULL, 0);
+	
+	if (t_success && m_output_used[FCGI_STDERR - FCGI_STDOUT])
+		t_success = Flush(FCGI_STDERR) && WriteRecord(FCGI_STDERR, m_request_id, NULL, 0);
+	
+	if (t_success)
+		t_success = WriteEndRequest(m_request_id, FCGI_REQUEST_COMPLETE);
+	
+	ClearParams();
+	m_request_id = 0;
+	
 	return t_success;
 }
 
-void cgi_finalize_session()
+bool MCFastCGIConnection::Read(void *p_buffer, uint32_t p_length, uint32_t& r_read)
 {
-	// close current session if open
-	if (s_current_session != NULL)
+	r_read = 0;
+	while(r_read < p_length)
 	{
-		MCSessionCommit(s_current_session);
-		s_current_session = NULL;
+		if (m_input_offset < m_input_length)
+		{
+			uint32_t t_amount;
+			t_amount = MCMin(p_length - r_read, m_input_length - m_input_offset);
+			MCMemoryCopy((uint8_t *)p_buffer + r_read, m_record + m_input_offset, t_amount);
+			m_input_offset += t_amount;
+			r_read += t_amount;
+			continue;
+		}
+		
+		if (m_input_finished)
+			break;
+		
+		if (!ReadRecord())
+		{
+			m_input_finished = true;
+			m_keep_connection = false;
+			return false;
+		}
+		
+		if (m_record_id != m_request_id)
+		{
+			if (!HandleOtherRecord())
+				return false;
+		}
+		else if (m_record_type == FCGI_STDIN)
+		{
+			m_input_length = m_record_length;
+			if (m_record_length == 0)
+				m_input_finished = true;
+		}
+		else if (m_record_type == FCGI_ABORT_REQUEST)
+			m_input_finished = true;
 	}
-
-	// clean up session files
-	MCSessionCleanup();
+	
+	return true;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-
-// Session properties
-
-static char *s_session_temp_dir = NULL;
-bool MCS_get_temporary_folder(char *&r_folder);
-
-bool MCS_set_session_save_path(const char *p_path)
+bool MCFastCGIConnection::Write(uint8_t p_type, const void *p_buffer, uint32_t p_length)
 {
-	char *t_save_path = nil;
+	uint32_t t_stream;
+	t_stream = p_type - FCGI_STDOUT;
 	
-	if (!MCCStringClone(p_path, t_save_path))
-		return false;
+	if (p_length != 0)
+		m_output_used[t_stream] = true;
 	
-	MCCStringFree(MCsessionsavepath);
-	MCsessionsavepath = t_save_path;
+	while(p_length > 0)
+	{
+		if (m_output_length[t_stream] == FASTCGI_OUTPUT_BUFFER_SIZE && !Flush(p_type))
+			return false;
+		
+		uint32_t t_amount;
+		t_amount = MCMin(p_length, FASTCGI_OUTPUT_BUFFER_SIZE - m_output_length[t_stream]);
+		MCMemoryCopy(m_output[t_stream] + m_output_length[t_stream], p_buffer, t_amount);
+		m_output_length[t_stream] += t_amount;
+		
+		p_buffer = (const uint8_t *)p_buffer + t_amount;
+		p_length -= t_amount;
+	}
 	
 	return true;
 }
 
-const char *MCS_get_session_save_path(void)
+bool MCFastCGIConnection::Flush(uint8_t p_type)
 {
-	if (MCsessionsavepath != NULL && MCCStringLength(MCsessionsavepath) > 0)
-		return MCsessionsavepath;
+	uint32_t t_stream;
+	t_stream = p_type - FCGI_STDOUT;
 	
-	if (s_session_temp_dir != NULL)
-		return s_session_temp_dir;
+	if (m_output_length[t_stream] == 0)
+		return true;
 	
-	if (MCS_get_temporary_folder(s_session_temp_dir))
-		return s_session_temp_dir;
+	uint32_t t_length;
+	t_length = m_output_length[t_stream];
+	m_output_length[t_stream] = 0;
 	
-	return NULL;
+	return WriteRecord(p_type, m_request_id, m_output[t_stream], t_length);
 }
 
-bool MCS_set_session_lifetime(uint32_t p_lifetime)
+bool MCFastCGIConnection::ReadBytes(void *p_buffer, uint32_t p_length)
 {
-	MCsessionlifetime = p_lifetime;
+	while(p_length > 0)
+	{
+		ssize_t t_read;
+		t_read = read(m_fd, p_buffer, p_length);
+		if (t_read < 0 && errno == EINTR)
+		{
+			// Stop waiting for the next request if asked to terminate, but
+			// finish reading one that is in progress.
+			if (m_request_id == 0 && (s_fastcgi_shutdown || MCquit))
+				return false;
+			continue;
+		}
+		if (t_read <= 0)
+			return false;
+		
+		p_buffer = (uint8_t *)p_buffer + t_read;
+		p_length -= t_read;
+	}
+	
 	return true;
 }
 
-uint32_t MCS_get_session_lifetime(void)
+bool MCFastCGIConnection::WriteBytes(const void *p_buffer, uint32_t p_length)
 {
-	return MCsessionlifetime;
+	while(p_length > 0)
+	{
+		ssize_t t_written;
+		t_written = write(m_fd, p_buffer, p_length);
+		if (t_written < 0 && errno == EINTR)
+			continue;
+		if (t_written < 0)
+			return false;
+		
+		p_buffer = (const uint8_t *)p_buffer + t_written;
+		p_length -= t_written;
+	}
+	
+	return true;
 }
 
-bool MCS_set_session_name(const char *p_name)
+bool MCFastCGIConnection::ReadRecord(void)
 {
-	char *t_name = nil;
+	// The record buffer is about to be reused, so any unread stdin content in
+	// it is lost (callers only read a record once it has been consumed).
+	m_input_offset = 0;
+	m_input_length = 0;
 	
-	if (!MCCStringClone(p_name, t_name))
+	uint8_t t_header[FCGI_HEADER_LENGTH];
+	if (!ReadBytes(t_header, FCGI_HEADER_LENGTH))
 		return false;
 	
-	MCCStringFree(MCsessionname);
-	MCsessionname = t_name;
+	if (t_header[0] != FCGI_VERSION_1)
+		return false;
 	
-	return true;
+	m_record_type = t_header[1];
+	m_record_id = (t_header[2] << 8) | t_header[3];
+	m_record_length = (t_header[4] << 8) | t_header[5];
+	
+	return ReadBytes(m_record, m_record_length + t_header[6]);
+}
+
+bool MCFastCGIConnection::WriteRecord(uint8_t p_type, uint16_t p_request_id, const void *p_content, uint32_t p_length)
+{
+	uint8_t t_header[FCGI_HEADER_LENGTH];
+	t_header[0] = FCGI_VERSION_1;
+	t_header[1] = p_type;
+	t_header[2] = p_request_id >> 8;
+	t_header[3] = p_request_id & 0xff;
+	t_header[4] = p_length >> 8;
+	t_header[5] = p_length & 0xff;
+	t_header[6] = 0;
+	t_header[7] = 0;
+	
+	// Send the header and content together so that each record goes out in
+	// one piece.
+	struct iovec t_vectors[2];
+	t_vectors[0] . iov_base = t_header;
+	t_vectors[0] . iov_len = FCGI_HEADER_LENGTH;
+	t_vectors[1] . iov_base = (void *)p_content;
+	t_vectors[1] . iov_len = p_length;
+	
+	ssize_t t_written;
+	do
+		t_written = writev(m_fd, t_vectors, 2);
+	while(t_written < 0 && errno == EINTR);
+	
+	if (t_written < 0)
+		return false;
+	
+	if (t_written < FCGI_HEADER_LENGTH)
+		return WriteBytes(t_header + t_written, FCGI_HEADER_LENGTH - t_written) &&
+				WriteBytes(p_content, p_length);
+	
+	t_written -= FCGI_HEADER_LENGTH;
+	return WriteBytes((const uint8_t *)p_content + t_written, p_length - t_written);
+}
+
+bool MCFastCGIConnection::WriteEndRequest(uint16_t p_request_id, uint8_t p_protocol_status)
+{
+	// The application status (the first four bytes) is always zero.
+	uint8_t t_body[8];
+	MCMemoryClear(t_body, sizeof(t_body));
+	t_body[4] = p_protocol_status;
+	
+	return WriteRecord(FCGI_END_REQUEST, p_request_id, t_body, sizeof(t_body));
+}
+
+bool MCFastCGIConnection::WriteValues(void)
+{
+	static const char *s_names[] =
+	{
+		"FCGI_MAX_CONNS",
+		"FCGI_MAX_REQS",
+		"FCGI_MPXS_CONNS",
+	};
+	
+	char t_max[U4L];
+	sprintf(t_max, "%u", s_fastcgi_max_connections);
+	
+	const char *t_values[] = { t_max, t_max, "0" };
+	
+	// Answer with the values of the variables we know about, ignoring the rest.
+	uint8_t t_result[128];
+	uint32_t t_length;
+	t_length = 0;
+	
+	const uint8_t *t_ptr, *t_limit;
+	t_ptr = m_record;
+	t_limit = m_record + m_record_length;
+	
+	uint32_t t_name_length, t_value_length;
+	while(fastcgi_read_pair(t_ptr, t_limit, t_name_length, t_value_length))
+	{
+		for(uint32_t i = 0; i < sizeof(s_names) / sizeof(s_names[0]); i++)
+		{
+			uint32_t t_known_length, t_known_value_length;
+			t_known_length = strlen(s_names[i]);
+			t_known_value_length = strlen(t_values[i]);
+			
+			if (t_name_length == t_known_length && memcmp(t_ptr, s_names[i], t_known_length) == 0 &&
+				t_length + 2 + t_known_length + t_known_value_length <= sizeof(t_result))
+			{
+				t_result[t_length++] = t_known_length;
+				t_result[t_length++] = t_known_value_length;
+				MCMemoryCopy(t_result + t_length, s_names[i], t_known_length);
+				t_length += t_known_length;
+				MCMemoryCopy(t_result + t_length, t_values[i], t_known_value_length);
+				t_length += t_known_value_length;
+			}
+		}
+		
+		t_ptr += t_name_length + t_value_length;
+	}
+	
+	return WriteRecord(FCGI_GET_VALUES_RESULT, 0, t_result, t_length);
+}
+
+bool MCFastCGIConnection::HandleOtherRecord(void)
+{
+	switch(m_record_type)
+	{
+		case FCGI_GET_VALUES:
+			return WriteValues();
+			
+		case FCGI_BEGIN_REQUEST:
+			// We only serve one request at a time on each connection.
+			return WriteEndRequest(m_record_id, FCGI_CANT_MPX_CONN);
+			
+		default:
+			break;
+	}
+	
+	// Unknown management records must be answered, anything else belongs to
+	// a request that is no longer active and so can be ignored.
+	if (m_record_id == 0)
+	{
+		uint8_t t_body[8];
+		MCMemoryClear(t_body, sizeof(t_body));
+		t_body[0] = m_record_type;
+		return WriteRecord(FCGI_UNKNOWN_TYPE, 0, t_body, sizeof(t_body));
+	}
+	
+	return true;
+}
+
+bool MCFastCGIConnection::AcceptRequest(void)
+{
+	m_request_id = 0;
+	while(m_request_id == 0)
+	{
+		if (!ReadRecord())
+			return false;
+		
+		if (m_record_type != FCGI_BEGIN_REQUEST || m_record_id == 0)
+		{
+			if (!HandleOtherRecord())
+				return false;
+			continue;
+		}
+		
+		if (m_record_length < 8)
+			return false;
+		
+		uint16_t t_role;
+		t_role = (m_record[0] << 8) | m_record[1];
+		
+		bool t_keep_connection;
+		t_keep_connection = (m_record[2] & FCGI_KEEP_CONN) != 0;
+		
+		if (t_role != FCGI_RESPONDER)
+		{
+			if (!WriteEndRequest(m_record_id, FCGI_UNKNOWN_ROLE) || !t_keep_connection)
+				return false;
+			continue;
+		}
+		
+		m_request_id = m_record_id;
+		m_keep_connection = t_keep_connection;
+	}
+	
+	return true;
+}
+
+bool MCFastCGIConnection::ReadParams(uint8_t*& r_params, uint32_t& r_length, bool& r_aborted)
+{
+	bool t_success;
+	t_success = true;
+	
+	uint8_t *t_params;
+	t_params = NULL;
+	
+	uint32_t t_length;
+	t_length = 0;
+	
+	bool t_finished;
+	t_finished = false;
+	
+	r_aborted = false;
+	
+	while(t_success && !t_finished)
+	{
+		t_success = ReadRecord();
+		if (!t_success)
+			break;
+		
+		if (m_record_id != m_request_id)
+			t_success = HandleOtherRecord();
+		else if (m_record_type == FCGI_PARAMS && m_record_length == 0)
+			t_finished = true;
+		else if (m_record_type == FCGI_PARAMS)
+		{
+			t_success = MCMemoryReallocate(t_params, t_length + m_record_length, t_params);
+			if (t_success)
+			{
+				MCMemoryCopy(t_params + t_length, m_record, m_record_length);
+				t_length += m_record_length;
+			}
+		}
+		else if (m_record_type == FCGI_ABORT_REQUEST)
+		{
+			r_aborted = true;
+			t_finished = true;
+		}
+		else
+			t_success = false;
+	}
+	
+	if (t_success && !r_aborted)
+	{
+		r_params = t_params;
+		r_length = t_length;
+	}
+	else
+		MCMemoryDeallocate(t_params);
+	
+	return t_success;
+}
+
+bool MCFastCGIConnection::SetParams(const uint8_t *p_params, uint32_t p_length)
+{
+	const uint8_t *t_ptr, *t_limit;
+	t_ptr = p_params;
+	t_limit = p_params + p_length;
+	
+	uint32_t t_name_length, t_value_length;
+	while(fastcgi_read_pair(t_ptr, t_limit, t_name_length, t_value_length))
+	{
+		char *t_name, *t_value;
+		if (!MCCStringCloneSubstring((const char *)t_ptr, t_name_length, t_name))
+			return false;
+		
+		if (!MCCStringCloneSubstring((const char *)t_ptr + t_name_length, t_value_length, t_value) ||
+			!MCMemoryResizeArray(m_param_count + 1, m_params, m_param_count))
+		{
+			MCCStringFree(t_name);
+			return false;
+		}
+		
+		MCS_setenv(t_name, t_value);
+		MCCStringFree(t_value);
+		
+		m_params[m_param_count - 1] = t_name;
+		
+		t_ptr += t_name_length + t_value_length;
+	}
+	
+	return t_ptr == t_limit;
+}
+
+void MCFastCGIConnection::ClearParams(void)
+{
+	for(uint32_t i = 0; i < m_param_count; i++)
+	{
+		MCS_unsetenv(m_params[i]);
+		MCCStringFree(m_params[i]);
+	}
+	
+	MCMemoryDeleteArray(m_params);
+	m_params = NULL;
+	m_param_count = 0;
+}
+
+////////
+
+// file handle class which reads the stdin stream of a FastCGI request
+class MCFastCGIInputHandle: public MCSystemFileHandle
+{
+public:
+	MCFastCGIInputHandle(MCFastCGIConnection *p_connection)
+	{
+		m_connection = p_connection;
+		m_offset = 0;
+	}
+	
+	void Close(void)
+	{
+		delete this;
+	}
+	
+	bool Read(void *p_buffer, uint32_t p_length, uint32_t& r_read)
+	{
+		bool t_success;
+		t_success = m_connection -> Read(p_buffer, p_length, r_read);
+		m_offset += r_read;
+		
+		return t_success;
+	}
+	
+	bool Write(const void *p_buffer, uint32_t p_length, uint32_t& r_written)
+	{
+		return false;
+	}
+	
+	bool Seek(int64_t p_offset, int p_direction)
+	{
+		return false;
+	}
+	
+	bool Truncate(void)
+	{
+		return false;
+	}
+	
+	bool Sync(void)
+	{
+		return true;
+	}
+	
+	bool Flush(void)
+	{
+		return true;
+	}
+	
+	bool PutBack(char p_char)
+	{
+		return false;
+	}
+	
+	int64_t Tell(void)
+	{
+		return m_offset;
+	}
+	
+	void *GetFilePointer(void)
+	{
+		return NULL;
+	}
+	
+	int64_t GetFileSize(void)
+	{
+		return 0;
+	}
+	
+private:
+	MCFastCGIConnection *m_connection;
+	int64_t m_offset;
+};
+
+// file handle class which writes to the stdout or stderr stream of a FastCGI
+// request
+class MCFastCGIOutputHandle: public MCSystemFileHandle
+{
+public:
+	MCFastCGIOutputHandle(MCFastCGIConnection *p_connection, uint8_t p_type)
+	{
+		m_connection = p_connection;
+		m_type = p_type;
+		m_offset = 0;
+	}
+	
+	void Close(void)
+	{
+		delete this;
+	}
+	
+	bool Read(void *p_buffer, uint32_t p_length, uint32_t& r_read)
+	{
+		return false;
+	}
+	
+	bool Write(const void *p_buffer, uint32_t p_length, uint32_t& r_written)
+	{
+		if (!m_connection -> Write(m_type, p_buffer, p_length))
+			return false;
+		
+		m_offset += p_length;
+		r_written = p_length;
+		
+		return true;
+	}
+	
+	bool Seek(int64_t p_offset, int p_direction)
+	{
+		return false;
+	}
+	
+	bool Truncate(void)
+	{
+		return false;
+	}
+	
+	bool Sync(void)
+	{
+		return true;
+	}
+	
+	bool Flush(void)
+	{
+		return m_connection -> Flush(m_type);
+	}
+	
+	bool PutBack(char p_char)
+	{
+		return false;
+	}
+	
+	int64_t Tell(void)
+	{
+		return m_offset;
+	}
+	
+	void *GetFilePointer(void)
+	{
+		return NULL;
+	}
+	
+	int64_t GetFileSize(void)
+	{
+		return 0;
+	}
+	
+private:
+	MCFastCGIConnection *m_connection;
+	uint8_t m_type;
+	int64_t m_offset;
+};
+
+////////
+
+static bool fastcgi_handle_request(MCFastCGIConnection& p_connection, void (*p_handler)(void))
+{
+	// Route the standard streams through the connection for the duration of
+	// the request.
+	IO_handle t_stdin, t_stdout, t_stderr;
+	t_stdin = IO_stdin;
+	t_stdout = IO_stdout;
+	t_stderr = IO_stderr;
+	
+	IO_stdin = new IO_header(new MCFastCGIInputHandle(&p_connection), 0);
+	IO_stdout = new IO_header(new MCFastCGIOutputHandle(&p_connection, FCGI_STDOUT), 0);
+	IO_stderr = new IO_header(new MCFastCGIOutputHandle(&p_connection, FCGI_STDERR), 0);
+	
+	// Not all web servers pass PATH_TRANSLATED, in which case the script to run
+	// is the one named by SCRIPT_FILENAME.
+	if (MCS_getenv("PATH_TRANSLATED") == NULL && MCS_getenv("SCRIPT_FILENAME") != NULL)
+		MCS_setenv("PATH_TRANSLATED", MCS_getenv("SCRIPT_FILENAME"));
+	
+	if (MCS_getenv("PATH_TRANSLATED") != NULL)
+		p_handler();
+	else
+	{
+		static const char s_error[] = "Status: 400 Bad Request\nContent-Type: text/plain\n\nNo script specified\n";
+		MCS_write(s_error, 1, sizeof(s_error) - 1, IO_stdout);
+	}
+	
+	MCS_close(IO_stdin);
+	MCS_close(IO_stdout);
+	MCS_close(IO_stderr);
+	
+	IO_stdin = t_stdin;
+	IO_stdout = t_stdout;
+	IO_stderr = t_stderr;
+	
+	// These may have been synthesized by cgi_initialize rather than passed as
+	// params, so make sure they don't carry over to the next request.
+	MCS_unsetenv("PATH_TRANSLATED");
+	MCS_unsetenv("PATH_INFO");
+	
+	return p_connection . EndRequest();
+}
+
+// Accept connections on the given socket and serve requests from them until
+// asked to quit, or until the given number of requests has been served (if
+// non-zero).
+static void fastcgi_serve(int p_socket, uint32_t p_max_requests, void (*p_handler)(void))
+{
+	uint32_t t_requests;
+	t_requests = 0;
+	
+	while(!MCquit && !s_fastcgi_shutdown && (p_max_requests == 0 || t_requests < p_max_requests))
+	{
+		int t_fd;
+		t_fd = accept(p_socket, NULL, NULL);
+		if (t_fd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+		
+		// Records are written whole, so there is nothing to gain by delaying
+		// small writes (this fails harmlessly on local sockets).
+		int t_nodelay;
+		t_nodelay = 1;
+		setsockopt(t_fd, IPPROTO_TCP, TCP_NODELAY, &t_nodelay, sizeof(t_nodelay));
+		
+		MCFastCGIConnection t_connection(t_fd);
+		while(!MCquit && !s_fastcgi_shutdown && t_connection . BeginRequest())
+		{
+			bool t_success;
+			t_success = fastcgi_handle_request(t_connection, p_handler);
+			
+			t_requests += 1;
+			
+			if (!t_success || !t_connection . KeepConnection() ||
+				(p_max_requests != 0 && t_requests >= p_max_requests))
+				break;
+		}
+	}
+}
+
+// Create a socket listening on the given address, which is either a path (for
+// a local socket) or '[<host>]:<port>'.
+static int fastcgi_listen(const char *p_address)
+{
+	int t_socket;
+	t_socket = -1;
+	
+	const char *t_port;
+	t_port = strrchr(p_address, ':');
+	
+	if (strchr(p_address, '/') != NULL || t_port == NULL)
+	{
+		struct sockaddr_un t_addr;
+		if (strlen(p_address) >= sizeof(t_addr . sun_path))
+			return -1;
+		
+		memset(&t_addr, 0, sizeof(t_addr));
+		t_addr . sun_family = AF_UNIX;
+		strcpy(t_addr . sun_path, p_address);
+		
+		// Remove any socket left behind by a previous instance.
+		struct stat t_info;
+		if (lstat(p_address, &t_info) == 0 && S_ISSOCK(t_info . st_mode))
+			unlink(p_address);
+		
+		t_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (t_socket >= 0 && bind(t_socket, (struct sockaddr *)&t_addr, sizeof(t_addr)) < 0)
+		{
+			close(t_socket);
+			t_socket = -1;
+		}
+	}
+	else
+	{
+		// An IPv6 host can be enclosed in brackets to separate it from the port.
+		const char *t_host_start, *t_host_end;
+		t_host_start = p_address;
+		t_host_end = t_port;
+		if (t_host_end - t_host_start >= 2 && t_host_start[0] == '[' && t_host_end[-1] == ']')
+		{
+			t_host_start += 1;
+			t_host_end -= 1;
+		}
+		
+		char *t_host;
+		t_host = NULL;
+		if (t_host_end != t_host_start && !MCCStringCloneSubstring(t_host_start, t_host_end - t_host_start, t_host))
+			return -1;
+		
+		struct addrinfo t_hints;
+		memset(&t_hints, 0, sizeof(t_hints));
+		t_hints . ai_family = AF_UNSPEC;
+		t_hints . ai_socktype = SOCK_STREAM;
+		t_hints . ai_flags = AI_PASSIVE;
+		
+		struct addrinfo *t_addresses;
+		if (getaddrinfo(t_host, t_port + 1, &t_hints, &t_addresses) == 0)
+		{
+			for(struct addrinfo *t_addr = t_addresses; t_addr != NULL && t_socket < 0; t_addr = t_addr -> ai_next)
+			{
+				t_socket = socket(t_addr -> ai_family, t_addr -> ai_socktype, t_addr -> ai_protocol);
+				if (t_socket < 0)
+					continue;
+				
+				int t_reuse;
+				t_reuse = 1;
+				setsockopt(t_socket, SOL_SOCKET, SO_REUSEADDR, &t_reuse, sizeof(t_reuse));
+				
+				if (bind(t_socket, t_addr -> ai_addr, t_addr -> ai_addrlen) < 0)
+				{
+					close(t_socket);
+					t_socket = -1;
+				}
+			}
+			
+			freeaddrinfo(t_addresses);
+		}
+		
+		MCCStringFree(t_host);
+	}
+	
+	if (t_socket >= 0 && listen(t_socket, SOMAXCONN) < 0)
+	{
+		close(t_socket);
+		t_socket = -1;
+	}
+	
+	return t_socket;
+}
+
+bool cgi_fastcgi_listener_available(void)
+{
+	// A web server which spawns FastCGI applications itself passes the
+	// listening socket as stdin, which (unlike a connected socket) has no peer.
+	struct sockaddr_storage t_address;
+	socklen_t t_length;
+	t_length = sizeof(t_address);
+	return getpeername(FCGI_LISTENSOCK_FILENO, (struct sockaddr *)&t_address, &t_length) < 0 && errno == ENOTCONN;
+}
+
+bool cgi_serve_fastcgi(const char *p_address, uint32_t p_workers, uint32_t p_max_requests, void (*p_handler)(void))
+{
+	int t_socket;
+	if (p_address != NULL)
+	{
+		t_socket = fastcgi_listen(p_address);
+		if (t_socket < 0)
+		{
+			fprintf(stderr, "livecode-server could not listen on '%s'\n", p_address);
+			return false;
+		}
+	}
+	else
+		t_socket = FCGI_LISTENSOCK_FILENO;
+	
+	s_cgi_persistent = true;
+	s_fastcgi_max_connections = MCMax(p_workers, 1U);
+	
+	// A termination request must interrupt accept, read and waitpid, otherwise
+	// it would go unnoticed until the next connection arrives. It is handled
+	// here rather than by the engine's handler, which would abort the script
+	// of the request being served.
+	struct sigaction t_action;
+	memset(&t_action, 0, sizeof(t_action));
+	t_action . sa_handler = fastcgi_handle_terminate;
+	sigemptyset(&t_action . sa_mask);
+	sigaction(SIGTERM, &t_action, NULL);
+	
+	// Without any workers, requests are served by this process (which is
+	// useful when debugging).
+	if (p_workers == 0)
+	{
+		fastcgi_serve(t_socket, p_max_requests, p_handler);
+		return true;
+	}
+	
+	pid_t *t_workers;
+	t_workers = new pid_t[p_workers];
+	for(uint32_t i = 0; i < p_workers; i++)
+		t_workers[i] = 0;
+	
+	bool t_is_worker;
+	t_is_worker = false;
+	while(!MCquit && !s_fastcgi_shutdown && !t_is_worker)
+	{
+		// Start a worker in any slot which doesn't have one.
+		for(uint32_t i = 0; i < p_workers && !t_is_worker; i++)
+		{
+			if (t_workers[i] != 0)
+				continue;
+			
+			pid_t t_pid;
+			t_pid = fork();
+			if (t_pid == 0)
+				t_is_worker = true;
+			else if (t_pid > 0)
+				t_workers[i] = t_pid;
+		}
+		
+		if (t_is_worker)
+			break;
+		
+		// Wait for a worker to exit (it will be replaced on the next iteration).
+		pid_t t_pid;
+		t_pid = waitpid(-1, NULL, 0);
+		if (t_pid > 0)
+		{
+			for(uint32_t i = 0; i < p_workers; i++)
+				if (t_workers[i] == t_pid)
+					t_workers[i] = 0;
+		}
+		else if (errno == ECHILD)
+			sleep(1);
+	}
+	
+	if (!t_is_worker)
+	{
+		// Pass the termination request on to the workers, and wait for them to
+		// finish their current requests.
+		for(uint32_t i = 0; i < p_workers; i++)
+			if (t_workers[i] != 0)
+				kill(t_workers[i], SIGTERM);
+		
+		for(uint32_t i = 0; i < p_workers; i++)
+			if (t_workers[i] != 0)
+				while(waitpid(t_workers[i], NULL, 0) < 0 && errno == EINTR)
+					;
+	}
+	
+	delete[] t_workers;
+	
+	// Workers serve requests until they are told to quit, or have served their
+	// quota, and then return so that the engine shuts down normally.
+	if (t_is_worker)
+		fastcgi_serve(t_socket, p_max_requests, p_handler);
+	else if (p_address != NULL)
+		close(t_socket);
+	
+	return true;
+}
+
+#else
+
+bool cgi_fastcgi_listener_available(void)
+{
+	return false;
+}
+
+bool cgi_serve_fastcgi(const char *p_address, uint32_t p_workers, uint32_t p_max_requests, void (*p_handler)(void))
+{
+	fprintf(stderr, "livecode-server does not support FastCGI on this platform\n");
+	return false;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MCServerGetSessionIdFromCookie(char *&r_id);
+
+MCSession *s_current_session = NULL;
+
+bool MCServerStartSession()
+{
+	// start session:
+	// if MCsessionid is empty - get id from cookie
+	// if MCsessionid not empty - use MCsessionid - clear MCsessionid once opened
+	bool t_success = true;
+	
+	if (s_current_session != NULL)
+		return true;
+
+	const char *t_session_id = NULL;
+	char *t_cookie_id = NULL;
+	
+	t_session_id = MCsessionid;
+	
+	if (t_session_id == NULL)
+	{
+		t_success = MCServerGetSessionIdFromCookie(t_cookie_id);
+		t_session_id = t_cookie_id;
+	}
+	
+	if (t_success)
+		t_success = MCSessionStart(t_session_id, s_current_session);
+	
+	MCVariable *t_session_var = NULL;
+	
+	if (t_success)
+	{
+		t_session_var = MCVariable::lookupglobal_cstring("$_SESSION");
+		if (t_session_var == NULL)
+		{
+			t_success = MCVariable::createwithname_cstring("$_SESSION", t_session_var);
+			if (t_success)
+			{
+				t_session_var->setnext(MCglobals);
+				MCglobals = t_session_var;
+			}
+		}
+	}
+	if (t_success)
+		t_session_var->getvalue().assign_empty();
+	
+	if (t_success)
+	{
+		if (s_current_session->data_length > 0)
+			t_success = t_session_var->getvalue().decode(MCString(s_current_session->data, s_current_session->data_length));
+	}
+	
+	if (t_success)
+	{
+		// clear MCsessionid - now associated with open session
+		MCCStringFree(MCsessionid);
+		MCsessionid = NULL;
+	}
+	else
+	{
+		MCSessionDiscard(s_current_session);
+		s_current_session = NULL;
+	}
+	
+	MCCStringFree(t_cookie_id);
+	
+	return t_success;
+}
+
+bool MCServerStopSession()
+{
+	bool t_success = true;
+	
+	if (s_current_session == NULL)
+		return true;
+	
+	char *t_data = NULL;
+	uint32_t t_data_length = 0;
+	
+	MCVariable *t_session_var;
+	t_session_var = MCVariable::lookupglobal_cstring("$_SESSION");
+
+	if (t_session_var != NULL)
+		t_success = t_session_var->getvalue().encode((void*&)t_data, t_data_length);
+
+	if (t_success)
+	{
+		MCMemoryDeallocate(s_current_session->data);
+		s_current_session->data = t_data;
+		s_current_session->data_length = t_data_length;
+		
+		t_success = MCSessionCommit(s_current_session);
+		s_current_session = NULL;
+	}
+
+	return t_success;
+}
+
+bool MCServerDeleteSession()
+{
+	bool t_success = true;
+	
+	// discard the current session first so its lock is released before the
+	// session is expired.
+	char *t_id = NULL;
+	if (MCS_get_session_id() != NULL)
+		t_success = MCCStringClone(MCS_get_session_id(), t_id);
+	
+	if (s_current_session != NULL)
+	{
+		MCSessionDiscard(s_current_session);
+		s_current_session = NULL;
+	}
+	
+	if (t_success)
+		t_success = MCSessionExpire(t_id);
+	
+	MCCStringFree(t_id);
+	
+	return t_success;
+}
+
+void cgi_finalize_session()
+{
+	// close current session if open
+	if (s_current_session != NULL)
+	{
+		MCSessionCommit(s_current_session);
+		s_current_session = NULL;
+	}
+
+	// clean up session files
+	MCSessionCleanup();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Session properties
+
+static char *s_session_temp_dir = NULL;
+bool MCS_get_temporary_folder(char *&r_folder);
+
+bool MCS_set_session_save_path(const char *p_path)
+{
+	char *t_save_path = nil;
+	
+	if (!MCCStringClone(p_path, t_save_path))
+		return false;
+	
+	MCCStringFree(MCsessionsavepath);
+	MCsessionsavepath = t_save_path;
+	
+	return true;
+}
+
+const char *MCS_get_session_save_path(void)
+{
+	if (MCsessionsavepath != NULL && MCCStringLength(MCsessionsavepath) > 0)
+		return MCsessionsavepath;
+	
+	if (s_session_temp_dir != NULL)
+		return s_session_temp_dir;
+	
+	if (MCS_get_temporary_folder(s_session_temp_dir))
+		return s_session_temp_dir;
+	
+	return NULL;
+}
+
+bool MCS_set_session_lifetime(uint32_t p_lifetime)
+{
+	MCsessionlifetime = p_lifetime;
+	return true;
+}
+
+uint32_t MCS_get_session_lifetime(void)
+{
+	return MCsessionlifetime;
+}
+
+bool MCS_set_session_name(const char *p_name)
+{
+	char *t_name = nil;
+	
+	if (!MCCStringClone(p_name, t_name))
+		return false;
+	
+	MCCStringFree(MCsessionname);
+	MCsessionname = t_name;
+	
+	return true;
 }
 
 const char *MCS_get_session_name(void)
@@ -1684,6 +2915,27 @@ const char *MCS_get_session_id(void)
 	return MCsessionid;
 }
 
+bool MCS_set_session_store(MCSSessionStore p_store)
+{
+	// the store cannot change while a session is open
+	if (s_current_session != NULL)
+		return false;
+	
+	MCsessionstore = p_store;
+	
+	return true;
+}
+
+MCSSessionStore MCS_get_session_store(void)
+{
+	return MCsessionstore;
+}
+
+void MCS_get_include_cache_statistics(uint32_t& r_hits, uint32_t& r_misses)
+{
+	MCserverscript -> GetCacheStatistics(r_hits, r_misses);
+}
+
 bool MCServerGetSessionIdFromCookie(char *&r_id)
 {
 	MCVariable *t_cookie_array;
@@ -63,6 +63,16 @@ static char *s_server_home = NULL;
 // If true, the server engine is running in CGI mode
 static bool s_server_cgi = false;
 
+// If true, the server engine is running in FastCGI mode, in which case it
+// serves requests on the given address (or the socket passed by the web server
+// on stdin if nil). The requests are handled by the given number of worker
+// processes (or the main process if zero), each of which is replaced after
+// serving the given number of requests (if non-zero).
+static bool s_server_fastcgi = false;
+static char *s_fastcgi_address = NULL;
+static uint32_t s_fastcgi_workers = 4;
+static uint32_t s_fastcgi_max_requests = 1000;
+
 // The main script the server engine will run.
 char *MCserverinitialscript = NULL;
 
@@ -101,6 +111,9 @@ char *MCsessionid = NULL;
 // The lifetime of session data in seconds.  default = 24mins
 uint32_t MCsessionlifetime = 60 * 24;
 
+// The backend used to store session data
+MCSSessionStore MCsessionstore = kMCSSessionStoreIndex;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 /*
@@ -327,8 +340,37 @@ int X_close();
 
 extern bool cgi_initialize();
 extern void cgi_finalize(void);
+extern bool cgi_fastcgi_listener_available(void);
+extern bool cgi_serve_fastcgi(const char *p_address, uint32_t p_workers, uint32_t p_max_requests, void (*p_handler)(void));
 extern void MCU_initialize_names();
 
+// Parse the FastCGI mode options:
+//   -fastcgi [ <address> ] [ -workers <count> ] [ -maxrequests <count> ]
+// Where <address> is either a local socket path or '[<host>]:<port>'.
+static bool X_parse_fastcgi_options(int argc, char *argv[])
+{
+	int i;
+	i = 2;
+	
+	if (i < argc && argv[i][0] != '-')
+		s_fastcgi_address = strdup(argv[i++]);
+	
+	for(; i < argc; i += 2)
+	{
+		if (i + 1 >= argc)
+			return false;
+		
+		if (strcmp(argv[i], "-workers") == 0)
+			s_fastcgi_workers = strtoul(argv[i + 1], NULL, 10);
+		else if (strcmp(argv[i], "-maxrequests") == 0)
+			s_fastcgi_max_requests = strtoul(argv[i + 1], NULL, 10);
+		else
+			return false;
+	}
+	
+	return true;
+}
+
 bool X_init(int argc, char *argv[], char *envp[])
 {
 	int i;
@@ -397,6 +439,22 @@ bool X_init(int argc, char *argv[], char *envp[])
 		//   be created.
 		envp = nil;
 	}
+	else if ((argc > 1 && strcmp(argv[1], "-fastcgi") == 0) ||
+			 (argc == 1 && cgi_fastcgi_listener_available()))
+	{
+		if (!X_parse_fastcgi_options(argc, argv))
+		{
+			fprintf(stderr, "usage: %s -fastcgi [<address>] [-workers <count>] [-maxrequests <count>]\n", argv[0]);
+			return False;
+		}
+		
+		s_server_fastcgi = true;
+		
+		// Each request is run as a CGI request would be, so as with CGI mode
+		// env vars should not be created.
+		MCS_set_errormode(kMCSErrorModeInline);
+		envp = nil;
+	}
 	else
 	{
 		MCS_set_errormode(kMCSErrorModeStderr);
@@ -459,11 +517,144 @@ static void X_load_extensions(MCServerScript *p_script)
 	delete t_dir;
 }
 
+// Run the main script, reporting any errors using the scriptExecutionError
+// handler.
+static void X_run_script(void)
+{
+	MCExecPoint ep;
+	if (!MCserverscript -> Include(ep, MCserverinitialscript, false) &&
+		MCS_get_errormode() != kMCSErrorModeDebugger)
+	{
+		char *t_eerror, *t_efiles;
+		t_eerror = MCeerror -> getsvalue() . clone();
+		MCserverscript -> ListFiles(ep);
+		t_efiles = ep . getsvalue() . clone();
+		MCeerror -> clear();
+		
+		MCParameter t_exec_stack, t_files;
+		t_exec_stack . sets_argument(t_eerror);
+		t_exec_stack . setnext(&t_files);
+		t_files . sets_argument(t_efiles);
+		
+		Exec_stat t_stat;
+		t_stat = MCserverscript -> message(MCM_script_execution_error, &t_exec_stack);
+		if (t_stat == ES_NOT_HANDLED && MCS_get_errormode() != kMCSErrorModeQuiet)
+		{
+			MCHandlerlist *t_handlerlist;
+			t_handlerlist = new MCHandlerlist;
+			
+			MCHandler *t_handler;
+			t_handler = new MCHandler(HT_MESSAGE, true);
+			
+			MCScriptPoint sp(MCserverscript, t_handlerlist, s_default_error_handler);
+			
+			Parse_stat t_parse_stat;
+			t_parse_stat = t_handler -> parse(sp, false);
+			t_stat = MCserverscript -> exechandler(t_handler, &t_exec_stack);
+			
+			delete t_handler;
+			delete t_handlerlist;
+		}
+		
+		if ((t_stat != ES_NORMAL && t_stat != ES_PASS) && MCS_get_errormode() != kMCSErrorModeQuiet)
+		{
+			IO_printf(IO_stderr, "ERROR:\n%s\n", t_eerror);
+			IO_printf(IO_stderr, "FILES:\n%s\n", t_efiles);
+		}
+
+		delete t_eerror;
+		delete t_efiles;
+	}
+}
+
+// Serve a single FastCGI request - the request's params have been placed in
+// the environment and the standard streams connected to it. Once done, all
+// script state is discarded so the next request starts afresh.
+static void X_serve_request(void)
+{
+	MCperror -> clear();
+	MCeerror -> clear();
+	
+	// Globals are added to the front of the list, so those in front of this
+	// one once the request is done have been created by its script.
+	MCVariable *t_first_global;
+	t_first_global = NULL;
+	
+	if (cgi_initialize())
+	{
+		t_first_global = MCglobals;
+		X_run_script();
+		cgi_finalize();
+	}
+	
+	// Discard the handlers, script locals and files loaded by the request.
+	MCserverscript -> Reset();
+	
+	// Delete the globals created by the request's script so the next request
+	// doesn't see them. Any declared by a retained script, and any '$' globals
+	// (which scripts bind to when parsed), are kept as handlers refer to them
+	// directly - their values are cleared below.
+	if (t_first_global != NULL)
+	{
+		MCVariable *t_previous;
+		t_previous = NULL;
+		MCVariable *t_var;
+		t_var = MCglobals;
+		while(t_var != t_first_global)
+		{
+			MCVariable *t_next;
+			t_next = t_var -> getnext();
+			if (MCserverscript -> IsGlobalRetained(t_var))
+				t_previous = t_var;
+			else
+			{
+				if (t_previous == NULL)
+					MCglobals = t_next;
+				else
+					t_previous -> setnext(t_next);
+				delete t_var;
+			}
+			t_var = t_next;
+		}
+	}
+	
+	// The remaining globals may be referenced from elsewhere (e.g. by externals
+	// or the engine's own cgi variables), so their values are cleared rather
+	// than the variables being deleted.
+	for(MCVariable *t_var = MCglobals; t_var != NULL; t_var = t_var -> getnext())
+		t_var -> clear(True);
+	MCresult -> clear(True);
+	
+	delete MCserverinitialscript;
+	MCserverinitialscript = NULL;
+	
+	MCS_set_errormode(kMCSErrorModeInline);
+	MCserveroutputtextencoding = kMCSOutputTextEncodingNative;
+	MCserveroutputlineendings = kMCSOutputLineEndingsNative;
+	
+	MCexitall = False;
+}
+
 void X_main_loop(void)
 {
 	int i;
 	MCstackbottom = (char *)&i;
 
+	if (s_server_fastcgi)
+	{
+		MCserverscript = static_cast<MCServerScript *>(MCdispatcher -> gethome());
+		
+		// Externals are loaded once and shared by all requests.
+		X_load_extensions(MCserverscript);
+		
+		// Scripts are retained between requests so that unchanged files are
+		// only parsed once per worker.
+		MCserverscript -> SetCacheIncludes(true);
+		
+		cgi_serve_fastcgi(s_fastcgi_address, s_fastcgi_workers, s_fastcgi_max_requests, X_serve_request);
+		return;
+	}
+	
 	if (MCserverinitialscript == NULL)
 		return;
 	
@@ -510,50 +701,7 @@ void X_main_loop(void)
 		return;
 #endif
 	
-	MCExecPoint ep;
-	if (!MCserverscript -> Include(ep, MCserverinitialscript, false) &&
-		MCS_get_errormode() != kMCSErrorModeDebugger)
-	{
-		char *t_eerror, *t_efiles;
-		t_eerror = MCeerror -> getsvalue() . clone();
-		MCserverscript -> ListFiles(ep);
-		t_efiles = ep . getsvalue() . clone();
-		MCeerror -> clear();
-		
-		MCParameter t_exec_stack, t_files;
-		t_exec_stack . sets_argument(t_eerror);
-		t_exec_stack . setnext(&t_files);
-		t_files . sets_argument(t_efiles);
-		
-		Exec_stat t_stat;
-		t_stat = MCserverscript -> message(MCM_script_execution_error, &t_exec_stack);
-		if (t_stat == ES_NOT_HANDLED && MCS_get_errormode() != kMCSErrorModeQuiet)
-		{
-			MCHandlerlist *t_handlerlist;
-			t_handlerlist = new MCHandlerlist;
-			
-			MCHandler *t_handler;
-			t_handler = new MCHandler(HT_MESSAGE, true);
-			
-			MCScriptPoint sp(MCserverscript, t_handlerlist, s_default_error_handler);
-			
-			Parse_stat t_parse_stat;
-			t_parse_stat = t_handler -> parse(sp, false);
-			t_stat = MCserverscript -> exechandler(t_handler, &t_exec_stack);
-			
-			delete t_handler;
-			delete t_handlerlist;
-		}
-		
-		if ((t_stat != ES_NORMAL && t_stat != ES_PASS) && MCS_get_errormode() != kMCSErrorModeQuiet)
-		{
-			IO_printf(IO_stderr, "ERROR:\n%s\n", t_eerror);
-			IO_printf(IO_stderr, "FILES:\n%s\n", t_efiles);
-		}
-
-		delete t_eerror;
-		delete t_efiles;
-	}
+	X_run_script();
 	
 	if (s_server_cgi)
 		cgi_finalize();
@@ -33,6 +33,7 @@ extern char *MCsessionsavepath;
 extern char *MCsessionname;
 extern char *MCsessionid;
 extern uint32_t MCsessionlifetime;
+extern MCSSessionStore MCsessionstore;
 
 extern char **MCservercgiheaders;
 extern uint32_t MCservercgiheadercount;
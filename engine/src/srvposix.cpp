@@ -1010,3 +1010,14 @@ bool MCSystemLockFile(MCSystemFileHandle *p_file, bool p_shared, bool p_wait)
 	
 	return 0 == flock(t_fd, t_op);
 }
+
+bool MCSystemFileIsCurrent(MCSystemFileHandle *p_file, const char *p_path)
+{
+	int t_fd = fileno(((MCStdioFileHandle*)p_file)->GetStream());
+	
+	struct stat t_open_stat, t_path_stat;
+	if (fstat(t_fd, &t_open_stat) != 0 || stat(p_path, &t_path_stat) != 0)
+		return false;
+	
+	return t_open_stat.st_dev == t_path_stat.st_dev && t_open_stat.st_ino == t_path_stat.st_ino;
+}
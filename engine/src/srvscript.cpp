@@ -38,6 +38,30 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "system.h"
 #include "srvscript.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WINDOWS_SERVER
+#define stat _stat
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The maximum number of programs retained between requests.
+#define MAX_CACHED_PROGRAMS 64
+
+static bool stat_file(const char *p_filename, int64_t& r_size, int64_t& r_modified)
+{
+	struct stat t_stat;
+	if (stat(p_filename, &t_stat) != 0)
+		return false;
+
+	r_size = t_stat . st_size;
+	r_modified = t_stat . st_mtime;
+
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 MCServerScript::MCServerScript(void)
@@ -46,22 +70,309 @@ MCServerScript::MCServerScript(void)
 	m_ep = NULL;
 	m_include_depth = 0;
 	m_current_file = nil;
+	m_cache_includes = false;
+	m_programs = nil;
+	m_program = nil;
+	m_unit_index = 0;
+	m_parsing_unit = nil;
+	m_cache_hits = 0;
+	m_cache_misses = 0;
 }
 
 MCServerScript::~MCServerScript(void)
 {
-	while(m_files != NULL)
+	Reset();
+
+	while(m_programs != nil)
 	{
-		File *t_file;
-		t_file = m_files;
-		m_files = m_files -> next;
+		Program *t_program;
+		t_program = m_programs;
+		m_programs = m_programs -> next;
+
+		DestroyProgram(t_program);
+	}
+}
+
+void MCServerScript::Reset(void)
+{
+	// The handlers and the global exec point refer to substrings of the file
+	// buffers, so must go first.
+	delete m_ep;
+	m_ep = NULL;
+	
+	if (m_program != nil)
+	{
+		// The handlers are owned by the program's units, so are only removed from
+		// the handler list here.
+		hlist -> detachhandlers();
+		m_program -> files = m_files;
+
+		if (m_cache_includes && m_program -> reusable && CollectGlobals(m_program))
+		{
+			RewindProgram(m_program);
+
+			m_program -> next = m_programs;
+			m_programs = m_program;
+
+			Program *t_last;
+			t_last = m_programs;
+			for(uint32_t i = 1; i < MAX_CACHED_PROGRAMS && t_last -> next != nil; i++)
+				t_last = t_last -> next;
+
+			while(t_last -> next != nil)
+			{
+				Program *t_stale;
+				t_stale = t_last -> next;
+				t_last -> next = t_stale -> next;
+				DestroyProgram(t_stale);
+			}
+		}
+		else
+			DestroyProgram(m_program);
+
+		m_program = nil;
+		hlist = NULL;
+		m_files = NULL;
+	}
+	else
+	{
+		delete hlist;
+		hlist = NULL;
 		
+		while(m_files != NULL)
+		{
+			File *t_file;
+			t_file = m_files;
+			m_files = m_files -> next;
+			
+			if (t_file -> handle != NULL)
+				t_file -> handle -> Close();
+			delete t_file -> filename;
+			delete t_file -> script;
+			delete t_file;
+		}
+	}
+	
+	m_current_file = nil;
+	m_include_depth = 0;
+	m_unit_index = 0;
+}
+
+void MCServerScript::SetCacheIncludes(bool p_enabled)
+{
+	m_cache_includes = p_enabled;
+}
+
+void MCServerScript::GetCacheStatistics(uint32_t& r_hits, uint32_t& r_misses)
+{
+	r_hits = m_cache_hits;
+	r_misses = m_cache_misses;
+}
+
+bool MCServerScript::IsGlobalRetained(MCVariable *p_var)
+{
+	// Environment globals are bound into the varrefs of any script that
+	// mentions them (rather than being declared), so a retained script may
+	// refer to one without it appearing in any global list.
+	if (p_var -> isenv())
+		return true;
+
+	for(Program *t_program = m_programs; t_program != nil; t_program = t_program -> next)
+	{
+		uint32_t t_low, t_high;
+		t_low = 0;
+		t_high = t_program -> global_count;
+		while(t_low < t_high)
+		{
+			uint32_t t_mid;
+			t_mid = t_low + (t_high - t_low) / 2;
+			if (t_program -> globals[t_mid] == p_var)
+				return true;
+			if (t_program -> globals[t_mid] < p_var)
+				t_low = t_mid + 1;
+			else
+				t_high = t_mid;
+		}
+	}
+	
+	return false;
+}
+
+static int compare_global_address(const void *a, const void *b)
+{
+	MCVariable *t_left, *t_right;
+	t_left = *(MCVariable * const *)a;
+	t_right = *(MCVariable * const *)b;
+	if (t_left < t_right)
+		return -1;
+	if (t_left > t_right)
+		return 1;
+	return 0;
+}
+
+bool MCServerScript::CollectGlobals(Program *p_program)
+{
+	uint32_t t_count;
+	t_count = p_program -> hlist -> getnglobals();
+	for(uint32_t i = 0; i < p_program -> unit_count; i++)
+		for(uint32_t j = 0; j < p_program -> units[i] . handler_count; j++)
+			t_count += p_program -> units[i] . handlers[j] -> getnglobals();
+
+	free(p_program -> globals);
+	p_program -> globals = NULL;
+	p_program -> global_count = 0;
+	if (t_count == 0)
+		return true;
+
+	p_program -> globals = (MCVariable **)malloc(sizeof(MCVariable *) * t_count);
+	if (p_program -> globals == NULL)
+		return false;
+
+	uint32_t t_index;
+	t_index = 0;
+	for(uint2 i = 0; i < p_program -> hlist -> getnglobals(); i++)
+		p_program -> globals[t_index++] = p_program -> hlist -> getglobal(i);
+	for(uint32_t i = 0; i < p_program -> unit_count; i++)
+		for(uint32_t j = 0; j < p_program -> units[i] . handler_count; j++)
+		{
+			MCHandler *t_handler;
+			t_handler = p_program -> units[i] . handlers[j];
+			for(uint2 k = 0; k < t_handler -> getnglobals(); k++)
+				p_program -> globals[t_index++] = t_handler -> getglobal(k);
+		}
+
+	qsort(p_program -> globals, t_count, sizeof(MCVariable *), compare_global_address);
+	p_program -> global_count = t_count;
+
+	return true;
+}
+
+void MCServerScript::OpenProgram(const char *p_filename)
+{
+	char *t_filename;
+	t_filename = MCsystem -> ResolvePath(p_filename);
+
+	// Look for a program for the main script, removing it from the cache if
+	// found.
+	Program *t_program, *t_previous;
+	t_previous = nil;
+	for(t_program = m_programs; t_program != nil; t_previous = t_program, t_program = t_program -> next)
+		if (strcmp(t_program -> filename, t_filename) == 0)
+			break;
+
+	if (t_program != nil)
+	{
+		if (t_previous != nil)
+			t_previous -> next = t_program -> next;
+		else
+			m_programs = t_program -> next;
+		t_program -> next = nil;
+
+		// If any of the files the program uses have changed since they were
+		// parsed, then the program is discarded.
+		for(File *t_file = t_program -> files; t_file != nil; t_file = t_file -> next)
+		{
+			int64_t t_size, t_modified;
+			if (!stat_file(t_file -> filename, t_size, t_modified) ||
+				t_size != t_file -> size || t_modified != t_file -> modified)
+			{
+				DestroyProgram(t_program);
+				t_program = nil;
+				break;
+			}
+		}
+	}
+
+	if (t_program == nil)
+	{
+		t_program = new Program;
+		t_program -> next = nil;
+		t_program -> filename = t_filename;
+		t_program -> hlist = new MCHandlerlist;
+		t_program -> files = nil;
+		t_program -> units = nil;
+		t_program -> unit_count = 0;
+		t_program -> reusable = true;
+		t_program -> globals = NULL;
+		t_program -> global_count = 0;
+	}
+	else
+		delete t_filename;
+
+	m_program = t_program;
+	m_unit_index = 0;
+
+	hlist = t_program -> hlist;
+	m_files = t_program -> files;
+}
+
+void MCServerScript::DestroyUnits(Program *p_program, uint32_t p_first_unit)
+{
+	for(uint32_t i = p_first_unit; i < p_program -> unit_count; i++)
+	{
+		Unit *t_unit;
+		t_unit = &p_program -> units[i];
+
+		if (t_unit -> statements != nil)
+			t_unit -> statements -> deletestatements(t_unit -> statements);
+
+		for(uint32_t j = 0; j < t_unit -> handler_count; j++)
+			delete t_unit -> handlers[j];
+		free(t_unit -> handlers);
+	}
+
+	if (p_first_unit < p_program -> unit_count)
+		p_program -> unit_count = p_first_unit;
+}
+
+void MCServerScript::RewindProgram(Program *p_program)
+{
+	// Restore all script locals to their initial values.
+	MCNameRef *t_vinits;
+	t_vinits = p_program -> hlist -> getvinits();
+
+	uint32_t t_index;
+	t_index = 0;
+	for(MCVariable *t_var = p_program -> hlist -> getvars(); t_var != nil; t_var = t_var -> getnext(), t_index++)
+	{
+		if (t_vinits[t_index] != nil)
+			t_var -> setnameref_unsafe(t_vinits[t_index]);
+		else
+		{
+			t_var -> setnameref_unsafe(t_var -> getname());
+			t_var -> setuql();
+		}
+	}
+
+	for(File *t_file = p_program -> files; t_file != nil; t_file = t_file -> next)
+		t_file -> included = false;
+}
+
+void MCServerScript::DestroyProgram(Program *p_program)
+{
+	// The statements and handlers refer to the script locals and file buffers,
+	// so must go first.
+	DestroyUnits(p_program, 0);
+	free(p_program -> units);
+
+	delete p_program -> hlist;
+
+	while(p_program -> files != nil)
+	{
+		File *t_file;
+		t_file = p_program -> files;
+		p_program -> files = t_file -> next;
+
 		if (t_file -> handle != NULL)
 			t_file -> handle -> Close();
 		delete t_file -> filename;
 		delete t_file -> script;
 		delete t_file;
 	}
+
+	free(p_program -> globals);
+	delete p_program -> filename;
+	delete p_program;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -69,8 +380,14 @@ MCServerScript::~MCServerScript(void)
 void MCServerScript::ListFiles(MCExecPoint& ep)
 {
 	ep . clear();
+	bool t_first;
+	t_first = true;
 	for(File *t_file = m_files; t_file != NULL; t_file = t_file -> next)
-		ep . concatcstring(t_file -> filename, EC_RETURN, t_file == m_files);
+		if (t_file -> included)
+		{
+			ep . concatcstring(t_file -> filename, EC_RETURN, t_first);
+			t_first = false;
+		}
 }
 
 uint4 MCServerScript::GetFileIndexForContext(MCExecPoint& ep)
@@ -137,6 +454,9 @@ MCServerScript::File *MCServerScript::FindFile(const char *p_filename, bool p_ad
 	t_file -> index = m_files == NULL ? 1 : m_files -> index + 1;
 	t_file -> script = NULL;
 	t_file -> handle = NULL;
+	t_file -> included = false;
+	t_file -> size = 0;
+	t_file -> modified = 0;
 	
 	return t_file;
 }
@@ -197,6 +517,20 @@ Parse_stat MCServerScript::ParseNextStatement(MCScriptPoint& sp, MCStatement*& r
 						{
 							sp . sethandler(NULL);
 							hlist -> addhandler((Handler_type)t_symbol -> which, t_new_handler);
+							
+							// If parsed scripts are being retained, the handler is owned by the
+							// unit being parsed.
+							if (m_parsing_unit != nil)
+							{
+								m_parsing_unit -> handlers = (MCHandler **)realloc(m_parsing_unit -> handlers, sizeof(MCHandler *) * (m_parsing_unit -> handler_count + 1));
+								m_parsing_unit -> handlers[m_parsing_unit -> handler_count++] = t_new_handler;
+								
+								// Calls to private handlers bind directly to the handler when
+								// first executed, so a program containing them can't be run
+								// again with a potentially different set of includes.
+								if (t_is_private)
+									m_program -> reusable = false;
+							}
 						}
 						else
 						{
@@ -311,7 +645,12 @@ bool MCServerScript::Include(MCExecPoint& outer_ep, const char *p_filename, bool
 	}
 
 	if (hlist == NULL)
-		hlist = new MCHandlerlist;
+	{
+		if (m_cache_includes)
+			OpenProgram(p_filename);
+		else
+			hlist = new MCHandlerlist;
+	}
 	
 	if (m_ep == NULL)
 		m_ep = new MCExecPoint(this, hlist, NULL);
@@ -342,16 +681,23 @@ bool MCServerScript::Include(MCExecPoint& outer_ep, const char *p_filename, bool
 	MCsystem->SetCurrentFolder(t_old_folder);
 	MCCStringFree(t_old_folder);
 
-	// If we are 'requiring' and the script is already loaded, we are done.
-	if (t_file -> script != NULL && p_require)
+	// If we are 'requiring' and the script is already included, we are done.
+	if (t_file -> included && p_require)
 		return true;
 	
 	// If the file isn't open yet, open it
 	if (t_file -> script == NULL)
 	{
-		// Attempt to open the file
+		// If the file is to be retained, then note its size and modification
+		// time so we can tell if it changes. (This is done before reading so
+		// that a change while reading is noticed on the next request).
+		if (m_program != nil && !stat_file(t_file -> filename, t_file -> size, t_file -> modified))
+			m_program -> reusable = false;
+		
+		// Attempt to open the file - retained files are not mmapped since
+		// their contents must not change underneath the parsed script.
 		MCSystemFileHandle *t_handle;
-		t_handle = MCsystem -> OpenFile(t_file -> filename, kMCSystemFileModeRead | kMCSystemFileModeNulTerminate, true);
+		t_handle = MCsystem -> OpenFile(t_file -> filename, kMCSystemFileModeRead | kMCSystemFileModeNulTerminate, m_program == nil);
 		if (t_handle == NULL)
 		{
 			MCeerror -> add(EE_INCLUDE_FILENOTFOUND, 0, 0, t_file -> filename);
@@ -382,6 +728,65 @@ bool MCServerScript::Include(MCExecPoint& outer_ep, const char *p_filename, bool
 		m_files = t_file;
 	}
 	
+	t_file -> included = true;
+	
+	// If parsed scripts are being retained, then each include uses the next unit
+	// of the program. If the unit was parsed from the same file on a previous
+	// request then its handlers and statements can be reused directly.
+	// Otherwise, this request has diverged from the previous run of the program
+	// so the remaining units are discarded and a new one is started.
+	Unit *t_unit;
+	t_unit = nil;
+	
+	bool t_cached;
+	t_cached = false;
+	
+	if (m_program != nil)
+	{
+		if (m_unit_index < m_program -> unit_count && m_program -> units[m_unit_index] . file == t_file)
+			t_cached = true;
+		else
+		{
+			DestroyUnits(m_program, m_unit_index);
+			
+			uint2 t_nvars, t_nconstants, t_nglobals;
+			t_nvars = t_nconstants = t_nglobals = 0;
+			if (m_unit_index > 0)
+			{
+				t_nvars = m_program -> units[m_unit_index - 1] . nvars;
+				t_nconstants = m_program -> units[m_unit_index - 1] . nconstants;
+				t_nglobals = m_program -> units[m_unit_index - 1] . nglobals;
+			}
+			
+			MCVariable *t_removed;
+			t_removed = hlist -> truncate(t_nvars, t_nconstants, t_nglobals);
+			while(t_removed != nil)
+			{
+				MCVariable *t_next;
+				t_next = t_removed -> getnext();
+				delete t_removed;
+				t_removed = t_next;
+			}
+			
+			m_program -> units = (Unit *)realloc(m_program -> units, sizeof(Unit) * (m_program -> unit_count + 1));
+			
+			Unit *t_new_unit;
+			t_new_unit = &m_program -> units[m_program -> unit_count];
+			t_new_unit -> file = t_file;
+			t_new_unit -> statements = nil;
+			t_new_unit -> handlers = nil;
+			t_new_unit -> handler_count = 0;
+			t_new_unit -> nvars = 0;
+			t_new_unit -> nconstants = 0;
+			t_new_unit -> nglobals = 0;
+			
+			m_program -> unit_count += 1;
+		}
+		
+		t_unit = &m_program -> units[m_unit_index];
+		m_unit_index += 1;
+	}
+	
 	// Save the old file index
 	File *t_old_file;
 	t_old_file = m_current_file;
@@ -389,12 +794,6 @@ bool MCServerScript::Include(MCExecPoint& outer_ep, const char *p_filename, bool
 	// Set the current one.
 	m_current_file = t_file;
 	
-	// Note that script point does not copy 'script' and requires it to be NUL-
-	// terminated. Indeed, this string *has* to persist until termination as
-	// constants, handler names and variable names use substrings of it directly.
-	MCScriptPoint sp(this, hlist, t_file -> script);
-	sp . allowtags(True);
-	
 	// The statement chain that will executed.
 	MCStatement *t_statements, *t_last_statement;
 	t_statements = t_last_statement = nil;
@@ -402,35 +801,74 @@ bool MCServerScript::Include(MCExecPoint& outer_ep, const char *p_filename, bool
 	// Clear any parse errors
 	MCperror -> clear();
 
-	// Parse the statements
 	Parse_stat t_stat;
 	t_stat = PS_NORMAL;
-	for(;;)
-	{	
-		// If we end up parsing a statement, it will be stored here.
-		MCStatement *t_statement;
-		t_statement = NULL;
-
-		// Fetch the next statement (if any).
-		t_stat = ParseNextStatement(sp, t_statement);
 	
-		// If we got a statement, append it to the chain.
-		if (t_statement != nil)
-		{
-			if (t_last_statement != nil)
-				t_last_statement -> setnext(t_statement);
-			else
-				t_statements = t_statement;
+	if (t_cached)
+	{
+		// Reinstate the unit's handlers and use its statements.
+		hlist -> addhandlers(t_unit -> handlers, t_unit -> handler_count);
+		
+		t_statements = t_unit -> statements;
+		
+		m_cache_hits += 1;
+	}
+	else
+	{
+		// Note that script point does not copy 'script' and requires it to be NUL-
+		// terminated. Indeed, this string *has* to persist until termination as
+		// constants, handler names and variable names use substrings of it directly.
+		MCScriptPoint sp(this, hlist, t_file -> script);
+		sp . allowtags(True);
+		
+		m_parsing_unit = t_unit;
+		
+		// Parse the statements
+		for(;;)
+		{	
+			// If we end up parsing a statement, it will be stored here.
+			MCStatement *t_statement;
+			t_statement = NULL;
+
+			// Fetch the next statement (if any).
+			t_stat = ParseNextStatement(sp, t_statement);
+		
+			// If we got a statement, append it to the chain.
+			if (t_statement != nil)
+			{
+				if (t_last_statement != nil)
+					t_last_statement -> setnext(t_statement);
+				else
+					t_statements = t_statement;
 
-			t_last_statement = t_statement;
+				t_last_statement = t_statement;
+			}
+			else if (t_stat == PS_EOF)
+			{
+				t_stat = PS_NORMAL;
+				break;
+			}
+			else
+				break;
 		}
-		else if (t_stat == PS_EOF)
+		
+		m_parsing_unit = nil;
+		
+		// If retaining the parsed script, the unit takes ownership of the
+		// statements and notes what script locals, constants and globals have
+		// been declared up to this point.
+		if (t_unit != nil)
 		{
-			t_stat = PS_NORMAL;
-			break;
+			t_unit -> statements = t_statements;
+			t_unit -> nvars = hlist -> getnvars();
+			t_unit -> nconstants = hlist -> getnconstants();
+			t_unit -> nglobals = hlist -> getnglobals();
+			
+			if (t_stat != PS_NORMAL)
+				m_program -> reusable = false;
+			
+			m_cache_misses += 1;
 		}
-		else
-			break;
 	}
 
 	////
@@ -473,7 +911,8 @@ bool MCServerScript::Include(MCExecPoint& outer_ep, const char *p_filename, bool
 			t_statement = t_statement -> getnext();
 		}
 
-		t_statements -> deletestatements(t_statements);
+		if (t_unit == nil)
+			t_statements -> deletestatements(t_statements);
 	}
 	
 	// Reduce the include depth.
@@ -26,6 +26,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #endif
 
 class MCStatement;
+class MCHandler;
 
 class MCServerScript: public MCStack
 {
@@ -33,6 +34,10 @@ public:
 	MCServerScript(void);
 	virtual ~MCServerScript(void);
 	
+	// Discard all handlers, script locals and files loaded by previous includes
+	// returning the script to the state it was in before the first include.
+	void Reset(void);
+
 	void ListFiles(MCExecPoint& ep);
 	
 	uint32_t GetIncludeDepth(void);
@@ -46,6 +51,21 @@ public:
 	// add new entry and return its index.
 	uint4 FindFileIndex(const char *p_filename, bool p_add);
 	
+	// Enable or disable retention of parsed scripts between requests. When
+	// enabled, Reset() keeps the handlers and top-level statements of the
+	// main script and the files it includes, so that a subsequent request
+	// running the same (unchanged) files skips parsing them.
+	void SetCacheIncludes(bool p_enabled);
+	
+	// Return the number of includes that were satisfied from (hits) and not
+	// satisfied from (misses) the cache of parsed scripts.
+	void GetCacheStatistics(uint32_t& r_hits, uint32_t& r_misses);
+	
+	// Returns true if the given global variable is declared by any of the
+	// retained programs, or is an environment global (and so must outlive the
+	// request which created it).
+	bool IsGlobalRetained(MCVariable *p_var);
+	
 private:
 	// A File record stores information about an included file.
 	struct File
@@ -69,6 +89,63 @@ private:
 		// The underlying system file-handle for the file - this will be nil
 		// if we had to load the entire file, non-nil if mmapped.
 		MCSystemFileHandle *handle;
+		
+		// Whether the file has been included in the current request.
+		bool included;
+		
+		// The size and modification time of the file when it was loaded.
+		int64_t size;
+		int64_t modified;
+	};
+	
+	// A Unit record stores the result of parsing a file for one include. Units
+	// are stored in the order the includes are executed.
+	struct Unit
+	{
+		// The file that was parsed.
+		File *file;
+		
+		// The top-level statements of the file.
+		MCStatement *statements;
+		
+		// The handlers defined by the file.
+		MCHandler **handlers;
+		uint32_t handler_count;
+		
+		// The number of script locals, constants and globals in the handler
+		// list after the file was parsed.
+		uint2 nvars;
+		uint2 nconstants;
+		uint2 nglobals;
+	};
+	
+	// A Program record stores the parsed state of a main script and all the
+	// files it included, so that it can be reused by later requests.
+	struct Program
+	{
+		// The list linkage for the cache of programs.
+		Program *next;
+		
+		// The absolute filename of the main script.
+		char *filename;
+		
+		// The handler list the units were parsed against, and the files they
+		// refer to.
+		MCHandlerlist *hlist;
+		File *files;
+		
+		// The units, in include order.
+		Unit *units;
+		uint32_t unit_count;
+		
+		// This is set to false if anything happens that means the program
+		// cannot be safely run again (such as a parse error).
+		bool reusable;
+		
+		// The globals declared by the handler list and the units' handlers,
+		// sorted by address. This is rebuilt each time the program is retained.
+		MCVariable **globals;
+		uint32_t global_count;
 	};
 	
 	// Locate the given file in the list of files, adding it if not present and
@@ -78,6 +155,25 @@ private:
 	// Return the next statement in the script point, processing any definitions
 	// that occur before it.
 	Parse_stat ParseNextStatement(MCScriptPoint& sp, MCStatement*& r_statement);
+	
+	// Find (or create) the program for the given main script, and make its
+	// handler list and files current.
+	void OpenProgram(const char *p_filename);
+	
+	// Destroy the units of the given program from the given index onwards. The
+	// handlers of the units must not be in the program's handler list.
+	void DestroyUnits(Program *p_program, uint32_t p_first_unit);
+	
+	// Return the program to the state it was in before it was run.
+	void RewindProgram(Program *p_program);
+	
+	// Rebuild the sorted set of globals the program's handlers refer to,
+	// returning false if there is not enough memory to do so.
+	bool CollectGlobals(Program *p_program);
+	
+	// Destroy the given program, including all its handlers, statements and
+	// files.
+	void DestroyProgram(Program *p_program);
 
 	// The linked list of files that have been included
 	File *m_files;
@@ -90,6 +186,25 @@ private:
 
 	// The execpoint in which global code is executed.
 	MCExecPoint *m_ep;
+	
+	// Whether parsed scripts are retained between requests.
+	bool m_cache_includes;
+	
+	// The programs retained from previous requests (most recently used first).
+	Program *m_programs;
+	
+	// The program being run by the current request, if caching is enabled.
+	Program *m_program;
+	
+	// The index of the unit the next include in the current request will use.
+	uint32_t m_unit_index;
+	
+	// The unit currently being parsed (if any).
+	Unit *m_parsing_unit;
+	
+	// The number of includes satisfied and not satisfied by the cache.
+	uint32_t m_cache_hits;
+	uint32_t m_cache_misses;
 };
 
 #endif
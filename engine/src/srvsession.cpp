@@ -43,6 +43,7 @@ typedef struct
 ////////////////////////////////////////////////////////////////////////////////
 
 bool MCSystemLockFile(MCSystemFileHandle *p_file, bool p_shared, bool p_wait);
+bool MCSystemFileIsCurrent(MCSystemFileHandle *p_file, const char *p_path);
 bool MCServerSetCookie(const MCString &p_name, const MCString &p_value, uint32_t p_expires, const MCString &p_path, const MCString &p_domain, bool p_secure, bool p_http_only);
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -66,6 +67,11 @@ bool MCSessionCopySession(MCSession *p_src, MCSession *&r_dst);
 bool MCSessionWriteSession(MCSession *p_session);
 bool MCSessionReadSession(MCSession *p_session);
 
+bool MCSessionShardedStart(const char *p_session_id, MCSessionRef &r_session);
+bool MCSessionShardedCloseSession(MCSession *p_session, bool p_update);
+bool MCSessionShardedExpireSession(const char *p_id);
+bool MCSessionShardedCleanup(void);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool MCSessionOpenIndex(MCSessionIndexRef &r_index)
@@ -509,6 +515,9 @@ bool MCSessionCloseSession(MCSession *p_session, bool p_update)
 
 bool MCSessionStart(const char *p_session_id, MCSessionRef &r_session)
 {
+	if (MCS_get_session_store() == kMCSSessionStoreSharded)
+		return MCSessionShardedStart(p_session_id, r_session);
+	
 	bool t_success = true;
 	
 	MCSessionIndexRef t_index = NULL;
@@ -553,15 +562,25 @@ bool MCSessionStart(const char *p_session_id, MCSessionRef &r_session)
 
 bool MCSessionCommit(MCSessionRef p_session)
 {
+	if (p_session != NULL && p_session->sharded)
+		return MCSessionShardedCloseSession(p_session, true);
+	
 	return MCSessionCloseSession(p_session, true);
 }
 
 void MCSessionDiscard(MCSessionRef p_session)
 {
-	MCSessionCloseSession(p_session, false);
+	if (p_session != NULL && p_session->sharded)
+		MCSessionShardedCloseSession(p_session, false);
+	else
+		MCSessionCloseSession(p_session, false);
 }
+
 bool MCSessionExpireSession(const char *p_id)
 {
+	if (MCS_get_session_store() == kMCSSessionStoreSharded)
+		return MCSessionShardedExpireSession(p_id);
+	
 	bool t_success = true;
 	
 	MCSession *t_session = NULL;
@@ -595,6 +614,9 @@ bool MCSessionExpire(const char *p_id)
 
 bool MCSessionCleanup(void)
 {
+	if (MCS_get_session_store() == kMCSSessionStoreSharded)
+		return MCSessionShardedCleanup();
+	
 	bool t_success = true;
 	
 	MCSessionIndexRef t_index = NULL;
@@ -690,4 +712,361 @@ bool MCSessionGenerateID(char *&r_id)
 void MCSessionRefreshExpireTime(MCSession *p_session)
 {
 	p_session->expires = MCS_time() + MCS_get_session_lifetime();
-}
\ No newline at end of file
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The sharded session store keeps each session in its own file, at
+// <save path>/lcsessions/<xx>/<key> where <key> is the hex MD5 of the
+// originating ip and session id, and <xx> is its first two characters.
+// Sessions are located by computing their path and are locked individually,
+// so concurrent requests only contend when they use the same session.
+// Expired sessions are swept one shard at a time.
+
+// sharded session file format:
+// session id (string) + originating ip (string) + expires (real64) + session data (binary)
+// an empty file holds no session.
+
+#define SESSION_SHARD_FOLDER "lcsessions"
+#define SESSION_SHARD_COUNT 256
+
+static bool MCSessionShardedGetFilename(const char *p_ip, const char *p_id, char *&r_filename)
+{
+	md5_state_t t_state;
+	md5_byte_t t_digest[16];
+	md5_init(&t_state);
+	md5_append(&t_state, (md5_byte_t *)p_ip, MCCStringLength(p_ip));
+	md5_append(&t_state, (md5_byte_t *)"\n", 1);
+	md5_append(&t_state, (md5_byte_t *)p_id, MCCStringLength(p_id));
+	md5_finish(&t_state, t_digest);
+	
+	char *t_key = NULL;
+	if (!byte_to_hex((uint8_t*)t_digest, 16, t_key))
+		return false;
+	
+	bool t_success;
+	t_success = MCCStringFormat(r_filename, "%s/%.2s/%s", SESSION_SHARD_FOLDER, t_key, t_key);
+	
+	MCCStringFree(t_key);
+	
+	return t_success;
+}
+
+static bool MCSessionShardedEnsureFolder(const char *p_path)
+{
+	if (MCsystem->FolderExists(p_path))
+		return true;
+	
+	// another request may create the folder at the same time
+	return MCsystem->CreateFolder(p_path) || MCsystem->FolderExists(p_path);
+}
+
+static bool MCSessionShardedOpenFile(const char *p_filename, MCSystemFileHandle *&r_file)
+{
+	bool t_success = true;
+	
+	char *t_folder = NULL;
+	char *t_shard = NULL;
+	char *t_path = NULL;
+	MCSystemFileHandle *t_file = NULL;
+	
+	t_success = MCCStringFormat(t_folder, "%s/%s", MCS_get_session_save_path(), SESSION_SHARD_FOLDER);
+	if (t_success)
+		t_success = MCCStringFormat(t_shard, "%s/%.*s", MCS_get_session_save_path(), (int)MCCStringLength(SESSION_SHARD_FOLDER) + 3, p_filename);
+	if (t_success)
+		t_success = MCCStringFormat(t_path, "%s/%s", MCS_get_session_save_path(), p_filename);
+	
+	if (t_success)
+		t_success = MCSessionShardedEnsureFolder(t_folder) && MCSessionShardedEnsureFolder(t_shard);
+	
+	// the cleanup sweep deletes expired files while holding their lock, so
+	// if the file we locked is no longer the one at the path it has been
+	// swept and we must open the path again.
+	while (t_success)
+	{
+		t_success = NULL != (t_file = MCsystem->OpenFile(t_path, kMCSystemFileModeUpdate, false));
+		
+		if (t_success)
+			t_success = MCSystemLockFile(t_file, false, true);
+		
+		if (!t_success || MCSystemFileIsCurrent(t_file, t_path))
+			break;
+		
+		t_file->Close();
+		t_file = NULL;
+	}
+	
+	if (t_success)
+		r_file = t_file;
+	else if (t_file != NULL)
+		t_file->Close();
+	
+	MCCStringFree(t_folder);
+	MCCStringFree(t_shard);
+	MCCStringFree(t_path);
+	
+	return t_success;
+}
+
+static bool MCSessionShardedReadHeader(MCSystemFileHandle *p_file, const char *p_id, const char *p_ip, real64_t &r_expires)
+{
+	bool t_success = true;
+	
+	char *t_id = NULL;
+	char *t_ip = NULL;
+	
+	t_success = read_cstring(p_file, t_id) &&
+				read_cstring(p_file, t_ip) &&
+				read_real64(p_file, r_expires);
+	
+	// the file may belong to another session if the keys collide
+	if (t_success && p_id != NULL)
+		t_success = MCCStringEqual(t_id, p_id) && MCCStringEqual(t_ip, p_ip);
+	
+	MCCStringFree(t_id);
+	MCCStringFree(t_ip);
+	
+	return t_success;
+}
+
+bool MCSessionShardedStart(const char *p_session_id, MCSessionRef &r_session)
+{
+	bool t_success = true;
+	
+	MCSession *t_session = NULL;
+	char *t_remote_addr;
+	t_remote_addr = MCS_getenv("REMOTE_ADDR");
+	
+	t_success = MCMemoryNew(t_session);
+	
+	if (t_success)
+	{
+		t_session->sharded = true;
+		t_success = MCCStringClone(t_remote_addr ? t_remote_addr : "", t_session->ip);
+	}
+	
+	if (t_success)
+	{
+		if (p_session_id != NULL && p_session_id[0] != '\0')
+			t_success = MCCStringClone(p_session_id, t_session->id);
+		else
+			t_success = MCSessionGenerateID(t_session->id);
+	}
+	
+	if (t_success)
+		t_success = MCSessionShardedGetFilename(t_session->ip, t_session->id, t_session->filename);
+	
+	if (t_success)
+		t_success = MCSessionShardedOpenFile(t_session->filename, t_session->filehandle);
+	
+	if (t_success && t_session->filehandle->GetFileSize() > 0)
+	{
+		// a record that is unreadable, belongs to another session or has
+		// expired is replaced by an empty session.
+		real64_t t_expires;
+		if (MCSessionShardedReadHeader(t_session->filehandle, t_session->id, t_session->ip, t_expires) && t_expires > MCS_time())
+		{
+			if (!read_binary(t_session->filehandle, (void*&)t_session->data, t_session->data_length))
+			{
+				t_session->data = NULL;
+				t_session->data_length = 0;
+			}
+		}
+	}
+	
+	if (t_success)
+		t_success = MCServerSetCookie(MCS_get_session_name(), t_session->id, 0, NULL, NULL, false, true);
+	
+	if (t_success)
+		MCSessionRefreshExpireTime(t_session);
+	
+	if (t_success)
+		r_session = t_session;
+	else
+	{
+		if (t_session != NULL)
+			MCSessionShardedCloseSession(t_session, false);
+	}
+	
+	return t_success;
+}
+
+bool MCSessionShardedCloseSession(MCSession *p_session, bool p_update)
+{
+	bool t_success = true;
+	
+	if (p_session == NULL)
+		return true;
+	
+	if (p_session->filehandle != NULL)
+	{
+		if (p_update)
+		{
+			MCSessionRefreshExpireTime(p_session);
+			
+			t_success = p_session->filehandle->Seek(0, 1);
+			if (t_success)
+				t_success = write_cstring(p_session->filehandle, p_session->id) &&
+							write_cstring(p_session->filehandle, p_session->ip) &&
+							write_real64(p_session->filehandle, p_session->expires) &&
+							write_binary(p_session->filehandle, p_session->data, p_session->data_length);
+			if (t_success)
+				t_success = p_session->filehandle->Flush();
+			if (t_success)
+				t_success = p_session->filehandle->Truncate();
+		}
+		p_session->filehandle->Close();
+	}
+	
+	MCSessionDisposeSession(p_session);
+	
+	return t_success;
+}
+
+bool MCSessionShardedExpireSession(const char *p_id)
+{
+	bool t_success = true;
+	
+	if (p_id == NULL)
+		return true;
+	
+	char *t_remote_addr;
+	t_remote_addr = MCS_getenv("REMOTE_ADDR");
+	
+	char *t_filename = NULL;
+	char *t_path = NULL;
+	MCSystemFileHandle *t_file = NULL;
+	
+	t_success = MCSessionShardedGetFilename(t_remote_addr ? t_remote_addr : "", p_id, t_filename);
+	if (t_success)
+		t_success = MCCStringFormat(t_path, "%s/%s", MCS_get_session_save_path(), t_filename);
+	
+	// truncating the file under its lock removes the session, the empty
+	// file is deleted when its shard is next swept.
+	if (t_success && MCsystem->FileExists(t_path))
+	{
+		t_success = MCSessionShardedOpenFile(t_filename, t_file);
+		
+		real64_t t_expires;
+		if (t_success && t_file->GetFileSize() > 0 &&
+			MCSessionShardedReadHeader(t_file, p_id, t_remote_addr ? t_remote_addr : "", t_expires))
+		{
+			t_success = t_file->Seek(0, 1);
+			if (t_success)
+				t_success = t_file->Truncate();
+		}
+		
+		if (t_file != NULL)
+			t_file->Close();
+	}
+	
+	MCCStringFree(t_filename);
+	MCCStringFree(t_path);
+	
+	return t_success;
+}
+
+struct MCSessionShardedListState
+{
+	char **names;
+	uint32_t count;
+};
+
+static bool MCSessionShardedListCallback(void *p_context, const MCSystemFolderEntry *p_entry)
+{
+	MCSessionShardedListState *t_state;
+	t_state = (MCSessionShardedListState *)p_context;
+	
+	if (p_entry->is_folder)
+		return true;
+	
+	if (!MCMemoryResizeArray(t_state->count + 1, t_state->names, t_state->count))
+		return false;
+	
+	return MCCStringClone(p_entry->name, t_state->names[t_state->count - 1]);
+}
+
+bool MCSessionShardedCleanup(void)
+{
+	bool t_success = true;
+	
+	// sweep a single shard, chosen at random, on each call so the cost of
+	// cleaning up is independent of the number of sessions.
+	uint8_t *t_random = NULL;
+	uint32_t t_shard_index = 0;
+	if (MCCrypt_random_bytes(1, (void*&)t_random))
+		t_shard_index = t_random[0] % SESSION_SHARD_COUNT;
+	MCMemoryDeallocate(t_random);
+	
+	char *t_shard = NULL;
+	t_success = MCCStringFormat(t_shard, "%s/%s/%02X", MCS_get_session_save_path(), SESSION_SHARD_FOLDER, t_shard_index);
+	
+	if (!t_success || !MCsystem->FolderExists(t_shard))
+	{
+		MCCStringFree(t_shard);
+		return t_success;
+	}
+	
+	MCSessionShardedListState t_list;
+	t_list.names = NULL;
+	t_list.count = 0;
+	
+	char *t_dir;
+	t_dir = MCS_getcurdir();
+	
+	if (MCS_setcurdir(t_shard))
+		t_success = MCsystem->ListFolderEntries(MCSessionShardedListCallback, &t_list);
+	
+	MCS_setcurdir(t_dir);
+	delete t_dir;
+	
+	real8 t_time;
+	t_time = MCS_time();
+	
+	for (uint32_t i = 0; t_success && i < t_list.count; i++)
+	{
+		char *t_full_path = NULL;
+		if (!MCCStringFormat(t_full_path, "%s/%s", t_shard, t_list.names[i]))
+			continue;
+		
+		// sessions in use are locked, so skip any file we cannot lock. the
+		// file is deleted while the lock is still held, so a request that
+		// opened the path before the delete sees that the file it locked is
+		// no longer current and opens it again.
+		MCSystemFileHandle *t_file;
+		t_file = MCsystem->OpenFile(t_full_path, kMCSystemFileModeRead, false);
+		if (t_file != NULL)
+		{
+			bool t_expired = false;
+			if (MCSystemLockFile(t_file, false, false) && MCSystemFileIsCurrent(t_file, t_full_path))
+			{
+				real64_t t_expires;
+				t_expired = t_file->GetFileSize() == 0 ||
+							!MCSessionShardedReadHeader(t_file, NULL, NULL, t_expires) ||
+							t_expires <= t_time;
+			}
+			
+			// files that are open can't be deleted on Windows, so there the
+			// delete is retried once the file is closed - it fails if another
+			// request has opened the file in the meantime.
+			bool t_deleted = false;
+			if (t_expired)
+				t_deleted = MCsystem->DeleteFile(t_full_path);
+			
+			t_file->Close();
+			
+			if (t_expired && !t_deleted)
+				MCsystem->DeleteFile(t_full_path);
+		}
+		
+		MCCStringFree(t_full_path);
+	}
+	
+	for (uint32_t i = 0; i < t_list.count; i++)
+		MCCStringFree(t_list.names[i]);
+	MCMemoryDeleteArray(t_list.names);
+	
+	MCCStringFree(t_shard);
+	
+	return t_success;
+}
@@ -27,6 +27,9 @@ typedef struct
 	
 	MCSystemFileHandle * filehandle;
 	
+	// true if the session is held in the sharded session store
+	bool		sharded;
+	
 	// session data
 	uint32_t	data_length;
 	char *		data;
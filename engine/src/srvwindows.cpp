@@ -1267,5 +1267,12 @@ bool MCSystemLockFile(MCSystemFileHandle *p_file, bool p_shared, bool p_wait)
 	return t_success;
 }
 
+bool MCSystemFileIsCurrent(MCSystemFileHandle *p_file, const char *p_path)
+{
+	// Files are opened without FILE_SHARE_DELETE, so one cannot be deleted
+	// or replaced while we have it open.
+	return true;
+}
+
 
 
@@ -134,6 +134,12 @@ MCStack::MCStack()
 	// MW-2011-11-24: [[ UpdateScreen ]] Start off with defer updates false.
 	m_defer_updates = false;
 	
+	// Nothing is known about the stack's file until it is saved.
+	m_saved_digest_valid = false;
+	m_saved_length = 0;
+	m_saved_modified = 0;
+	m_saved_file_id = 0;
+	
 	// MW-2012-10-10: [[ IdCache ]]
 	m_id_cache = nil;
 
@@ -323,6 +329,12 @@ MCStack::MCStack(const MCStack &sref) : MCObject(sref)
 	// MW-2011-11-24: [[ UpdateScreen ]] Start off with defer updates false.
 	m_defer_updates = false;
 	
+	// Nothing is known about the stack's file until it is saved.
+	m_saved_digest_valid = false;
+	m_saved_length = 0;
+	m_saved_modified = 0;
+	m_saved_file_id = 0;
+	
 	// MW-2010-11-17: [[ Valgrind ]] Uninitialized value.
 	cursoroverride = false;
 
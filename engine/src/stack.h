@@ -170,6 +170,15 @@ protected:
 	//   be flushed at the next updateScreen point.
 	bool m_defer_updates : 1;
 	
+	// The length and md5 digest of what was last written to the stack's file
+	// by a save, and the file's modification time and id after it, so an
+	// unchanged stack needn't replace a file that hasn't been touched since.
+	bool m_saved_digest_valid : 1;
+	uint4 m_saved_length;
+	uint8_t m_saved_digest[16];
+	int64_t m_saved_modified;
+	uint64_t m_saved_file_id;
+	
 	MCRectangle old_rect ; 	// The rectangle of the stack before it was "fullscreened"
 	
 	static uint2 ibeam;
@@ -364,6 +373,8 @@ public:
 	void setstackfiles(const MCString &);
 	char *getstackfile(const MCString &);
 	void setfilename(char *f);
+	void setsaveddigest(uint4 p_length, const uint8_t p_digest[16], int64_t p_modified, uint64_t p_file_id);
+	bool matchessaveddigest(uint4 p_length, const uint8_t p_digest[16], int64_t p_modified, uint64_t p_file_id) const;
 
 	virtual IO_stat load(IO_handle stream, const char *version, uint1 type);
 	IO_stat load_stack(IO_handle stream, const char *version);
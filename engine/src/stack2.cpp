@@ -2255,6 +2255,24 @@ void MCStack::setfilename(char *f)
 	filename = f;
 	if (f != NULL)
 		MCU_fix_path(filename);
+
+	// Whatever was last saved no longer says anything about the file.
+	m_saved_digest_valid = false;
+}
+
+void MCStack::setsaveddigest(uint4 p_length, const uint8_t p_digest[16], int64_t p_modified, uint64_t p_file_id)
+{
+	m_saved_digest_valid = true;
+	m_saved_length = p_length;
+	memcpy(m_saved_digest, p_digest, 16);
+	m_saved_modified = p_modified;
+	m_saved_file_id = p_file_id;
+}
+
+bool MCStack::matchessaveddigest(uint4 p_length, const uint8_t p_digest[16], int64_t p_modified, uint64_t p_file_id) const
+{
+	return m_saved_digest_valid && m_saved_length == p_length && memcmp(m_saved_digest, p_digest, 16) == 0 &&
+		m_saved_modified == p_modified && m_saved_file_id == p_file_id;
 }
 
 void MCStack::loadwindowshape()
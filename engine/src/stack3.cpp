@@ -1123,7 +1123,14 @@ Exec_stat MCStack::setcard(MCCard *card, Boolean recent, Boolean dynamic)
 		return ES_NORMAL;
 	}
 	else
+	{
+		// Decode the new card's images together, rather than one by one as
+		// each is first drawn - but only if it is actually about to be drawn.
+		if (card != oldcard && window != DNULL && isvisible() && !(state & CS_ICONIC))
+			curcard -> prefetchimages();
+
 		effectrect(curcard->getrect(), abort);
+	}
 
 	MClockmessages = oldlock;
 	if (oldcard != NULL && oldcard != curcard)
@@ -56,13 +56,13 @@ bool MCStackSecurityCopyStack(const MCStack *p_stack, MCStack *&r_copy)
 
 bool MCStackSecurityCreateObjectInputStream(IO_handle p_stream, uint32_t p_length, MCObjectInputStream *&r_object_stream)
 {
-	r_object_stream = new MCObjectInputStream(p_stream, p_length);
+	r_object_stream = new MCObjectInputStream(p_stream, p_length, true);
 	return r_object_stream != nil;
 }
 
 bool MCStackSecurityCreateObjectOutputStream(IO_handle p_stream, MCObjectOutputStream *&r_object_stream)
 {
-	r_object_stream = new MCObjectOutputStream(p_stream);
+	r_object_stream = new MCObjectOutputStream(p_stream, true);
 	return r_object_stream != nil;
 }
 
@@ -754,6 +754,12 @@ void MCS_fakewriteat(IO_handle p_stream, uint4 p_pos, const void *p_buffer, uint
 	t_handle -> WriteAt(p_pos, p_buffer, p_size);
 }
 
+bool MCS_getreadbuffer(IO_handle p_stream, const char*& r_buffer, uint4& r_available)
+{
+	// The system file handles don't expose their buffers.
+	return false;
+}
+
 const char *MCS_tmpnam(void)
 {
 	static char *t_file = NULL;
@@ -29,6 +29,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "tilecache.h"
 #include "region.h"
 
+#include "thread.h"
+
 #ifdef _HAS_QSORT_R
 #define stdc_qsort(a, b, c, d, e) qsort_r(a, b, c, e, d)
 #elif defined(_HAS_QSORT_S)
@@ -2374,7 +2376,7 @@ void MCTileCacheRenderSprite(MCTileCacheRef self, MCTileCacheLayer& x_layer)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static bool MCTileCacheDoComposite(MCTileCacheRef self)
+static bool MCTileCacheDoComposite(MCTileCacheRef self, void *p_context)
 {
 	if (self -> display_list_frontier == 0)
 		return true;
@@ -2416,12 +2418,12 @@ static bool MCTileCacheDoComposite(MCTileCacheRef self)
 			if (t_tile -> constant == 0)
 			{
 				if (self -> compositor . composite_tile != nil)
-					t_success = self -> compositor . composite_tile(self -> compositor . context, t_x, t_y, t_tile -> data);
+					t_success = self -> compositor . composite_tile(p_context, t_x, t_y, t_tile -> data);
 			}
 			else if (t_tile -> alpha != 0)
 			{
 				if (self -> compositor . composite_rect != nil)
-					t_success = self -> compositor . composite_rect(self -> compositor . context, t_x, t_y, (uintptr_t)(t_tile -> data));
+					t_success = self -> compositor . composite_rect(p_context, t_x, t_y, (uintptr_t)(t_tile -> data));
 			}
 		}
 		else if (!t_in_layer)
@@ -2444,7 +2446,7 @@ static bool MCTileCacheDoComposite(MCTileCacheRef self)
 			
 			// Now we notify the compositor about starting a new layer.
 			if (self -> compositor . begin_layer != nil)
-				t_success = self -> compositor . begin_layer(self -> compositor . context, t_clip, t_opacity, t_ink);
+				t_success = self -> compositor . begin_layer(p_context, t_clip, t_opacity, t_ink);
 			
 			// Mark ourselves as being within a layer.
 			t_in_layer = true;
@@ -2457,7 +2459,7 @@ static bool MCTileCacheDoComposite(MCTileCacheRef self)
 			
 			// Notify the compositor.
 			if (self -> compositor . end_layer != nil)
-				t_success = self -> compositor . end_layer(self -> compositor . context);
+				t_success = self -> compositor . end_layer(p_context);
 			
 			// Mark ourselves as being outside a layer.
 			t_in_layer = false;
@@ -2468,6 +2470,77 @@ static bool MCTileCacheDoComposite(MCTileCacheRef self)
 	return t_success;
 }
 
+// The smallest band of rows worth compositing on its own.
+#define kMCTileCacheMinimumBandHeight 32
+
+struct MCTileCacheCompositeBandsContext
+{
+	MCTileCacheRef tilecache;
+	MCRectangle dirty;
+	int32_t band_height;
+	bool *results;
+};
+
+static void MCTileCacheCompositeBand(void *p_context, uindex_t p_index)
+{
+	MCTileCacheCompositeBandsContext *t_context;
+	t_context = (MCTileCacheCompositeBandsContext *)p_context;
+
+	MCTileCacheRef self;
+	self = t_context -> tilecache;
+
+	MCRectangle t_band;
+	t_band = t_context -> dirty;
+	t_band . y += p_index * t_context -> band_height;
+	t_band . height = MCU_min(t_context -> band_height, t_context -> dirty . y + t_context -> dirty . height - t_band . y);
+
+	// Each band replays the whole display list, clipped to its rows.
+	void *t_band_context;
+	if (!self -> compositor . begin_band(self -> compositor . context, t_band, t_band_context))
+	{
+		t_context -> results[p_index] = false;
+		return;
+	}
+
+	t_context -> results[p_index] = MCTileCacheDoComposite(self, t_band_context);
+
+	self -> compositor . end_band(self -> compositor . context, t_band_context);
+}
+
+// Composite the display list by splitting the dirty area into horizontal bands
+// and compositing them on the thread pool. The display list and tiles are only
+// read while this happens.
+static bool MCTileCacheDoCompositeBands(MCTileCacheRef self, const MCRectangle& p_dirty)
+{
+	// Use a couple of bands per thread so that an uneven scene still spreads
+	// its work out.
+	int32_t t_band_height;
+	t_band_height = (p_dirty . height + MCThreadPoolGetConcurrency() * 2 - 1) / (MCThreadPoolGetConcurrency() * 2);
+	t_band_height = MCU_max(t_band_height, kMCTileCacheMinimumBandHeight);
+
+	uindex_t t_band_count;
+	t_band_count = (p_dirty . height + t_band_height - 1) / t_band_height;
+
+	MCTileCacheCompositeBandsContext t_context;
+	t_context . tilecache = self;
+	t_context . dirty = p_dirty;
+	t_context . band_height = t_band_height;
+	if (!MCMemoryNewArray(t_band_count, t_context . results))
+		return false;
+
+	MCThreadPoolRun(t_band_count, MCTileCacheCompositeBand, &t_context);
+
+	bool t_success;
+	t_success = true;
+	for(uindex_t i = 0; i < t_band_count; i++)
+		if (!t_context . results[i])
+			t_success = false;
+
+	MCMemoryDeleteArray(t_context . results);
+
+	return t_success;
+}
+
 bool MCTileCacheComposite(MCTileCacheRef self, MCStackSurface *p_surface, MCRegionRef p_dirty_rgn)
 {
 	// Keep track of whether the compositor calls succeeded.
@@ -2478,9 +2551,19 @@ bool MCTileCacheComposite(MCTileCacheRef self, MCStackSurface *p_surface, MCRegi
 	if (t_success && self -> compositor . begin_frame)
 		t_success = self -> compositor . begin_frame(self -> compositor . context, p_surface, p_dirty_rgn);
 
-	// Next run through the display list (backwards).
-	if (t_success)
-		t_success = MCTileCacheDoComposite(self);
+	// Next run through the display list (backwards). If the compositor can work
+	// on bands of the frame independently and there is enough to do, the bands
+	// are composited concurrently.
+	MCRectangle t_dirty;
+	t_dirty = MCRegionGetBoundingBox(p_dirty_rgn);
+	if (t_success &&
+		self -> display_list_frontier != 0 &&
+		self -> compositor . begin_band != nil &&
+		MCThreadPoolGetConcurrency() > 1 &&
+		t_dirty . height >= 2 * kMCTileCacheMinimumBandHeight)
+		t_success = MCTileCacheDoCompositeBands(self, t_dirty);
+	else if (t_success)
+		t_success = MCTileCacheDoComposite(self, self -> compositor . context);
 	
 	// Final step, tell the compositor we are done.
 	if (t_success && self -> compositor . end_frame != nil)
@@ -2511,7 +2594,7 @@ bool MCTileCacheSnapshot(MCTileCacheRef self, MCRectangle p_area, Pixmap& r_pixm
 		t_success = self -> compositor . begin_snapshot(self -> compositor . context, p_area, t_snapshot);
 	
 	if (t_success)
-		t_success = MCTileCacheDoComposite(self);
+		t_success = MCTileCacheDoComposite(self, self -> compositor . context);
 	
 	if (t_success)
 		t_success = self -> compositor . end_snapshot(self -> compositor . context, p_area, t_snapshot);
@@ -47,6 +47,12 @@ typedef bool (*MCTileCacheEndLayerCallback)(void *context);
 typedef bool (*MCTileCacheCompositeTileCallback)(void *context, int32_t x, int32_t y, void *tile);
 // Composite a tile-sized rectangle at the given location.
 typedef bool (*MCTileCacheCompositeRectCallback)(void *context, int32_t x, int32_t y, uint32_t color);
+// Create a context for compositing the given band of the current frame. Bands
+// don't overlap, and are composited concurrently so the band contexts must not
+// share any mutable state.
+typedef bool (*MCTileCacheBeginBandCallback)(void *context, const MCRectangle& band, void*& r_band_context);
+// Compositing of a band has ended.
+typedef void (*MCTileCacheEndBandCallback)(void *context, void *band_context);
 // Snapshot of the current frame has begun.
 typedef bool (*MCTileCacheBeginSnapshotCallback)(void *context, MCRectangle area, Pixmap target);
 // Snapshot of the current frame has ended.
@@ -68,6 +74,8 @@ struct MCTileCacheCompositor
 	MCTileCacheEndLayerCallback end_layer;
 	MCTileCacheCompositeTileCallback composite_tile;
 	MCTileCacheCompositeRectCallback composite_rect;
+	MCTileCacheBeginBandCallback begin_band;
+	MCTileCacheEndBandCallback end_band;
 	MCTileCacheBeginSnapshotCallback begin_snapshot;
 	MCTileCacheEndSnapshotCallback end_snapshot;
 };
@@ -42,6 +42,8 @@ struct MCTileCacheSoftwareCompositorContext
 	
 	// The rectangle the bits cover
 	MCRectangle dirty;
+	// The rectangle being composited (a band of dirty, or all of it)
+	MCRectangle band;
 
 	// The raster to render into.
 	void *bits;
@@ -95,7 +97,8 @@ bool MCTileCacheSoftwareCompositor_BeginFrame(void *p_context, MCStackSurface *p
 	
 	self -> tile_size = MCTileCacheGetTileSize(self -> tilecache);
 	self -> dirty = MCRegionGetBoundingBox(p_dirty);
-	self -> clip = self -> dirty;
+	self -> band = self -> dirty;
+	self -> clip = self -> band;
 	self -> combiner = s_surface_combiners_nda[GXcopy];
 	self -> opacity = 255;
 	
@@ -109,12 +112,42 @@ bool MCTileCacheSoftwareCompositor_EndFrame(void *p_context, MCStackSurface *p_s
 	return true;
 }
 
+bool MCTileCacheSoftwareCompositor_BeginBand(void *p_context, const MCRectangle& p_band, void*& r_band_context)
+{
+	MCTileCacheSoftwareCompositorContext *self;
+	self = (MCTileCacheSoftwareCompositorContext *)p_context;
+
+	// A band shares the frame's raster, but has its own clip, combiner state and
+	// fill row so that bands can be composited at the same time.
+	MCTileCacheSoftwareCompositorContext *t_band;
+	if (!MCMemoryNew(t_band))
+		return false;
+
+	*t_band = *self;
+	t_band -> band = MCU_intersect_rect(self -> dirty, p_band);
+	t_band -> clip = t_band -> band;
+	t_band -> tile_row = nil;
+	t_band -> tile_row_color = 0;
+
+	r_band_context = t_band;
+
+	return true;
+}
+
+void MCTileCacheSoftwareCompositor_EndBand(void *p_context, void *p_band_context)
+{
+	MCTileCacheSoftwareCompositorContext *t_band;
+	t_band = (MCTileCacheSoftwareCompositorContext *)p_band_context;
+	MCMemoryDeallocate(t_band -> tile_row);
+	MCMemoryDelete(t_band);
+}
+
 bool MCTileCacheSoftwareCompositor_BeginLayer(void *p_context, const MCRectangle& p_clip, uint32_t p_opacity, uint32_t p_ink)
 {
 	MCTileCacheSoftwareCompositorContext *self;
 	self = (MCTileCacheSoftwareCompositorContext *)p_context;
 	
-	self -> clip = MCU_intersect_rect(self -> dirty, p_clip);
+	self -> clip = MCU_intersect_rect(self -> band, p_clip);
 	self -> opacity = p_opacity;
 	self -> combiner = s_surface_combiners_nda[p_ink];
 
@@ -126,7 +159,7 @@ bool MCTileCacheSoftwareCompositor_EndLayer(void *p_context)
 	MCTileCacheSoftwareCompositorContext *self;
 	self = (MCTileCacheSoftwareCompositorContext *)p_context;
 
-	self -> clip = self -> dirty;
+	self -> clip = self -> band;
 	self -> opacity = 255;
 	self -> combiner = s_surface_combiners_nda[GXcopy];
 
@@ -213,6 +246,8 @@ bool MCTileCacheSoftwareCompositorConfigure(MCTileCacheRef p_tilecache, MCTileCa
 	r_compositor . deallocate_tile = MCTileCacheSoftwareCompositor_DeallocateTile;
 	r_compositor . begin_frame = MCTileCacheSoftwareCompositor_BeginFrame;
 	r_compositor . end_frame = MCTileCacheSoftwareCompositor_EndFrame;
+	r_compositor . begin_band = MCTileCacheSoftwareCompositor_BeginBand;
+	r_compositor . end_band = MCTileCacheSoftwareCompositor_EndBand;
 	r_compositor . begin_layer = MCTileCacheSoftwareCompositor_BeginLayer;
 	r_compositor . end_layer = MCTileCacheSoftwareCompositor_EndLayer;
 	r_compositor . composite_tile = MCTileCacheSoftwareCompositor_CompositeTile;
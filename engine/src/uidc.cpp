@@ -182,11 +182,361 @@ MCMovingList::~MCMovingList()
 	delete pts;
 }
 
+static void MCMessageListFree(MCMessageList& p_message)
+{
+	while (p_message.params != NULL)
+	{
+		MCParameter *tmp = p_message.params;
+		p_message.params = p_message.params->getnext();
+		delete tmp;
+	}
+	MCNameDelete(p_message . message);
+}
+
+static inline uint4 MCMessageHeapHashId(uint4 p_id)
+{
+	return p_id * 2654435761U;
+}
+
+static inline uint4 MCMessageHeapHashObject(MCObject *p_object)
+{
+	return (uint4)((uintptr_t)p_object >> 3) * 2654435761U;
+}
+
+MCMessageHeap::MCMessageHeap(void)
+{
+	m_messages = NULL;
+	m_count = 0;
+	m_capacity = 0;
+	m_ids = NULL;
+	m_objects = NULL;
+	m_index_size = 0;
+}
+
+MCMessageHeap::~MCMessageHeap(void)
+{
+	for(uint4 i = 0; i < m_count; i++)
+		MCMessageListFree(m_messages[i]);
+	delete[] m_messages;
+	delete[] m_ids;
+	delete[] m_objects;
+}
+
+void MCMessageHeap::push(const MCMessageList& p_message)
+{
+	if (m_count == m_capacity)
+		grow();
+
+	objectadd(p_message . object);
+	place(m_count++, p_message);
+	siftup(m_count - 1);
+}
+
+void MCMessageHeap::remove(uint4 p_index, MCMessageList& r_message)
+{
+	r_message = m_messages[p_index];
+	if (r_message . id != 0)
+		idremove(r_message . id);
+	objectremove(r_message . object);
+
+	m_count--;
+	if (p_index == m_count)
+		return;
+
+	// Move the last message into the hole, then restore the heap order in
+	// whichever direction it is broken.
+	place(p_index, m_messages[m_count]);
+	update(p_index);
+}
+
+void MCMessageHeap::update(uint4 p_index)
+{
+	if (p_index > 0 && before(p_index, (p_index - 1) / 2))
+		siftup(p_index);
+	else
+		siftdown(p_index);
+}
+
+bool MCMessageHeap::findid(uint4 p_id, uint4& r_index)
+{
+	if (m_count == 0)
+		return false;
+
+	uint4 t_position;
+	t_position = idfind(p_id);
+	if (t_position == 0)
+		return false;
+
+	r_index = t_position - 1;
+	return true;
+}
+
+bool MCMessageHeap::hasobject(MCObject *p_object)
+{
+	if (m_count == 0)
+		return false;
+
+	uint4 t_mask;
+	t_mask = m_index_size - 1;
+	for(uint4 i = MCMessageHeapHashObject(p_object) & t_mask; m_objects[i] . object != NULL; i = (i + 1) & t_mask)
+		if (m_objects[i] . object == p_object)
+			return true;
+
+	return false;
+}
+
+bool MCMessageHeap::findobject(MCObject *p_object, MCNameRef p_name, uint4& r_index)
+{
+	if (!hasobject(p_object))
+		return false;
+
+	for(uint4 i = 0; i < m_count; i++)
+		if (m_messages[i] . object == p_object && MCNameIsEqualTo(m_messages[i] . message, p_name, kMCCompareCaseless))
+		{
+			r_index = i;
+			return true;
+		}
+
+	return false;
+}
+
+void MCMessageHeap::cancelobject(MCObject *p_object, MCNameRef p_name)
+{
+	if (!hasobject(p_object))
+		return;
+
+	uint4 t_kept;
+	t_kept = 0;
+	for(uint4 i = 0; i < m_count; i++)
+	{
+		if (m_messages[i] . object == p_object
+		        && (p_name == NULL || MCNameIsEqualTo(m_messages[i] . message, p_name, kMCCompareCaseless)))
+			MCMessageListFree(m_messages[i]);
+		else
+			m_messages[t_kept++] = m_messages[i];
+	}
+
+	if (t_kept == m_count)
+		return;
+
+	m_count = t_kept;
+	rebuild();
+}
+
+bool MCMessageHeap::before(uint4 a, uint4 b)
+{
+	if (m_messages[a] . time != m_messages[b] . time)
+		return m_messages[a] . time < m_messages[b] . time;
+	return (int4)(m_messages[a] . sequence - m_messages[b] . sequence) < 0;
+}
+
+void MCMessageHeap::place(uint4 p_index, const MCMessageList& p_message)
+{
+	m_messages[p_index] = p_message;
+	if (p_message . id != 0)
+		idinsert(p_message . id, p_index);
+}
+
+void MCMessageHeap::siftup(uint4 p_index)
+{
+	while (p_index > 0)
+	{
+		uint4 t_parent;
+		t_parent = (p_index - 1) / 2;
+		if (!before(p_index, t_parent))
+			break;
+
+		MCMessageList t_message;
+		t_message = m_messages[t_parent];
+		place(t_parent, m_messages[p_index]);
+		place(p_index, t_message);
+		p_index = t_parent;
+	}
+}
+
+void MCMessageHeap::siftdown(uint4 p_index)
+{
+	for(;;)
+	{
+		uint4 t_least;
+		t_least = p_index;
+
+		uint4 t_child;
+		t_child = 2 * p_index + 1;
+		if (t_child < m_count && before(t_child, t_least))
+			t_least = t_child;
+		if (t_child + 1 < m_count && before(t_child + 1, t_least))
+			t_least = t_child + 1;
+		if (t_least == p_index)
+			break;
+
+		MCMessageList t_message;
+		t_message = m_messages[t_least];
+		place(t_least, m_messages[p_index]);
+		place(p_index, t_message);
+		p_index = t_least;
+	}
+}
+
+void MCMessageHeap::grow(void)
+{
+	uint4 t_capacity;
+	t_capacity = m_capacity == 0 ? 16 : m_capacity * 2;
+
+	MCMessageList *t_messages;
+	t_messages = new MCMessageList[t_capacity];
+	if (m_count != 0)
+		memcpy(t_messages, m_messages, m_count * sizeof(MCMessageList));
+	delete[] m_messages;
+
+	m_messages = t_messages;
+	m_capacity = t_capacity;
+
+	rebuild();
+}
+
+void MCMessageHeap::rebuild(void)
+{
+	if (m_index_size != m_capacity * 2)
+	{
+		delete[] m_ids;
+		delete[] m_objects;
+		m_index_size = m_capacity * 2;
+		m_ids = new IdSlot[m_index_size];
+		m_objects = new ObjectSlot[m_index_size];
+	}
+	memset(m_ids, 0, m_index_size * sizeof(IdSlot));
+	memset(m_objects, 0, m_index_size * sizeof(ObjectSlot));
+
+	for(uint4 i = 0; i < m_count; i++)
+	{
+		if (m_messages[i] . id != 0)
+			idinsert(m_messages[i] . id, i);
+		objectadd(m_messages[i] . object);
+	}
+
+	if (m_count > 1)
+		for(uint4 i = m_count / 2; i-- > 0; )
+			siftdown(i);
+}
+
+// The id index maps an id to its position in the heap plus one, so that a
+// position of zero marks an empty slot.
+void MCMessageHeap::idinsert(uint4 p_id, uint4 p_position)
+{
+	uint4 t_mask;
+	t_mask = m_index_size - 1;
+
+	uint4 i;
+	for(i = MCMessageHeapHashId(p_id) & t_mask; m_ids[i] . position != 0; i = (i + 1) & t_mask)
+		if (m_ids[i] . id == p_id)
+			break;
+
+	m_ids[i] . id = p_id;
+	m_ids[i] . position = p_position + 1;
+}
+
+uint4 MCMessageHeap::idfind(uint4 p_id)
+{
+	uint4 t_mask;
+	t_mask = m_index_size - 1;
+	for(uint4 i = MCMessageHeapHashId(p_id) & t_mask; m_ids[i] . position != 0; i = (i + 1) & t_mask)
+		if (m_ids[i] . id == p_id)
+			return m_ids[i] . position;
+	return 0;
+}
+
+void MCMessageHeap::idremove(uint4 p_id)
+{
+	uint4 t_mask;
+	t_mask = m_index_size - 1;
+
+	uint4 i;
+	for(i = MCMessageHeapHashId(p_id) & t_mask; m_ids[i] . position != 0; i = (i + 1) & t_mask)
+		if (m_ids[i] . id == p_id)
+			break;
+	if (m_ids[i] . position == 0)
+		return;
+
+	// Shift back any following entries of the cluster that would no longer be
+	// reachable across the hole.
+	uint4 j;
+	j = i;
+	for(;;)
+	{
+		m_ids[i] . position = 0;
+		for(;;)
+		{
+			j = (j + 1) & t_mask;
+			if (m_ids[j] . position == 0)
+				return;
+
+			uint4 k;
+			k = MCMessageHeapHashId(m_ids[j] . id) & t_mask;
+			if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+				continue;
+			break;
+		}
+		m_ids[i] = m_ids[j];
+		i = j;
+	}
+}
+
+void MCMessageHeap::objectadd(MCObject *p_object)
+{
+	uint4 t_mask;
+	t_mask = m_index_size - 1;
+
+	uint4 i;
+	for(i = MCMessageHeapHashObject(p_object) & t_mask; m_objects[i] . object != NULL; i = (i + 1) & t_mask)
+		if (m_objects[i] . object == p_object)
+		{
+			m_objects[i] . count++;
+			return;
+		}
+
+	m_objects[i] . object = p_object;
+	m_objects[i] . count = 1;
+}
+
+void MCMessageHeap::objectremove(MCObject *p_object)
+{
+	uint4 t_mask;
+	t_mask = m_index_size - 1;
+
+	uint4 i;
+	for(i = MCMessageHeapHashObject(p_object) & t_mask; m_objects[i] . object != NULL; i = (i + 1) & t_mask)
+		if (m_objects[i] . object == p_object)
+			break;
+	if (m_objects[i] . object == NULL || --m_objects[i] . count != 0)
+		return;
+
+	uint4 j;
+	j = i;
+	for(;;)
+	{
+		m_objects[i] . object = NULL;
+		for(;;)
+		{
+			j = (j + 1) & t_mask;
+			if (m_objects[j] . object == NULL)
+				return;
+
+			uint4 k;
+			k = MCMessageHeapHashObject(m_objects[j] . object) & t_mask;
+			if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+				continue;
+			break;
+		}
+		m_objects[i] = m_objects[j];
+		i = j;
+	}
+}
+
 MCUIDC::MCUIDC()
 {
 	messageid = 0;
-	nmessages = maxmessages = 0;
-	messages = NULL;
+	messagesequence = 0;
 	moving = NULL;
 	ncolors = 0;
 	colors = NULL;
@@ -199,9 +549,6 @@ MCUIDC::MCUIDC()
 
 MCUIDC::~MCUIDC()
 {
-	while (nmessages != 0)
-		cancelmessageindex(0, True);
-	delete messages;
 }
 
 
@@ -677,15 +1024,12 @@ Boolean MCUIDC::getmouseclick(uint2 button, Boolean& r_abort)
 
 void MCUIDC::delaymessage(MCObject *optr, MCNameRef mptr, char *p1, char *p2)
 {
-	if (nmessages == maxmessages)
-	{
-		maxmessages++;
-		MCU_realloc((char **)&messages, nmessages, maxmessages, sizeof(MCMessageList));
-	}
-	messages[nmessages].object = optr;
-	/* UNCHECKED */ MCNameClone(mptr, messages[nmessages].message);
-	messages[nmessages].time = MCS_time();
-	messages[nmessages].id = ++messageid;
+	MCMessageList t_message;
+	t_message.object = optr;
+	/* UNCHECKED */ MCNameClone(mptr, t_message.message);
+	t_message.time = MCS_time();
+	t_message.id = ++messageid;
+	t_message.sequence = ++messagesequence;
 	MCParameter *params = NULL;
 	if (p1 != NULL)
 	{
@@ -697,25 +1041,23 @@ void MCUIDC::delaymessage(MCObject *optr, MCNameRef mptr, char *p1, char *p2)
 			params->getnext()->setbuffer(p2, strlen(p2));
 		}
 	}
-	messages[nmessages++].params = params;
+	t_message.params = params;
+	messages.push(t_message);
 }
 
 void MCUIDC::addmessage(MCObject *optr, MCNameRef mptr, real8 time, MCParameter *params)
 {
-	if (nmessages == maxmessages)
-	{
-		maxmessages++;
-		MCU_realloc((char **)&messages, nmessages,
-		            maxmessages, sizeof(MCMessageList));
-	}
-	messages[nmessages].object = optr;
-	/* UNCHECKED */ MCNameClone(mptr, messages[nmessages].message);
-	messages[nmessages].time = time;
-	messages[nmessages].id = ++messageid;
+	MCMessageList t_message;
+	t_message.object = optr;
+	/* UNCHECKED */ MCNameClone(mptr, t_message.message);
+	t_message.time = time;
+	t_message.id = ++messageid;
+	t_message.sequence = ++messagesequence;
+	t_message.params = params;
+	messages.push(t_message);
 	char buffer[U4L];
-	sprintf(buffer, "%u", messages[nmessages].id);
+	sprintf(buffer, "%u", t_message.id);
 	MCresult->copysvalue(buffer);
-	messages[nmessages++].params = params;
 }
 
 Boolean MCUIDC::wait(real8 duration, Boolean dispatch, Boolean anyevent)
@@ -812,132 +1154,159 @@ void MCUIDC::updatemenubar(Boolean force)
 
 void MCUIDC::addtimer(MCObject *optr, MCNameRef mptr, uint4 delay)
 {
-	uint2 i;
-	for (i = 0 ; i < nmessages ; i++)
-		if (messages[i].object == optr && MCNameIsEqualTo(messages[i].message, mptr, kMCCompareCaseless))
+	// If the object already has a pending message with this name, re-time it
+	// rather than posting another.
+	MCMessageHeap *t_heaps[2] = { &timers, &messages };
+	for(uint4 i = 0; i < 2; i++)
+	{
+		uint4 t_index;
+		if (t_heaps[i] -> findobject(optr, mptr, t_index))
 		{
-			messages[i].time = MCS_time() + delay / 1000.0;
+			t_heaps[i] -> get(t_index) . time = MCS_time() + delay / 1000.0;
+			t_heaps[i] -> update(t_index);
 			return;
 		}
-	if (nmessages == maxmessages)
-	{
-		maxmessages++;
-		MCU_realloc((char **)&messages, nmessages,
-		            maxmessages, sizeof(MCMessageList));
 	}
-	messages[nmessages].object = optr;
-	/* UNCHECKED */ MCNameClone(mptr, messages[nmessages].message);
-	messages[nmessages].time = MCS_time() + delay / 1000.0;
-	messages[nmessages].id = 0;
-	messages[nmessages++].params = NULL;
+
+	MCMessageList t_message;
+	t_message.object = optr;
+	/* UNCHECKED */ MCNameClone(mptr, t_message.message);
+	t_message.time = MCS_time() + delay / 1000.0;
+	t_message.id = 0;
+	t_message.sequence = ++messagesequence;
+	t_message.params = NULL;
+	timers.push(t_message);
 }
 
-void MCUIDC::cancelmessageindex(uint2 i, Boolean dodelete)
+// Return the heap whose next message is due first. Only timers are eligible
+// if messages are not being dispatched.
+bool MCUIDC::nextmessage(Boolean dispatch, MCMessageHeap*& r_heap)
 {
-	if (dodelete)
+	bool t_has_timer, t_has_message;
+	t_has_timer = timers . getcount() != 0;
+	t_has_message = dispatch && messages . getcount() != 0;
+
+	if (t_has_timer && t_has_message)
 	{
-		while (messages[i].params != NULL)
-		{
-			MCParameter *tmp = messages[i].params;
-			messages[i].params = messages[i].params->getnext();
-			delete tmp;
-		}
-		MCNameDelete(messages[i] . message);
+		MCMessageList& t_timer = timers . get(0);
+		MCMessageList& t_message = messages . get(0);
+		if (t_message . time < t_timer . time
+		        || (t_message . time == t_timer . time && (int4)(t_message . sequence - t_timer . sequence) < 0))
+			r_heap = &messages;
+		else
+			r_heap = &timers;
 	}
-	nmessages--;
-	while (i++ < nmessages)
-		messages[i - 1] = messages[i];
+	else if (t_has_timer)
+		r_heap = &timers;
+	else if (t_has_message)
+		r_heap = &messages;
+	else
+		return false;
+
+	return true;
 }
 
 void MCUIDC::cancelmessageid(uint4 id)
 {
-	uint2 i;
-	for (i = 0 ; i < nmessages ; i++)
-		if (messages[i].id == id)
-		{
-			cancelmessageindex(i, True);
-			return;
-		}
+	uint4 t_index;
+	if (!messages . findid(id, t_index))
+		return;
+
+	MCMessageList t_message;
+	messages . remove(t_index, t_message);
+	MCMessageListFree(t_message);
 }
 
 void MCUIDC::cancelmessageobject(MCObject *optr, MCNameRef mptr)
 {
-	uint2 i;
-	for (i = 0 ; i < nmessages ; i++)
-		if (messages[i].object == optr
-		        && (mptr == NULL || MCNameIsEqualTo(messages[i].message, mptr, kMCCompareCaseless)))
-			cancelmessageindex(i--, True);
+	messages . cancelobject(optr, mptr);
+	timers . cancelobject(optr, mptr);
+}
+
+static int compare_message_sequence(const void *a, const void *b)
+{
+	const MCMessageList *t_left = *(const MCMessageList **)a;
+	const MCMessageList *t_right = *(const MCMessageList **)b;
+	return (int4)(t_left -> sequence - t_right -> sequence);
 }
 
 void MCUIDC::listmessages(MCExecPoint &ep)
 {
-	uint2 i;
+	ep.clear();
+
+	uint4 t_count;
+	t_count = messages . getcount();
+	if (t_count == 0)
+		return;
+
+	// The heap is not kept in posting order, so sort the messages back into it
+	// before listing them.
+	MCMessageList **t_list;
+	t_list = new MCMessageList *[t_count];
+	for(uint4 i = 0; i < t_count; i++)
+		t_list[i] = &messages . get(i);
+	qsort(t_list, t_count, sizeof(MCMessageList *), compare_message_sequence);
+
 	MCExecPoint ep1(ep);
 	bool first;
 	first = true;
-	ep.clear();
-	for (i = 0 ; i < nmessages ; i++)
+	for(uint4 i = 0; i < t_count; i++)
 	{
-		if (messages[i].id != 0)
-		{
-			ep.concatuint(messages[i].id, EC_RETURN, first);
-			ep.concatreal(messages[i].time, EC_COMMA, false);
-			ep.concatnameref(messages[i].message, EC_COMMA, false);
-			messages[i].object->getprop(0, P_LONG_ID, ep1, false);
-			ep.concatmcstring(ep1.getsvalue(), EC_COMMA, false);
-			first = false;
-		}
+		ep.concatuint(t_list[i]->id, EC_RETURN, first);
+		ep.concatreal(t_list[i]->time, EC_COMMA, false);
+		ep.concatnameref(t_list[i]->message, EC_COMMA, false);
+		t_list[i]->object->getprop(0, P_LONG_ID, ep1, false);
+		ep.concatmcstring(ep1.getsvalue(), EC_COMMA, false);
+		first = false;
 	}
+
+	delete[] t_list;
 }
 
 Boolean MCUIDC::handlepending(real8 &curtime, real8 &eventtime,
                               Boolean dispatch)
 {
 	Boolean doneone = False;
-	uint2 mdone = 0;
-	while (nmessages > mdone)
+	uint4 mdone = 0;
+	while (messages . getcount() + timers . getcount() > mdone)
 	{
-		int2 minindex = -1;
-		uint2 i;
-		for (i = 0 ; i < nmessages ; i++)
-			if ((dispatch || messages[i].id == 0)
-			        && (minindex == -1 || messages[i].time < messages[minindex].time))
-				minindex = i;
-		if (minindex == -1)
+		MCMessageHeap *t_heap;
+		if (!nextmessage(dispatch, t_heap))
 			break;
-		if (curtime < messages[minindex].time)
+		MCMessageList& t_next = t_heap -> get(0);
+		if (curtime < t_next.time)
 		{
-			if (eventtime > messages[minindex].time
-			        && (dispatch || messages[minindex].id == 0))
-				eventtime = messages[minindex].time;
+			if (eventtime > t_next.time)
+				eventtime = t_next.time;
 			break;
 		}
-		if (dispatch || messages[minindex].id == 0)
+		mdone++;
+		if (!dispatch && MCNameIsEqualTo(t_next.message, MCM_idle, kMCCompareCaseless))
 		{
-			mdone++;
-			if (!dispatch && MCNameIsEqualTo(messages[minindex].message, MCM_idle, kMCCompareCaseless))
-				messages[minindex].time = curtime + ((real8)MCidleRate / 1000.0);
-			else
+			t_next.time = curtime + ((real8)MCidleRate / 1000.0);
+			t_heap -> update(0);
+		}
+		else
+		{
+			doneone = True;
+			MCMessageList t_message;
+			t_heap -> remove(0, t_message);
+			MCParameter *p = t_message.params;
+			MCNameRef m = t_message.message;
+			MCObject *o = t_message.object;
+			MCSaveprops sp;
+			MCU_saveprops(sp);
+			MCU_resetprops(False);
+			o->timer(m, p);
+			MCU_restoreprops(sp);
+			while (p != NULL)
 			{
-				doneone = True;
-				MCParameter *p = messages[minindex].params;
-				MCNameRef m = messages[minindex].message;
-				MCObject *o = messages[minindex].object;
-				cancelmessageindex(minindex, False);
-				MCSaveprops sp;
-				MCU_saveprops(sp);
-				MCU_resetprops(False);
-				o->timer(m, p);
-				MCU_restoreprops(sp);
-				while (p != NULL)
-				{
-					MCParameter *tmp = p;
-					p = p->getnext();
-					delete tmp;
-				}
-				MCNameDelete(m);
-				curtime = MCS_time();
+				MCParameter *tmp = p;
+				p = p->getnext();
+				delete tmp;
 			}
+			MCNameDelete(m);
+			curtime = MCS_time();
 		}
 	}
 	if (moving != NULL)
@@ -949,9 +1318,10 @@ Boolean MCUIDC::handlepending(real8 &curtime, real8 &eventtime,
 	//   time of the next message to process in the queue.
 	if (doneone)
 	{
-		for(uint32_t i = 0; i < nmessages; i++)
-			if (eventtime > messages[i] . time)
-				eventtime = messages[i] . time;
+		if (messages . getcount() != 0 && eventtime > messages . get(0) . time)
+			eventtime = messages . get(0) . time;
+		if (timers . getcount() != 0 && eventtime > timers . get(0) . time)
+			eventtime = timers . get(0) . time;
 	}
 	return doneone;
 }
@@ -106,9 +106,89 @@ typedef struct
 	real8 time;
 	MCParameter *params;
 	uint4 id;
+	// The order the message was posted in. This breaks ties between messages
+	// due at the same time and orders the pendingMessages.
+	uint4 sequence;
 }
 MCMessageList;
 
+// A binary min-heap of pending messages ordered by time. Messages with a
+// non-zero id are indexed by id, and the number of messages each object has
+// is kept, so that messages can be cancelled without scanning the heap.
+class MCMessageHeap
+{
+public:
+	MCMessageHeap(void);
+	~MCMessageHeap(void);
+
+	uint4 getcount(void) const
+	{
+		return m_count;
+	}
+
+	// The message at the given position, position 0 being the next due.
+	MCMessageList& get(uint4 p_index)
+	{
+		return m_messages[p_index];
+	}
+
+	void push(const MCMessageList& p_message);
+
+	// Remove the message at the given position, returning it in r_message.
+	void remove(uint4 p_index, MCMessageList& r_message);
+
+	// Restore heap order after the time of the message at the given position
+	// has changed.
+	void update(uint4 p_index);
+
+	bool findid(uint4 p_id, uint4& r_index);
+
+	bool hasobject(MCObject *p_object);
+
+	// Find a message for the given object with the given name.
+	bool findobject(MCObject *p_object, MCNameRef p_name, uint4& r_index);
+
+	// Remove (and free) all the messages for the given object, or just those
+	// with the given name if it is not nil.
+	void cancelobject(MCObject *p_object, MCNameRef p_name);
+
+private:
+	struct IdSlot
+	{
+		uint4 id;
+		uint4 position;
+	};
+
+	struct ObjectSlot
+	{
+		MCObject *object;
+		uint4 count;
+	};
+
+	bool before(uint4 a, uint4 b);
+	void place(uint4 p_index, const MCMessageList& p_message);
+	void siftup(uint4 p_index);
+	void siftdown(uint4 p_index);
+	void grow(void);
+	void rebuild(void);
+
+	void idinsert(uint4 p_id, uint4 p_position);
+	uint4 idfind(uint4 p_id);
+	void idremove(uint4 p_id);
+	void objectadd(MCObject *p_object);
+	void objectremove(MCObject *p_object);
+
+	MCMessageList *m_messages;
+	uint4 m_count;
+	uint4 m_capacity;
+
+	// Both indices are open-addressed with linear probing, with a size that
+	// is a power of two at least twice the capacity of the heap.
+	IdSlot *m_ids;
+	ObjectSlot *m_objects;
+	uint4 m_index_size;
+};
+
 struct MCDisplay
 {
 	uint4 index;
@@ -233,11 +313,14 @@ enum MCPlatformFeature
 class MCUIDC
 {
 protected:
-	MCMessageList *messages;
+	// Messages posted by send and by the engine, and internal timers (which
+	// have an id of 0) are kept in separate heaps, as timers are also run
+	// when other messages are not being dispatched.
+	MCMessageHeap messages;
+	MCMessageHeap timers;
 	MCMovingList *moving;
 	uint4 messageid;
-	uint2 nmessages;
-	uint2 maxmessages;
+	uint4 messagesequence;
 	MCColor *colors;
 	char **colornames;
 	int2 *allocs;
@@ -525,7 +608,7 @@ public:
 	//
 
 	void addtimer(MCObject *optr, MCNameRef name, uint4 delay);
-	void cancelmessageindex(uint2 i, Boolean dodelete);
+	bool nextmessage(Boolean dispatch, MCMessageHeap*& r_heap);
 	void cancelmessageid(uint4 id);
 	void cancelmessageobject(MCObject *optr, MCNameRef name);
 	void listmessages(MCExecPoint &ep);
@@ -554,7 +637,7 @@ public:
 	void setpixel(MCBitmap *image, int2 x, int2 y, uint4 pixel);
 	Boolean hasmessages()
 	{
-		return nmessages != 0;
+		return messages . getcount() != 0 || timers . getcount() != 0;
 	}
 	void closemodal()
 	{
@@ -17,6 +17,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "prefix.h"
 
 #include "core.h"
+#include "thread.h"
 #include "globdefs.h"
 #include "filedefs.h"
 #include "objdefs.h"
@@ -770,6 +771,66 @@ void MCU_upper(char *dptr, const MCString &s)
 		*dptr++ = MCS_toupper(*sptr++);
 }
 
+// Needles at least this long are searched for with a Horspool skip table,
+// shorter ones by scanning for their first byte (with memchr when case
+// sensitive).
+#define OFFSET_SKIP_THRESHOLD 8
+
+// Needles up to this long are folded into a buffer on the stack.
+#define OFFSET_FOLD_BUFFER 256
+
+static bool MCU_offset_horspool(const uint1 *p_part, uint4 p_part_length, const uint1 *p_whole, uint4 p_whole_length, bool p_fold, uint4& r_offset)
+{
+	// The skip table holds, for each byte, how far the window can move when
+	// that byte is the last in the window. Callers often search the same
+	// text repeatedly (as replace does), so the table is bytes to keep it
+	// cheap to build - a skip shorter than the ideal is always safe.
+	uint1 t_skip[256];
+	memset(t_skip, MCU_min(p_part_length, 255U), sizeof(t_skip));
+	for(uint4 i = 0; i < p_part_length - 1; i++)
+		t_skip[p_part[i]] = MCU_min(p_part_length - 1 - i, 255U);
+
+	uint1 t_last;
+	t_last = p_part[p_part_length - 1];
+
+	// When folding, the needle is already lower case, so each byte of the
+	// haystack is folded before it is compared or used to skip.
+	uint4 t_limit;
+	t_limit = p_whole_length - p_part_length;
+	for(uint4 i = 0; i <= t_limit; )
+	{
+		uint1 t_char;
+		t_char = p_whole[i + p_part_length - 1];
+		if (p_fold)
+			t_char = MCS_tolower(t_char);
+		if (t_char == t_last)
+		{
+			bool t_match;
+			if (p_fold)
+			{
+				t_match = true;
+				for(uint4 j = 0; j < p_part_length - 1; j++)
+					if (MCS_tolower(p_whole[i + j]) != p_part[j])
+					{
+						t_match = false;
+						break;
+					}
+			}
+			else
+				t_match = memcmp(p_whole + i, p_part, p_part_length - 1) == 0;
+
+			if (t_match)
+			{
+				r_offset = i;
+				return true;
+			}
+		}
+		i += t_skip[t_char];
+	}
+
+	return false;
+}
+
 Boolean MCU_offset(const MCString &part, const MCString &whole,
                    uint4 &offset, Boolean casesensitive)
 {
@@ -780,54 +841,70 @@ Boolean MCU_offset(const MCString &part, const MCString &whole,
 	if (tl > sl || tl == 0 || sl == 0)
 		return False;
 	uint4 length = sl - tl;
-	uint4 i;
 	const uint1 *pptr = (uint1 *)part.getstring();
 	const uint1 *wptr = (uint1 *)whole.getstring();
 	if (casesensitive)
-		for (i = 0 ; i <= length ; i++)
+	{
+		if (tl >= OFFSET_SKIP_THRESHOLD)
+			return MCU_offset_horspool(pptr, tl, wptr, sl, false, offset);
+
+		// Let memchr (which is vectorized by the C library) find each
+		// candidate first byte, then check the rest of the needle.
+		const uint1 *sptr = wptr;
+		const uint1 *eptr = wptr + length + 1;
+		while (sptr < eptr)
 		{
-			const uint1 *sptr = pptr;
-			const uint1 *dptr = wptr + i;
-			if (*sptr != *dptr)
-				continue;
-			int4 diff = 0;
-			uint4 n = tl;
-			while (n--)
-				if (*dptr++ != *sptr++)
-				{
-					diff = 1;
-					break;
-				}
-			if (diff == 0)
+			sptr = (const uint1 *)memchr(sptr, *pptr, eptr - sptr);
+			if (sptr == NULL)
+				break;
+			if (memcmp(sptr + 1, pptr + 1, tl - 1) == 0)
 			{
-				offset = i;
+				offset = sptr - wptr;
 				return True;
 			}
+			sptr++;
 		}
-	else
-		for (i = 0 ; i <= length ; i++)
-		{
-			int4 diff = 0;
-
-			char t_p, t_w;
-			t_p = *pptr;
-			t_w = *(wptr + i);
-
-			t_p = MCS_tolower(t_p);
-			t_w = MCS_tolower(t_w);
+		return False;
+	}
 
-			if (t_p != t_w)
-				continue;
-			else
-				diff = MCU_strncasecmp((char *)pptr, (char *)wptr + i, tl);
+	// Bytes compare equal without case if they lower-case to the same byte,
+	// so fold the needle once up front and the haystack as it is scanned.
+	uint1 t_buffer[OFFSET_FOLD_BUFFER];
+	uint1 *t_folded;
+	if (tl <= OFFSET_FOLD_BUFFER)
+		t_folded = t_buffer;
+	else
+		t_folded = new uint1[tl];
+	for (uint4 i = 0 ; i < tl ; i++)
+		t_folded[i] = MCS_tolower(pptr[i]);
 
-			if (diff == 0)
+	bool t_found;
+	if (tl >= OFFSET_SKIP_THRESHOLD)
+		t_found = MCU_offset_horspool(t_folded, tl, wptr, sl, true, offset);
+	else
+	{
+		// Short needles skip too little to repay building the table.
+		t_found = false;
+		for (uint4 i = 0 ; i <= length ; i++)
+			if (MCS_tolower(wptr[i]) == t_folded[0])
 			{
-				offset = i;
-				return True;
+				uint4 j;
+				for (j = 1 ; j < tl ; j++)
+					if (MCS_tolower(wptr[i + j]) != t_folded[j])
+						break;
+				if (j == tl)
+				{
+					offset = i;
+					t_found = true;
+					break;
+				}
 			}
-		}
-	return False;
+	}
+
+	if (t_folded != t_buffer)
+		delete[] t_folded;
+
+	return t_found;
 }
 
 void MCU_chunk_offset(MCExecPoint &ep, MCString &w,
@@ -1020,6 +1097,62 @@ void MCU_break_string(const MCString &s, MCString *&ptrs, uint2 &nptrs,
 extern compare_t MCSystemCompareInternational(const char *, const char *);
 #endif
 
+// Return whether the node 'a' should be placed before the node 'b'. As 'a' is
+// always the node from the earlier run, equal nodes keep their order.
+static inline Boolean msortfirst(const MCSortnode *a, const MCSortnode *b, Sort_type form, Boolean reverse)
+{
+	if (reverse)
+		switch (form)
+		{
+		case ST_INTERNATIONAL:
+#if defined(_MAC_DESKTOP) || defined(_IOS_MOBILE)
+			return MCSystemCompareInternational(a->svalue, b->svalue) >= 0;
+#else
+			return strcoll(a->svalue, b->svalue) >= 0;
+#endif
+		case ST_TEXT:
+			return strcmp(a->svalue, b->svalue) >= 0;
+		default:
+			return a->nvalue >= b->nvalue;
+		}
+	else
+		switch (form)
+		{
+		case ST_INTERNATIONAL:
+#if defined(_MAC_DESKTOP) || defined(_IOS_MOBILE)
+			return MCSystemCompareInternational(a->svalue, b->svalue) <= 0;
+#else
+			return strcoll(a->svalue, b->svalue) <= 0;
+#endif
+		case ST_TEXT:
+			return strcmp(a->svalue, b->svalue) <= 0;
+		default:
+			return a->nvalue <= b->nvalue;
+		}
+}
+
+// Merge the sorted runs b1 and b2 into t.
+static void msortmerge(const MCSortnode *b1, uint4 n1, const MCSortnode *b2, uint4 n2, MCSortnode *t, Sort_type form, Boolean reverse)
+{
+	while (n1 > 0 && n2 > 0)
+	{
+		if (msortfirst(b1, b2, form, reverse))
+		{
+			*t++ = *b1++;
+			n1--;
+		}
+		else
+		{
+			*t++ = *b2++;
+			n2--;
+		}
+	}
+	if (n1 > 0)
+		memcpy(t, b1, n1 * sizeof(MCSortnode));
+	if (n2 > 0)
+		memcpy(t, b2, n2 * sizeof(MCSortnode));
+}
+
 static void msort(MCSortnode *b, uint4 n, MCSortnode *t, Sort_type form, Boolean reverse)
 {
 	if (n <= 1)
@@ -1033,45 +1166,12 @@ static void msort(MCSortnode *b, uint4 n, MCSortnode *t, Sort_type form, Boolean
 	msort(b1, n1, t, form, reverse);
 	msort(b2, n2, t, form, reverse);
 
+	// The second run is already in place, so only the nodes merged before it
+	// is exhausted need copying back.
 	MCSortnode *tmp = t;
 	while (n1 > 0 && n2 > 0)
 	{
-		Boolean first;
-		if (reverse)
-			switch (form)
-			{
-			case ST_INTERNATIONAL:
-#if defined(_MAC_DESKTOP) || defined(_IOS_MOBILE)
-				first = MCSystemCompareInternational(b1->svalue, b2->svalue) >= 0;
-#else
-				first = strcoll(b1->svalue, b2->svalue) >= 0;
-#endif
-				break;
-			case ST_TEXT:
-				first = strcmp(b1->svalue, b2->svalue) >= 0;
-				break;
-			default:
-				first = b1->nvalue >= b2->nvalue;
-				break;
-			}
-		else
-			switch (form)
-			{
-			case ST_INTERNATIONAL:
-#if defined(_MAC_DESKTOP) || defined(_IOS_MOBILE)
-				first = MCSystemCompareInternational(b1->svalue, b2->svalue) <= 0;
-#else
-				first = strcoll(b1->svalue, b2->svalue) <= 0;
-#endif
-				break;
-			case ST_TEXT:
-				first = strcmp(b1->svalue, b2->svalue) <= 0;
-				break;
-			default:
-				first = b1->nvalue <= b2->nvalue;
-				break;
-			}
-		if (first)
+		if (msortfirst(b1, b2, form, reverse))
 		{
 			*tmp++ = *b1++;
 			n1--;
@@ -1087,13 +1187,259 @@ static void msort(MCSortnode *b, uint4 n, MCSortnode *t, Sort_type form, Boolean
 	memcpy(b, t, (n - n2) * sizeof(MCSortnode));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Lists shorter than this are sorted on the calling thread.
+#define PARALLEL_SORT_THRESHOLD 16384
+
+// Lists shorter than this are sorted numerically by merging rather than by
+// radix.
+#define RADIX_SORT_THRESHOLD 256
+
+struct MCSortContext
+{
+	MCSortnode *items;
+	MCSortnode *temp;
+	uint4 nitems;
+	uint4 width;
+	Sort_type form;
+	Boolean reverse;
+	const MCSortnode *source;
+	MCSortnode *target;
+};
+
+// Sort the index'th run of 'width' items in place.
+static void MCU_sortrun(void *p_context, uindex_t p_index)
+{
+	MCSortContext *t_context;
+	t_context = (MCSortContext *)p_context;
+
+	uint4 t_start, t_count;
+	t_start = p_index * t_context -> width;
+	t_count = MCU_min(t_context -> width, t_context -> nitems - t_start);
+	msort(t_context -> items + t_start, t_count, t_context -> temp + t_start, t_context -> form, t_context -> reverse);
+}
+
+// Merge the index'th pair of runs of 'width' items from source into target.
+static void MCU_sortmerge(void *p_context, uindex_t p_index)
+{
+	MCSortContext *t_context;
+	t_context = (MCSortContext *)p_context;
+
+	uint4 t_start, t_middle, t_end;
+	t_start = p_index * 2 * t_context -> width;
+	t_middle = MCU_min(t_start + t_context -> width, t_context -> nitems);
+	t_end = MCU_min(t_middle + t_context -> width, t_context -> nitems);
+	msortmerge(t_context -> source + t_start, t_middle - t_start, t_context -> source + t_middle, t_end - t_middle, t_context -> target + t_start, t_context -> form, t_context -> reverse);
+}
+
+// Sort the items as a number of runs, one per thread, then merge the runs in
+// pairs until only one is left.
+static void MCU_parallelsort(MCSortnode *items, uint4 nitems, MCSortnode *tmp, Sort_type form, Boolean reverse)
+{
+	uint4 t_concurrency;
+	t_concurrency = MCThreadPoolGetConcurrency();
+	if (nitems < PARALLEL_SORT_THRESHOLD || t_concurrency <= 1)
+	{
+		msort(items, nitems, tmp, form, reverse);
+		return;
+	}
+
+	MCSortContext t_context;
+	t_context . items = items;
+	t_context . temp = tmp;
+	t_context . nitems = nitems;
+	t_context . width = (nitems + t_concurrency - 1) / t_concurrency;
+	t_context . form = form;
+	t_context . reverse = reverse;
+	MCThreadPoolRun((nitems + t_context . width - 1) / t_context . width, MCU_sortrun, &t_context);
+
+	t_context . source = items;
+	t_context . target = tmp;
+	while (t_context . width < nitems)
+	{
+		MCThreadPoolRun((nitems + 2 * t_context . width - 1) / (2 * t_context . width), MCU_sortmerge, &t_context);
+
+		MCSortnode *t_merged;
+		t_merged = t_context . target;
+		t_context . target = (MCSortnode *)t_context . source;
+		t_context . source = t_merged;
+
+		if (t_context . width > nitems / 2)
+			break;
+		t_context . width *= 2;
+	}
+
+	if (t_context . source != items)
+		memcpy(items, t_context . source, nitems * sizeof(MCSortnode));
+}
+
+// Map a number to an unsigned key which orders the same way.
+static inline uint64_t MCU_sortkey(real8 p_value)
+{
+	// Make sure -0 and 0 compare equal.
+	if (p_value == 0.0)
+		p_value = 0.0;
+
+	uint64_t t_bits;
+	memcpy(&t_bits, &p_value, sizeof(uint64_t));
+	if ((t_bits & 0x8000000000000000ULL) != 0)
+		return ~t_bits;
+	return t_bits | 0x8000000000000000ULL;
+}
+
+// Sort by numeric value with a least-significant-digit radix sort on the keys
+// of the numbers, which is stable. Digits that are the same across all keys
+// are skipped, which for most lists of numbers includes the top ones.
+static void MCU_radixsort(MCSortnode *items, uint4 nitems, MCSortnode *tmp, Boolean reverse)
+{
+	struct key_t
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	key_t *t_keys;
+	t_keys = new key_t[nitems * 2];
+	key_t *t_other;
+	t_other = t_keys + nitems;
+
+	uint4 (*t_counts)[2048];
+	t_counts = new uint4[6][2048];
+	memset(t_counts, 0, 6 * 2048 * sizeof(uint4));
+
+	for(uint4 i = 0; i < nitems; i++)
+	{
+		uint64_t t_key;
+		t_key = MCU_sortkey(items[i] . nvalue);
+		if (reverse)
+			t_key = ~t_key;
+		t_keys[i] . key = t_key;
+		t_keys[i] . index = i;
+		for(uint4 d = 0; d < 6; d++)
+			t_counts[d][(t_key >> (d * 11)) & 2047]++;
+	}
+
+	for(uint4 d = 0; d < 6; d++)
+	{
+		uint4 *t_count;
+		t_count = t_counts[d];
+		if (t_count[(t_keys[0] . key >> (d * 11)) & 2047] == nitems)
+			continue;
+
+		uint4 t_offset;
+		t_offset = 0;
+		for(uint4 i = 0; i < 2048; i++)
+		{
+			uint4 t_size;
+			t_size = t_count[i];
+			t_count[i] = t_offset;
+			t_offset += t_size;
+		}
+
+		for(uint4 i = 0; i < nitems; i++)
+			t_other[t_count[(t_keys[i] . key >> (d * 11)) & 2047]++] = t_keys[i];
+
+		key_t *t_swap;
+		t_swap = t_keys;
+		t_keys = t_other;
+		t_other = t_swap;
+	}
+
+	for(uint4 i = 0; i < nitems; i++)
+		tmp[i] = items[t_keys[i] . index];
+	memcpy(items, tmp, nitems * sizeof(MCSortnode));
+
+	delete[] (t_keys < t_other ? t_keys : t_other);
+	delete[] t_counts;
+}
+
+#if !defined(_MAC_DESKTOP) && !defined(_IOS_MOBILE)
+struct MCSortCollateContext
+{
+	const MCSortnode *items;
+	MCSortnode *keys;
+	uint4 nitems;
+	uint4 width;
+};
+
+// Compute the collation keys of the index'th run of 'width' items. Each key
+// node points back at the item it was computed from.
+static void MCU_sortcollate(void *p_context, uindex_t p_index)
+{
+	MCSortCollateContext *t_context;
+	t_context = (MCSortCollateContext *)p_context;
+
+	uint4 t_start, t_end;
+	t_start = p_index * t_context -> width;
+	t_end = MCU_min(t_start + t_context -> width, t_context -> nitems);
+	for(uint4 i = t_start; i < t_end; i++)
+	{
+		size_t t_length;
+		t_length = strxfrm(NULL, t_context -> items[i] . svalue, 0);
+
+		char *t_key;
+		t_key = new char[t_length + 1];
+		strxfrm(t_key, t_context -> items[i] . svalue, t_length + 1);
+
+		t_context -> keys[i] . svalue = t_key;
+		t_context -> keys[i] . data = &t_context -> items[i];
+	}
+}
+
+// Comparing with strcoll transforms both strings on every comparison, so
+// instead transform each string once into its collation key and sort the
+// keys with strcmp, which orders them the same way.
+static void MCU_collatesort(MCSortnode *items, uint4 nitems, MCSortnode *tmp, Boolean reverse)
+{
+	MCSortnode *t_keys;
+	t_keys = new MCSortnode[nitems];
+
+	MCSortCollateContext t_context;
+	t_context . items = items;
+	t_context . keys = t_keys;
+	t_context . nitems = nitems;
+	t_context . width = MCU_max(1024U, (nitems + MCThreadPoolGetConcurrency() - 1) / MCThreadPoolGetConcurrency());
+	MCThreadPoolRun((nitems + t_context . width - 1) / t_context . width, MCU_sortcollate, &t_context);
+
+	MCU_parallelsort(t_keys, nitems, tmp, ST_TEXT, reverse);
+
+	for(uint4 i = 0; i < nitems; i++)
+	{
+		tmp[i] = *(const MCSortnode *)t_keys[i] . data;
+		delete[] t_keys[i] . svalue;
+	}
+	memcpy(items, tmp, nitems * sizeof(MCSortnode));
+
+	delete[] t_keys;
+}
+#endif
+
 void MCU_sort(MCSortnode *items, uint4 nitems,
               Sort_type dir, Sort_type form)
 {
 	if (nitems <= 1)
 		return;
 	MCSortnode *tmp = new MCSortnode[nitems];
-	msort(items, nitems, tmp, form, dir == ST_DESCENDING);
+	switch (form)
+	{
+	case ST_TEXT:
+		MCU_parallelsort(items, nitems, tmp, form, dir == ST_DESCENDING);
+		break;
+	case ST_INTERNATIONAL:
+#if defined(_MAC_DESKTOP) || defined(_IOS_MOBILE)
+		msort(items, nitems, tmp, form, dir == ST_DESCENDING);
+#else
+		MCU_collatesort(items, nitems, tmp, dir == ST_DESCENDING);
+#endif
+		break;
+	default:
+		if (nitems < RADIX_SORT_THRESHOLD)
+			msort(items, nitems, tmp, form, dir == ST_DESCENDING);
+		else
+			MCU_radixsort(items, nitems, tmp, dir == ST_DESCENDING);
+		break;
+	}
 	delete tmp;
 }
 
@@ -2543,22 +2889,35 @@ bool MCU_disjointrangecontains(MCRange* p_ranges, int p_count, int p_element)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// The capacity of a fake write buffer is derived from its length. Small buffers
+// grow in 4K steps, larger ones double so that writing out a large amount of data
+// (such as a whole stack) doesn't keep reallocating.
+static uint4 MCU_fakewritecapacity(uint4 p_length)
+{
+	if (p_length <= 65536)
+		return (p_length + 4095) & ~4095;
+
+	if (p_length > 0x80000000U)
+		return (p_length + 65535) & ~65535;
+
+	uint4 t_capacity;
+	t_capacity = 65536;
+	while(t_capacity < p_length)
+		t_capacity <<= 1;
+
+	return t_capacity;
+}
+
 IO_stat MCU_dofakewrite(char*& x_buffer, uint4& x_length, const void *p_data, uint4 p_size, uint4 p_count)
 {
 	uint4 t_capacity;
-	if (x_length > 65536)
-		t_capacity = (x_length + 65535) & ~65535;
-	else
-		t_capacity = (x_length + 4095) & ~4095;
+	t_capacity = MCU_fakewritecapacity(x_length);
 
 	uint4 t_new_capacity;
 	t_new_capacity = x_length + p_size * p_count;
 	if (t_new_capacity > t_capacity)
 	{
-		if (t_new_capacity >= 65536)
-			t_new_capacity = (t_new_capacity + 65535) & ~65535;
-		else
-			t_new_capacity = (t_new_capacity + 4095) & ~4095;
+		t_new_capacity = MCU_fakewritecapacity(t_new_capacity);
 
 		char *t_new_buffer;
 		t_new_buffer = (char *)realloc(x_buffer, t_new_capacity);
@@ -125,6 +125,82 @@ MCVariable::~MCVariable(void)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The free list threads through the first word of each recycled block. It is
+// capped so that a deep recursion doesn't pin its peak usage forever.
+#define LOCAL_VARIABLE_POOL_LIMIT 1024
+
+static void *s_local_variable_pool = nil;
+static uint32_t s_local_variable_pool_size = 0;
+
+#ifdef _DEBUG
+#ifdef new
+#undef new
+#define redef_new
+#endif
+#endif
+
+bool MCVariable::createlocal(MCNameRef p_name, MCVariable*& r_var)
+{
+	void *t_block;
+	if (s_local_variable_pool != nil)
+	{
+		t_block = s_local_variable_pool;
+		s_local_variable_pool = *(void **)t_block;
+		s_local_variable_pool_size--;
+	}
+	else
+	{
+		t_block = new char[sizeof(MCVariable)];
+		if (t_block == nil)
+			return false;
+	}
+
+	MCVariable *self;
+	self = new(t_block) MCVariable;
+	self -> next = nil;
+	self -> name = nil;
+
+	self -> is_msg = false;
+	self -> is_env = false;
+	self -> is_global = false;
+	self -> is_deferred = false;
+	self -> is_uql = false;
+
+	if (!MCNameClone(p_name, self -> name))
+	{
+		destroylocal(self);
+		return false;
+	}
+
+	r_var = self;
+
+	return true;
+}
+
+#ifdef _DEBUG
+#ifdef redef_new
+#undef redef_new
+#define new new(__FILE__, __LINE__)
+#endif
+#endif
+
+void MCVariable::destroylocal(MCVariable *p_var)
+{
+	p_var -> ~MCVariable();
+
+	if (s_local_variable_pool_size == LOCAL_VARIABLE_POOL_LIMIT)
+	{
+		delete[] (char *)p_var;
+		return;
+	}
+
+	*(void **)p_var = s_local_variable_pool;
+	s_local_variable_pool = p_var;
+	s_local_variable_pool_size++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MCVariable::doclearuql(void)
 {
 	if (value . is_string() && value . get_string() . getstring() == MCNameGetOldString(name) . getstring())
@@ -687,6 +763,12 @@ Exec_stat MCDeferredVariable::compute(void)
 	return ES_NORMAL;
 }
 
+void MCDeferredVariable::reset(void)
+{
+	clear(True);
+	is_deferred = true;
+}
+
 Exec_stat MCDeferredVarref::eval(MCExecPoint& ep)
 {
 	Exec_stat t_stat;
@@ -23,7 +23,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #define VAR_PAD 16
 #define VAR_MASK 0xFFFFFFF0
-#define VAR_APPEND_MAX (MAXUINT2 * 4)
+// Appending grows a string's buffer by 1/VAR_APPEND_GROWTH of its new size.
+#define VAR_APPEND_GROWTH 2
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -50,20 +51,35 @@ arrayextent;
 
 struct MCHashentry;
 
+// The hash table of an MCVariableArray is open-addressed (using linear probing)
+// and each slot holds the hash of the key of its entry as well as the entry, so
+// that probing rarely needs to touch the entries themselves. The entries are
+// allocated individually so that pointers to them remain valid as the table
+// grows.
+struct MCHashslot
+{
+	uint32_t hash;
+	MCHashentry *entry;
+};
+
 class MCVariableArray
 {
-	MCHashentry **table;
+	MCHashslot *table;
 	uint32_t tablesize;
 	uint32_t nfilled;
+	uint32_t ndeleted;
 	uint32_t keysize;
 	uint8_t dimensions;
 	arrayextent *extents;
 
 public:
-	// Initialize the hash to the given size
+	// Initialize the hash with room for the given number of keys
 	void presethash(uint4 p_size);
 
-	// Increase the size of the hash to the next power of two
+	// Rehash the table into one of at least the given size (rounded up to a
+	// power of two with room for the current number of keys). The table never
+	// shrinks, and if p_new_size is zero it grows only if the number of keys
+	// requires it.
 	void resizehash(uint32_t p_new_size = 0);
 
 	// Free the array's memory
@@ -149,12 +165,13 @@ public:
 	// PRECONDITION: this is initialized
 	MCHashentry *getnextelement(uint4 &l, MCHashentry *e, Boolean donumeric, MCExecPoint &ep);
 
-	// Iterate over the keys in the array
+	// Iterate over the keys in the array. Here 'l' is the index of the next
+	// slot to examine, and should be zero to start the iteration.
 	// PRECONDITION: this is initialized
 	MCHashentry *getnextkey(uint4& l, MCHashentry *e) const;
 
-	// Alternative form of iteration - uses the entry's hash element to compute
-	// the next entry.
+	// Alternative form of iteration - uses the entry's hash element to locate
+	// its slot and so compute the next entry.
 	// PRECONDITION: this is initialized
 	MCHashentry *getnextkey(MCHashentry *e) const;
 
@@ -211,6 +228,16 @@ private:
 	// Compute the hash value of the given string
 	uint4 computehash(const MCString &);
 
+	// Return the index of the slot containing the given entry, or tablesize if
+	// it isn't in the table
+	uint32_t findslot(MCHashentry *p_entry) const;
+
+	// Insert the given entry into an empty slot (the key must not be present)
+	void insertslot(MCHashentry *p_entry);
+
+	// Mark the slot with the given index as deleted and update the counts
+	void removeslot(uint32_t p_index);
+
 	// Update the extents on the array appropriately using the given key
 	void extentfromkey(char *skey);
 
@@ -260,6 +287,12 @@ inline uint32_t MCVariableArray::getnfilled(void) const
 //   - empty -> empty array
 //
 
+// The MCVariableChunkIndex struct caches the offsets of a delimiter char within
+// the string value of an MCVariableValue. It is built lazily (only as much of
+// the string is scanned as has been needed so far) and allows line and item
+// chunks of large values to be located without rescanning from the start.
+struct MCVariableChunkIndex;
+
 #define kMCEncodedValueTypeUndefined 1
 #define kMCEncodedValueTypeEmpty 2
 #define kMCEncodedValueTypeString 3
@@ -403,6 +436,20 @@ public:
 	// malformed.
 	//
 	bool decode(const MCString& p_value);
+
+	// Return the number of occurrences of p_delimiter in the string value
+	// before p_offset. The delimiter index is extended as required.
+	// PRECONDITION: this is a string
+	uint32_t count_delimiters(char p_delimiter, uint32_t p_offset);
+
+	// Fetch the offset of the (zero-based) p_index'th occurrence of p_delimiter
+	// in the string value. Returns false if there are not that many.
+	// PRECONDITION: this is a string
+	bool find_delimiter(char p_delimiter, uint32_t p_index, uint32_t& r_offset);
+
+	// Throw away any delimiter indices. This must be called if the string
+	// buffer is modified other than through the methods of this class.
+	void discard_delimiter_index(void);
 	
 	// If a variable's dbg-notify is set it means it will notify the (server)
 	// debugger when it is deleted and/or changed.
@@ -429,6 +476,9 @@ private:
 	Value_format get_type(void) const;
 	void set_type(Value_format new_type);
 
+	bool has_delimiter_index(void) const;
+	MCVariableChunkIndex *fetch_delimiter_index(char p_delimiter);
+
 	enum
 	{
 		// If this is true, then modifying this value will have no visible effect
@@ -443,6 +493,11 @@ private:
 		kDebugNotifyBit = 1 << 2,
 		kDebugChangedBit = 1 << 3,
 		kDebugMutatedBit = 1 << 4,
+
+		// If this is true, then the value has delimiter indices for its string
+		// value. These are held in a side table keyed by the value's address,
+		// as most values are never chunked.
+		kDelimiterIndexBit = 1 << 5,
 	};
 
 	uint8_t _type;
@@ -471,8 +526,9 @@ private:
 
 struct MCHashentry
 {
-	MCHashentry *next;
 	uint32_t hash;
+	// The length of the key - this avoids computing strlen on every probe.
+	uint32_t length;
 	MCVariableValue value;
 	char string[4];
 
@@ -493,24 +549,25 @@ struct MCHashentry
 };
 
 inline MCHashentry::MCHashentry(void)
-	: next(NULL)
+	: hash(0),
+	  length(0)
 {
 }
 
 inline MCHashentry::MCHashentry(const MCString& p_key, uint32_t p_hash)
-	: next(NULL),
-	  hash(p_hash)
+	: hash(p_hash)
 {
 	strncpy(string, p_key . getstring(), p_key . getlength());
 	string[p_key . getlength()] = '\0';
+	length = strlen(string);
 }
 
 inline MCHashentry::MCHashentry(const MCHashentry& e)
-	: next(NULL),
-	  hash(e . hash),
+	: hash(e . hash),
+	  length(e . length),
 	  value(e . value)
 {
-	strcpy(string, e . string);
+	memcpy(string, e . string, e . length + 1);
 }
 
 #ifdef _DEBUG
@@ -523,7 +580,7 @@ inline MCHashentry::MCHashentry(const MCHashentry& e)
 inline MCHashentry *MCHashentry::Clone(void) const
 {
 	void *t_new_entry;
-	t_new_entry = new char[sizeof(MCHashentry) + strlen(string) - 3];
+	t_new_entry = new char[sizeof(MCHashentry) + length - 3];
 	if (t_new_entry != NULL)
 		return new(t_new_entry) MCHashentry(*this);
 	return NULL;
@@ -755,6 +812,9 @@ public:
 	// Returns true if the var doesn't need synching.
 	bool isplain(void) { return !is_msg && !is_env; }
 
+	// Returns true if the var is an environment ('$') global.
+	bool isenv(void) { return is_env; }
+
 	// Returns a new MCVarref of the appropriate type for this var
 	MCVarref *newvarref(void);
 
@@ -775,6 +835,12 @@ public:
 	/* CAN FAIL */ static bool createwithname_cstring(const char *name, MCVariable*& r_var);
 
 	/* CAN FAIL */ static bool createcopy(MCVariable& other, MCVariable*& r_var);
+
+	// Handler parameters and locals are created and destroyed on every call,
+	// so their storage is recycled rather than returned to the heap. A
+	// variable created with 'createlocal' must be freed with 'destroylocal'.
+	/* CAN FAIL */ static bool createlocal(MCNameRef name, MCVariable*& r_var);
+	static void destroylocal(MCVariable *var);
 };
 
 //
@@ -957,6 +1023,11 @@ public:
 	static bool createwithname_cstring(const char *name, MCDeferredVariableComputeCallback callback, void *context, MCVariable*& r_var);
 
 	Exec_stat compute(void);
+
+	// Discard the variable's value and re-arm the callback so that the value
+	// is computed again on next access. This is used by the server engine when
+	// it serves more than one request in the same process.
+	void reset(void);
 };
 
 // A 'deferred' varref works identically to a normal varref except that it
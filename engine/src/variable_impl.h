@@ -309,10 +309,19 @@ inline void MCVariableValue::getkeys(char **r_keys, uint32_t p_count)
 
 //
 
+inline bool MCVariableValue::has_delimiter_index(void) const
+{
+	return (_flags & kDelimiterIndexBit) != 0;
+}
+
 inline void MCVariableValue::destroy(void)
 {
 	if (get_type() != VF_ARRAY)
+	{
 		free(strnum . buffer . data);
+		if (has_delimiter_index())
+			discard_delimiter_index();
+	}
 	else
 		array . freehash();
 }
@@ -41,12 +41,33 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "stacksecurity.h"
 
+// A slot which once held an entry but has since been removed is marked with
+// this value so that probing continues past it.
+#define HASH_DELETED ((MCHashentry *)1)
+
+// The maximum proportion of slots (filled or deleted) in a table is 3/4.
+#define HASH_LOAD_LIMIT(size) ((size) - ((size) >> 2))
+
+static inline bool MCHashslotIsFilled(const MCHashslot& p_slot)
+{
+	return p_slot . entry != NULL && p_slot . entry != HASH_DELETED;
+}
+
+static uint32_t MCVariableArrayComputeTableSize(uint32_t p_size, uint32_t p_count)
+{
+	uint32_t t_size;
+	t_size = TABLE_SIZE;
+	while(t_size < p_size || HASH_LOAD_LIMIT(t_size) <= p_count)
+		t_size <<= 1;
+	return t_size;
+}
+
 void MCVariableArray::presethash(uint4 size)
 {
-	tablesize = size;
-	table = new MCHashentry *[tablesize];
-	memset((char *)table, 0, tablesize * sizeof(MCHashentry *));
-	nfilled = keysize = 0;
+	tablesize = MCVariableArrayComputeTableSize(0, size);
+	table = new MCHashslot[tablesize];
+	memset((char *)table, 0, tablesize * sizeof(MCHashslot));
+	nfilled = ndeleted = keysize = 0;
 	dimensions = EXTENT_ALLOCEVAL;
 	extents = NULL;
 }
@@ -56,17 +77,9 @@ void MCVariableArray::freehash(void)
 	uint4 i;
 	if (table != NULL)
 		for (i = 0 ; i < tablesize ; i++)
-			if (table[i] != NULL)
-			{
-				MCHashentry *e = table[i];
-				while (e != NULL)
-				{
-					MCHashentry *next = e->next;
-					delete e;
-					e = next;
-				}
-			}
-	delete table;
+			if (MCHashslotIsFilled(table[i]))
+				delete table[i] . entry;
+	delete[] table;
 	if (extents != NULL)
 		delete extents;
 }
@@ -74,32 +87,95 @@ void MCVariableArray::freehash(void)
 void MCVariableArray::resizehash(uint32_t p_new_tablesize)
 {
 	uint4 oldsize = tablesize;
-
-	if (p_new_tablesize == 0)
-		tablesize <<= 1;
-	else
-		tablesize = p_new_tablesize;
-
-	MCHashentry **oldtable = table;
-	table = new MCHashentry *[tablesize];
-	memset((char *)table, 0, tablesize * sizeof(MCHashentry *));
+	MCHashslot *oldtable = table;
+
+	// The table never shrinks here, but a table which is full of deleted slots
+	// is rehashed at the same size.
+	if (p_new_tablesize < oldsize)
+		p_new_tablesize = oldsize;
+	tablesize = MCVariableArrayComputeTableSize(p_new_tablesize, nfilled);
+	table = new MCHashslot[tablesize];
+	memset((char *)table, 0, tablesize * sizeof(MCHashslot));
+	ndeleted = 0;
+
+	// Deleted slots are dropped as the entries are moved across, so the new
+	// table only contains filled and empty slots.
 	uint4 i;
 	for (i = 0 ; i < oldsize ; i++)
-	{
-		if (oldtable[i] != NULL)
+		if (MCHashslotIsFilled(oldtable[i]))
 		{
-			MCHashentry *e = oldtable[i];
-			while (e != NULL)
-			{
-				MCHashentry *next = e->next;
-				uint4 index = e->hash & tablesize - 1;
-				e->next = table[index];
-				table[index] = e;
-				e = next;
-			}
+			uint4 index = oldtable[i] . hash & (tablesize - 1);
+			while (table[index] . entry != NULL)
+				index = (index + 1) & (tablesize - 1);
+			table[index] = oldtable[i];
 		}
+	delete[] oldtable;
+}
+
+uint32_t MCVariableArray::findslot(MCHashentry *p_entry) const
+{
+	// The entry's probe sequence ends at the first empty slot, so if that is
+	// reached the entry isn't in the table (for example, if it was removed
+	// while the keys were being iterated).
+	uint4 index = p_entry -> hash & (tablesize - 1);
+	for(uint4 t_probes = 0; t_probes < tablesize; t_probes++)
+	{
+		if (table[index] . entry == p_entry)
+			return index;
+		if (table[index] . entry == NULL)
+			break;
+		index = (index + 1) & (tablesize - 1);
+	}
+	return tablesize;
+}
+
+void MCVariableArray::insertslot(MCHashentry *p_entry)
+{
+	if (nfilled + ndeleted + 1 > HASH_LOAD_LIMIT(tablesize))
+		resizehash();
+
+	uint4 index = p_entry -> hash & (tablesize - 1);
+	while (MCHashslotIsFilled(table[index]))
+		index = (index + 1) & (tablesize - 1);
+
+	if (table[index] . entry == HASH_DELETED)
+		ndeleted--;
+	table[index] . hash = p_entry -> hash;
+	table[index] . entry = p_entry;
+	nfilled++;
+}
+
+void MCVariableArray::removeslot(uint32_t p_index)
+{
+	MCHashentry *e = table[p_index] . entry;
+	keysize -= e -> length + 1;
+	nfilled--;
+
+	// If the next slot is empty then no probe sequence passes through this one
+	// so it can be made empty too, otherwise it must be marked as deleted.
+	if (table[(p_index + 1) & (tablesize - 1)] . entry == NULL)
+		table[p_index] . entry = NULL;
+	else
+	{
+		table[p_index] . entry = HASH_DELETED;
+		ndeleted++;
 	}
-	delete oldtable;
+
+	// Once the table is empty all the deleted markers can go.
+	if (nfilled == 0 && ndeleted != 0)
+	{
+		memset((char *)table, 0, tablesize * sizeof(MCHashslot));
+		ndeleted = 0;
+	}
+
+	delete extents;
+	extents = NULL;
+	if (nfilled == 0)
+		dimensions = EXTENT_ALLOCEVAL;
+	else
+		dimensions = EXTENT_RECALC;
+
+	delete e;
 }
 
 ////
@@ -108,6 +184,7 @@ void MCVariableArray::taketable(MCVariableArray *v)
 {
 	tablesize = v->tablesize;
 	nfilled = v->nfilled;
+	ndeleted = v->ndeleted;
 	keysize = v->keysize;
 	table = v->table;
 	v->table = NULL;
@@ -121,6 +198,7 @@ bool MCVariableArray::copytable(const MCVariableArray &v)
 {
 	tablesize = v.tablesize;
 	nfilled = v.nfilled;
+	ndeleted = 0;
 	keysize = v.keysize;
 	dimensions = v.dimensions;
 	if (v.extents != NULL)
@@ -132,26 +210,27 @@ bool MCVariableArray::copytable(const MCVariableArray &v)
 	}
 	else
 		extents = NULL;
-	table = new MCHashentry *[tablesize];
+	table = new MCHashslot[tablesize];
 	if (table == NULL)
 		goto no_memory;
-	memset((char *)table, 0, tablesize * sizeof(MCHashentry *));
+	memset((char *)table, 0, tablesize * sizeof(MCHashslot));
 	uint4 i;
 	for (i = 0 ; i < tablesize ; i++)
 	{
-		if (v.table[i] != NULL)
+		// Deleted slots in the source are copied as empty ones, so entries
+		// must be reinserted rather than copied to the same slot.
+		if (MCHashslotIsFilled(v.table[i]))
 		{
-			MCHashentry *e = v.table[i];
-			while (e != NULL)
-			{
-				MCHashentry *ne;
-				ne = e -> Clone();
-				if (ne == NULL)
-					goto no_memory;
-				ne->next = table[i];
-				table[i] = ne;
-				e = e->next;
-			}
+			MCHashentry *ne;
+			ne = v.table[i] . entry -> Clone();
+			if (ne == NULL)
+				goto no_memory;
+
+			uint4 index = ne -> hash & (tablesize - 1);
+			while (table[index] . entry != NULL)
+				index = (index + 1) & (tablesize - 1);
+			table[index] . hash = ne -> hash;
+			table[index] . entry = ne;
 		}
 	}
 	return true;
@@ -163,13 +242,24 @@ no_memory:
 
 ////
 
+// The hash is FNV-1a over the lowercased key followed by a final avalanche
+// step, so that all bits of the result are useful when masking by the table
+// size (keys such as "1".."n" differ only in a few low bits otherwise).
 uint4 MCVariableArray::computehash(const MCString &s)
 {
-	uint4 value = 0;
+	uint4 value = 2166136261U;
 	uint4 length = s.getlength();
 	const char *sptr = s.getstring();
 	while (length--)
-		value += (value << 3) + MCS_tolower(*sptr++);
+	{
+		value ^= (uint1)MCS_tolower(*sptr++);
+		value *= 16777619U;
+	}
+	value ^= value >> 16;
+	value *= 0x85ebca6bU;
+	value ^= value >> 13;
+	value *= 0xc2b2ae35U;
+	value ^= value >> 16;
 	return value;
 }
 
@@ -245,35 +335,29 @@ void MCVariableArray::extentfromkey(char *skey)
 MCHashentry *MCVariableArray::lookuphash(const MCString &s, Boolean cs, Boolean add)
 {
 	uint4 hash = computehash(s);
-	uint4 index = hash & tablesize - 1;
-	MCHashentry *e = table[index];
-	while (e != NULL)
+	uint4 length = s.getlength();
+	uint4 index = hash & (tablesize - 1);
+	while (table[index] . entry != NULL)
 	{
-		if (cs)
+		MCHashentry *e = table[index] . entry;
+		if (e != HASH_DELETED && table[index] . hash == hash && e -> length == length)
 		{
-			uint4 l = strlen(e->string);
-			if (hash == e->hash && s.getlength() == l
-			        && !strncmp(s.getstring(), e->string, l))
+			if (cs)
+			{
+				if (memcmp(s.getstring(), e->string, length) == 0)
+					return e;
+			}
+			else if (MCU_strncasecmp(s.getstring(), e->string, length) == 0)
 				return e;
 		}
-		else
-			if (hash == e->hash && s == e->string)
-				return e;
-		e = e->next;
+		index = (index + 1) & (tablesize - 1);
 	}
 	if (add)
 	{
-		if (nfilled++ > tablesize)
-		{
-			resizehash();
-			index = hash & tablesize - 1;
-		}
-		e = MCHashentry::Create(s, hash);
-		uint4 length = s.getlength();
+		MCHashentry *e = MCHashentry::Create(s, hash);
 		extentfromkey(e->string);
 		keysize += length + 1;
-		e->next = table[index];
-		table[index] = e;
+		insertslot(e);
 		return e;
 	}
 
@@ -282,72 +366,17 @@ MCHashentry *MCVariableArray::lookuphash(const MCString &s, Boolean cs, Boolean
 
 void MCVariableArray::removehash(const MCString& s, Boolean cs)
 {
-	uint4 hash = computehash(s);
-	uint4 index = hash & tablesize - 1;
-	MCHashentry *e = table[index];
-	MCHashentry *last = NULL;
-	Boolean match = False;
-	while (e != NULL)
-	{
-		if (cs)
-		{
-			uint4 l = strlen(e->string);
-			if (hash == e->hash && s.getlength() == l
-			        && !strncmp(s.getstring(), e->string, l))
-				match = True;
-		}
-		else
-			if (hash == e->hash && s == e->string)
-				match = True;
-		if (match)
-		{
-			if (last == NULL)
-				table[index] = e->next;
-			else
-				last->next = e->next;
-			delete e;
-			keysize -= s.getlength() + 1;
-			nfilled--;
-			delete extents;
-			extents = NULL;
-			if (nfilled == 0)
-				dimensions = EXTENT_ALLOCEVAL;
-			else
-				dimensions = EXTENT_RECALC;
-			return;
-		}
-		last = e;
-		e = e->next;
-	}
+	MCHashentry *e = lookuphash(s, cs, False);
+	if (e != NULL)
+		removeslot(findslot(e));
 }
 
 void MCVariableArray::removehash(MCHashentry *p_hash)
 {
-	uint4 index;
-	index = p_hash -> hash & (tablesize - 1);
-	
-	MCHashentry *last;
-	if (table[index] == p_hash)
-		last = NULL;
-	else
-		for(last = table[index]; last -> next != p_hash; last = last -> next)
-			;
-	
-	if (last == NULL)
-		table[index] = p_hash -> next;
-	else
-		last -> next = p_hash -> next;
-		
-	keysize -= strlen(p_hash -> string) + 1;
-	nfilled -= 1;
-	delete extents;
-	extents = NULL;
-	if (nfilled == 0)
-		dimensions = EXTENT_ALLOCEVAL;
-	else
-		dimensions = EXTENT_RECALC;
-	
-	delete p_hash;
+	uint32_t t_slot;
+	t_slot = findslot(p_hash);
+	if (t_slot < tablesize)
+		removeslot(t_slot);
 }
 
 void MCVariableArray::getextents(MCExecPoint &ep)
@@ -368,19 +397,9 @@ void MCVariableArray::getkeys(char **keylist, uint4 kcount)
 {
 	uint4 i;
 	uint4 count = 0;
-	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
-		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				keylist[count] = e->string;
-				e = e->next;
-				count++;
-				if (count == kcount)
-					break;
-			}
-		}
+	for (i = 0 ; i < tablesize && count < kcount ; i++)
+		if (MCHashslotIsFilled(table[i]))
+			keylist[count++] = table[i] . entry -> string;
 }
 
 void MCVariableArray::getkeys(MCExecPoint &ep)
@@ -390,17 +409,12 @@ void MCVariableArray::getkeys(MCExecPoint &ep)
 	char *dptr = startptr;
 	uint4 i;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				uint4 length = strlen(e->string);
-				memcpy(dptr, e->string, length);
-				dptr += length;
-				*dptr++ = '\n';
-				e = e->next;
-			}
+			MCHashentry *e = table[i] . entry;
+			memcpy(dptr, e->string, e->length);
+			dptr += e->length;
+			*dptr++ = '\n';
 		}
 	if (dptr != startptr)
 		dptr--;
@@ -433,17 +447,12 @@ Exec_stat MCVariableArray::dofunc(MCExecPoint& ep, Functions func, uint4 &nparam
 {
 	uint4 i;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				real64_t value;
-				if (!e -> value . get_as_real(ep, value))
-					return ES_ERROR;
-				MCU_dofunc(func, nparams, n, value, oldn, (MCSortnode *)titems);
-				e = e->next;
-			}
+			real64_t value;
+			if (!table[i] . entry -> value . get_as_real(ep, value))
+				return ES_ERROR;
+			MCU_dofunc(func, nparams, n, value, oldn, (MCSortnode *)titems);
 		}
 	return ES_NORMAL;
 }
@@ -456,136 +465,128 @@ Exec_stat MCVariableArray::factorarray(MCExecPoint &ep, Operators op)
 	{
 		MCVariableArray *v = ep.getarray() -> get_array();
 		for (i = 0 ; i < v->tablesize ; i++)
-			if (v->table[i] != NULL)
+			if (MCHashslotIsFilled(v->table[i]))
 			{
-				MCHashentry *e = v->table[i];
+				MCHashentry *e = v->table[i] . entry;
 				MCHashentry *de;
 				real64_t dst_value, src_value;
-				while (e != NULL)
+				if ((de = lookuphash(e->string, False, False)) == NULL ||
+				        !de -> value . get_as_real(ep, dst_value) || !e -> value . get_as_real(ep, src_value))
+					return ES_ERROR;
+				switch (op)
 				{
-					if ((de = lookuphash(e->string, False, False)) == NULL ||
-					        !de -> value . get_as_real(ep, dst_value) || !e -> value . get_as_real(ep, src_value))
-						return ES_ERROR;
-					switch (op)
+				case O_PLUS:
+					dst_value += src_value;
+					break;
+				case O_MINUS:
+					dst_value -= src_value;
+					break;
+				case O_TIMES:
+					dst_value *= src_value;
+					break;
+				case O_DIV:
+					dst_value /= src_value;
+					if (dst_value != MCinfinity && MCS_geterrno() == 0)
 					{
-					case O_PLUS:
-						dst_value += src_value;
-						break;
-					case O_MINUS:
-						dst_value -= src_value;
-						break;
-					case O_TIMES:
-						dst_value *= src_value;
-						break;
-					case O_DIV:
-						dst_value /= src_value;
+						if (dst_value < 0.0)
+							dst_value = ceil(dst_value);
+						else
+							dst_value = floor(dst_value);
+					}
+					break;
+				case O_MOD:
+					{
+						real8 n = dst_value;
+						dst_value = n/src_value;
 						if (dst_value != MCinfinity && MCS_geterrno() == 0)
-						{
-							if (dst_value < 0.0)
-								dst_value = ceil(dst_value);
-							else
-								dst_value = floor(dst_value);
-						}
-						break;
-					case O_MOD:
-						{
-							real8 n = dst_value;
-							dst_value = n/src_value;
-							if (dst_value != MCinfinity && MCS_geterrno() == 0)
-								dst_value = fmod(n, src_value);
-						}
-						break;
-					case O_WRAP:
-						{
-							real8 n = dst_value;
-							dst_value = n/src_value;
-							if (dst_value != MCinfinity && MCS_geterrno() == 0)
-								dst_value = MCU_fwrap(n, src_value);
-						}
-						break;
-					default:
-						dst_value /= src_value;
-						break;
+							dst_value = fmod(n, src_value);
 					}
-					if (src_value == MCinfinity || MCS_geterrno() != 0)
+					break;
+				case O_WRAP:
 					{
-						MCS_seterrno(0);
-						if (src_value == 0.0)
-							MCeerror->add(EE_DIVIDE_ZERO, 0, 0);
-						else
-							MCeerror->add(EE_MATRIX_RANGE, 0, 0);
-						return ES_ERROR;
+						real8 n = dst_value;
+						dst_value = n/src_value;
+						if (dst_value != MCinfinity && MCS_geterrno() == 0)
+							dst_value = MCU_fwrap(n, src_value);
 					}
-					de -> value . assign_real(dst_value);
-					e = e->next;
+					break;
+				default:
+					dst_value /= src_value;
+					break;
 				}
+				if (src_value == MCinfinity || MCS_geterrno() != 0)
+				{
+					MCS_seterrno(0);
+					if (src_value == 0.0)
+						MCeerror->add(EE_DIVIDE_ZERO, 0, 0);
+					else
+						MCeerror->add(EE_MATRIX_RANGE, 0, 0);
+					return ES_ERROR;
+				}
+				de -> value . assign_real(dst_value);
 			}
 	}
 	else
 	{
 		real8 tnum = ep.getnvalue();
 		for (i = 0 ; i < tablesize ; i++)
-			if (table[i] != NULL)
+			if (MCHashslotIsFilled(table[i]))
 			{
-				MCHashentry *e = table[i];
-				while (e != NULL)
+				MCHashentry *e = table[i] . entry;
+				real64_t value;
+				if (!e -> value . get_as_real(ep, value))
+					return ES_ERROR;
+				switch (op)
 				{
-					real64_t value;
-					if (!e -> value . get_as_real(ep, value))
-						return ES_ERROR;
-					switch (op)
+				case O_PLUS:
+					value += tnum;
+					break;
+				case O_MINUS:
+					value -= tnum;
+					break;
+				case O_TIMES:
+					value *= tnum;
+					break;
+				case O_DIV:
+					value /= tnum;
+					if (value != MCinfinity && MCS_geterrno() == 0)
 					{
-					case O_PLUS:
-						value += tnum;
-						break;
-					case O_MINUS:
-						value -= tnum;
-						break;
-					case O_TIMES:
-						value *= tnum;
-						break;
-					case O_DIV:
-						value /= tnum;
+						if (value < 0.0)
+							value = ceil(value);
+						else
+							value = floor(value);
+					}
+					break;
+				case O_MOD:
+					{
+						real8 n = value;
+						value = n / tnum;
 						if (value != MCinfinity && MCS_geterrno() == 0)
-						{
-							if (value < 0.0)
-								value = ceil(value);
-							else
-								value = floor(value);
-						}
-						break;
-					case O_MOD:
-						{
-							real8 n = value;
-							value = n / tnum;
-							if (value != MCinfinity && MCS_geterrno() == 0)
-								value = fmod(n, tnum);
-						}
-						break;					
-					case O_WRAP:
-						{
-							real8 n = value;
-							value = n / tnum;
-							if (value != MCinfinity && MCS_geterrno() == 0)
-								value = MCU_fwrap(n, tnum);
-						}
-						break;
-					default:
-						value /= tnum;
-						break;
+							value = fmod(n, tnum);
 					}
-					if (value == MCinfinity || MCS_geterrno() != 0)
+					break;					
+				case O_WRAP:
 					{
-						MCS_seterrno(0);
-						if (tnum == 0.0)
-							MCeerror->add(EE_DIVIDE_ZERO, 0, 0);
-						else
-							MCeerror->add(EE_MATRIX_RANGE, 0, 0);
-						return ES_ERROR;
+						real8 n = value;
+						value = n / tnum;
+						if (value != MCinfinity && MCS_geterrno() == 0)
+							value = MCU_fwrap(n, tnum);
 					}
-					e -> value . assign_real(value);
-					e = e->next;
+					break;
+				default:
+					value /= tnum;
+					break;
 				}
+				if (value == MCinfinity || MCS_geterrno() != 0)
+				{
+					MCS_seterrno(0);
+					if (tnum == 0.0)
+						MCeerror->add(EE_DIVIDE_ZERO, 0, 0);
+					else
+						MCeerror->add(EE_MATRIX_RANGE, 0, 0);
+					return ES_ERROR;
+				}
+				e -> value . assign_real(value);
 			}
 	}
 	return ES_NORMAL;
@@ -594,36 +595,10 @@ Exec_stat MCVariableArray::factorarray(MCExecPoint &ep, Operators op)
 Exec_stat MCVariableArray::intersectarray(MCVariableArray& v)
 {
 	uint4 i;
-	MCHashentry *last;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
-		{
-			last = NULL;
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				if (v.lookuphash(e->string, False, False) == NULL)
-				{
-					if (last == NULL)
-						table[i] = e->next;
-					else
-						last->next = e->next;
-					keysize -= strlen(e->string) + 1;
-					nfilled--;
-					MCHashentry *tmp = e->next;
-					delete e;
-					e = tmp;
-					delete extents;//clear extents
-					extents = NULL;
-					dimensions = nfilled == 0 ? EXTENT_ALLOCEVAL : EXTENT_RECALC;
-				}
-				else
-				{
-					last = e;
-					e = e->next;
-				}
-			}
-		}
+		if (MCHashslotIsFilled(table[i]) &&
+		        v.lookuphash(table[i] . entry -> string, False, False) == NULL)
+			removeslot(i);
 
 	return ES_NORMAL;
 }
@@ -632,17 +607,13 @@ Exec_stat MCVariableArray::unionarray(MCVariableArray& v)
 {
 	uint4 i;
 	for (i = 0 ; i < v.tablesize ; i++)
-		if (v.table[i] != NULL)
+		if (MCHashslotIsFilled(v.table[i]))
 		{
-			MCHashentry *e = v.table[i];
-			while (e != NULL)
+			MCHashentry *e = v.table[i] . entry;
+			if (lookuphash(e->string, False, False) == NULL)
 			{
-				if (lookuphash(e->string, False, False) == NULL)
-				{
-					MCHashentry *ne = lookuphash(e->string, False, True);
-					ne -> value . assign(e -> value);
-				}
-				e = e->next;
+				MCHashentry *ne = lookuphash(e->string, False, True);
+				ne -> value . assign(e -> value);
 			}
 		}
 	return ES_NORMAL;
@@ -655,14 +626,9 @@ void MCVariableArray::calcextents(void)
 	dimensions = EXTENT_ALLOCEVAL;
 	uint4 i;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				extentfromkey(e->string);
-				e = e->next;
-			}
+			extentfromkey(table[i] . entry -> string);
 			if (dimensions == EXTENT_NONNUM)
 				break;
 		}
@@ -756,15 +722,11 @@ MCHashentry *MCVariableArray::getnextelement(uint4 &l, MCHashentry *e, Boolean d
 	{
 		if (table == NULL)
 			return NULL;
-		if (e != NULL && e->next != NULL)
-			ne = e->next;
-		else
-			while (l < tablesize)
+		while (l < tablesize)
+			if (MCHashslotIsFilled(table[l++]))
 			{
-				ne = table[l];
-				l++;
-				if (ne != NULL)
-					break;
+				ne = table[l - 1] . entry;
+				break;
 			}
 	}
 	
@@ -776,29 +738,30 @@ MCHashentry *MCVariableArray::getnextelement(uint4 &l, MCHashentry *e, Boolean d
 
 MCHashentry *MCVariableArray::getnextkey(uint4& l, MCHashentry *e) const
 {	
-	if (e != NULL && e -> next != NULL)
-		return e -> next;
-	
 	while(l < tablesize)
-		if (table[l++] != NULL)
-			return table[l - 1];
+		if (MCHashslotIsFilled(table[l++]))
+			return table[l - 1] . entry;
 
 	return NULL;
 }
 
 MCHashentry *MCVariableArray::getnextkey(MCHashentry *e) const
 {
-	if (e != NULL && e -> next != NULL)
-		return e -> next;
-
+	// If the entry is no longer in the table then there is no way to tell
+	// where iteration had got to, so it ends.
 	uint32_t l;
 	if (e != NULL)
-		l = (( e -> hash) & (tablesize - 1)) + 1;
+	{
+		l = findslot(e);
+		if (l == tablesize)
+			return NULL;
+		l += 1;
+	}
 	else
 		l = 0;
 	while(l < tablesize)
-		if (table[l++] != NULL)
-			return table[l - 1];
+		if (MCHashslotIsFilled(table[l++]))
+			return table[l - 1] . entry;
 
 	return NULL;
 }
@@ -810,18 +773,14 @@ void MCVariableArray::combine(MCExecPoint& ep, char el, char k, char*& r_buffer,
 	uint4 ncount = 0;
 	uint4 ssize = 0;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
+			MCHashentry *e = table[i] . entry;
+			if (e -> value . ensure_string(ep))
 			{
-				if (e -> value . ensure_string(ep))
-				{
-					ssize += e -> value . get_string() . getlength() + 2;
-					items[ncount].data = e;
-					items[ncount++].svalue = e->string;
-				}
-				e = e->next;
+				ssize += e -> value . get_string() . getlength() + 2;
+				items[ncount].data = e;
+				items[ncount++].svalue = e->string;
 			}
 		}
 
@@ -852,7 +811,7 @@ void MCVariableArray::combine(MCExecPoint& ep, char el, char k, char*& r_buffer,
 
 		if (k)
 		{
-			uint4 ksize = strlen(e->string) + 1;
+			uint4 ksize = e->length + 1;
 			memcpy(&sptr[ssize], e->string, ksize);
 			ssize += ksize;
 			sptr[ssize - 1] = k;
@@ -976,7 +935,9 @@ void MCVariableArray::combine_column(MCExecPoint& ep, char p_row_delimiter, char
 	t_size = 0;
 	for(uint4 t_index = 0; t_index < tablesize; ++t_index)
 	{
-		for(MCHashentry *t_entry = table[t_index]; t_entry != NULL; t_entry = t_entry -> next)
+		MCHashentry *t_entry;
+		t_entry = table[t_index] . entry;
+		if (t_entry != NULL && t_entry != HASH_DELETED)
 			if (!t_entry -> value . is_undefined())
 			{
 				uint2 t_column;
@@ -1113,18 +1074,11 @@ void MCVariableArray::combine_column(MCExecPoint& ep, char p_row_delimiter, char
 }
 
 // This function returns a pointer to the first instance of 'c' after 'frontier',
-// or 'limit' if it reaches that first.
-static const char *strchr_limit(const char *frontier, const char *limit, char c)
+// or 'limit' if it reaches that first. It uses the same (memchr-based) search as
+// chunks and 'repeat for each', rather than comparing a byte at a time.
+static inline const char *strchr_limit(const char *frontier, const char *limit, char c)
 {
-	while(frontier < limit)
-	{
-		if (*frontier == c)
-			return frontier;
-			
-		frontier += 1;
-	}
-			
-	return limit;
+	return MCU_findchar(frontier, limit, c);
 }
 
 void MCVariableArray::split_column(const MCString& s, char p_row_delimiter, char p_column_delimiter)
@@ -1296,18 +1250,14 @@ void MCVariableArray::combine_as_set(MCExecPoint& ep, char el, char*& r_buffer,
 	uint4 ncount = 0;
 	uint4 ssize = 0;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
+			MCHashentry *e = table[i] . entry;
+			if (e -> value . is_string() && e -> value . get_string() == MCtruemcstring)
 			{
-				if (e -> value . is_string() && e -> value . get_string() == MCtruemcstring)
-				{
-					ssize += strlen(e -> string) + 1;
-					items[ncount].data = e;
-					items[ncount++].svalue = e->string;
-				}
-				e = e->next;
+				ssize += e -> length + 1;
+				items[ncount].data = e;
+				items[ncount++].svalue = e->string;
 			}
 		}
 
@@ -1324,7 +1274,7 @@ void MCVariableArray::combine_as_set(MCExecPoint& ep, char el, char*& r_buffer,
 		uint4 esize;
 		const char *estring;
 		estring = e -> string;
-		esize = strlen(e -> string);
+		esize = e -> length;
 
 		memcpy(&sptr[ssize], estring, esize);
 
@@ -1376,21 +1326,17 @@ Exec_stat MCVariableArray::setprops(uint4 parid, MCObject *optr)
 	MCerrorlock++;
 	uint4 i;
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
+			MCHashentry *e = table[i] . entry;
+			MCScriptPoint sp(e->string);
+			Symbol_type type;
+			const LT *te;
+			if (sp.next(type) && sp.lookup(SP_FACTOR, te) == PS_NORMAL
+			        && te->type == TT_PROPERTY && te->which != P_ID)
 			{
-				MCScriptPoint sp(e->string);
-				Symbol_type type;
-				const LT *te;
-				if (sp.next(type) && sp.lookup(SP_FACTOR, te) == PS_NORMAL
-				        && te->type == TT_PROPERTY && te->which != P_ID)
-				{
-					e -> value . fetch(ep);
-					optr->setprop(parid, (Properties)te->which, ep, False);
-				}
-				e = e->next;
+				e -> value . fetch(ep);
+				optr->setprop(parid, (Properties)te->which, ep, False);
 			}
 		}
 	MCerrorlock--;
@@ -1421,24 +1367,16 @@ IO_stat MCVariableArray::loadkeys(IO_handle stream, bool p_merge)
 	MCStackSecuritySetIOEncryptionEnabled(decrypt);
 	if (!p_merge)
 	{
-		nfilled = t_new_nfilled;
+		nfilled = ndeleted = 0;
 		extents = NULL;
 		dimensions = EXTENT_NONNUM;
 		keysize = 0;
-		tablesize = TABLE_SIZE;
-		while (tablesize < nfilled)
-			tablesize <<= 1;
-		table = new MCHashentry *[tablesize];
-		memset((char *)table, 0, tablesize * sizeof(MCHashentry *));
-	}
-	else if (t_new_nfilled > tablesize)
-	{
-		uint32_t t_new_tablesize;
-		t_new_tablesize = tablesize;
-		while(t_new_tablesize < t_new_nfilled)
-			t_new_tablesize <<= 1;
-		resizehash(t_new_tablesize);
+		tablesize = MCVariableArrayComputeTableSize(0, t_new_nfilled);
+		table = new MCHashslot[tablesize];
+		memset((char *)table, 0, tablesize * sizeof(MCHashslot));
 	}
+	else if (HASH_LOAD_LIMIT(tablesize) <= nfilled + t_new_nfilled)
+		resizehash(MCVariableArrayComputeTableSize(0, nfilled + t_new_nfilled));
 
 	uint32_t t_size;
 	t_size = large ? 4 : 2;
@@ -1462,9 +1400,7 @@ IO_stat MCVariableArray::loadkeys(IO_handle stream, bool p_merge)
 			MCCStringFree(t_string);
 			t_string = nil;
 
-			uint4 index = e->hash & tablesize - 1;
-			e->next = table[index];
-			table[index] = e;
+			insertslot(e);
 
 			stat = IO_read_string(t_string, t_length, stream, t_size, false, false);
 		}
@@ -1494,19 +1430,14 @@ IO_stat MCVariableArray::savekeys(IO_handle stream)
 	Boolean large = False;
 	for (i = 0 ; i < tablesize ; i++)
 	{
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				if (e -> value . is_string() && e -> value . get_string() . getlength() > MAXUINT2)
-					large = True;
-		
-				if (!e -> value . is_array())
-					t_writable_nfilled += 1;
-
-				e = e->next;
-			}
+			MCHashentry *e = table[i] . entry;
+			if (e -> value . is_string() && e -> value . get_string() . getlength() > MAXUINT2)
+				large = True;
+	
+			if (!e -> value . is_array())
+				t_writable_nfilled += 1;
 		}
 	}
 
@@ -1521,62 +1452,55 @@ IO_stat MCVariableArray::savekeys(IO_handle stream)
 		return stat;
 	
 	for (i = 0 ; i < tablesize ; i++)
-		if (table[i] != NULL)
+		if (MCHashslotIsFilled(table[i]))
 		{
-			MCHashentry *e = table[i];
-			while (e != NULL)
-			{
-				// Skip any array valued keys.
-				if (e -> value . is_array())
-				{
-					e = e -> next;
-					continue;
-				}
+			MCHashentry *e = table[i] . entry;
 
-				// IM-2013-04-04: [[ BZ 10811 ]] pre 6.0 versions of loadkeys() expect
-				// a null-terminated string of non-zero length (including null),
-				// but IO_write_string() writes a single zero byte for an empty string
-				// so we need a special case here.
-				if (e->string == nil || e->string[0] == '\0')
-				{
-					// write length + null
-					if ((stat = IO_write_uint1(1, stream)) != IO_NORMAL)
-						return stat;
-					// write null
-					if ((stat = IO_write_uint1(0, stream)) != IO_NORMAL)
-						return stat;
-				}
-				else
-				{
-					if ((stat = IO_write_string(e->string, stream, 1)) != IO_NORMAL)
-						return stat;
-				}
-
-				const char *t_value_str;
-				uint32_t t_value_length;
-				MCExecPoint ep;
-				if (e -> value . ensure_string(ep))
-				{
-					t_value_str = e -> value . get_string() . getstring();
-					t_value_length = e -> value . get_string() . getlength();
-				}
-				else
-				{
-					t_value_str = NULL;
-					t_value_length = 0;
-				}
+			// Skip any array valued keys.
+			if (e -> value . is_array())
+				continue;
 
-				uint32_t t_size;
-				if (large)
-					t_size = 4;
-				else
-					t_size = 2;
-				MCString t_string(t_value_str, t_value_length);
-				if ((stat = IO_write_string(t_string, stream, t_size, false)) != IO_NORMAL)
+			// IM-2013-04-04: [[ BZ 10811 ]] pre 6.0 versions of loadkeys() expect
+			// a null-terminated string of non-zero length (including null),
+			// but IO_write_string() writes a single zero byte for an empty string
+			// so we need a special case here.
+			if (e->string == nil || e->string[0] == '\0')
+			{
+				// write length + null
+				if ((stat = IO_write_uint1(1, stream)) != IO_NORMAL)
 					return stat;
+				// write null
+				if ((stat = IO_write_uint1(0, stream)) != IO_NORMAL)
+					return stat;
+			}
+			else
+			{
+				if ((stat = IO_write_string(e->string, stream, 1)) != IO_NORMAL)
+					return stat;
+			}
 
-				e = e->next;
+			const char *t_value_str;
+			uint32_t t_value_length;
+			MCExecPoint ep;
+			if (e -> value . ensure_string(ep))
+			{
+				t_value_str = e -> value . get_string() . getstring();
+				t_value_length = e -> value . get_string() . getlength();
 			}
+			else
+			{
+				t_value_str = NULL;
+				t_value_length = 0;
+			}
+
+			uint32_t t_size;
+			if (large)
+				t_size = 4;
+			else
+				t_size = 2;
+			MCString t_string(t_value_str, t_value_length);
+			if ((stat = IO_write_string(t_string, stream, t_size, false)) != IO_NORMAL)
+				return stat;
 		}
 	return IO_NORMAL;
 }
@@ -1678,18 +1602,13 @@ IO_stat MCVariableArray::load(MCObjectInputStream& p_stream, bool p_merge)
 
 	if (t_stat == IO_NORMAL)
 	{
-		uint32_t t_table_size;
-		t_table_size = TABLE_SIZE;
-		while(t_table_size < t_nfilled)
-			t_table_size <<= 1;
-
 		if (p_merge)
 		{
-			if (tablesize < t_table_size)
-				resizehash(t_table_size);
+			if (HASH_LOAD_LIMIT(tablesize) <= nfilled + t_nfilled)
+				resizehash(MCVariableArrayComputeTableSize(0, nfilled + t_nfilled));
 		}
 		else
-			presethash(t_table_size);
+			presethash(t_nfilled);
 	}
 
 	while(t_stat == IO_NORMAL)
@@ -1699,19 +1618,11 @@ IO_stat MCVariableArray::load(MCObjectInputStream& p_stream, bool p_merge)
 		if (t_entry == NULL)
 			break;
 
-		t_entry -> hash = computehash(t_entry -> string);
-
-		uint32_t t_index;
-		t_index = t_entry -> hash & (tablesize - 1);
+		t_entry -> hash = computehash(MCString(t_entry -> string, t_entry -> length));
 
-		uint4 t_length;
-		t_length = strlen(t_entry -> string);
 		extentfromkey(t_entry -> string);
-		keysize += t_length + 1;
-		t_entry -> next = table[t_index];
-		table[t_index] = t_entry;
-
-		nfilled += 1;
+		keysize += t_entry -> length + 1;
+		insertslot(t_entry);
 	}
 
 	return t_stat;
@@ -1721,25 +1632,15 @@ void MCVariableArray::listelements(MCHashentry **p_entries)
 {
 	uint4 t_count;
 	t_count = 0;
-	for(uint32_t i = 0 ; i < tablesize ; i++)
-	if (table[i] != NULL)
-	{
-		MCHashentry *e = table[i];
-		while (e != NULL)
-		{
-			p_entries[t_count] = e;
-			e = e->next;
-			t_count++;
-			if (t_count == nfilled)
-				break;
-		}
-	}
+	for(uint32_t i = 0 ; i < tablesize && t_count < nfilled ; i++)
+		if (MCHashslotIsFilled(table[i]))
+			p_entries[t_count++] = table[i] . entry;
 }
 
 uint4 MCHashentry::Measure(void)
 {
 	uint4 t_size;
-	t_size = 1 + 4 + strlen(string) + 1;
+	t_size = 1 + 4 + length + 1;
 
 	switch(value . get_format())
 	{
@@ -1834,21 +1735,32 @@ IO_stat MCHashentry::Load(MCObjectInputStream& p_stream, MCHashentry*& r_entry)
 	if (t_stat == IO_NORMAL)
 		t_stat = p_stream . ReadU32(t_length);
 
+	// If the stream is being read in place, the key is copied straight from it
+	// into the entry.
+	const char *t_borrowed_key;
+	t_borrowed_key = NULL;
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . ReadBorrowedCString(t_borrowed_key);
+
 	char *t_key;
 	t_key = NULL;
-	if (t_stat == IO_NORMAL)
+	if (t_stat == IO_NORMAL && t_borrowed_key == NULL)
 		t_stat = p_stream . ReadCString(t_key);
 
 	MCHashentry *t_entry;
 	t_entry = NULL;
 	if (t_stat == IO_NORMAL)
 	{
+		const char *t_key_string;
+		t_key_string = t_borrowed_key != NULL ? t_borrowed_key : t_key;
+
 		uint32_t t_key_length;
-		t_key_length = t_key == NULL ? 0 : strlen(t_key);
+		t_key_length = t_key_string == NULL ? 0 : strlen(t_key_string);
 
 		t_entry = MCHashentry::Create(t_key_length);
-		memcpy(t_entry -> string, t_key, t_key_length);
+		memcpy(t_entry -> string, t_key_string, t_key_length);
 		t_entry -> string[t_key_length] = '\0';
+		t_entry -> length = t_key_length;
 
 		switch((Value_format)(t_type - 1))
 		{
@@ -1860,12 +1772,23 @@ IO_stat MCHashentry::Load(MCObjectInputStream& p_stream, MCHashentry*& r_entry)
 			uint32_t t_string_length;
 			t_stat = p_stream . ReadU32(t_string_length);
 
+			// If the stream is being read in place, the value is copied once
+			// from it, and only after its length has been checked against what
+			// is there.
+			const void *t_borrowed_string;
+			t_borrowed_string = NULL;
+			if (t_stat == IO_NORMAL)
+				t_stat = p_stream . ReadBorrowed(t_borrowed_string, t_string_length);
+
 			char *t_string;
 			t_string = NULL;
 			if (t_stat == IO_NORMAL)
 			{
 				t_string = new char[t_string_length];
-				t_stat = p_stream . Read(t_string, t_string_length);
+				if (t_borrowed_string != NULL)
+					memcpy(t_string, t_borrowed_string, t_string_length);
+				else
+					t_stat = p_stream . Read(t_string, t_string_length);
 			}
 
 			if (t_stat == IO_NORMAL)
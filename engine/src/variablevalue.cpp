@@ -99,6 +99,13 @@ void MCVariableValue::assign_buffer(char *p_buffer, uint32_t p_length)
 
 void MCVariableValue::exchange(MCVariableValue& v)
 {
+	// Delimiter indices are keyed by address, so they can't move with the
+	// strings.
+	if (has_delimiter_index())
+		discard_delimiter_index();
+	if (v . has_delimiter_index())
+		v . discard_delimiter_index();
+
 	char t_temp[sizeof(MCVariableValue) - 4];
 	memcpy(t_temp, ((char *)&v) + 4, sizeof(MCVariableValue) - 4);
 	memcpy(((char *)&v) + 4, ((char *)this) + 4, sizeof(MCVariableValue) - 4);
@@ -448,6 +455,9 @@ bool MCVariableValue::assign_string(const MCString& p_string)
 
 	if (!is_array())
 	{
+		if (has_delimiter_index())
+			discard_delimiter_index();
+
 		// Note that it could be that p_string overlaps buffer, but in which case the new size will
 		// always be less than the current size so no realloc occurs.
 
@@ -554,6 +564,11 @@ bool MCVariableValue::assign_custom_both(const char *s, real64_t n)
 // This method assumes the value is already a string.
 bool MCVariableValue::reserve(uint32_t p_required_length, void*& r_buffer, uint32_t& r_length)
 {
+	// The caller is free to modify the buffer, so any delimiter index cannot
+	// be trusted afterwards.
+	if (has_delimiter_index())
+		discard_delimiter_index();
+
 	if (strnum . buffer . size == 0)
 	{
 		// If the buffer is 0 size it means we are either empty or we have a constant
@@ -600,12 +615,18 @@ bool MCVariableValue::commit(uint32_t p_actual_length)
 	if (strnum . buffer . size < p_actual_length)
 		return false;
 
+	if (has_delimiter_index())
+		discard_delimiter_index();
+
 	strnum . buffer . data = (char *)realloc(strnum . buffer . data, p_actual_length);
 	strnum . buffer . size = p_actual_length;
 
 	strnum . svalue . string = strnum . buffer . data;
 	strnum . svalue . length = p_actual_length;
 
+	// The buffer has been edited, so any cached numeric value is now stale.
+	set_type(VF_STRING);
+
 	set_dbg_changed(true);
 
 	return true;
@@ -622,6 +643,9 @@ void MCVariableValue::assign_constant_both(const MCString& s, real64_t n)
 // This method is wrapped by other methods. It is used by ::append, and also the
 // externals V1 interface. It assumes that the value within the value is already
 // a string.
+// Note that appending doesn't invalidate any delimiter indices since they only
+// record offsets into the (unchanged) prefix of the string - the new portion will
+// be scanned when it is next needed.
 bool MCVariableValue::append_string(const MCString& s)
 {
 	const char *t_new_string;
@@ -634,30 +658,58 @@ bool MCVariableValue::append_string(const MCString& s)
 	{
 		uint32_t t_new_size;
 		t_new_size = t_new_length + strnum . svalue . length;
+		if (t_new_size < t_new_length)
+			return false;
 
 		if (t_new_size > strnum . buffer . size)
 		{
-			t_new_size = (t_new_size + VAR_PAD) & VAR_MASK;
+			// Once the value owns a buffer, grow it geometrically so that building
+			// a string by repeated appends takes linear time overall.
+			uint32_t t_capacity;
+			t_capacity = (t_new_size + VAR_PAD) & VAR_MASK;
 			if (strnum . buffer . data != NULL)
-				t_new_size += MCU_min(t_new_size, VAR_APPEND_MAX);
+				t_capacity = MCU_max(t_capacity, (t_new_size + MCU_min(t_new_size / VAR_APPEND_GROWTH, MAXUINT4 - t_new_size)) & VAR_MASK);
+			if (t_capacity < t_new_size)
+				t_capacity = t_new_size;
 
-			char *t_new_buffer;
-			t_new_buffer = (char *)malloc(t_new_size);
-			if (t_new_buffer != NULL)
+			char *t_new_buffer, *t_old_buffer;
+			t_old_buffer = NULL;
+			if (strnum . buffer . size != 0 && strnum . svalue . string == strnum . buffer . data)
 			{
-				memcpy(t_new_buffer, strnum . svalue . string, strnum . svalue . length);
-				memmove(t_new_buffer + strnum . svalue . length, t_new_string, t_new_length);
-				
-				free(strnum . buffer . data);
-
-				strnum . buffer . data = t_new_buffer;
-				strnum . buffer . size = t_new_size;
+				// The string is already in our buffer so extend it in place - for
+				// large blocks realloc can usually do this without copying. If the
+				// appended string is part of the buffer, it has to be found again
+				// afterwards.
+				bool t_overlaps;
+				uint32_t t_overlap_offset;
+				t_overlaps = t_new_string >= strnum . buffer . data && t_new_string < strnum . buffer . data + strnum . buffer . size;
+				t_overlap_offset = t_overlaps ? t_new_string - strnum . buffer . data : 0;
+
+				t_new_buffer = (char *)realloc(strnum . buffer . data, t_capacity);
+				if (t_new_buffer == NULL)
+					return false;
 
-				strnum . svalue . string = t_new_buffer;
-				strnum . svalue . length += t_new_length;
+				if (t_overlaps)
+					t_new_string = t_new_buffer + t_overlap_offset;
 			}
 			else
-				return false;
+			{
+				t_new_buffer = (char *)malloc(t_capacity);
+				if (t_new_buffer == NULL)
+					return false;
+
+				memcpy(t_new_buffer, strnum . svalue . string, strnum . svalue . length);
+				t_old_buffer = strnum . buffer . data;
+			}
+
+			memmove(t_new_buffer + strnum . svalue . length, t_new_string, t_new_length);
+			free(t_old_buffer);
+
+			strnum . buffer . data = t_new_buffer;
+			strnum . buffer . size = t_capacity;
+
+			strnum . svalue . string = t_new_buffer;
+			strnum . svalue . length += t_new_length;
 		}
 		else
 		{
@@ -727,7 +779,7 @@ bool MCVariableValue::encode(void*& r_buffer, uint32_t& r_length)
 		return false;
 	
 	MCObjectOutputStream *t_stream;
-	t_stream = new MCObjectOutputStream(t_stream_handle);
+	t_stream = new MCObjectOutputStream(t_stream_handle, true);
 	if (t_stream == NULL)
 	{
 		char *t_buffer;
@@ -809,7 +861,7 @@ bool MCVariableValue::decode(const MCString& p_value)
 		return false;
 		
 	MCObjectInputStream *t_stream = nil;
-	t_stream = new MCObjectInputStream(t_stream_handle, p_value . getlength());
+	t_stream = new MCObjectInputStream(t_stream_handle, p_value . getlength(), true);
 	if (t_stream == NULL)
 	{
 		MCS_close(t_stream_handle);
@@ -873,6 +925,321 @@ bool MCVariableValue::decode(const MCString& p_value)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// At most this many delimiter indices are kept on a value - in practice only
+// the line and item delimiters are of interest.
+#define VAR_INDEX_MAX 2
+
+struct MCVariableChunkIndex
+{
+	MCVariableChunkIndex *next;
+	char delimiter;
+
+	// The number of bytes of the string which have been scanned so far.
+	uint32_t scanned;
+
+	// The (increasing) offsets of the delimiters found in the scanned portion.
+	uint32_t *offsets;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+// Scan the string until either p_limit bytes have been examined or more than
+// p_index delimiters have been found. Returns false if memory is exhausted.
+static bool MCVariableChunkIndexScan(MCVariableChunkIndex *self, const MCString& p_string, uint32_t p_limit, uint32_t p_index)
+{
+	const char *t_string;
+	t_string = p_string . getstring();
+
+	if (p_limit > p_string . getlength())
+		p_limit = p_string . getlength();
+
+	while(self -> scanned < p_limit && self -> count <= p_index)
+	{
+		const char *t_found;
+		t_found = (const char *)memchr(t_string + self -> scanned, self -> delimiter, p_limit - self -> scanned);
+		if (t_found == NULL)
+		{
+			self -> scanned = p_limit;
+			break;
+		}
+
+		if (self -> count == self -> capacity)
+		{
+			uint32_t t_new_capacity;
+			t_new_capacity = self -> capacity == 0 ? 64 : self -> capacity * 2;
+
+			uint32_t *t_new_offsets;
+			t_new_offsets = (uint32_t *)realloc(self -> offsets, t_new_capacity * sizeof(uint32_t));
+			if (t_new_offsets == NULL)
+				return false;
+
+			self -> offsets = t_new_offsets;
+			self -> capacity = t_new_capacity;
+		}
+
+		self -> offsets[self -> count++] = t_found - t_string;
+		self -> scanned = t_found - t_string + 1;
+	}
+
+	return true;
+}
+
+// Few values are ever chunked, so rather than each value having a field for
+// its delimiter indices, they are held in this table, keyed by the address of
+// the value. It is open-addressed with linear probing, and entries are removed
+// by shifting back those that follow, so there are no tombstones.
+struct MCVariableChunkIndexSlot
+{
+	const MCVariableValue *value;
+	MCVariableChunkIndex *indices;
+};
+
+static MCVariableChunkIndexSlot *s_chunk_index_slots = NULL;
+static uint32_t s_chunk_index_capacity = 0;
+static uint32_t s_chunk_index_count = 0;
+
+static inline uint32_t MCVariableChunkIndexHash(const MCVariableValue *p_value)
+{
+	uintptr_t t_address;
+	t_address = (uintptr_t)p_value;
+	return (uint32_t)((t_address >> 3) ^ (t_address >> 17)) * 2654435761U;
+}
+
+// Returns the slot for the given value - if it has no entry, the slot it would
+// go in (whose value is NULL).
+static MCVariableChunkIndexSlot *MCVariableChunkIndexFindSlot(const MCVariableValue *p_value)
+{
+	uint32_t t_mask, t_slot;
+	t_mask = s_chunk_index_capacity - 1;
+	t_slot = MCVariableChunkIndexHash(p_value) & t_mask;
+	while(s_chunk_index_slots[t_slot] . value != NULL && s_chunk_index_slots[t_slot] . value != p_value)
+		t_slot = (t_slot + 1) & t_mask;
+	return &s_chunk_index_slots[t_slot];
+}
+
+// Returns the slot holding the list of indices for the given value, adding one
+// with an empty list if there isn't one. Returns NULL if memory is exhausted.
+static MCVariableChunkIndexSlot *MCVariableChunkIndexAddSlot(const MCVariableValue *p_value)
+{
+	if ((s_chunk_index_count + 1) * 2 > s_chunk_index_capacity)
+	{
+		MCVariableChunkIndexSlot *t_old_slots;
+		uint32_t t_old_capacity;
+		t_old_slots = s_chunk_index_slots;
+		t_old_capacity = s_chunk_index_capacity;
+
+		uint32_t t_new_capacity;
+		t_new_capacity = t_old_capacity == 0 ? 16 : t_old_capacity * 2;
+
+		MCVariableChunkIndexSlot *t_new_slots;
+		t_new_slots = (MCVariableChunkIndexSlot *)calloc(t_new_capacity, sizeof(MCVariableChunkIndexSlot));
+		if (t_new_slots == NULL)
+			return NULL;
+
+		s_chunk_index_slots = t_new_slots;
+		s_chunk_index_capacity = t_new_capacity;
+		for(uint32_t i = 0; i < t_old_capacity; i++)
+			if (t_old_slots[i] . value != NULL)
+				*MCVariableChunkIndexFindSlot(t_old_slots[i] . value) = t_old_slots[i];
+
+		free(t_old_slots);
+	}
+
+	MCVariableChunkIndexSlot *t_slot;
+	t_slot = MCVariableChunkIndexFindSlot(p_value);
+	if (t_slot -> value == NULL)
+	{
+		t_slot -> value = p_value;
+		t_slot -> indices = NULL;
+		s_chunk_index_count += 1;
+	}
+
+	return t_slot;
+}
+
+// Removes the entry for the given value, returning its list of indices.
+static MCVariableChunkIndex *MCVariableChunkIndexRemoveSlot(const MCVariableValue *p_value)
+{
+	if (s_chunk_index_count == 0)
+		return NULL;
+
+	MCVariableChunkIndexSlot *t_slot;
+	t_slot = MCVariableChunkIndexFindSlot(p_value);
+	if (t_slot -> value == NULL)
+		return NULL;
+
+	MCVariableChunkIndex *t_indices;
+	t_indices = t_slot -> indices;
+
+	// Move back any following entries which would no longer be found.
+	uint32_t t_mask, t_hole, t_next;
+	t_mask = s_chunk_index_capacity - 1;
+	t_hole = t_slot - s_chunk_index_slots;
+	t_next = (t_hole + 1) & t_mask;
+	while(s_chunk_index_slots[t_next] . value != NULL)
+	{
+		uint32_t t_home;
+		t_home = MCVariableChunkIndexHash(s_chunk_index_slots[t_next] . value) & t_mask;
+		if (((t_next - t_home) & t_mask) >= ((t_next - t_hole) & t_mask))
+		{
+			s_chunk_index_slots[t_hole] = s_chunk_index_slots[t_next];
+			t_hole = t_next;
+		}
+		t_next = (t_next + 1) & t_mask;
+	}
+	s_chunk_index_slots[t_hole] . value = NULL;
+	s_chunk_index_slots[t_hole] . indices = NULL;
+	s_chunk_index_count -= 1;
+
+	return t_indices;
+}
+
+MCVariableChunkIndex *MCVariableValue::fetch_delimiter_index(char p_delimiter)
+{
+	MCVariableChunkIndexSlot *t_slot;
+	t_slot = MCVariableChunkIndexAddSlot(this);
+	if (t_slot == NULL)
+		return NULL;
+	_flags |= kDelimiterIndexBit;
+
+	MCVariableChunkIndex *t_previous, *t_index;
+	uint32_t t_depth;
+	t_previous = NULL;
+	t_depth = 0;
+	for(t_index = t_slot -> indices; t_index != NULL; t_index = t_index -> next)
+	{
+		if (t_index -> delimiter == p_delimiter)
+			break;
+
+		t_depth += 1;
+		if (t_index -> next == NULL)
+			break;
+
+		t_previous = t_index;
+	}
+
+	if (t_index != NULL && t_index -> delimiter == p_delimiter)
+	{
+		// Keep the most recently used index at the front.
+		if (t_previous != NULL)
+		{
+			t_previous -> next = t_index -> next;
+			t_index -> next = t_slot -> indices;
+			t_slot -> indices = t_index;
+		}
+		return t_index;
+	}
+
+	// If there are already the maximum number of indices, reuse the least
+	// recently used one.
+	if (t_depth >= VAR_INDEX_MAX)
+	{
+		if (t_previous != NULL)
+			t_previous -> next = NULL;
+		else
+			t_slot -> indices = NULL;
+	}
+	else
+	{
+		t_index = (MCVariableChunkIndex *)malloc(sizeof(MCVariableChunkIndex));
+		if (t_index == NULL)
+			return NULL;
+
+		t_index -> offsets = NULL;
+		t_index -> capacity = 0;
+	}
+
+	t_index -> delimiter = p_delimiter;
+	t_index -> scanned = 0;
+	t_index -> count = 0;
+	t_index -> next = t_slot -> indices;
+	t_slot -> indices = t_index;
+
+	return t_index;
+}
+
+uint32_t MCVariableValue::count_delimiters(char p_delimiter, uint32_t p_offset)
+{
+	MCString t_string;
+	t_string = get_string();
+
+	if (p_offset > t_string . getlength())
+		p_offset = t_string . getlength();
+
+	MCVariableChunkIndex *t_index;
+	t_index = fetch_delimiter_index(p_delimiter);
+	if (t_index == NULL || !MCVariableChunkIndexScan(t_index, t_string, p_offset, UINT32_MAX))
+	{
+		// If memory is exhausted, fall back to counting directly.
+		discard_delimiter_index();
+
+		return MCU_countchar(t_string . getstring(), t_string . getstring() + p_offset, p_delimiter);
+	}
+
+	// Binary search for the first delimiter at or after p_offset.
+	uint32_t t_low, t_high;
+	t_low = 0;
+	t_high = t_index -> count;
+	while(t_low < t_high)
+	{
+		uint32_t t_mid;
+		t_mid = t_low + (t_high - t_low) / 2;
+		if (t_index -> offsets[t_mid] < p_offset)
+			t_low = t_mid + 1;
+		else
+			t_high = t_mid;
+	}
+
+	return t_low;
+}
+
+bool MCVariableValue::find_delimiter(char p_delimiter, uint32_t p_index, uint32_t& r_offset)
+{
+	MCString t_string;
+	t_string = get_string();
+
+	MCVariableChunkIndex *t_index;
+	t_index = fetch_delimiter_index(p_delimiter);
+	if (t_index == NULL || !MCVariableChunkIndexScan(t_index, t_string, t_string . getlength(), p_index))
+	{
+		// If memory is exhausted, fall back to searching directly.
+		discard_delimiter_index();
+
+		for(uint32_t i = 0; i < t_string . getlength(); i++)
+			if (t_string . getstring()[i] == p_delimiter && p_index-- == 0)
+			{
+				r_offset = i;
+				return true;
+			}
+		return false;
+	}
+
+	if (p_index >= t_index -> count)
+		return false;
+
+	r_offset = t_index -> offsets[p_index];
+	return true;
+}
+
+void MCVariableValue::discard_delimiter_index(void)
+{
+	if (!has_delimiter_index())
+		return;
+	_flags &= ~kDelimiterIndexBit;
+
+	MCVariableChunkIndex *t_indices;
+	t_indices = MCVariableChunkIndexRemoveSlot(this);
+	while(t_indices != NULL)
+	{
+		MCVariableChunkIndex *t_index;
+		t_index = t_indices;
+		t_indices = t_index -> next;
+		free(t_index -> offsets);
+		free(t_index);
+	}
+}
+///////////////////////////////////////////////////////////////////////////////
+
 bool MCVariableValue::coerce_to_real(MCExecPoint& ep)
 {
 	assert(!is_real());
@@ -910,6 +1277,9 @@ bool MCVariableValue::coerce_to_string(MCExecPoint& ep)
 
 	if (is_number())
 	{
+		if (has_delimiter_index())
+			discard_delimiter_index();
+
 		uint32_t t_length;
 		t_length = MCU_r8tos(strnum . buffer . data, strnum . buffer . size, strnum . nvalue, ep . getnffw(), ep . getnftrailing(), ep . getnfforce());
 
@@ -28,4 +28,22 @@ void MCThreadEventWait(MCThreadEventRef event);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The thread pool runs independent pieces of work on a set of worker threads,
+// one per processor. The workers are started the first time the pool is used.
+// Work run on the pool must only touch the memory it is given - in particular
+// it must not call back into the engine.
+
+typedef void (*MCThreadPoolCallback)(void *context, uindex_t index);
+
+// Call 'callback' once for each index in [0, count), spreading the calls over
+// the pool, and return when they have all completed. The calling thread runs
+// calls too. If the pool is already running work (or couldn't be started)
+// the calls are made in turn on the calling thread.
+void MCThreadPoolRun(uindex_t count, MCThreadPoolCallback callback, void *context);
+
+// Return the number of threads (including the caller) work is spread over.
+uindex_t MCThreadPoolGetConcurrency(void);
+
+////////////////////////////////////////////////////////////////////////////////
+
 #endif
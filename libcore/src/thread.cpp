@@ -6,6 +6,7 @@
 #if defined(_WINDOWS)
 
 #include <windows.h>
+#include <process.h>
 
 bool MCThreadEventCreate(MCThreadEventRef& r_event)
 {
@@ -42,9 +43,150 @@ void MCThreadEventWait(MCThreadEventRef self)
 	WaitForSingleObject((HANDLE)self, INFINITE);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+struct MCThreadPoolJob
+{
+	MCThreadPoolCallback callback;
+	void *context;
+	uindex_t count;
+	uindex_t next;
+	uindex_t remaining;
+};
+
+// The pool lock protects the current job. Workers wait on the work semaphore
+// for a job to be posted, and the caller waits on the done event for the last
+// call of its job to complete.
+static CRITICAL_SECTION s_pool_lock;
+static HANDLE s_pool_work = nil;
+static HANDLE s_pool_done = nil;
+static MCThreadPoolJob *s_pool_job = nil;
+static uindex_t s_pool_worker_count = 0;
+static bool s_pool_started = false;
+
+static unsigned int __stdcall MCThreadPoolWorker(void *p_context)
+{
+	for(;;)
+	{
+		WaitForSingleObject(s_pool_work, INFINITE);
+
+		EnterCriticalSection(&s_pool_lock);
+		while(s_pool_job != nil && s_pool_job -> next < s_pool_job -> count)
+		{
+			MCThreadPoolJob *t_job;
+			t_job = s_pool_job;
+
+			uindex_t t_index;
+			t_index = t_job -> next++;
+			LeaveCriticalSection(&s_pool_lock);
+
+			t_job -> callback(t_job -> context, t_index);
+
+			EnterCriticalSection(&s_pool_lock);
+			if (--t_job -> remaining == 0)
+				SetEvent(s_pool_done);
+		}
+		LeaveCriticalSection(&s_pool_lock);
+	}
+
+	return 0;
+}
+
+static void MCThreadPoolStart(void)
+{
+	s_pool_started = true;
+
+	SYSTEM_INFO t_info;
+	GetSystemInfo(&t_info);
+	if (t_info . dwNumberOfProcessors <= 1)
+		return;
+
+	InitializeCriticalSection(&s_pool_lock);
+	s_pool_work = CreateSemaphore(NULL, 0, t_info . dwNumberOfProcessors, NULL);
+	s_pool_done = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (s_pool_work == nil || s_pool_done == nil)
+		return;
+
+	for(uindex_t i = 0; i < t_info . dwNumberOfProcessors - 1; i++)
+	{
+		HANDLE t_thread;
+		t_thread = (HANDLE)_beginthreadex(NULL, 0, MCThreadPoolWorker, NULL, 0, NULL);
+		if (t_thread == 0)
+			break;
+		CloseHandle(t_thread);
+		s_pool_worker_count++;
+	}
+}
+
+void MCThreadPoolRun(uindex_t p_count, MCThreadPoolCallback p_callback, void *p_context)
+{
+	if (!s_pool_started)
+		MCThreadPoolStart();
+
+	bool t_inline;
+	t_inline = p_count <= 1 || s_pool_worker_count == 0;
+
+	if (!t_inline)
+	{
+		EnterCriticalSection(&s_pool_lock);
+		t_inline = s_pool_job != nil;
+		if (t_inline)
+			LeaveCriticalSection(&s_pool_lock);
+	}
+
+	if (t_inline)
+	{
+		for(uindex_t i = 0; i < p_count; i++)
+			p_callback(p_context, i);
+		return;
+	}
+
+	MCThreadPoolJob t_job;
+	t_job . callback = p_callback;
+	t_job . context = p_context;
+	t_job . count = p_count;
+	t_job . next = 0;
+	t_job . remaining = p_count;
+	s_pool_job = &t_job;
+	ResetEvent(s_pool_done);
+	ReleaseSemaphore(s_pool_work, MCMin(p_count - 1, s_pool_worker_count), NULL);
+
+	while(t_job . next < t_job . count)
+	{
+		uindex_t t_index;
+		t_index = t_job . next++;
+		LeaveCriticalSection(&s_pool_lock);
+
+		p_callback(p_context, t_index);
+
+		EnterCriticalSection(&s_pool_lock);
+		t_job . remaining--;
+	}
+
+	bool t_wait;
+	t_wait = t_job . remaining != 0;
+	LeaveCriticalSection(&s_pool_lock);
+
+	if (t_wait)
+		WaitForSingleObject(s_pool_done, INFINITE);
+
+	EnterCriticalSection(&s_pool_lock);
+	s_pool_job = nil;
+	LeaveCriticalSection(&s_pool_lock);
+}
+
+uindex_t MCThreadPoolGetConcurrency(void)
+{
+	if (!s_pool_started)
+		MCThreadPoolStart();
+
+	return s_pool_worker_count + 1;
+}
+
 #elif defined(_MACOSX) || defined(_LINUX)
 
 #include <pthread.h>
+#include <unistd.h>
 
 struct MCThreadEvent
 {
@@ -113,6 +255,137 @@ void MCThreadEventWait(MCThreadEventRef self)
 	pthread_mutex_unlock(&self -> mutex);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+struct MCThreadPoolJob
+{
+	MCThreadPoolCallback callback;
+	void *context;
+	uindex_t count;
+	uindex_t next;
+	uindex_t remaining;
+};
+
+// The pool mutex protects the current job. Workers wait on the work condition
+// for a job with calls left to make, and the caller waits on the done
+// condition for the last call of its job to complete.
+static pthread_mutex_t s_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t s_pool_done = PTHREAD_COND_INITIALIZER;
+static MCThreadPoolJob *s_pool_job = nil;
+static uindex_t s_pool_worker_count = 0;
+static bool s_pool_started = false;
+
+static void *MCThreadPoolWorker(void *p_context)
+{
+	pthread_mutex_lock(&s_pool_mutex);
+	for(;;)
+	{
+		while(s_pool_job == nil || s_pool_job -> next == s_pool_job -> count)
+			pthread_cond_wait(&s_pool_work, &s_pool_mutex);
+
+		MCThreadPoolJob *t_job;
+		t_job = s_pool_job;
+
+		uindex_t t_index;
+		t_index = t_job -> next++;
+		pthread_mutex_unlock(&s_pool_mutex);
+
+		t_job -> callback(t_job -> context, t_index);
+
+		pthread_mutex_lock(&s_pool_mutex);
+		if (--t_job -> remaining == 0)
+			pthread_cond_signal(&s_pool_done);
+	}
+
+	return nil;
+}
+
+static void MCThreadPoolStart(void)
+{
+	s_pool_started = true;
+
+	long t_processors;
+	t_processors = sysconf(_SC_NPROCESSORS_ONLN);
+	for(long i = 1; i < t_processors; i++)
+	{
+		pthread_t t_thread;
+		if (pthread_create(&t_thread, nil, MCThreadPoolWorker, nil) != 0)
+			break;
+		pthread_detach(t_thread);
+		s_pool_worker_count++;
+	}
+}
+
+void MCThreadPoolRun(uindex_t p_count, MCThreadPoolCallback p_callback, void *p_context)
+{
+	pthread_mutex_lock(&s_pool_mutex);
+
+	if (!s_pool_started)
+		MCThreadPoolStart();
+
+	if (p_count <= 1 || s_pool_worker_count == 0 || s_pool_job != nil)
+	{
+		pthread_mutex_unlock(&s_pool_mutex);
+		for(uindex_t i = 0; i < p_count; i++)
+			p_callback(p_context, i);
+		return;
+	}
+
+	MCThreadPoolJob t_job;
+	t_job . callback = p_callback;
+	t_job . context = p_context;
+	t_job . count = p_count;
+	t_job . next = 0;
+	t_job . remaining = p_count;
+	s_pool_job = &t_job;
+	pthread_cond_broadcast(&s_pool_work);
+
+	while(t_job . next < t_job . count)
+	{
+		uindex_t t_index;
+		t_index = t_job . next++;
+		pthread_mutex_unlock(&s_pool_mutex);
+
+		p_callback(p_context, t_index);
+
+		pthread_mutex_lock(&s_pool_mutex);
+		t_job . remaining--;
+	}
+
+	while(t_job . remaining != 0)
+		pthread_cond_wait(&s_pool_done, &s_pool_mutex);
+
+	s_pool_job = nil;
+	pthread_mutex_unlock(&s_pool_mutex);
+}
+
+uindex_t MCThreadPoolGetConcurrency(void)
+{
+	pthread_mutex_lock(&s_pool_mutex);
+	if (!s_pool_started)
+		MCThreadPoolStart();
+	pthread_mutex_unlock(&s_pool_mutex);
+
+	return s_pool_worker_count + 1;
+}
+
+#else
+
+// The mobile platforms (iOS and Android) have no pool - the work is run in
+// turn on the calling thread.
+
+void MCThreadPoolRun(uindex_t p_count, MCThreadPoolCallback p_callback, void *p_context)
+{
+	for(uindex_t i = 0; i < p_count; i++)
+		p_callback(p_context, i);
+}
+
+uindex_t MCThreadPoolGetConcurrency(void)
+{
+	return 1;
+}
+
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
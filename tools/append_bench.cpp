@@ -0,0 +1,303 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program measures building a large string by repeated appends, as
+// 'put ... after tVar' in a loop does, through MCVariableValue::append_string
+// (engine/src/variablevalue.cpp). It times the buffer growth before (at most
+// VAR_APPEND_MAX more per reallocation, into a fresh block) and after (by half
+// the new size, with realloc) the change to geometric growth, for strings of
+// increasing size up to 500MB built from 13-byte appends. It also checks the
+// built string is correct, including when a value is appended to itself.
+//
+// The old growth is quadratic, so it is only run up to the size given by the
+// second argument (64MB by default).
+//
+// variablevalue.cpp can't be built outside the engine, so the functions below
+// are copies of the string-growing part of append_string - if that is changed,
+// change the copy here too.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o append_bench tools/append_bench.cpp && ./append_bench [max MB] [old max MB]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#define MAXUINT2 65535U
+#define MAXUINT4 4294967295U
+
+#define VAR_PAD 16
+#define VAR_MASK 0xFFFFFFF0
+#define VAR_APPEND_MAX (MAXUINT2 * 4)
+#define VAR_APPEND_GROWTH 2
+
+static inline uint32_t MCU_min(uint32_t one, uint32_t two) {return one > two ? two : one;}
+static inline uint32_t MCU_max(uint32_t one, uint32_t two) {return one > two ? one : two;}
+
+// The string part of MCVariableValue's strnum.
+struct BenchValue
+{
+	struct
+	{
+		const char *string;
+		uint32_t length;
+	} svalue;
+	struct
+	{
+		char *data;
+		uint32_t size;
+	} buffer;
+};
+
+// append_string before geometric growth.
+static bool bench_append_old(BenchValue& strnum, const char *t_new_string, uint32_t t_new_length)
+{
+	uint32_t t_new_size;
+	t_new_size = t_new_length + strnum . svalue . length;
+
+	if (t_new_size > strnum . buffer . size)
+	{
+		t_new_size = (t_new_size + VAR_PAD) & VAR_MASK;
+		if (strnum . buffer . data != NULL)
+			t_new_size += MCU_min(t_new_size, VAR_APPEND_MAX);
+
+		char *t_new_buffer;
+		t_new_buffer = (char *)malloc(t_new_size);
+		if (t_new_buffer != NULL)
+		{
+			memcpy(t_new_buffer, strnum . svalue . string, strnum . svalue . length);
+			memmove(t_new_buffer + strnum . svalue . length, t_new_string, t_new_length);
+
+			free(strnum . buffer . data);
+
+			strnum . buffer . data = t_new_buffer;
+			strnum . buffer . size = t_new_size;
+
+			strnum . svalue . string = t_new_buffer;
+			strnum . svalue . length += t_new_length;
+		}
+		else
+			return false;
+	}
+	else
+	{
+		memmove(strnum . buffer . data + strnum . svalue . length, t_new_string, t_new_length);
+		strnum . svalue . string = strnum . buffer . data;
+		strnum . svalue . length += t_new_length;
+	}
+
+	return true;
+}
+
+// append_string as it is now.
+static bool bench_append_new(BenchValue& strnum, const char *t_new_string, uint32_t t_new_length)
+{
+	uint32_t t_new_size;
+	t_new_size = t_new_length + strnum . svalue . length;
+	if (t_new_size < t_new_length)
+		return false;
+
+	if (t_new_size > strnum . buffer . size)
+	{
+		uint32_t t_capacity;
+		t_capacity = (t_new_size + VAR_PAD) & VAR_MASK;
+		if (strnum . buffer . data != NULL)
+			t_capacity = MCU_max(t_capacity, (t_new_size + MCU_min(t_new_size / VAR_APPEND_GROWTH, MAXUINT4 - t_new_size)) & VAR_MASK);
+		if (t_capacity < t_new_size)
+			t_capacity = t_new_size;
+
+		char *t_new_buffer, *t_old_buffer;
+		t_old_buffer = NULL;
+		if (strnum . buffer . size != 0 && strnum . svalue . string == strnum . buffer . data)
+		{
+			bool t_overlaps;
+			uint32_t t_overlap_offset;
+			t_overlaps = t_new_string >= strnum . buffer . data && t_new_string < strnum . buffer . data + strnum . buffer . size;
+			t_overlap_offset = t_overlaps ? t_new_string - strnum . buffer . data : 0;
+
+			t_new_buffer = (char *)realloc(strnum . buffer . data, t_capacity);
+			if (t_new_buffer == NULL)
+				return false;
+
+			if (t_overlaps)
+				t_new_string = t_new_buffer + t_overlap_offset;
+		}
+		else
+		{
+			t_new_buffer = (char *)malloc(t_capacity);
+			if (t_new_buffer == NULL)
+				return false;
+
+			memcpy(t_new_buffer, strnum . svalue . string, strnum . svalue . length);
+			t_old_buffer = strnum . buffer . data;
+		}
+
+		memmove(t_new_buffer + strnum . svalue . length, t_new_string, t_new_length);
+		free(t_old_buffer);
+
+		strnum . buffer . data = t_new_buffer;
+		strnum . buffer . size = t_capacity;
+
+		strnum . svalue . string = t_new_buffer;
+		strnum . svalue . length += t_new_length;
+	}
+	else
+	{
+		memmove(strnum . buffer . data + strnum . svalue . length, t_new_string, t_new_length);
+		strnum . svalue . string = strnum . buffer . data;
+		strnum . svalue . length += t_new_length;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef bool (*bench_append_function)(BenchValue&, const char *, uint32_t);
+
+static double bench_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+// A CSV-like row fragment, 13 bytes.
+static const char s_piece[] = "1234,abcdefg\n";
+#define BENCH_PIECE_LENGTH 13
+
+// Build a string of the given size, returning the time taken in seconds or
+// a negative value if an append failed or the result is wrong.
+static double bench_build(bench_append_function p_append, uint32_t p_size, uint32_t& r_reallocations)
+{
+	BenchValue t_value;
+	memset(&t_value, 0, sizeof(t_value));
+	t_value . svalue . string = "";
+
+	uint32_t t_reallocations;
+	t_reallocations = 0;
+
+	double t_start;
+	t_start = bench_now();
+	while(t_value . svalue . length + BENCH_PIECE_LENGTH <= p_size)
+	{
+		uint32_t t_old_size;
+		t_old_size = t_value . buffer . size;
+		if (!p_append(t_value, s_piece, BENCH_PIECE_LENGTH))
+		{
+			free(t_value . buffer . data);
+			return -1.0;
+		}
+		if (t_value . buffer . size != t_old_size)
+			t_reallocations += 1;
+	}
+	double t_time;
+	t_time = bench_now() - t_start;
+
+	bool t_correct;
+	t_correct = true;
+	for(uint32_t i = 0; t_correct && i < t_value . svalue . length; i += BENCH_PIECE_LENGTH)
+		t_correct = memcmp(t_value . svalue . string + i, s_piece, BENCH_PIECE_LENGTH) == 0;
+
+	free(t_value . buffer . data);
+
+	r_reallocations = t_reallocations;
+	return t_correct ? t_time : -1.0;
+}
+
+// Append a value to itself repeatedly ('put x after x'), which makes the new
+// code find the appended string again after the realloc.
+static bool bench_check_self_append(bench_append_function p_append)
+{
+	BenchValue t_value;
+	memset(&t_value, 0, sizeof(t_value));
+	t_value . svalue . string = "";
+	if (!p_append(t_value, "ab", 2))
+		return false;
+
+	for(int i = 0; i < 24; i++)
+		if (!p_append(t_value, t_value . svalue . string, t_value . svalue . length))
+			return false;
+
+	bool t_correct;
+	t_correct = t_value . svalue . length == 2 << 24;
+	for(uint32_t i = 0; t_correct && i < t_value . svalue . length; i += 2)
+		t_correct = t_value . svalue . string[i] == 'a' && t_value . svalue . string[i + 1] == 'b';
+
+	free(t_value . buffer . data);
+	return t_correct;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_max, t_old_max;
+	t_max = 500;
+	t_old_max = 64;
+	if (argc > 1)
+		t_max = (uint32_t)atoi(argv[1]);
+	if (argc > 2)
+		t_old_max = (uint32_t)atoi(argv[2]);
+
+	if (!bench_check_self_append(bench_append_old) || !bench_check_self_append(bench_append_new))
+	{
+		fprintf(stderr, "appending a value to itself gave the wrong result\n");
+		return 1;
+	}
+
+	printf("%-8s %14s %12s %14s %12s %12s\n", "size", "old seconds", "old reallocs", "new seconds", "new reallocs", "new ns/byte");
+
+	static const uint32_t s_sizes[] = { 8, 16, 32, 64, 125, 250, 500 };
+	for(uint32_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]) && s_sizes[i] <= t_max; i++)
+	{
+		uint32_t t_size;
+		t_size = s_sizes[i] << 20;
+
+		char t_old_time[32], t_old_reallocs[32];
+		strcpy(t_old_time, "-");
+		strcpy(t_old_reallocs, "-");
+		if (s_sizes[i] <= t_old_max)
+		{
+			uint32_t t_reallocations;
+			double t_time;
+			t_time = bench_build(bench_append_old, t_size, t_reallocations);
+			if (t_time < 0.0)
+			{
+				fprintf(stderr, "old append failed at %uMB\n", s_sizes[i]);
+				return 1;
+			}
+			sprintf(t_old_time, "%.3f", t_time);
+			sprintf(t_old_reallocs, "%u", t_reallocations);
+		}
+
+		uint32_t t_reallocations;
+		double t_time;
+		t_time = bench_build(bench_append_new, t_size, t_reallocations);
+		if (t_time < 0.0)
+		{
+			fprintf(stderr, "new append failed at %uMB\n", s_sizes[i]);
+			return 1;
+		}
+
+		char t_label[16];
+		sprintf(t_label, "%uMB", s_sizes[i]);
+		printf("%-8s %14s %12s %14.3f %12u %12.2f\n", t_label, t_old_time, t_old_reallocs, t_time, t_reallocations, t_time * 1e9 / t_size);
+	}
+
+	return 0;
+}
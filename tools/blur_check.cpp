@@ -0,0 +1,521 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program checks the blurs in engine/src/bitmapeffectblur.cpp, which the
+// shadow, glow and overlay effects in engine/src/bitmapeffect.cpp use. For
+// random input and output rects, radii, spreads and filters it checks:
+//
+//   - that each mask value is exactly the one given by summing the kernel (or
+//     box) over the input directly. The reference below takes the kernel, the
+//     box passes and the spread from the blur itself, but recomputes every
+//     sum from scratch with 64-bit totals.
+//
+//   - that blurring the output rect as a number of horizontal strips, each
+//     started with its own output rect as MCBitmapEffectRenderRows does, gives
+//     the same mask rows as blurring it whole.
+//
+//   - that the fast Gaussian blur gives the same mask with its SSE2 paths
+//     turned off as with them on.
+//
+// The input is allocated at exactly its size, so building with
+// -fsanitize=address also checks that the blurs only read the input rect.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o blur_check tools/blur_check.cpp && ./blur_check [cases]
+//
+// or, to check under the sanitizers:
+//
+//   g++ -g -O1 -fsanitize=address,undefined -fno-sanitize-recover=all -o blur_check tools/blur_check.cpp && ./blur_check
+//
+// Add -m32 to check the 32-bit build, which picks the SSE2 paths at runtime.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+// The blurs need only a few things from the engine's headers, so those are
+// defined here and the headers skipped.
+#define __PREFIX__
+#define __GLOBDEFS_H
+#define FILEDEFS_H
+#define OBJDEFS_H
+#define PARSEDEFS_H
+#define __MC_PACKED__
+
+typedef int16_t int2;
+typedef uint16_t uint2;
+typedef int32_t int4;
+typedef uint32_t uint4;
+
+struct MCRectangle
+{
+	int2 x, y;
+	uint2 width, height;
+};
+
+inline int4 MCU_min(int4 one, int4 two) {return one > two ? two : one;}
+inline uint4 MCU_min(uint4 one, uint4 two) {return one > two ? two : one;}
+inline int4 MCU_max(int4 one, int4 two) {return one > two ? one : two;}
+inline uint4 MCU_max(uint4 one, uint4 two) {return one > two ? one : two;}
+
+#include "../engine/src/bitmapeffectblur.cpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t s_seed = 1;
+
+static uint32_t check_random(void)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 8) ^ (s_seed << 16);
+}
+
+// A random blur case. The rects are in the plane, the input being where the
+// source layer's pixels are.
+struct CheckCase
+{
+	MCRectangle input;
+	MCRectangle output;
+	MCBitmapEffectBlurParameters params;
+	uint32_t *pixels;
+};
+
+// Fills the input with a mix of solid, transparent and random alpha, in runs
+// so that there are edges for the blur to soften.
+static void check_make_case(CheckCase& r_case)
+{
+	r_case . input . x = (int2)(check_random() % 41) - 20;
+	r_case . input . y = (int2)(check_random() % 41) - 20;
+	r_case . input . width = 1 + check_random() % 80;
+	r_case . input . height = 1 + check_random() % 80;
+
+	switch(check_random() % 4)
+	{
+	case 0:
+		r_case . params . radius = 0;
+		break;
+	case 1:
+		r_case . params . radius = 1 + check_random() % 80;
+		break;
+	default:
+		r_case . params . radius = 1 + check_random() % 24;
+		break;
+	}
+	r_case . params . spread = check_random() % 2 == 0 ? 0 : check_random() & 0xff;
+	r_case . params . filter = (MCBitmapEffectFilter)(check_random() % 4);
+
+	// The output is anywhere from well inside the input to beyond the blur's
+	// reach of it.
+	int32_t t_reach;
+	t_reach = r_case . params . radius + 10;
+	r_case . output . x = r_case . input . x - t_reach + (int2)(check_random() % (r_case . input . width + 2 * t_reach));
+	r_case . output . y = r_case . input . y - t_reach + (int2)(check_random() % (r_case . input . height + 2 * t_reach));
+	r_case . output . x -= check_random() % 30;
+	r_case . output . y -= check_random() % 30;
+	r_case . output . width = 1 + check_random() % 100;
+	r_case . output . height = 1 + check_random() % 100;
+
+	uint32_t t_count;
+	t_count = r_case . input . width * r_case . input . height;
+	r_case . pixels = new uint32_t[t_count];
+
+	uint32_t t_alpha, t_run;
+	t_alpha = 0;
+	t_run = 0;
+	for(uint32_t i = 0; i < t_count; i++)
+	{
+		if (t_run == 0)
+		{
+			switch(check_random() % 3)
+			{
+			case 0:
+				t_alpha = 0;
+				break;
+			case 1:
+				t_alpha = 255;
+				break;
+			default:
+				t_alpha = 256;
+				break;
+			}
+			t_run = 1 + check_random() % 20;
+		}
+		t_run -= 1;
+
+		uint32_t t_pixel_alpha;
+		t_pixel_alpha = t_alpha == 256 ? check_random() & 0xff : t_alpha;
+		r_case . pixels[i] = (t_pixel_alpha << 24) | (check_random() & 0xffffff);
+	}
+}
+
+// Blur the given rows of the case's output rect, as MCBitmapEffectRenderRows
+// does, into the rows of p_mask.
+static bool check_blur_rows(const CheckCase& p_case, int32_t p_first_row, int32_t p_row_count, uint8_t *p_mask)
+{
+	MCRectangle t_rect;
+	t_rect = p_case . output;
+	t_rect . y += p_first_row;
+	t_rect . height = p_row_count;
+
+	// The blur is given a pointer to where the output rect's top-left would be
+	// in the input, even if that is outside it.
+	uint32_t *t_src;
+	t_src = p_case . pixels + (intptr_t)(t_rect . y - p_case . input . y) * p_case . input . width + (t_rect . x - p_case . input . x);
+
+	MCBitmapEffectBlurRef t_blur;
+	if (!MCBitmapEffectBlurBegin(p_case . params, p_case . input, t_rect, t_src, p_case . input . width, t_blur))
+		return false;
+
+	for(int32_t y = 0; y < p_row_count; y++)
+		MCBitmapEffectBlurContinue(t_blur, p_mask + y * p_case . output . width);
+
+	MCBitmapEffectBlurEnd(t_blur);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Inclusive prefix sums of a region of values, so any rect of it can be summed.
+// Columns and rows before the region's start sum to zero.
+struct CheckSums
+{
+	int32_t left, top, right, bottom;
+	int64_t *sums;
+
+	int64_t At(int32_t x, int32_t y) const
+	{
+		if (x < left || y < top)
+			return 0;
+		return sums[(y - top) * (right - left) + (x - left)];
+	}
+
+	// The total of the rect (x0, y0) - (x1, y1) inclusive, computed as the
+	// blurs do from the four corners - so an empty rect can be negative.
+	int64_t Sum(int32_t x0, int32_t y0, int32_t x1, int32_t y1) const
+	{
+		return At(x1, y1) - At(x0 - 1, y1) - At(x1, y0 - 1) + At(x0 - 1, y0 - 1);
+	}
+};
+
+static void check_make_sums(CheckSums& r_sums, int32_t p_left, int32_t p_top, int32_t p_right, int32_t p_bottom, const uint32_t *p_values)
+{
+	r_sums . left = p_left;
+	r_sums . top = p_top;
+	r_sums . right = p_right;
+	r_sums . bottom = p_bottom;
+
+	int32_t t_width;
+	t_width = p_right - p_left;
+	r_sums . sums = new int64_t[t_width * (p_bottom - p_top)];
+	for(int32_t y = 0; y < p_bottom - p_top; y++)
+	{
+		int64_t t_row;
+		t_row = 0;
+		for(int32_t x = 0; x < t_width; x++)
+		{
+			t_row += p_values[y * t_width + x];
+			r_sums . sums[y * t_width + x] = t_row + (y > 0 ? r_sums . sums[(y - 1) * t_width + x] : 0);
+		}
+	}
+}
+
+// The alpha of the input at the given point, relative to the output rect.
+static uint32_t check_alpha(const CheckCase& p_case, int32_t x, int32_t y)
+{
+	int32_t t_x, t_y;
+	t_x = x + p_case . output . x - p_case . input . x;
+	t_y = y + p_case . output . y - p_case . input . y;
+	assert(t_x >= 0 && t_x < p_case . input . width && t_y >= 0 && t_y < p_case . input . height);
+	return p_case . pixels[t_y * p_case . input . width + t_x] >> 24;
+}
+
+// The mask when the blur has nothing to do - the input alpha where there is
+// input, and 0 elsewhere.
+static void check_reference_none(const CheckCase& p_case, uint8_t *p_mask)
+{
+	int32_t t_left, t_top, t_right, t_bottom;
+	t_left = p_case . input . x - p_case . output . x;
+	t_top = p_case . input . y - p_case . output . y;
+	t_right = t_left + p_case . input . width;
+	t_bottom = t_top + p_case . input . height;
+
+	for(int32_t y = 0; y < p_case . output . height; y++)
+		for(int32_t x = 0; x < p_case . output . width; x++)
+			p_mask[y * p_case . output . width + x] = x >= t_left && x < t_right && y >= t_top && y < t_bottom ? check_alpha(p_case, x, y) : 0;
+}
+
+static void check_reference_fast_gaussian(const CheckCase& p_case, uint8_t *p_mask)
+{
+	// Take the kernel from a blur of the same parameters.
+	MCBitmapEffectBlurRef t_blur_ref;
+	if (!MCBitmapEffectBlurBegin(p_case . params, p_case . input, p_case . output, p_case . pixels, p_case . input . width, t_blur_ref))
+		abort();
+
+	MCBitmapEffectFastGaussianBlur *t_blur;
+	t_blur = static_cast<MCBitmapEffectFastGaussianBlur *>(t_blur_ref);
+
+	if (t_blur -> kernel == NULL)
+	{
+		MCBitmapEffectBlurEnd(t_blur_ref);
+		check_reference_none(p_case, p_mask);
+		return;
+	}
+
+	int32_t r, t_width, t_height;
+	r = t_blur -> radius;
+	t_width = p_case . output . width;
+	t_height = p_case . output . height;
+
+	int32_t t_left, t_top, t_right, t_bottom;
+	t_left = p_case . input . x - p_case . output . x;
+	t_top = p_case . input . y - p_case . output . y;
+	t_right = t_left + p_case . input . width;
+	t_bottom = t_top + p_case . input . height;
+
+	for(int32_t y = 0; y < t_height; y++)
+		for(int32_t x = 0; x < t_width; x++)
+		{
+			// Outside the vertical reach of the input the range is empty.
+			uint64_t t_total;
+			t_total = 0;
+			for(int32_t k = MCU_max(-r, t_top - y); k <= MCU_min(t_bottom - y - 1, r); k++)
+			{
+				uint64_t t_row;
+				t_row = 0;
+				for(int32_t j = MCU_max(-r, t_left - x); j <= MCU_min(t_right - x - 1, r); j++)
+					t_row += (uint64_t)t_blur -> kernel[r + j] * check_alpha(p_case, x + j, y + k);
+				if (t_row > 0xFFFFFFFF)
+					t_row = 0xFFFFFFFF;
+
+				t_total += (uint64_t)t_blur -> kernel[r + k] * (t_row >> 16);
+			}
+
+			p_mask[y * t_width + x] = t_total < 0x1000000 ? (uint8_t)(t_total >> 16) : 0xFF;
+		}
+
+	MCBitmapEffectBlurEnd(t_blur_ref);
+}
+
+static void check_reference_box(const CheckCase& p_case, uint8_t *p_mask)
+{
+	// Take the pass layout and spread from a blur of the same parameters.
+	MCBitmapEffectBlurRef t_blur_ref;
+	if (!MCBitmapEffectBlurBegin(p_case . params, p_case . input, p_case . output, p_case . pixels, p_case . input . width, t_blur_ref))
+		abort();
+
+	MCBitmapEffectBoxBlur *t_blur;
+	t_blur = static_cast<MCBitmapEffectBoxBlur *>(t_blur_ref);
+
+	if (t_blur -> m_passes == 0)
+	{
+		MCBitmapEffectBlurEnd(t_blur_ref);
+		check_reference_none(p_case, p_mask);
+		return;
+	}
+
+	// The first pass's values are the input alpha over its region, and each
+	// later pass's are the average of the previous pass's over its window,
+	// clipped to the previous pass's region.
+	CheckSums t_sums;
+	memset(&t_sums, 0, sizeof(t_sums));
+	for(uint32_t p = 0; p < t_blur -> m_passes; p++)
+	{
+		const MCBitmapEffectBoxBlurPassInfo& t_pass = t_blur -> pass_info[p];
+
+		uint32_t *t_values;
+		t_values = new uint32_t[t_pass . width * t_pass . height];
+		for(int32_t y = t_pass . top; y < t_pass . bottom; y++)
+			for(int32_t x = t_pass . left; x < t_pass . right; x++)
+			{
+				uint32_t t_value;
+				if (p == 0)
+					t_value = check_alpha(p_case, x, y);
+				else
+				{
+					const MCBitmapEffectBoxBlurPassInfo& t_prev = t_blur -> pass_info[p - 1];
+					int64_t t_sum;
+					t_sum = t_sums . Sum(x + MCU_max(-t_prev . radius, t_prev . left - x), y + MCU_max(-t_prev . radius, t_prev . top - y),
+										 x + MCU_min(t_prev . right - x - 1, t_prev . radius), y + MCU_min(t_prev . bottom - y - 1, t_prev . radius));
+					t_value = (uint32_t)t_sum / (uint32_t)(t_prev . window * t_prev . window);
+				}
+				t_values[(y - t_pass . top) * t_pass . width + (x - t_pass . left)] = t_value;
+			}
+
+		delete[] t_sums . sums;
+		check_make_sums(t_sums, t_pass . left, t_pass . top, t_pass . right, t_pass . bottom, t_values);
+		delete[] t_values;
+	}
+
+	const MCBitmapEffectBoxBlurPassInfo& t_last = t_blur -> pass_info[t_blur -> m_passes - 1];
+
+	int32_t t_area, t_max_val;
+	t_area = t_last . window * t_last . window;
+	if (t_blur -> spread != 0)
+		t_max_val = 0x100 * t_area * 256 / t_blur -> spread;
+	else
+		t_max_val = 0;
+
+	int32_t r, t_width;
+	r = t_last . radius;
+	t_width = p_case . output . width;
+	for(int32_t y = 0; y < p_case . output . height; y++)
+		for(int32_t x = 0; x < t_width; x++)
+		{
+			uint8_t t_mask;
+			t_mask = 0;
+			if (y >= t_last . top - r && y < t_last . bottom + r &&
+				x >= t_last . left - r && x < t_last . right + r + 1)
+			{
+				int32_t t_sum;
+				t_sum = (int32_t)t_sums . Sum(x + MCU_max(-r, t_last . left - x), y + MCU_max(-r, t_last . top - y),
+											  x + MCU_min(t_last . right - x - 1, r), y + MCU_min(t_last . bottom - y - 1, r));
+				if (t_sum <= t_max_val)
+					t_mask = t_sum * t_blur -> spread / (t_area * 256);
+				else
+					t_mask = 0xFF;
+			}
+			p_mask[y * t_width + x] = t_mask;
+		}
+
+	delete[] t_sums . sums;
+
+	MCBitmapEffectBlurEnd(t_blur_ref);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *s_filter_names[] = { "fast gaussian", "one pass box", "two pass box", "three pass box" };
+
+static void check_report(const char *p_what, const CheckCase& p_case, int32_t p_x, int32_t p_y, uint8_t p_expected, uint8_t p_got)
+{
+	fprintf(stderr, "%s: %s, radius %d, spread %u, input %d,%d %ux%u, output %d,%d %ux%u: mask at %d,%d is %u, expected %u\n",
+			p_what, s_filter_names[p_case . params . filter], p_case . params . radius, p_case . params . spread,
+			p_case . input . x, p_case . input . y, p_case . input . width, p_case . input . height,
+			p_case . output . x, p_case . output . y, p_case . output . width, p_case . output . height,
+			p_x, p_y, p_got, p_expected);
+}
+
+static bool check_masks(const char *p_what, const CheckCase& p_case, const uint8_t *p_expected, const uint8_t *p_got)
+{
+	for(int32_t y = 0; y < p_case . output . height; y++)
+		for(int32_t x = 0; x < p_case . output . width; x++)
+		{
+			int32_t i;
+			i = y * p_case . output . width + x;
+			if (p_expected[i] != p_got[i])
+			{
+				check_report(p_what, p_case, x, y, p_expected[i], p_got[i]);
+				return false;
+			}
+		}
+	return true;
+}
+
+static bool check_case(const CheckCase& p_case)
+{
+	uint32_t t_count;
+	t_count = p_case . output . width * p_case . output . height;
+
+	uint8_t *t_whole, *t_strips, *t_reference;
+	t_whole = new uint8_t[t_count];
+	t_strips = new uint8_t[t_count];
+	t_reference = new uint8_t[t_count];
+
+	bool t_success;
+	t_success = check_blur_rows(p_case, 0, p_case . output . height, t_whole);
+
+	// The reference.
+	if (t_success)
+	{
+		if (p_case . params . filter == kMCBitmapEffectFilterFastGaussian)
+			check_reference_fast_gaussian(p_case, t_reference);
+		else
+			check_reference_box(p_case, t_reference);
+		t_success = check_masks("reference", p_case, t_reference, t_whole);
+	}
+
+#ifdef BLUR_USE_SSE2
+	// The scalar paths.
+	if (t_success && s_blur_use_sse2)
+	{
+		s_blur_use_sse2 = false;
+		t_success = check_blur_rows(p_case, 0, p_case . output . height, t_strips);
+		s_blur_use_sse2 = true;
+		if (t_success)
+			t_success = check_masks("scalar", p_case, t_whole, t_strips);
+	}
+#endif
+
+	// Strips of random height, from a single row up to the whole rect.
+	if (t_success)
+	{
+		memset(t_strips, 0xAA, t_count);
+
+		int32_t t_first_row;
+		t_first_row = 0;
+		while(t_success && t_first_row < p_case . output . height)
+		{
+			int32_t t_row_count;
+			t_row_count = MCU_min(p_case . output . height - t_first_row, 1 + (int32_t)(check_random() % p_case . output . height));
+			t_success = check_blur_rows(p_case, t_first_row, t_row_count, t_strips + t_first_row * p_case . output . width);
+			t_first_row += t_row_count;
+		}
+
+		if (t_success)
+			t_success = check_masks("strips", p_case, t_whole, t_strips);
+	}
+
+	delete[] t_reference;
+	delete[] t_strips;
+	delete[] t_whole;
+
+	return t_success;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_cases;
+	t_cases = argc > 1 ? strtoul(argv[1], NULL, 10) : 3000;
+
+	uint32_t t_filter_counts[4] = { 0, 0, 0, 0 };
+	for(uint32_t i = 0; i < t_cases; i++)
+	{
+		CheckCase t_case;
+		check_make_case(t_case);
+
+		bool t_success;
+		t_success = check_case(t_case);
+		delete[] t_case . pixels;
+
+		if (!t_success)
+		{
+			fprintf(stderr, "case %u failed\n", i);
+			return 1;
+		}
+
+		t_filter_counts[t_case . params . filter] += 1;
+	}
+
+	for(uint32_t i = 0; i < 4; i++)
+		printf("%s: %u cases matched the reference and their strips\n", s_filter_names[i], t_filter_counts[i]);
+
+	return 0;
+}
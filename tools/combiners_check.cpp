@@ -0,0 +1,167 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program checks that the SSE2 paths of the source-over combiners in
+// engine/src/combiners.cpp give exactly the same pixels as the scalar code. It
+// runs each combiner on random layers with the SSE2 paths turned off and then
+// on, and compares the results.
+//
+// To build and run it on Linux, from the root of the repository:
+//
+//   g++ -O2 -o combiners_check tools/combiners_check.cpp && ./combiners_check
+//
+// Add -m32 to check the 32-bit build, which picks the SSE2 paths at runtime.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// The combiners need nothing from the engine's prefix header, other than the
+// standard integer types.
+#define __PREFIX__
+#include "../engine/src/combiners.cpp"
+
+// The transparent ink compares against the engine's background colour.
+uint32_t g_current_background_colour = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t s_seed = 1;
+
+static uint32_t check_random(void)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 8) ^ (s_seed << 16);
+}
+
+// Returns a random pixel. If p_premultiplied is true, the color components are
+// no greater than the alpha (as blendSrcOver expects). Transparent and opaque
+// pixels are made more likely as the combiners treat them specially.
+static uint32_t check_random_pixel(bool p_premultiplied)
+{
+	uint32_t t_alpha;
+	switch(check_random() % 4)
+	{
+	case 0:
+		t_alpha = 0;
+		break;
+	case 1:
+		t_alpha = 255;
+		break;
+	default:
+		t_alpha = check_random() & 0xff;
+		break;
+	}
+
+	uint32_t t_pixel;
+	t_pixel = t_alpha << 24;
+	for(int i = 0; i < 3; i++)
+	{
+		uint32_t t_component;
+		t_component = check_random() & 0xff;
+		if (p_premultiplied)
+			t_component = t_alpha == 0 ? 0 : t_component % (t_alpha + 1);
+		t_pixel |= t_component << (i * 8);
+	}
+
+	return t_pixel;
+}
+
+static bool check_combiner(const char *p_name, surface_combiner_t p_combiner, bool p_premultiplied, uint32_t p_runs)
+{
+	for(uint32_t t_run = 0; t_run < p_runs; t_run++)
+	{
+		// Widths cover a few groups of four pixels and every remainder, and
+		// the strides are padded so rows don't run into each other.
+		uint32_t t_width, t_height, t_dst_pad, t_src_pad;
+		t_width = 1 + check_random() % 37;
+		t_height = 1 + check_random() % 4;
+		t_dst_pad = check_random() % 3;
+		t_src_pad = check_random() % 3;
+
+		uint8_t t_opacity;
+		switch(check_random() % 4)
+		{
+		case 0:
+			t_opacity = 255;
+			break;
+		case 1:
+			t_opacity = 1 + check_random() % 254;
+			break;
+		default:
+			t_opacity = check_random() & 0xff;
+			break;
+		}
+
+		uint32_t t_dst_stride, t_src_stride;
+		t_dst_stride = t_width + t_dst_pad;
+		t_src_stride = t_width + t_src_pad;
+
+		uint32_t t_src[41 * 4], t_dst[41 * 4], t_scalar_dst[41 * 4], t_vector_dst[41 * 4];
+		for(uint32_t i = 0; i < t_src_stride * t_height; i++)
+			t_src[i] = check_random_pixel(p_premultiplied);
+		for(uint32_t i = 0; i < t_dst_stride * t_height; i++)
+			t_dst[i] = check_random_pixel(true);
+
+		memcpy(t_scalar_dst, t_dst, sizeof(t_dst));
+		memcpy(t_vector_dst, t_dst, sizeof(t_dst));
+
+		s_combiners_use_sse2 = false;
+		p_combiner(t_scalar_dst, t_dst_stride * 4, t_src, t_src_stride * 4, t_width, t_height, t_opacity);
+
+		s_combiners_use_sse2 = true;
+		p_combiner(t_vector_dst, t_dst_stride * 4, t_src, t_src_stride * 4, t_width, t_height, t_opacity);
+
+		if (memcmp(t_scalar_dst, t_vector_dst, sizeof(t_dst)) != 0)
+		{
+			fprintf(stderr, "%s: mismatch (width %u, height %u, opacity %u)\n", p_name, t_width, t_height, t_opacity);
+			return false;
+		}
+	}
+
+	printf("%s: %u runs matched\n", p_name, p_runs);
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef COMBINERS_USE_SSE2
+	if (!s_combiners_use_sse2)
+	{
+		printf("This CPU doesn't have SSE2, so there is nothing to check.\n");
+		return 0;
+	}
+
+	uint32_t t_runs;
+	t_runs = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+	bool t_success;
+	t_success = true;
+	if (!check_combiner("blendSrcOver", surface_combine_blendSrcOver, true, t_runs))
+		t_success = false;
+	if (!check_combiner("blendSrcOver_masked", surface_combine_blendSrcOver_masked, false, t_runs))
+		t_success = false;
+	if (!check_combiner("blendSrcOver_solid", surface_combine_blendSrcOver_solid, false, t_runs))
+		t_success = false;
+
+	return t_success ? 0 : 1;
+#else
+	printf("This build of the combiners has no SSE2 paths, so there is nothing to check.\n");
+	return 0;
+#endif
+}
@@ -0,0 +1,264 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program measures the frame time of compositing a 3840x2160 frame from
+// 32x32 tiles, the way the tile cache's software compositor does it when it
+// composites in bands (see MCTileCacheDoCompositeBands in engine/src/tilecache.cpp),
+// at 1, 2, 4 and 8 threads. The frame is made of three layers covering the
+// whole frame: opaque scenery, a sprite at partial opacity and a sprite whose
+// tiles are mostly transparent. Each band replays every layer clipped to its
+// rows, using the engine's combiners.
+//
+// Only compositing is measured - rendering the tiles is not done in parallel.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o composite_bench tools/composite_bench.cpp -lpthread && ./composite_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+// The combiners need nothing from the engine's prefix header, other than the
+// standard integer types.
+#define __PREFIX__
+#include "../engine/src/combiners.cpp"
+
+// The transparent ink compares against the engine's background colour.
+uint32_t g_current_background_colour = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The same constants as the tile cache uses.
+#define kBenchTileSize 32
+#define kBenchMinimumBandHeight 32
+
+#define kBenchFrameWidth 3840
+#define kBenchFrameHeight 2160
+#define kBenchLayerCount 3
+
+struct BenchLayer
+{
+	uint8_t opacity;
+	uint32_t **tiles;
+};
+
+struct BenchFrame
+{
+	uint32_t *bits;
+	int32_t stride;
+	BenchLayer layers[kBenchLayerCount];
+	int32_t tiles_across;
+	int32_t tiles_down;
+};
+
+struct BenchBands
+{
+	BenchFrame *frame;
+	int32_t band_height;
+	uint32_t band_count;
+
+	pthread_mutex_t lock;
+	uint32_t next_band;
+};
+
+static void bench_composite_band(BenchFrame *p_frame, int32_t p_top, int32_t p_bottom)
+{
+	for(int32_t l = 0; l < kBenchLayerCount; l++)
+	{
+		BenchLayer *t_layer;
+		t_layer = &p_frame -> layers[l];
+
+		for(int32_t ty = p_top / kBenchTileSize; ty * kBenchTileSize < p_bottom; ty++)
+		{
+			// Clip the row of tiles to the band.
+			int32_t t_top, t_bottom;
+			t_top = ty * kBenchTileSize;
+			t_bottom = t_top + kBenchTileSize;
+			if (t_top < p_top)
+				t_top = p_top;
+			if (t_bottom > p_bottom)
+				t_bottom = p_bottom;
+
+			for(int32_t tx = 0; tx < p_frame -> tiles_across; tx++)
+			{
+				uint32_t *t_tile;
+				t_tile = t_layer -> tiles[ty * p_frame -> tiles_across + tx];
+
+				uint8_t *t_dst;
+				t_dst = (uint8_t *)p_frame -> bits + p_frame -> stride * t_top + tx * kBenchTileSize * sizeof(uint32_t);
+
+				uint32_t *t_src;
+				t_src = t_tile + kBenchTileSize * (t_top - ty * kBenchTileSize);
+
+				surface_combine_blendSrcOver(t_dst, p_frame -> stride, t_src, kBenchTileSize * sizeof(uint32_t), kBenchTileSize, t_bottom - t_top, t_layer -> opacity);
+			}
+		}
+	}
+}
+
+static void *bench_worker(void *p_context)
+{
+	BenchBands *t_bands;
+	t_bands = (BenchBands *)p_context;
+
+	for(;;)
+	{
+		uint32_t t_band;
+		pthread_mutex_lock(&t_bands -> lock);
+		t_band = t_bands -> next_band++;
+		pthread_mutex_unlock(&t_bands -> lock);
+
+		if (t_band >= t_bands -> band_count)
+			break;
+
+		int32_t t_top, t_bottom;
+		t_top = t_band * t_bands -> band_height;
+		t_bottom = t_top + t_bands -> band_height;
+		if (t_bottom > kBenchFrameHeight)
+			t_bottom = kBenchFrameHeight;
+
+		bench_composite_band(t_bands -> frame, t_top, t_bottom);
+	}
+
+	return NULL;
+}
+
+static double bench_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+// Composite one frame on the given number of threads (including the caller),
+// splitting it into bands as the tile cache does, and return the time taken.
+static double bench_frame(BenchFrame *p_frame, uint32_t p_threads)
+{
+	BenchBands t_bands;
+	t_bands . frame = p_frame;
+	t_bands . next_band = 0;
+	pthread_mutex_init(&t_bands . lock, NULL);
+
+	if (p_threads == 1)
+	{
+		t_bands . band_height = kBenchFrameHeight;
+		t_bands . band_count = 1;
+	}
+	else
+	{
+		t_bands . band_height = (kBenchFrameHeight + p_threads * 2 - 1) / (p_threads * 2);
+		if (t_bands . band_height < kBenchMinimumBandHeight)
+			t_bands . band_height = kBenchMinimumBandHeight;
+		t_bands . band_count = (kBenchFrameHeight + t_bands . band_height - 1) / t_bands . band_height;
+	}
+
+	double t_start;
+	t_start = bench_now();
+
+	pthread_t t_workers[8];
+	for(uint32_t i = 1; i < p_threads; i++)
+		pthread_create(&t_workers[i], NULL, bench_worker, &t_bands);
+
+	bench_worker(&t_bands);
+
+	for(uint32_t i = 1; i < p_threads; i++)
+		pthread_join(t_workers[i], NULL);
+
+	double t_time;
+	t_time = bench_now() - t_start;
+
+	pthread_mutex_destroy(&t_bands . lock);
+
+	return t_time;
+}
+
+static int bench_compare_times(const void *a, const void *b)
+{
+	double x, y;
+	x = *(const double *)a;
+	y = *(const double *)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+int main(int argc, char *argv[])
+{
+	BenchFrame t_frame;
+	t_frame . stride = kBenchFrameWidth * sizeof(uint32_t);
+	t_frame . bits = (uint32_t *)malloc(t_frame . stride * kBenchFrameHeight);
+	t_frame . tiles_across = kBenchFrameWidth / kBenchTileSize;
+	t_frame . tiles_down = (kBenchFrameHeight + kBenchTileSize - 1) / kBenchTileSize;
+	memset(t_frame . bits, 0, t_frame . stride * kBenchFrameHeight);
+
+	// The layers' tiles are filled with premultiplied pixels: the scenery is
+	// opaque, the second layer half transparent and the third mostly clear.
+	srand(1);
+	for(int32_t l = 0; l < kBenchLayerCount; l++)
+	{
+		uint32_t t_tile_count;
+		t_tile_count = t_frame . tiles_across * t_frame . tiles_down;
+
+		t_frame . layers[l] . opacity = l == 1 ? 160 : 255;
+		t_frame . layers[l] . tiles = (uint32_t **)malloc(t_tile_count * sizeof(uint32_t *));
+		for(uint32_t t = 0; t < t_tile_count; t++)
+		{
+			uint32_t *t_tile;
+			t_tile = (uint32_t *)malloc(kBenchTileSize * kBenchTileSize * sizeof(uint32_t));
+			for(int32_t i = 0; i < kBenchTileSize * kBenchTileSize; i++)
+			{
+				uint32_t t_alpha;
+				if (l == 0)
+					t_alpha = 255;
+				else if (l == 1)
+					t_alpha = 128;
+				else
+					t_alpha = rand() % 8 == 0 ? 200 : 0;
+
+				uint32_t t_pixel;
+				t_pixel = t_alpha << 24;
+				for(int32_t c = 0; c < 3; c++)
+					t_pixel |= (t_alpha == 0 ? 0 : rand() % (t_alpha + 1)) << (c * 8);
+				t_tile[i] = t_pixel;
+			}
+			t_frame . layers[l] . tiles[t] = t_tile;
+		}
+	}
+
+	uint32_t t_frames;
+	t_frames = argc > 1 ? strtoul(argv[1], NULL, 10) : 20;
+	if (t_frames == 0)
+		t_frames = 1;
+
+	double *t_times;
+	t_times = (double *)malloc(t_frames * sizeof(double));
+
+	static const uint32_t s_thread_counts[] = { 1, 2, 4, 8 };
+	for(uint32_t i = 0; i < sizeof(s_thread_counts) / sizeof(s_thread_counts[0]); i++)
+	{
+		// One frame to warm up, then report the median.
+		bench_frame(&t_frame, s_thread_counts[i]);
+		for(uint32_t f = 0; f < t_frames; f++)
+			t_times[f] = bench_frame(&t_frame, s_thread_counts[i]);
+		qsort(t_times, t_frames, sizeof(double), bench_compare_times);
+
+		printf("%u thread%s: %.2f ms per frame\n", s_thread_counts[i], s_thread_counts[i] == 1 ? "" : "s", t_times[t_frames / 2] * 1000.0);
+	}
+
+	return 0;
+}
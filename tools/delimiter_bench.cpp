@@ -0,0 +1,282 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program measures the throughput of the delimiter scans used by chunks,
+// 'repeat for each' and split (MCU_findchar and MCU_countchar in
+// engine/src/mcutility.cpp) against the byte-at-a-time loops they replaced.
+// For a range of line lengths it times, over 64MB of text:
+//
+//   - finding each line delimiter in turn with a byte loop, with memchr (what
+//     MCU_findchar uses except in MSVC builds) and with the SSE2 loop that
+//     MCU_findchar uses in MSVC builds
+//   - counting line delimiters with a byte loop and with the SSE2 kernel of
+//     MCU_countchar
+//   - the row and column scan of split_column, with a byte loop and with
+//     MCU_findchar
+//
+// mcutility.cpp can't be built outside the engine, so the kernels below are
+// copies of those in it - if they are changed there, change them here too.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o delimiter_bench tools/delimiter_bench.cpp && ./delimiter_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BENCH_USE_SSE2
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The loop that split_column's strchr_limit used to be.
+static const char *bench_findchar_bytewise(const char *p_start, const char *p_end, char p_target)
+{
+	while(p_start < p_end)
+	{
+		if (*p_start == p_target)
+			return p_start;
+		p_start += 1;
+	}
+	return p_end;
+}
+
+// MCU_findchar, other than in MSVC builds.
+static const char *bench_findchar_memchr(const char *p_start, const char *p_end, char p_target)
+{
+	const char *t_found;
+	t_found = (const char *)memchr(p_start, p_target, p_end - p_start);
+	if (t_found == NULL)
+		return p_end;
+	return t_found;
+}
+
+#ifdef BENCH_USE_SSE2
+static inline uint32_t bench_lowestbit(uint32_t p_mask)
+{
+	return __builtin_ctz(p_mask);
+}
+
+// MCU_findchar in MSVC builds.
+static const char *bench_findchar_sse2(const char *p_start, const char *p_end, char p_target)
+{
+	const char *t_ptr;
+	t_ptr = p_start;
+
+	while (t_ptr < p_end && ((uintptr_t)t_ptr & 15) != 0)
+	{
+		if (*t_ptr == p_target)
+			return t_ptr;
+		t_ptr++;
+	}
+
+	__m128i t_pattern;
+	t_pattern = _mm_set1_epi8(p_target);
+	while (p_end - t_ptr >= 32)
+	{
+		uint32_t t_mask;
+		t_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)t_ptr), t_pattern)) |
+					(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)(t_ptr + 16)), t_pattern)) << 16);
+		if (t_mask != 0)
+			return t_ptr + bench_lowestbit(t_mask);
+		t_ptr += 32;
+	}
+
+	while (t_ptr < p_end)
+	{
+		if (*t_ptr == p_target)
+			return t_ptr;
+		t_ptr++;
+	}
+
+	return p_end;
+}
+#endif
+
+static uint32_t bench_countchar_bytewise(const char *p_start, const char *p_end, char p_target)
+{
+	uint32_t t_count;
+	t_count = 0;
+	while(p_start < p_end)
+		if (*p_start++ == p_target)
+			t_count++;
+	return t_count;
+}
+
+// MCU_countchar.
+static uint32_t bench_countchar(const char *p_start, const char *p_end, char p_target)
+{
+	const char *t_ptr;
+	t_ptr = p_start;
+
+	uint32_t t_count;
+	t_count = 0;
+
+#ifdef BENCH_USE_SSE2
+	while (t_ptr < p_end && ((uintptr_t)t_ptr & 15) != 0)
+	{
+		if (*t_ptr == p_target)
+			t_count++;
+		t_ptr++;
+	}
+
+	__m128i t_pattern, t_zero;
+	t_pattern = _mm_set1_epi8(p_target);
+	t_zero = _mm_setzero_si128();
+	while (p_end - t_ptr >= 16)
+	{
+		uint32_t t_blocks;
+		t_blocks = (uint32_t)((p_end - t_ptr) / 16);
+		if (t_blocks > 255)
+			t_blocks = 255;
+
+		__m128i t_accum;
+		t_accum = t_zero;
+		while (t_blocks-- > 0)
+		{
+			t_accum = _mm_sub_epi8(t_accum, _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)t_ptr), t_pattern));
+			t_ptr += 16;
+		}
+
+		__m128i t_sums;
+		t_sums = _mm_sad_epu8(t_accum, t_zero);
+		t_count += _mm_cvtsi128_si32(t_sums) + _mm_cvtsi128_si32(_mm_srli_si128(t_sums, 8));
+	}
+#endif
+
+	while (t_ptr < p_end)
+	{
+		if (*t_ptr == p_target)
+			t_count++;
+		t_ptr++;
+	}
+
+	return t_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef const char *(*bench_finder_t)(const char *, const char *, char);
+
+// Finds every line in turn, as 'repeat for each line' does.
+static uint32_t bench_lines(bench_finder_t p_finder, const char *p_text, uint32_t p_length)
+{
+	const char *t_ptr, *t_end;
+	t_ptr = p_text;
+	t_end = p_text + p_length;
+
+	uint32_t t_lines;
+	t_lines = 0;
+	while(t_ptr < t_end)
+	{
+		t_ptr = p_finder(t_ptr, t_end, '\n') + 1;
+		t_lines++;
+	}
+	return t_lines;
+}
+
+// Finds every row and then every cell in it, as split_column does.
+static uint32_t bench_cells(bench_finder_t p_finder, const char *p_text, uint32_t p_length)
+{
+	const char *t_ptr, *t_end;
+	t_ptr = p_text;
+	t_end = p_text + p_length;
+
+	uint32_t t_cells;
+	t_cells = 0;
+	while(t_ptr < t_end)
+	{
+		const char *t_row_end;
+		t_row_end = p_finder(t_ptr, t_end, '\n');
+		while(t_ptr <= t_row_end)
+		{
+			t_ptr = p_finder(t_ptr, t_row_end, '\t') + 1;
+			t_cells++;
+		}
+	}
+	return t_cells;
+}
+
+static double bench_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+static volatile uint32_t s_sink;
+
+#define BENCH_TIME(m_label, m_expr) \
+	{ \
+		double t_best; \
+		t_best = 1e30; \
+		for(int t_run = 0; t_run < 5; t_run++) \
+		{ \
+			double t_start; \
+			t_start = bench_now(); \
+			s_sink = (m_expr); \
+			double t_time; \
+			t_time = bench_now() - t_start; \
+			if (t_time < t_best) \
+				t_best = t_time; \
+		} \
+		printf("  %-24s %6.2f GB/s\n", m_label, t_length / t_best / 1e9); \
+	}
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_length;
+	t_length = 64 * 1024 * 1024;
+
+	char *t_text;
+	t_text = (char *)malloc(t_length);
+
+	static const uint32_t s_line_lengths[] = { 10, 81, 1000, 100000 };
+	for(uint32_t i = 0; i < sizeof(s_line_lengths) / sizeof(s_line_lengths[0]); i++)
+	{
+		// Lines of the given length, with a tab roughly every 8 characters.
+		srand(1);
+		for(uint32_t j = 0; j < t_length; j++)
+		{
+			if (j % s_line_lengths[i] == s_line_lengths[i] - 1)
+				t_text[j] = '\n';
+			else if (rand() % 8 == 0)
+				t_text[j] = '\t';
+			else
+				t_text[j] = 'a' + rand() % 26;
+		}
+
+		printf("%u-byte lines:\n", s_line_lengths[i]);
+		BENCH_TIME("find lines (bytes)", bench_lines(bench_findchar_bytewise, t_text, t_length));
+		BENCH_TIME("find lines (memchr)", bench_lines(bench_findchar_memchr, t_text, t_length));
+#ifdef BENCH_USE_SSE2
+		BENCH_TIME("find lines (sse2)", bench_lines(bench_findchar_sse2, t_text, t_length));
+#endif
+		BENCH_TIME("count lines (bytes)", bench_countchar_bytewise(t_text, t_text + t_length, '\n'));
+		BENCH_TIME("count lines (kernel)", bench_countchar(t_text, t_text + t_length, '\n'));
+		BENCH_TIME("split cells (bytes)", bench_cells(bench_findchar_bytewise, t_text, t_length));
+		BENCH_TIME("split cells (memchr)", bench_cells(bench_findchar_memchr, t_text, t_length));
+	}
+
+	free(t_text);
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program measures the per-call variable overhead of MCHandler::exec
+// (engine/src/handler.cpp), before and after parameters and locals were
+// recycled through MCVariable::createlocal / destroylocal
+// (engine/src/variable.cpp). For each call it does what exec does with its
+// variables:
+//
+//   - allocates the parameter and local pointer arrays
+//   - creates a variable for each parameter, storing a short string in it
+//   - creates a variable for each local
+//   - on return, destroys them all and frees the arrays
+//
+// 'before' creates the variables with new and delete, as createwithname did;
+// 'after' uses a copy of the free list createlocal and destroylocal use. The
+// handler is called in a flat loop, and recursively at depths either side of
+// the free list's cap.
+//
+// The engine's variable classes can't be built outside it, so a stand-in of
+// the same size is used and the pool below is a copy of the one in
+// variable.cpp - if that is changed, change it here too. Only the variable
+// lifecycle is measured, not statement execution.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o handler_call_bench tools/handler_call_bench.cpp && ./handler_call_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <new>
+#include <sys/time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The same size and shape as MCVariable on a 64-bit build - a name, the list
+// link, a value (flags plus a string or array) and the flag bits.
+class BenchVariable
+{
+public:
+	BenchVariable(void)
+	{
+		name = NULL;
+		next = NULL;
+		flags = 0;
+		data = NULL;
+		size = 0;
+		is_msg = is_env = is_global = is_deferred = is_uql = false;
+	}
+
+	~BenchVariable(void)
+	{
+		free(data);
+	}
+
+	void store(const char *p_string, uint32_t p_length)
+	{
+		data = (char *)malloc(p_length);
+		memcpy(data, p_string, p_length);
+		size = p_length;
+		flags = 1;
+	}
+
+	const void *name;
+	BenchVariable *next;
+	uint32_t flags;
+	char *data;
+	uint32_t size;
+	double number;
+	bool is_msg : 1;
+	bool is_env : 1;
+	bool is_global : 1;
+	bool is_deferred : 1;
+	bool is_uql : 1;
+};
+
+static BenchVariable *bench_create_heap(const void *p_name)
+{
+	BenchVariable *t_var;
+	t_var = new BenchVariable;
+	t_var -> name = p_name;
+	return t_var;
+}
+
+static void bench_destroy_heap(BenchVariable *p_var)
+{
+	delete p_var;
+}
+
+// As LOCAL_VARIABLE_POOL_LIMIT, createlocal and destroylocal in variable.cpp.
+#define BENCH_POOL_LIMIT 1024
+
+static void *s_pool = NULL;
+static uint32_t s_pool_size = 0;
+
+static BenchVariable *bench_create_pooled(const void *p_name)
+{
+	void *t_block;
+	if (s_pool != NULL)
+	{
+		t_block = s_pool;
+		s_pool = *(void **)t_block;
+		s_pool_size--;
+	}
+	else
+		t_block = new char[sizeof(BenchVariable)];
+
+	BenchVariable *t_var;
+	t_var = new(t_block) BenchVariable;
+	t_var -> name = p_name;
+	return t_var;
+}
+
+static void bench_destroy_pooled(BenchVariable *p_var)
+{
+	p_var -> ~BenchVariable();
+
+	if (s_pool_size == BENCH_POOL_LIMIT)
+	{
+		delete[] (char *)p_var;
+		return;
+	}
+
+	*(void **)p_var = s_pool;
+	s_pool = p_var;
+	s_pool_size++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *s_names[] = { "pText", "pIndex", "tResult", "tLine", "tCount" };
+
+#define BENCH_PARAMS 2
+#define BENCH_LOCALS 3
+
+template<BenchVariable *(*Create)(const void *), void (*Destroy)(BenchVariable *)>
+static uint64_t bench_call(uint32_t p_depth)
+{
+	BenchVariable **t_params;
+	t_params = new BenchVariable *[BENCH_PARAMS];
+	for(int i = 0; i < BENCH_PARAMS; i++)
+	{
+		t_params[i] = Create(s_names[i]);
+		t_params[i] -> store("some parameter", 14);
+	}
+
+	BenchVariable **t_vars;
+	t_vars = new BenchVariable *[BENCH_LOCALS];
+	for(int i = BENCH_LOCALS; i-- > 0;)
+		t_vars[i] = Create(s_names[BENCH_PARAMS + i]);
+
+	uint64_t t_result;
+	t_result = t_params[0] -> size + (uintptr_t)t_vars[0] -> name;
+	if (p_depth > 1)
+		t_result += bench_call<Create, Destroy>(p_depth - 1);
+
+	for(int i = BENCH_PARAMS; i-- > 0;)
+		Destroy(t_params[i]);
+	delete[] t_params;
+	for(int i = BENCH_LOCALS; i-- > 0;)
+		Destroy(t_vars[i]);
+	delete[] t_vars;
+
+	return t_result;
+}
+
+static double bench_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+static volatile uint64_t s_sink;
+
+template<BenchVariable *(*Create)(const void *), void (*Destroy)(BenchVariable *)>
+static double bench_run(uint32_t p_depth, uint32_t p_calls)
+{
+	// One untimed pass so the pool (and the heap) are warm.
+	s_sink += bench_call<Create, Destroy>(p_depth);
+
+	double t_start;
+	t_start = bench_now();
+	for(uint32_t i = 0; i < p_calls / p_depth; i++)
+		s_sink += bench_call<Create, Destroy>(p_depth);
+	return (bench_now() - t_start) * 1e9 / p_calls;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_calls;
+	t_calls = 10000000;
+	if (argc > 1)
+		t_calls = (uint32_t)atoi(argv[1]);
+
+	printf("sizeof(variable) = %u, %d params + %d locals per call, %u calls\n\n", (unsigned)sizeof(BenchVariable), BENCH_PARAMS, BENCH_LOCALS, t_calls);
+	printf("%-22s %12s %12s %8s\n", "calls", "before ns", "after ns", "ratio");
+
+	static const uint32_t s_depths[] = { 1, 10, 200, 1000 };
+	for(uint32_t i = 0; i < sizeof(s_depths) / sizeof(s_depths[0]); i++)
+	{
+		double t_before, t_after;
+		t_before = bench_run<bench_create_heap, bench_destroy_heap>(s_depths[i], t_calls);
+		t_after = bench_run<bench_create_pooled, bench_destroy_pooled>(s_depths[i], t_calls);
+
+		char t_label[32];
+		if (s_depths[i] == 1)
+			sprintf(t_label, "flat");
+		else
+			sprintf(t_label, "recursive, depth %u", s_depths[i]);
+		printf("%-22s %12.1f %12.1f %7.2fx\n", t_label, t_before, t_after, t_before / t_after);
+	}
+
+	return 0;
+}
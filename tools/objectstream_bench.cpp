@@ -0,0 +1,807 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program measures loading and saving custom property data through
+// MCObjectInputStream and MCObjectOutputStream (engine/src/objectstream.cpp),
+// as MCHashentry::Load and Save (engine/src/variablearray.cpp) do for each
+// entry of a property set - a key, then a string value.
+//
+// The property set used has many short keys and values, with a 64K value every
+// 64 entries. It is loaded:
+//
+//   - 'buffered' - copied through the stream's 16K buffer, as when the stack
+//     file is encrypted or read from a file that isn't in memory
+//   - 'mapped' - with the buffer pointing at the stack file in memory, but with
+//     keys and values still read by copying (ReadCString and Read)
+//   - 'borrowed' - in memory, with keys and values taken from the stream with
+//     ReadBorrowedCString and ReadBorrowed, as Load does now
+//
+// and saved with every block copied through the 16K buffer ('chunked') or
+// with blocks of 16K or more written directly ('direct'). The loaded data is
+// checked against what was saved.
+//
+// The engine's stream classes can't be built outside it, so the ones below are
+// copies of the parts of them that are used, over an in-memory handle - if
+// objectstream.cpp or MCHashentry::Load is changed, change the copy here too.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o objectstream_bench tools/objectstream_bench.cpp && ./objectstream_bench [entries]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+
+enum IO_stat
+{
+	IO_NORMAL,
+	IO_EOF,
+	IO_ERROR
+};
+
+#define nil NULL
+
+static inline uint32_t MCU_min(uint32_t one, uint32_t two) {return one > two ? two : one;}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// An in-memory stand-in for IO_handle, with MCS_getreadbuffer, IO_read,
+// MCS_seek_cur and MCS_write over it.
+struct BenchHandle
+{
+	char *data;
+	uint32_t size;
+	uint32_t capacity;
+	uint32_t position;
+	bool in_memory;
+};
+
+static bool MCS_getreadbuffer(BenchHandle *p_stream, const char*& r_buffer, uint32_t& r_available)
+{
+	if (!p_stream -> in_memory)
+		return false;
+
+	r_buffer = p_stream -> data + p_stream -> position;
+	r_available = p_stream -> size - p_stream -> position;
+	return true;
+}
+
+static IO_stat IO_read(void *p_buffer, uint32_t p_size, uint32_t& r_count, BenchHandle *p_stream)
+{
+	if (p_stream -> size - p_stream -> position < p_size * r_count)
+		return IO_EOF;
+
+	memcpy(p_buffer, p_stream -> data + p_stream -> position, p_size * r_count);
+	p_stream -> position += p_size * r_count;
+	return IO_NORMAL;
+}
+
+static IO_stat MCS_seek_cur(BenchHandle *p_stream, uint32_t p_offset)
+{
+	if (p_stream -> size - p_stream -> position < p_offset)
+		return IO_EOF;
+
+	p_stream -> position += p_offset;
+	return IO_NORMAL;
+}
+
+static IO_stat MCS_write(const void *p_buffer, uint32_t p_size, uint32_t p_count, BenchHandle *p_stream)
+{
+	uint32_t t_amount;
+	t_amount = p_size * p_count;
+	if (p_stream -> size + t_amount > p_stream -> capacity)
+	{
+		uint32_t t_capacity;
+		t_capacity = p_stream -> capacity == 0 ? 65536 : p_stream -> capacity;
+		while(t_capacity < p_stream -> size + t_amount)
+			t_capacity *= 2;
+
+		char *t_data;
+		t_data = (char *)realloc(p_stream -> data, t_capacity);
+		if (t_data == NULL)
+			return IO_ERROR;
+
+		p_stream -> data = t_data;
+		p_stream -> capacity = t_capacity;
+	}
+
+	memcpy(p_stream -> data + p_stream -> size, p_buffer, t_amount);
+	p_stream -> size += t_amount;
+	return IO_NORMAL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The input side of MCObjectInputStream.
+class BenchInputStream
+{
+public:
+	BenchInputStream(BenchHandle *p_stream, uint32_t p_remaining, bool p_passthrough)
+	{
+		m_stream = p_stream;
+		m_buffer = NULL;
+		m_frontier = 0;
+		m_limit = 0;
+		m_bound = 0;
+		m_remaining = p_remaining;
+		m_passthrough = p_passthrough;
+		m_buffer_is_mapped = false;
+	}
+
+	~BenchInputStream(void)
+	{
+		if (!m_buffer_is_mapped)
+			delete[] (char *)m_buffer;
+	}
+
+	IO_stat ReadU8(uint8_t& r_value)
+	{
+		return Read(&r_value, 1);
+	}
+
+	IO_stat ReadU32(uint32_t& r_value)
+	{
+		IO_stat t_stat;
+		t_stat = Read(&r_value, 4);
+		if (t_stat == IO_NORMAL)
+			r_value = ntohl(r_value);
+		return t_stat;
+	}
+
+	IO_stat ReadCString(char*& r_value)
+	{
+		uint32_t t_length;
+		t_length = 0;
+
+		char *t_output;
+		t_output = NULL;
+
+		bool t_finished;
+		t_finished = false;
+
+		while(!t_finished)
+		{
+			if (m_limit == m_frontier)
+			{
+				IO_stat t_stat;
+				t_stat = Fill();
+				if (t_stat != IO_NORMAL)
+					return t_stat;
+			}
+
+			uint32_t t_offset;
+			const char *t_nul;
+			t_nul = (const char *)memchr((char *)m_buffer + m_frontier, '\0', m_limit - m_frontier);
+			if (t_nul != NULL)
+			{
+				t_offset = t_nul - ((char *)m_buffer + m_frontier) + 1;
+				t_finished = true;
+			}
+			else
+				t_offset = m_limit - m_frontier;
+
+			uint32_t t_new_length;
+			t_new_length = t_length + t_offset;
+
+			char *t_new_output;
+			t_new_output = (char *)realloc(t_output, t_new_length);
+			if (t_new_output == NULL)
+			{
+				free(t_output);
+				return IO_ERROR;
+			}
+
+			memcpy(t_new_output + t_length, (char *)m_buffer + m_frontier, t_offset);
+
+			t_output = t_new_output;
+			t_length = t_new_length;
+
+			m_frontier += t_offset;
+		}
+
+		if (t_output != NULL && t_output[0] == '\0')
+		{
+			free(t_output);
+			t_output = NULL;
+		}
+
+		r_value = t_output;
+		return IO_NORMAL;
+	}
+
+	IO_stat Read(void *p_buffer, uint32_t p_amount)
+	{
+		while(p_amount > 0)
+		{
+			if (m_limit == m_frontier)
+			{
+				IO_stat t_stat;
+				t_stat = Fill();
+				if (t_stat != IO_NORMAL)
+					return t_stat;
+			}
+
+			uint32_t t_available;
+			t_available = MCU_min(m_limit - m_frontier, p_amount);
+
+			if (p_buffer != NULL)
+			{
+				memcpy(p_buffer, (char *)m_buffer + m_frontier, t_available);
+				p_buffer = (char *)p_buffer + t_available;
+			}
+
+			p_amount -= t_available;
+			m_frontier += t_available;
+		}
+
+		return IO_NORMAL;
+	}
+
+	IO_stat ReadBorrowed(const void*& r_data, uint32_t p_amount)
+	{
+		r_data = nil;
+
+		if (m_buffer == nil && m_remaining != 0)
+		{
+			IO_stat t_stat;
+			t_stat = Fill();
+			if (t_stat != IO_NORMAL)
+				return t_stat;
+		}
+
+		if (!m_buffer_is_mapped)
+			return IO_NORMAL;
+
+		if (m_limit - m_frontier < p_amount)
+			return IO_EOF;
+
+		r_data = (char *)m_buffer + m_frontier;
+		m_frontier += p_amount;
+
+		return IO_NORMAL;
+	}
+
+	IO_stat ReadBorrowedCString(const char*& r_value)
+	{
+		r_value = nil;
+
+		if (m_buffer == nil && m_remaining != 0)
+		{
+			IO_stat t_stat;
+			t_stat = Fill();
+			if (t_stat != IO_NORMAL)
+				return t_stat;
+		}
+
+		if (!m_buffer_is_mapped)
+			return IO_NORMAL;
+
+		const char *t_nul;
+		t_nul = (const char *)memchr((char *)m_buffer + m_frontier, '\0', m_limit - m_frontier);
+		if (t_nul == NULL)
+			return IO_EOF;
+
+		r_value = (char *)m_buffer + m_frontier;
+		m_frontier += t_nul - r_value + 1;
+
+		return IO_NORMAL;
+	}
+
+private:
+	IO_stat Fill(void)
+	{
+		if (m_remaining == 0)
+			return IO_EOF;
+
+		IO_stat t_stat;
+
+		const char *t_mapped_buffer;
+		uint32_t t_mapped_available;
+		if (m_passthrough && m_buffer == nil &&
+			MCS_getreadbuffer(m_stream, t_mapped_buffer, t_mapped_available) &&
+			t_mapped_available >= m_remaining)
+		{
+			t_stat = MCS_seek_cur(m_stream, m_remaining);
+			if (t_stat != IO_NORMAL)
+				return t_stat;
+
+			m_buffer = (void *)t_mapped_buffer;
+			m_buffer_is_mapped = true;
+			m_bound = m_remaining;
+			m_limit = m_remaining;
+			m_remaining = 0;
+
+			return IO_NORMAL;
+		}
+
+		if (m_buffer == nil)
+			m_buffer = new char[16384];
+
+		memmove(m_buffer, (char *)m_buffer + m_frontier, m_bound - m_frontier);
+		m_limit -= m_frontier;
+		m_bound -= m_frontier;
+		m_frontier = 0;
+
+		uint32_t t_available;
+		t_available = MCU_min(m_remaining, 16384 - m_bound);
+
+		uint32_t t_count;
+		t_count = 1;
+
+		t_stat = IO_read((char *)m_buffer + m_bound, t_available, t_count, m_stream);
+		if (t_stat != IO_NORMAL)
+			return t_stat;
+
+		m_bound += t_available;
+		m_remaining -= t_available;
+		m_limit += t_available;
+
+		return t_stat;
+	}
+
+	BenchHandle *m_stream;
+	void *m_buffer;
+	uint32_t m_frontier;
+	uint32_t m_limit;
+	uint32_t m_bound;
+	uint32_t m_remaining;
+	bool m_passthrough;
+	bool m_buffer_is_mapped;
+};
+
+// The output side of MCObjectOutputStream.
+class BenchOutputStream
+{
+public:
+	BenchOutputStream(BenchHandle *p_stream, bool p_passthrough)
+	{
+		m_stream = p_stream;
+		m_buffer = new char[16384];
+		m_frontier = 0;
+		m_passthrough = p_passthrough;
+		m_direct_buffer = nil;
+		m_direct_amount = 0;
+	}
+
+	~BenchOutputStream(void)
+	{
+		delete[] (char *)m_buffer;
+	}
+
+	IO_stat WriteU8(uint8_t p_value)
+	{
+		return Write(&p_value, 1);
+	}
+
+	IO_stat WriteU32(uint32_t p_value)
+	{
+		p_value = htonl(p_value);
+		return Write(&p_value, 4);
+	}
+
+	IO_stat WriteCString(const char *p_value)
+	{
+		if (p_value == NULL)
+			return WriteU8(0);
+
+		return Write(p_value, strlen(p_value) + 1);
+	}
+
+	IO_stat Write(const void *p_buffer, uint32_t p_amount)
+	{
+		if (m_passthrough && p_amount >= 16384)
+		{
+			m_direct_buffer = p_buffer;
+			m_direct_amount = p_amount;
+
+			IO_stat t_stat;
+			t_stat = Flush();
+
+			m_direct_buffer = nil;
+			m_direct_amount = 0;
+
+			return t_stat;
+		}
+
+		while(p_amount > 0)
+		{
+			if (m_frontier == 16384)
+			{
+				IO_stat t_stat;
+				t_stat = Flush();
+				if (t_stat != IO_NORMAL)
+					return t_stat;
+			}
+
+			uint32_t t_available;
+			t_available = MCU_min(16384 - m_frontier, p_amount);
+
+			memcpy((char *)m_buffer + m_frontier, p_buffer, t_available);
+
+			p_buffer = (char *)p_buffer + t_available;
+			p_amount -= t_available;
+			m_frontier += t_available;
+		}
+
+		return IO_NORMAL;
+	}
+
+	IO_stat Flush(void)
+	{
+		IO_stat t_stat;
+		t_stat = MCS_write(m_buffer, m_frontier, 1, m_stream);
+		if (t_stat != IO_NORMAL)
+			return t_stat;
+
+		m_frontier = 0;
+
+		if (m_direct_amount != 0)
+			return MCS_write(m_direct_buffer, m_direct_amount, 1, m_stream);
+
+		return IO_NORMAL;
+	}
+
+private:
+	BenchHandle *m_stream;
+	void *m_buffer;
+	uint32_t m_frontier;
+	bool m_passthrough;
+	const void *m_direct_buffer;
+	uint32_t m_direct_amount;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A property set entry - as MCHashentry, the key is allocated with the entry
+// and the value separately.
+struct BenchEntry
+{
+	char *value;
+	uint32_t value_length;
+	uint32_t length;
+	char string[1];
+};
+
+static BenchEntry *bench_create_entry(const char *p_key, uint32_t p_key_length)
+{
+	BenchEntry *t_entry;
+	t_entry = (BenchEntry *)malloc(sizeof(BenchEntry) + p_key_length);
+	memcpy(t_entry -> string, p_key, p_key_length);
+	t_entry -> string[p_key_length] = '\0';
+	t_entry -> length = p_key_length;
+	t_entry -> value = NULL;
+	t_entry -> value_length = 0;
+	return t_entry;
+}
+
+static void bench_delete_entry(BenchEntry *p_entry)
+{
+	delete[] p_entry -> value;
+	free(p_entry);
+}
+
+#define BENCH_TYPE_STRING 2
+
+// MCHashentry::Load before keys and values were borrowed from the stream.
+static IO_stat bench_load_copied(BenchInputStream& p_stream, BenchEntry*& r_entry)
+{
+	uint8_t t_type;
+	uint32_t t_length;
+	IO_stat t_stat;
+	t_stat = p_stream . ReadU8(t_type);
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . ReadU32(t_length);
+
+	char *t_key;
+	t_key = NULL;
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . ReadCString(t_key);
+
+	BenchEntry *t_entry;
+	t_entry = NULL;
+	if (t_stat == IO_NORMAL)
+	{
+		t_entry = bench_create_entry(t_key, t_key == NULL ? 0 : strlen(t_key));
+
+		uint32_t t_string_length;
+		t_stat = p_stream . ReadU32(t_string_length);
+		if (t_stat == IO_NORMAL)
+		{
+			t_entry -> value = new char[t_string_length];
+			t_entry -> value_length = t_string_length;
+			t_stat = p_stream . Read(t_entry -> value, t_string_length);
+		}
+	}
+
+	free(t_key);
+
+	r_entry = t_entry;
+	return t_stat;
+}
+
+// MCHashentry::Load as it is now.
+static IO_stat bench_load_borrowed(BenchInputStream& p_stream, BenchEntry*& r_entry)
+{
+	uint8_t t_type;
+	uint32_t t_length;
+	IO_stat t_stat;
+	t_stat = p_stream . ReadU8(t_type);
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . ReadU32(t_length);
+
+	const char *t_borrowed_key;
+	t_borrowed_key = NULL;
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . ReadBorrowedCString(t_borrowed_key);
+
+	char *t_key;
+	t_key = NULL;
+	if (t_stat == IO_NORMAL && t_borrowed_key == NULL)
+		t_stat = p_stream . ReadCString(t_key);
+
+	BenchEntry *t_entry;
+	t_entry = NULL;
+	if (t_stat == IO_NORMAL)
+	{
+		const char *t_key_string;
+		t_key_string = t_borrowed_key != NULL ? t_borrowed_key : t_key;
+		t_entry = bench_create_entry(t_key_string, t_key_string == NULL ? 0 : strlen(t_key_string));
+
+		uint32_t t_string_length;
+		t_stat = p_stream . ReadU32(t_string_length);
+
+		const void *t_borrowed_string;
+		t_borrowed_string = NULL;
+		if (t_stat == IO_NORMAL)
+			t_stat = p_stream . ReadBorrowed(t_borrowed_string, t_string_length);
+
+		if (t_stat == IO_NORMAL)
+		{
+			t_entry -> value = new char[t_string_length];
+			t_entry -> value_length = t_string_length;
+			if (t_borrowed_string != NULL)
+				memcpy(t_entry -> value, t_borrowed_string, t_string_length);
+			else
+				t_stat = p_stream . Read(t_entry -> value, t_string_length);
+		}
+	}
+
+	free(t_key);
+
+	r_entry = t_entry;
+	return t_stat;
+}
+
+static IO_stat bench_save(BenchOutputStream& p_stream, const BenchEntry *p_entry)
+{
+	IO_stat t_stat;
+	t_stat = p_stream . WriteU8(BENCH_TYPE_STRING);
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . WriteU32(p_entry -> length + 1 + 4 + p_entry -> value_length);
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . WriteCString(p_entry -> string);
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . WriteU32(p_entry -> value_length);
+	if (t_stat == IO_NORMAL)
+		t_stat = p_stream . Write(p_entry -> value, p_entry -> value_length);
+	return t_stat;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static double bench_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+static BenchEntry **bench_make_entries(uint32_t p_count)
+{
+	BenchEntry **t_entries;
+	t_entries = new BenchEntry *[p_count];
+
+	uint32_t t_seed;
+	t_seed = 1;
+	for(uint32_t i = 0; i < p_count; i++)
+	{
+		char t_key[32];
+		sprintf(t_key, "uProperty%u", i);
+		t_entries[i] = bench_create_entry(t_key, strlen(t_key));
+
+		t_seed = t_seed * 1103515245 + 12345;
+
+		uint32_t t_value_length;
+		if (i % 64 == 63)
+			t_value_length = 65536;
+		else
+			t_value_length = 4 + (t_seed >> 16) % 120;
+
+		t_entries[i] -> value = new char[t_value_length];
+		t_entries[i] -> value_length = t_value_length;
+		for(uint32_t j = 0; j < t_value_length; j++)
+			t_entries[i] -> value[j] = 'a' + (i + j) % 26;
+	}
+
+	return t_entries;
+}
+
+static bool bench_same(const BenchEntry *p_left, const BenchEntry *p_right)
+{
+	return p_left -> length == p_right -> length &&
+		memcmp(p_left -> string, p_right -> string, p_left -> length) == 0 &&
+		p_left -> value_length == p_right -> value_length &&
+		memcmp(p_left -> value, p_right -> value, p_left -> value_length) == 0;
+}
+
+typedef IO_stat (*bench_load_function)(BenchInputStream&, BenchEntry*&);
+
+// Load the entries from the saved data the given number of times, returning
+// the time taken for each in seconds, or a negative value if the result is
+// wrong.
+static double bench_load(BenchHandle& p_file, bool p_in_memory, bench_load_function p_load, BenchEntry **p_expected, uint32_t p_count, uint32_t p_repeats)
+{
+	double t_start;
+	t_start = bench_now();
+	for(uint32_t r = 0; r < p_repeats; r++)
+	{
+		p_file . position = 0;
+		p_file . in_memory = p_in_memory;
+
+		BenchInputStream t_stream(&p_file, p_file . size, true);
+		for(uint32_t i = 0; i < p_count; i++)
+		{
+			BenchEntry *t_entry;
+			if (p_load(t_stream, t_entry) != IO_NORMAL ||
+				(r == 0 && !bench_same(t_entry, p_expected[i])))
+			{
+				if (t_entry != NULL)
+					bench_delete_entry(t_entry);
+				return -1.0;
+			}
+			bench_delete_entry(t_entry);
+		}
+	}
+	return (bench_now() - t_start) / p_repeats;
+}
+
+static double bench_save_all(BenchHandle& p_file, bool p_passthrough, BenchEntry **p_entries, uint32_t p_count, uint32_t p_repeats)
+{
+	double t_start;
+	t_start = bench_now();
+	for(uint32_t r = 0; r < p_repeats; r++)
+	{
+		p_file . size = 0;
+
+		BenchOutputStream t_stream(&p_file, p_passthrough);
+		for(uint32_t i = 0; i < p_count; i++)
+			if (bench_save(t_stream, p_entries[i]) != IO_NORMAL)
+				return -1.0;
+		if (t_stream . Flush() != IO_NORMAL)
+			return -1.0;
+	}
+	return (bench_now() - t_start) / p_repeats;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_count;
+	t_count = 100000;
+	if (argc > 1)
+		t_count = (uint32_t)atoi(argv[1]);
+
+	BenchEntry **t_entries;
+	t_entries = bench_make_entries(t_count);
+
+	BenchHandle t_file;
+	memset(&t_file, 0, sizeof(t_file));
+
+	// Save once in each mode, checking the two give the same bytes.
+	if (bench_save_all(t_file, false, t_entries, t_count, 1) < 0.0)
+	{
+		fprintf(stderr, "chunked save failed\n");
+		return 1;
+	}
+	char *t_chunked;
+	uint32_t t_chunked_size;
+	t_chunked_size = t_file . size;
+	t_chunked = (char *)malloc(t_chunked_size);
+	memcpy(t_chunked, t_file . data, t_chunked_size);
+	if (bench_save_all(t_file, true, t_entries, t_count, 1) < 0.0 ||
+		t_file . size != t_chunked_size || memcmp(t_file . data, t_chunked, t_chunked_size) != 0)
+	{
+		fprintf(stderr, "direct save gave different data\n");
+		return 1;
+	}
+	free(t_chunked);
+
+	double t_megabytes;
+	t_megabytes = t_file . size / 1048576.0;
+
+	uint32_t t_repeats;
+	t_repeats = 10;
+
+	printf("%u entries, %.1fMB saved, best of %u\n\n", t_count, t_megabytes, t_repeats);
+	printf("%-10s %10s %10s\n", "", "ms", "MB/s");
+
+	struct
+	{
+		const char *label;
+		bool in_memory;
+		bench_load_function load;
+	} t_loads[] =
+	{
+		{ "buffered", false, bench_load_copied },
+		{ "mapped", true, bench_load_copied },
+		{ "borrowed", true, bench_load_borrowed },
+	};
+
+	for(uint32_t i = 0; i < sizeof(t_loads) / sizeof(t_loads[0]); i++)
+	{
+		double t_best;
+		t_best = -1.0;
+		for(uint32_t r = 0; r < t_repeats; r++)
+		{
+			double t_time;
+			t_time = bench_load(t_file, t_loads[i] . in_memory, t_loads[i] . load, t_entries, t_count, 1);
+			if (t_time < 0.0)
+			{
+				fprintf(stderr, "%s load gave the wrong result\n", t_loads[i] . label);
+				return 1;
+			}
+			if (t_best < 0.0 || t_time < t_best)
+				t_best = t_time;
+		}
+		printf("%-10s %10.2f %10.0f\n", t_loads[i] . label, t_best * 1000.0, t_megabytes / t_best);
+	}
+
+	// The borrowed load must also work when the stream isn't in memory.
+	if (bench_load(t_file, false, bench_load_borrowed, t_entries, t_count, 1) < 0.0)
+	{
+		fprintf(stderr, "borrowed load from a buffered stream gave the wrong result\n");
+		return 1;
+	}
+
+	static const char *s_save_labels[] = { "chunked", "direct" };
+	for(uint32_t i = 0; i < 2; i++)
+	{
+		double t_best;
+		t_best = -1.0;
+		for(uint32_t r = 0; r < t_repeats; r++)
+		{
+			double t_time;
+			t_time = bench_save_all(t_file, i == 1, t_entries, t_count, 1);
+			if (t_time < 0.0)
+			{
+				fprintf(stderr, "%s save failed\n", s_save_labels[i]);
+				return 1;
+			}
+			if (t_best < 0.0 || t_time < t_best)
+				t_best = t_time;
+		}
+		printf("%-10s %10.2f %10.0f\n", s_save_labels[i], t_best * 1000.0, t_megabytes / t_best);
+	}
+
+	for(uint32_t i = 0; i < t_count; i++)
+		bench_delete_entry(t_entries[i]);
+	delete[] t_entries;
+	free(t_file . data);
+
+	return 0;
+}
@@ -0,0 +1,510 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program checks and measures the substring search in MCU_offset
+// (engine/src/util.cpp), which offset(), replace and field find use.
+//
+// First it compares the current MCU_offset against the loop it replaced on
+// random cases, in both case modes, with needles from 1 to 300 bytes (so the
+// memchr, Horspool and heap-folded paths are all taken) over alphabets small
+// enough for near matches to be common. Each case is run with three lower-
+// casing tables - the C locale, ISO-8859-1 and a random many-to-one mapping -
+// since MClowercasingtable differs by platform. Any difference in the result
+// or the offset found is reported and the program exits with 1.
+//
+// Then, for generated English-like text of a range of sizes, it times finding
+// every occurrence of a set of needles in turn (as replace does) with both
+// functions in both case modes.
+//
+// util.cpp can't be built outside the engine, so the functions below are
+// copies of the old and new MCU_offset - if MCU_offset is changed, change
+// the copy here too.
+//
+// To build and run it on Linux or Mac OS X, from the root of the repository:
+//
+//   g++ -O2 -o offset_bench tools/offset_bench.cpp && ./offset_bench [cases]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <sys/time.h>
+
+typedef uint8_t uint1;
+typedef uint32_t uint4;
+typedef int32_t int4;
+
+static uint1 *MClowercasingtable;
+
+static inline uint1 MCS_tolower(uint1 p_char)
+{
+	return MClowercasingtable[p_char];
+}
+
+// As in engine/src/mcutility.cpp.
+static int4 MCU_strncasecmp(const char *one, const char *two, size_t n)
+{
+	const uint1 *optr = (const uint1 *)one;
+	const uint1 *tptr = (const uint1 *)two;
+	while (n--)
+	{
+		if (*optr != *tptr)
+		{
+			uint1 o = MCS_tolower(*optr);
+			uint1 t = MCS_tolower(*tptr);
+			if (o != t)
+				return o - t;
+		}
+		optr++;
+		tptr++;
+	}
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// MCU_offset before it was changed to use memchr and Horspool searches.
+static bool offset_old(const uint1 *pptr, uint4 tl, const uint1 *wptr, uint4 sl, uint4 &offset, bool casesensitive)
+{
+	offset = 0;
+
+	if (tl > sl || tl == 0 || sl == 0)
+		return false;
+	uint4 length = sl - tl;
+	uint4 i;
+	if (casesensitive)
+		for (i = 0 ; i <= length ; i++)
+		{
+			const uint1 *sptr = pptr;
+			const uint1 *dptr = wptr + i;
+			if (*sptr != *dptr)
+				continue;
+			int4 diff = 0;
+			uint4 n = tl;
+			while (n--)
+				if (*dptr++ != *sptr++)
+				{
+					diff = 1;
+					break;
+				}
+			if (diff == 0)
+			{
+				offset = i;
+				return true;
+			}
+		}
+	else
+		for (i = 0 ; i <= length ; i++)
+		{
+			int4 diff = 0;
+
+			char t_p, t_w;
+			t_p = *pptr;
+			t_w = *(wptr + i);
+
+			t_p = MCS_tolower(t_p);
+			t_w = MCS_tolower(t_w);
+
+			if (t_p != t_w)
+				continue;
+			else
+				diff = MCU_strncasecmp((char *)pptr, (char *)wptr + i, tl);
+
+			if (diff == 0)
+			{
+				offset = i;
+				return true;
+			}
+		}
+	return false;
+}
+
+// The current MCU_offset and its Horspool search.
+
+#define OFFSET_SKIP_THRESHOLD 8
+#define OFFSET_FOLD_BUFFER 256
+
+static bool MCU_offset_horspool(const uint1 *p_part, uint4 p_part_length, const uint1 *p_whole, uint4 p_whole_length, bool p_fold, uint4& r_offset)
+{
+	uint1 t_skip[256];
+	memset(t_skip, p_part_length < 255 ? p_part_length : 255, sizeof(t_skip));
+	for(uint4 i = 0; i < p_part_length - 1; i++)
+		t_skip[p_part[i]] = p_part_length - 1 - i < 255 ? p_part_length - 1 - i : 255;
+
+	uint1 t_last;
+	t_last = p_part[p_part_length - 1];
+
+	uint4 t_limit;
+	t_limit = p_whole_length - p_part_length;
+	for(uint4 i = 0; i <= t_limit; )
+	{
+		uint1 t_char;
+		t_char = p_whole[i + p_part_length - 1];
+		if (p_fold)
+			t_char = MCS_tolower(t_char);
+		if (t_char == t_last)
+		{
+			bool t_match;
+			if (p_fold)
+			{
+				t_match = true;
+				for(uint4 j = 0; j < p_part_length - 1; j++)
+					if (MCS_tolower(p_whole[i + j]) != p_part[j])
+					{
+						t_match = false;
+						break;
+					}
+			}
+			else
+				t_match = memcmp(p_whole + i, p_part, p_part_length - 1) == 0;
+
+			if (t_match)
+			{
+				r_offset = i;
+				return true;
+			}
+		}
+		i += t_skip[t_char];
+	}
+
+	return false;
+}
+
+static bool offset_new(const uint1 *pptr, uint4 tl, const uint1 *wptr, uint4 sl, uint4 &offset, bool casesensitive)
+{
+	offset = 0;
+
+	if (tl > sl || tl == 0 || sl == 0)
+		return false;
+	uint4 length = sl - tl;
+	if (casesensitive)
+	{
+		if (tl >= OFFSET_SKIP_THRESHOLD)
+			return MCU_offset_horspool(pptr, tl, wptr, sl, false, offset);
+
+		const uint1 *sptr = wptr;
+		const uint1 *eptr = wptr + length + 1;
+		while (sptr < eptr)
+		{
+			sptr = (const uint1 *)memchr(sptr, *pptr, eptr - sptr);
+			if (sptr == NULL)
+				break;
+			if (memcmp(sptr + 1, pptr + 1, tl - 1) == 0)
+			{
+				offset = sptr - wptr;
+				return true;
+			}
+			sptr++;
+		}
+		return false;
+	}
+
+	uint1 t_buffer[OFFSET_FOLD_BUFFER];
+	uint1 *t_folded;
+	if (tl <= OFFSET_FOLD_BUFFER)
+		t_folded = t_buffer;
+	else
+		t_folded = new uint1[tl];
+	for (uint4 i = 0 ; i < tl ; i++)
+		t_folded[i] = MCS_tolower(pptr[i]);
+
+	bool t_found;
+	if (tl >= OFFSET_SKIP_THRESHOLD)
+		t_found = MCU_offset_horspool(t_folded, tl, wptr, sl, true, offset);
+	else
+	{
+		t_found = false;
+		for (uint4 i = 0 ; i <= length ; i++)
+			if (MCS_tolower(wptr[i]) == t_folded[0])
+			{
+				uint4 j;
+				for (j = 1 ; j < tl ; j++)
+					if (MCS_tolower(wptr[i + j]) != t_folded[j])
+						break;
+				if (j == tl)
+				{
+					offset = i;
+					t_found = true;
+					break;
+				}
+			}
+	}
+
+	if (t_folded != t_buffer)
+		delete[] t_folded;
+
+	return t_found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t s_seed = 1;
+
+static uint32_t bench_random(void)
+{
+	s_seed = s_seed * 1103515245 + 12345;
+	return (s_seed >> 8) ^ (s_seed << 16);
+}
+
+static uint1 s_c_table[256];
+static uint1 s_latin1_table[256];
+static uint1 s_random_table[256];
+
+static void bench_make_tables(void)
+{
+	for(int i = 0; i < 256; i++)
+	{
+		s_c_table[i] = i < 128 ? (uint1)tolower(i) : (uint1)i;
+
+		// ISO-8859-1 upper case letters are 0xC0-0xDE, other than 0xD7.
+		s_latin1_table[i] = s_c_table[i];
+		if (i >= 0xC0 && i <= 0xDE && i != 0xD7)
+			s_latin1_table[i] = (uint1)(i + 0x20);
+
+		// Many bytes to a few, so that caseless near matches are common and
+		// folding isn't one-to-one.
+		s_random_table[i] = (uint1)(bench_random() % 24);
+	}
+}
+
+// Fill the buffer from an alphabet of the given size, starting at the given
+// byte. Mixing the case of letters, and using high-bit bytes, exercises the
+// folding.
+static void bench_fill(uint1 *p_buffer, uint4 p_length, uint1 p_first, uint4 p_alphabet)
+{
+	for(uint4 i = 0; i < p_length; i++)
+		p_buffer[i] = (uint1)(p_first + bench_random() % p_alphabet);
+}
+
+static bool bench_check(uint32_t p_cases)
+{
+	static uint1 *s_tables[] = { s_c_table, s_latin1_table, s_random_table };
+	static const char *s_table_names[] = { "C", "ISO-8859-1", "random" };
+
+	static const uint1 s_firsts[] = { 'A', 'a', 0xC0, 0 };
+
+	uint1 *t_whole, *t_part;
+	t_whole = new uint1[4096];
+	t_part = new uint1[300];
+
+	uint32_t t_failures;
+	t_failures = 0;
+	for(uint32_t t_case = 0; t_case < p_cases; t_case++)
+	{
+		uint4 t_whole_length, t_part_length;
+		t_whole_length = bench_random() % 4096;
+		switch(bench_random() % 3)
+		{
+		case 0:
+			t_part_length = 1 + bench_random() % 8;
+			break;
+		case 1:
+			t_part_length = 1 + bench_random() % 40;
+			break;
+		default:
+			t_part_length = 1 + bench_random() % 300;
+			break;
+		}
+
+		uint1 t_first;
+		t_first = s_firsts[bench_random() % 4];
+		uint4 t_alphabet;
+		t_alphabet = t_first == 0 ? 256 : 2 + bench_random() % 40;
+		bench_fill(t_whole, t_whole_length, t_first, t_alphabet);
+
+		// Most needles are taken from the haystack (so there is a match, and
+		// often an earlier near match), and have their case changed.
+		if (t_whole_length >= t_part_length && bench_random() % 4 != 0)
+		{
+			memcpy(t_part, t_whole + bench_random() % (t_whole_length - t_part_length + 1), t_part_length);
+			for(uint4 i = 0; i < t_part_length; i++)
+				if (bench_random() % 3 == 0)
+					t_part[i] ^= 0x20;
+		}
+		else
+			bench_fill(t_part, t_part_length, t_first, t_alphabet);
+
+		for(int t_table = 0; t_table < 3; t_table++)
+		{
+			MClowercasingtable = s_tables[t_table];
+			for(int t_sensitive = 0; t_sensitive < 2; t_sensitive++)
+			{
+				uint4 t_old_offset, t_new_offset;
+				bool t_old, t_new;
+				t_old = offset_old(t_part, t_part_length, t_whole, t_whole_length, t_old_offset, t_sensitive != 0);
+				t_new = offset_new(t_part, t_part_length, t_whole, t_whole_length, t_new_offset, t_sensitive != 0);
+				if (t_old != t_new || t_old_offset != t_new_offset)
+				{
+					if (t_failures < 10)
+						fprintf(stderr, "case %u (%s table, %s): needle %u, haystack %u: old %d at %u, new %d at %u\n",
+								t_case, s_table_names[t_table], t_sensitive ? "case sensitive" : "caseless",
+								t_part_length, t_whole_length, t_old, t_old_offset, t_new, t_new_offset);
+					t_failures += 1;
+				}
+			}
+		}
+	}
+
+	delete[] t_whole;
+	delete[] t_part;
+
+	printf("%u random cases, 3 tables, both case modes: %u differences\n\n", p_cases, t_failures);
+
+	return t_failures == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static double bench_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+// Generate English-like text - words from a small vocabulary, some
+// capitalized, with punctuation and line breaks.
+static uint1 *bench_make_text(uint4 p_length)
+{
+	static const char *s_words[] = { "the", "of", "and", "to", "a", "in", "is", "it", "that", "was",
+		"for", "on", "are", "with", "as", "his", "they", "be", "at", "one", "have", "this", "from",
+		"stack", "card", "field", "button", "handler", "message", "script", "object", "property",
+		"performance", "variable", "engine", "paragraph", "character", "window", "session" };
+
+	uint1 *t_text;
+	t_text = new uint1[p_length];
+	uint4 t_length;
+	t_length = 0;
+	while(t_length < p_length)
+	{
+		const char *t_word;
+		t_word = s_words[bench_random() % (sizeof(s_words) / sizeof(s_words[0]))];
+		uint4 t_word_length;
+		t_word_length = strlen(t_word);
+		for(uint4 i = 0; i < t_word_length && t_length < p_length; i++)
+			t_text[t_length++] = (i == 0 && bench_random() % 8 == 0) ? toupper(t_word[i]) : t_word[i];
+		if (t_length < p_length)
+		{
+			uint32_t t_separator;
+			t_separator = bench_random() % 16;
+			t_text[t_length++] = t_separator == 0 ? '\n' : (t_separator == 1 ? ',' : ' ');
+		}
+	}
+	return t_text;
+}
+
+typedef bool (*bench_offset_function)(const uint1 *, uint4, const uint1 *, uint4, uint4 &, bool);
+
+// Find every occurrence of the needle in turn, returning the count and the
+// time taken in seconds.
+static double bench_find_all(bench_offset_function p_function, const uint1 *p_part, uint4 p_part_length, const uint1 *p_whole, uint4 p_whole_length, bool p_sensitive, uint32_t& r_count)
+{
+	double t_start;
+	t_start = bench_now();
+
+	uint32_t t_count;
+	t_count = 0;
+	uint4 t_position;
+	t_position = 0;
+	for(;;)
+	{
+		uint4 t_offset;
+		if (!p_function(p_part, p_part_length, p_whole + t_position, p_whole_length - t_position, t_offset, p_sensitive))
+			break;
+		t_count += 1;
+		t_position += t_offset + p_part_length;
+	}
+
+	r_count = t_count;
+	return bench_now() - t_start;
+}
+
+static void bench_measure(void)
+{
+	MClowercasingtable = s_latin1_table;
+
+	static const uint4 s_sizes[] = { 4096, 1 << 20, 16 << 20 };
+	static const char *s_needles[] = { "the", "field", "Handler", "performance", "zebra crossing",
+		"the engine sends the message to the card script before the stack" };
+
+	printf("%-10s %-40s %6s %9s %11s %11s %7s\n", "text", "needle", "case", "found", "old MB/s", "new MB/s", "speedup");
+	for(uint32_t s = 0; s < sizeof(s_sizes) / sizeof(s_sizes[0]); s++)
+	{
+		uint1 *t_text;
+		t_text = bench_make_text(s_sizes[s]);
+
+		// Small texts are searched repeatedly so the time is measurable.
+		uint32_t t_repeats;
+		t_repeats = (64 << 20) / s_sizes[s];
+		if (t_repeats > 1 && s_sizes[s] >= (1 << 20))
+			t_repeats = 4;
+
+		for(uint32_t n = 0; n < sizeof(s_needles) / sizeof(s_needles[0]); n++)
+			for(int t_sensitive = 1; t_sensitive >= 0; t_sensitive--)
+			{
+				const uint1 *t_part;
+				t_part = (const uint1 *)s_needles[n];
+				uint4 t_part_length;
+				t_part_length = strlen(s_needles[n]);
+
+				double t_old_time, t_new_time;
+				uint32_t t_old_count, t_new_count;
+				t_old_count = t_new_count = 0;
+				t_old_time = t_new_time = 0.0;
+				for(uint32_t r = 0; r < t_repeats; r++)
+				{
+					t_old_time += bench_find_all(offset_old, t_part, t_part_length, t_text, s_sizes[s], t_sensitive != 0, t_old_count);
+					t_new_time += bench_find_all(offset_new, t_part, t_part_length, t_text, s_sizes[s], t_sensitive != 0, t_new_count);
+				}
+
+				double t_megabytes;
+				t_megabytes = (double)s_sizes[s] * t_repeats / (1 << 20);
+
+				char t_size[16];
+				if (s_sizes[s] >= (1 << 20))
+					sprintf(t_size, "%uMB", s_sizes[s] >> 20);
+				else
+					sprintf(t_size, "%uKB", s_sizes[s] >> 10);
+
+				char t_needle[41];
+				snprintf(t_needle, sizeof(t_needle), "%s", s_needles[n]);
+
+				printf("%-10s %-40s %6s %9u %11.0f %11.0f %6.1fx%s\n", t_size, t_needle, t_sensitive ? "exact" : "any",
+					   t_new_count, t_megabytes / t_old_time, t_megabytes / t_new_time, t_old_time / t_new_time,
+					   t_old_count != t_new_count ? "  COUNT DIFFERS" : "");
+			}
+
+		delete[] t_text;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_cases;
+	t_cases = 200000;
+	if (argc > 1)
+		t_cases = (uint32_t)atoi(argv[1]);
+
+	bench_make_tables();
+
+	if (!bench_check(t_cases))
+		return 1;
+
+	bench_measure();
+
+	return 0;
+}
@@ -0,0 +1,434 @@
+/* Copyright (C) 2003-2013 Runtime Revolution Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This program is the loopback load test for the epoll socket poll used on
+// Linux (MCS_poll in engine/src/lnxspec.cpp and MCSocket::setselect in
+// engine/src/opensslsocket.cpp). It runs the same scheme as the engine:
+//
+//   - sockets register level-triggered with a single epoll set, reading
+//     whenever connected and writing only while they have data queued
+//   - the poll selects on the epoll descriptor, then takes one batch of up to
+//     256 ready sockets with epoll_wait
+//   - a listening socket accepts one connection per event, and a connected
+//     socket reads the FIONREAD amount per event, as MCSocket::readsome does
+//
+// A child process opens the given number of connections (10000 by default)
+// to a listener in the parent, sends a message down each and waits for it to
+// be echoed back, then closes them all. The parent serves every connection
+// through the poll loop above and checks that each was accepted, echoed and
+// closed. Descriptors well above FD_SETSIZE are in use throughout, which the
+// select fallback can't handle.
+//
+// The client and server run in separate processes so each needs just over
+// the connection count in descriptors - the soft limit is raised to the hard
+// limit if needed.
+//
+// To build and run it on Linux, from the root of the repository:
+//
+//   g++ -O2 -o socket_load tools/socket_load.cpp && ./socket_load [connections]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// As SOCKET_EVENT_BATCH in lnxspec.cpp.
+#define LOAD_EVENT_BATCH 256
+
+// The message each client sends, and expects back.
+#define LOAD_MESSAGE "GET /session HTTP/1.0\r\n\r\n"
+
+static double load_now(void)
+{
+	struct timeval t_time;
+	gettimeofday(&t_time, NULL);
+	return t_time . tv_sec + t_time . tv_usec / 1000000.0;
+}
+
+static bool load_raise_fd_limit(uint32_t p_needed)
+{
+	struct rlimit t_limit;
+	if (getrlimit(RLIMIT_NOFILE, &t_limit) != 0)
+		return false;
+	if (t_limit . rlim_cur >= p_needed)
+		return true;
+	if (t_limit . rlim_max < p_needed)
+	{
+		fprintf(stderr, "need %u descriptors but the hard limit is %lu\n", p_needed, (unsigned long)t_limit . rlim_max);
+		return false;
+	}
+	t_limit . rlim_cur = p_needed;
+	return setrlimit(RLIMIT_NOFILE, &t_limit) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The server's view of a socket - the parts of MCSocket the poll uses.
+struct LoadSocket
+{
+	int fd;
+	bool accepting;
+	uint32_t pollevents;
+
+	// Echoed data not yet written.
+	char *wbuffer;
+	uint32_t wlength;
+
+	uint32_t received;
+};
+
+struct LoadServer
+{
+	int epoll;
+	uint32_t accepted;
+	uint32_t closed;
+	uint32_t open;
+	uint32_t peak_open;
+	uint64_t echoed;
+	int highest_fd;
+	uint32_t polls;
+	uint32_t events;
+};
+
+// As MCSocket::setselect - register the socket's current interest, removing
+// it from the set if it has none.
+static void load_setselect(LoadServer& x_server, LoadSocket *p_socket)
+{
+	uint32_t t_events;
+	t_events = EPOLLIN;
+	if (p_socket -> wlength != 0)
+		t_events |= EPOLLOUT;
+
+	if (t_events == p_socket -> pollevents)
+		return;
+
+	struct epoll_event t_event;
+	t_event . events = t_events;
+	t_event . data . ptr = p_socket;
+	epoll_ctl(x_server . epoll, p_socket -> pollevents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, p_socket -> fd, &t_event);
+	p_socket -> pollevents = t_events;
+}
+
+static void load_close(LoadServer& x_server, LoadSocket *p_socket)
+{
+	epoll_ctl(x_server . epoll, EPOLL_CTL_DEL, p_socket -> fd, NULL);
+	close(p_socket -> fd);
+	free(p_socket -> wbuffer);
+	delete p_socket;
+	x_server . closed += 1;
+	x_server . open -= 1;
+}
+
+// As MCSocket::writesome - write as much of the queued data as the socket
+// takes.
+static bool load_writesome(LoadServer& x_server, LoadSocket *p_socket)
+{
+	while(p_socket -> wlength != 0)
+	{
+		ssize_t t_written;
+		t_written = write(p_socket -> fd, p_socket -> wbuffer, p_socket -> wlength);
+		if (t_written < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		memmove(p_socket -> wbuffer, p_socket -> wbuffer + t_written, p_socket -> wlength - t_written);
+		p_socket -> wlength -= t_written;
+		x_server . echoed += t_written;
+	}
+	return true;
+}
+
+// As MCSocket::readsome - accept one connection, or read what FIONREAD says
+// is available and queue it to be echoed.
+static bool load_readsome(LoadServer& x_server, LoadSocket *p_socket)
+{
+	if (p_socket -> accepting)
+	{
+		int t_fd;
+		t_fd = accept4(p_socket -> fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (t_fd < 0)
+			return true;
+
+		LoadSocket *t_new;
+		t_new = new LoadSocket;
+		memset(t_new, 0, sizeof(LoadSocket));
+		t_new -> fd = t_fd;
+		load_setselect(x_server, t_new);
+
+		x_server . accepted += 1;
+		x_server . open += 1;
+		if (x_server . open > x_server . peak_open)
+			x_server . peak_open = x_server . open;
+		if (t_fd > x_server . highest_fd)
+			x_server . highest_fd = t_fd;
+		return true;
+	}
+
+	int t_available;
+	t_available = 0;
+	if (ioctl(p_socket -> fd, FIONREAD, &t_available) != 0)
+		return false;
+
+	// As in the engine, a readable socket with nothing to read has closed.
+	if (t_available == 0)
+		return false;
+
+	p_socket -> wbuffer = (char *)realloc(p_socket -> wbuffer, p_socket -> wlength + t_available);
+	ssize_t t_read;
+	t_read = read(p_socket -> fd, p_socket -> wbuffer + p_socket -> wlength, t_available);
+	if (t_read <= 0)
+		return t_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+	p_socket -> wlength += t_read;
+	p_socket -> received += t_read;
+	return true;
+}
+
+// As MCS_poll - wait on the epoll descriptor with select, then handle one
+// batch of ready sockets.
+static void load_poll(LoadServer& x_server, double p_delay)
+{
+	fd_set t_rmask;
+	FD_ZERO(&t_rmask);
+	FD_SET(x_server . epoll, &t_rmask);
+
+	struct timeval t_timeout;
+	t_timeout . tv_sec = (long)p_delay;
+	t_timeout . tv_usec = (long)((p_delay - (long)p_delay) * 1000000.0);
+	if (select(x_server . epoll + 1, &t_rmask, NULL, NULL, &t_timeout) <= 0)
+		return;
+
+	struct epoll_event t_events[LOAD_EVENT_BATCH];
+	int t_count;
+	t_count = epoll_wait(x_server . epoll, t_events, LOAD_EVENT_BATCH, 0);
+
+	x_server . polls += 1;
+
+	for(int i = 0; i < t_count; i++)
+	{
+		LoadSocket *t_socket;
+		t_socket = (LoadSocket *)t_events[i] . data . ptr;
+
+		uint32_t t_ready;
+		t_ready = t_events[i] . events;
+
+		x_server . events += 1;
+
+		bool t_ok;
+		t_ok = true;
+		if ((t_ready & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0)
+			t_ok = load_readsome(x_server, t_socket);
+		if (t_ok && (t_ready & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0)
+			t_ok = load_writesome(x_server, t_socket);
+
+		if (!t_ok)
+			load_close(x_server, t_socket);
+		else
+		{
+			// A socket with queued data tries to write straight away, as the
+			// engine does when write is called on it.
+			if (t_socket -> wlength != 0 && !t_socket -> accepting)
+				t_ok = load_writesome(x_server, t_socket);
+			if (!t_ok)
+				load_close(x_server, t_socket);
+			else
+				load_setselect(x_server, t_socket);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The client - open every connection, then send and check the echo on each,
+// then close them all. Exits with 0 if every connection echoed correctly.
+static int load_client(uint16_t p_port, uint32_t p_connections)
+{
+	int *t_fds;
+	t_fds = (int *)calloc(p_connections, sizeof(int));
+
+	struct sockaddr_in t_address;
+	memset(&t_address, 0, sizeof(t_address));
+	t_address . sin_family = AF_INET;
+	t_address . sin_port = htons(p_port);
+	t_address . sin_addr . s_addr = htonl(INADDR_LOOPBACK);
+
+	for(uint32_t i = 0; i < p_connections; i++)
+	{
+		t_fds[i] = socket(AF_INET, SOCK_STREAM, 0);
+		if (t_fds[i] < 0 || connect(t_fds[i], (struct sockaddr *)&t_address, sizeof(t_address)) != 0)
+		{
+			fprintf(stderr, "client: connection %u failed: %s\n", i, strerror(errno));
+			return 1;
+		}
+		int t_nodelay;
+		t_nodelay = 1;
+		setsockopt(t_fds[i], IPPROTO_TCP, TCP_NODELAY, &t_nodelay, sizeof(t_nodelay));
+	}
+
+	size_t t_length;
+	t_length = strlen(LOAD_MESSAGE);
+	for(uint32_t i = 0; i < p_connections; i++)
+		if (write(t_fds[i], LOAD_MESSAGE, t_length) != (ssize_t)t_length)
+		{
+			fprintf(stderr, "client: write on connection %u failed\n", i);
+			return 1;
+		}
+
+	for(uint32_t i = 0; i < p_connections; i++)
+	{
+		char t_buffer[64];
+		size_t t_got;
+		t_got = 0;
+		while(t_got < t_length)
+		{
+			ssize_t t_read;
+			t_read = read(t_fds[i], t_buffer + t_got, t_length - t_got);
+			if (t_read <= 0)
+			{
+				fprintf(stderr, "client: connection %u closed before its echo\n", i);
+				return 1;
+			}
+			t_got += t_read;
+		}
+		if (memcmp(t_buffer, LOAD_MESSAGE, t_length) != 0)
+		{
+			fprintf(stderr, "client: connection %u echoed the wrong data\n", i);
+			return 1;
+		}
+	}
+
+	for(uint32_t i = 0; i < p_connections; i++)
+		close(t_fds[i]);
+	free(t_fds);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+	uint32_t t_connections;
+	t_connections = 10000;
+	if (argc > 1)
+		t_connections = (uint32_t)atoi(argv[1]);
+
+	if (!load_raise_fd_limit(t_connections + 64))
+		return 1;
+
+	signal(SIGPIPE, SIG_IGN);
+
+	int t_listener;
+	t_listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	struct sockaddr_in t_address;
+	memset(&t_address, 0, sizeof(t_address));
+	t_address . sin_family = AF_INET;
+	t_address . sin_port = 0;
+	t_address . sin_addr . s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t t_address_length;
+	t_address_length = sizeof(t_address);
+	if (bind(t_listener, (struct sockaddr *)&t_address, sizeof(t_address)) != 0 ||
+		listen(t_listener, SOMAXCONN) != 0 ||
+		getsockname(t_listener, (struct sockaddr *)&t_address, &t_address_length) != 0)
+	{
+		fprintf(stderr, "server: can't listen: %s\n", strerror(errno));
+		return 1;
+	}
+
+	pid_t t_child;
+	t_child = fork();
+	if (t_child == 0)
+	{
+		close(t_listener);
+		_exit(load_client(ntohs(t_address . sin_port), t_connections));
+	}
+
+	LoadServer t_server;
+	memset(&t_server, 0, sizeof(t_server));
+	t_server . epoll = epoll_create1(EPOLL_CLOEXEC);
+
+	LoadSocket *t_listening;
+	t_listening = new LoadSocket;
+	memset(t_listening, 0, sizeof(LoadSocket));
+	t_listening -> fd = t_listener;
+	t_listening -> accepting = true;
+	load_setselect(t_server, t_listening);
+
+	double t_start;
+	t_start = load_now();
+
+	double t_all_accepted;
+	t_all_accepted = 0.0;
+
+	int t_status;
+	t_status = -1;
+	while(t_server . closed < t_connections)
+	{
+		load_poll(t_server, 0.1);
+
+		if (t_all_accepted == 0.0 && t_server . accepted == t_connections)
+			t_all_accepted = load_now();
+
+		// Stop if the client has given up.
+		if (t_status == -1 && waitpid(t_child, &t_status, WNOHANG) == t_child &&
+			(!WIFEXITED(t_status) || WEXITSTATUS(t_status) != 0))
+			break;
+
+		if (load_now() - t_start > 120.0)
+		{
+			fprintf(stderr, "server: timed out\n");
+			kill(t_child, SIGKILL);
+			break;
+		}
+	}
+
+	double t_end;
+	t_end = load_now();
+
+	if (t_status == -1)
+		waitpid(t_child, &t_status, 0);
+
+	bool t_passed;
+	t_passed = WIFEXITED(t_status) && WEXITSTATUS(t_status) == 0 &&
+				t_server . accepted == t_connections &&
+				t_server . closed == t_connections &&
+				t_server . echoed == (uint64_t)t_connections * strlen(LOAD_MESSAGE);
+
+	printf("connections      %u\n", t_connections);
+	printf("accepted         %u (all in %.3fs)\n", t_server . accepted, t_all_accepted != 0.0 ? t_all_accepted - t_start : 0.0);
+	printf("peak open        %u\n", t_server . peak_open);
+	printf("highest fd       %d (FD_SETSIZE is %d)\n", t_server . highest_fd, FD_SETSIZE);
+	printf("echoed bytes     %llu\n", (unsigned long long)t_server . echoed);
+	printf("closed           %u\n", t_server . closed);
+	printf("polls            %u, %.1f events per poll\n", t_server . polls, t_server . polls != 0 ? (double)t_server . events / t_server . polls : 0.0);
+	printf("total time       %.3fs\n", t_end - t_start);
+	printf("%s\n", t_passed ? "PASSED" : "FAILED");
+
+	return t_passed ? 0 : 1;
+}